@@ -2,7 +2,16 @@
 #define TWIDDLE_H
 
 #include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_atomic.h>
+#include <twiddle/bitmap/bitmap_bsi.h>
+#include <twiddle/bitmap/bitmap_mmap.h>
+#include <twiddle/bitmap/bitmap_parallel.h>
+#include <twiddle/bitmap/bitmap_rank.h>
 #include <twiddle/bitmap/bitmap_rle.h>
+#include <twiddle/bitmap/bitmap_roaring.h>
+#include <twiddle/bitmap/bitmap_snapshot.h>
+#include <twiddle/bitmap/bitmap_summary.h>
+#include <twiddle/bitmap/bitmatrix.h>
 
 #include <twiddle/bloomfilter/bloomfilter.h>
 #include <twiddle/bloomfilter/bloomfilter_a2.h>
@@ -2,21 +2,43 @@
 #define TWIDDLE_BITMAP_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include <twiddle/utils/alloc.h>
+
 #define TW_BITMAP_MAX_BITS (1UL << 48)
 #define TW_BITMAP_MAX_POS (TW_BITMAP_MAX_BITS - 1)
 
+/**
+ * number of positions batched operations prefetch ahead, large enough to
+ * cover DRAM latency on bitmaps not fitting in cache
+ */
+#define TW_BITMAP_PREFETCH_DISTANCE 16
+
+/**
+ * size in bytes from which growing heap allocated bits moves them to a memory
+ * mapping, grown further by remapping pages instead of copying them
+ */
+#define TW_BITMAP_REMAP_MIN (1UL << 21)
+
 /**
  * dense bitmap data structure
  *
  * This is the most basic implementation of a bitmap. It does not support
- * resizing and concurrent operations (unless constrained to reads only).
+ * concurrent operations (unless constrained to reads only), see
+ * `struct tw_bitmap_atomic` for concurrent writers. It is resized with
+ * `tw_bitmap_resize`, growing its allocation geometrically.
  *
  * There's a small overhead when setting/clearing bit to maintain the
  * number of active bits. This comes with a O(1) tw_bitmap_count and derived
+ * operations. Write-heavy users may skip this overhead with
+ * `tw_bitmap_set_nocount` and `tw_bitmap_clear_nocount`, the number of
+ * active bits is then recomputed on the next `tw_bitmap_count` and derived
  * operations.
  */
+struct tw_bitmap_cow;
+
 struct tw_bitmap {
   /** storage capacity in bits */
   uint64_t size;
@@ -24,6 +46,38 @@ struct tw_bitmap {
   uint64_t count;
   /** pointer to stored bits */
   uint64_t *data;
+  /** allocated bits in `data`, bits in `[size, capacity)` are cleared */
+  uint64_t capacity;
+  /** incremented on modifications, invalidates `struct tw_bitmap_rank` */
+  uint64_t generation;
+  /** memory mapping holding `data`, `NULL` if `data` is heap allocated */
+  void *mapping;
+  /** size in bytes of `mapping` */
+  uint64_t mapping_size;
+  /** allocation flags of `data`, see `enum tw_alloc_flags` */
+  int flags;
+  /** chunks of `mapping` shared with snapshots, `NULL` if not shared */
+  struct tw_bitmap_cow *cow;
+  /**
+   * set by `_nocount` writes, `count` and `generation` are then outdated and
+   * refreshed by the next operation reading the number of active bits
+   */
+  bool stale;
+};
+
+/**
+ * iterator over the active bits of a `struct tw_bitmap`
+ *
+ * The iterator holds a copy of the word being visited, thus the bitmap must
+ * not be modified while iterating.
+ */
+struct tw_bitmap_iter {
+  /** bitmap iterated upon */
+  const struct tw_bitmap *bitmap;
+  /** index of the word being visited */
+  uint64_t index;
+  /** active bits of the visited word not yet returned */
+  uint64_t word;
 };
 
 /**
@@ -39,6 +93,38 @@ struct tw_bitmap {
  */
 struct tw_bitmap *tw_bitmap_new(uint64_t size);
 
+/**
+ * Creates a `struct tw_bitmap` with the requested number of bits and
+ * allocation flags.
+ *
+ * @param size number of bits the bitmap should hold, must be smaller or equal
+ *             than `TW_BITMAP_MAX_BITS`
+ * @param flags bitwise or of `enum tw_alloc_flags`, e.g. huge pages for
+ *              bitmaps much larger than the last level cache
+ *
+ * @return `NULL` if allocation failed, otherwise a pointer to the newly
+ *         allocated `struct tw_bitmap`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_new_flags(uint64_t size, int flags);
+
+/**
+ * Creates a `struct tw_bitmap` viewing a caller buffer in place, see
+ * `twiddle/utils/alloc.h`. Its number of active bits is computed on first
+ * use. Wrapped bitmaps can't be resized, reserved nor snapshotted.
+ *
+ * @param data non-null buffer of `size / 8` bytes aligned on 64 bytes
+ * @param size number of bits of `data`, a strictly positive multiple of 512
+ *             smaller or equal than `TW_BITMAP_MAX_BITS`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed,
+ *         otherwise a pointer to the newly allocated `struct tw_bitmap`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_wrap(void *data, uint64_t size);
+
 /**
  * Free a `struct tw_bitmap`.
  *
@@ -52,7 +138,7 @@ void tw_bitmap_free(struct tw_bitmap *bitmap);
  * Copy a source bitmap into a specified bitmap.
  *
  * @param src non-null bitmap to copy from
- * @param dst non-null bitmap to copy to
+ * @param dst non-null bitmap to copy to, resized to the size of `src`
  *
  * @return `NULL` if copy failed, otherwise a pointer to dst
  *
@@ -67,13 +153,53 @@ struct tw_bitmap *tw_bitmap_copy(const struct tw_bitmap *src,
  * @param bitmap non-null bitmap to clone
  *
  * @return `NULL` if failed, otherwise a newly allocated bitmap initialized from
- *         the requests bitmap. The caller is responsible to deallocate the
- *         bitmap with tw_bitmap_free
+ *         the requests bitmap, a copy even if `bitmap` is shared. The caller
+ *         is responsible to deallocate the bitmap with tw_bitmap_free
  *
  * @note group:bitmap
  */
 struct tw_bitmap *tw_bitmap_clone(const struct tw_bitmap *bitmap);
 
+/**
+ * Resize a `struct tw_bitmap`, keeping the bits below the new size.
+ *
+ * Growing reallocates to at least twice the previous capacity, such that
+ * growing bit by bit is amortized constant time. Allocations larger than
+ * `TW_BITMAP_REMAP_MIN` bytes are memory mappings, grown by remapping pages
+ * instead of copying them. Shrinking clears the bits past the new size but
+ * keeps the allocation for later growth.
+ *
+ * @param bitmap non-null bitmap to resize, must neither be file-backed,
+ *               shared, see `tw_bitmap_snapshot`, nor wrapped, see
+ *               `tw_bitmap_wrap`
+ * @param size number of bits the bitmap should hold, must be smaller or equal
+ *             than `TW_BITMAP_MAX_BITS`, rounded as `tw_bitmap_new`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed, in which
+ *         case `bitmap` is left untouched, otherwise a pointer to `bitmap`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_resize(struct tw_bitmap *bitmap, uint64_t size);
+
+/**
+ * Reserve the allocation of a `struct tw_bitmap`, such that resizing it up to
+ * `capacity` bits does not reallocate. The size of `bitmap` is unchanged.
+ *
+ * @param bitmap non-null bitmap to reserve, must neither be file-backed,
+ *               shared, see `tw_bitmap_snapshot`, nor wrapped, see
+ *               `tw_bitmap_wrap`
+ * @param capacity number of bits to allocate, must be smaller or equal than
+ *                 `TW_BITMAP_MAX_BITS`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed, in which
+ *         case `bitmap` is left untouched, otherwise a pointer to `bitmap`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_reserve(struct tw_bitmap *bitmap,
+                                    uint64_t capacity);
+
 /**
  * Set position in a `struct tw_bitmap`.
  *
@@ -94,6 +220,34 @@ void tw_bitmap_set(struct tw_bitmap *bitmap, uint64_t pos);
  */
 void tw_bitmap_clear(struct tw_bitmap *bitmap, uint64_t pos);
 
+/**
+ * Set the bit at position `pos` without maintaining the number of active
+ * bits.
+ *
+ * Unlike `tw_bitmap_set`, the write does not depend on the previous value of
+ * the word nor on the count, consecutive writes thus do not serialize on
+ * `bitmap->count`. The count is recomputed, with the SIMD popcount kernels,
+ * by the next operation reading it, e.g. `tw_bitmap_count`,
+ * `tw_bitmap_density` or `tw_bitmap_full`.
+ *
+ * @param bitmap non-null bitmap to set the bit
+ * @param pos position of the bit to set, must be smaller than `bitmap.size`
+ *
+ * @note group:bitmap
+ */
+void tw_bitmap_set_nocount(struct tw_bitmap *bitmap, uint64_t pos);
+
+/**
+ * Clear the bit at position `pos` without maintaining the number of active
+ * bits, see `tw_bitmap_set_nocount`.
+ *
+ * @param bitmap non-null bitmap to clear the bit
+ * @param pos position of the bit to clear, must be smaller than `bitmap.size`
+ *
+ * @note group:bitmap
+ */
+void tw_bitmap_clear_nocount(struct tw_bitmap *bitmap, uint64_t pos);
+
 /**
  * Test a position in a `struct tw_bitmap`.
  *
@@ -134,6 +288,215 @@ bool tw_bitmap_test_and_set(struct tw_bitmap *bitmap, uint64_t pos);
  */
 bool tw_bitmap_test_and_clear(struct tw_bitmap *bitmap, uint64_t pos);
 
+/**
+ * Set multiple positions in a `struct tw_bitmap`.
+ *
+ * Positions are visited in order while prefetching the words of the
+ * positions `TW_BITMAP_PREFETCH_DISTANCE` ahead, such that memory accesses of
+ * random positions overlap.
+ *
+ * @param bitmap non-null bitmap to set positions at
+ * @param positions non-null array of positions to set, positions greater or
+ *                  equal than `bitmap.size` are ignored
+ * @param n_positions number of positions
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of bits
+ *         that were not active before
+ *
+ * @note group:bitmap
+ */
+uint64_t tw_bitmap_set_many(struct tw_bitmap *bitmap, const uint64_t *positions,
+                            size_t n_positions);
+
+/**
+ * Clear multiple positions in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to clear positions at
+ * @param positions non-null array of positions to clear, positions greater or
+ *                  equal than `bitmap.size` are ignored
+ * @param n_positions number of positions
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of bits
+ *         that were active before
+ *
+ * @note group:bitmap
+ */
+uint64_t tw_bitmap_clear_many(struct tw_bitmap *bitmap,
+                              const uint64_t *positions, size_t n_positions);
+
+/**
+ * Test multiple positions in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to test positions at
+ * @param positions non-null array of positions to test, positions greater or
+ *                  equal than `bitmap.size` are not active
+ * @param n_positions number of positions
+ * @param results non-null bitmap receiving the value of `positions[i]` at
+ *                position `i`, must be distinct from `bitmap` and have at
+ *                least `n_positions` bits, bits past `n_positions` are cleared
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to
+ *         `results`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_test_many(const struct tw_bitmap *bitmap,
+                                      const uint64_t *positions,
+                                      size_t n_positions,
+                                      struct tw_bitmap *results);
+
+/**
+ * Set a contiguous range in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to set the range
+ * @param start first position of the range
+ * @param end last position of the range, must be greater or equal than
+ *            `start` and smaller than `bitmap.size`
+ *
+ * @note group:bitmap
+ */
+void tw_bitmap_set_range(struct tw_bitmap *bitmap, uint64_t start,
+                         uint64_t end);
+
+/**
+ * Clear a contiguous range in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to clear the range
+ * @param start first position of the range
+ * @param end last position of the range, must be greater or equal than
+ *            `start` and smaller than `bitmap.size`
+ *
+ * @note group:bitmap
+ */
+void tw_bitmap_clear_range(struct tw_bitmap *bitmap, uint64_t start,
+                           uint64_t end);
+
+/**
+ * Negate a contiguous range in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to negate the range
+ * @param start first position of the range
+ * @param end last position of the range, must be greater or equal than
+ *            `start` and smaller than `bitmap.size`
+ *
+ * @note group:bitmap
+ */
+void tw_bitmap_flip_range(struct tw_bitmap *bitmap, uint64_t start,
+                          uint64_t end);
+
+/**
+ * Count the number of active bits in a contiguous range of a
+ * `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to count
+ * @param start first position of the range
+ * @param end last position of the range, must be greater or equal than
+ *            `start` and smaller than `bitmap.size`
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of active
+ *         bits in `[start, end]`
+ *
+ * @note group:bitmap
+ */
+uint64_t tw_bitmap_count_range(const struct tw_bitmap *bitmap, uint64_t start,
+                               uint64_t end);
+
+/**
+ * Verify if all bits of a contiguous range are active in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to test
+ * @param start first position of the range
+ * @param end last position of the range, must be greater or equal than
+ *            `start` and smaller than `bitmap.size`
+ *
+ * @return `false` if pre-conditions are not met or a bit of `[start, end]` is
+ *         not active, otherwise `true`
+ *
+ * @note group:bitmap
+ */
+bool tw_bitmap_test_range_all(const struct tw_bitmap *bitmap, uint64_t start,
+                              uint64_t end);
+
+/**
+ * Verify if any bit of a contiguous range is active in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to test
+ * @param start first position of the range
+ * @param end last position of the range, must be greater or equal than
+ *            `start` and smaller than `bitmap.size`
+ *
+ * @return `false` if pre-conditions are not met or no bit of `[start, end]` is
+ *         active, otherwise `true`
+ *
+ * @note group:bitmap
+ */
+bool tw_bitmap_test_range_any(const struct tw_bitmap *bitmap, uint64_t start,
+                              uint64_t end);
+
+/**
+ * Shift the bits of a `struct tw_bitmap` toward higher positions, i.e. the
+ * bit at position `pos` moves to `pos + shift`. Bits shifted past the size
+ * are discarded and low positions are cleared.
+ *
+ * @param bitmap non-null bitmap to shift
+ * @param shift number of positions to shift by, the bitmap is cleared if
+ *              greater or equal than `bitmap.size`
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to
+ *         `bitmap`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_shift_left(struct tw_bitmap *bitmap,
+                                       uint64_t shift);
+
+/**
+ * Shift the bits of a `struct tw_bitmap` toward lower positions, i.e. the
+ * bit at position `pos` moves to `pos - shift`. Bits shifted below position 0
+ * are discarded and high positions are cleared.
+ *
+ * @param bitmap non-null bitmap to shift
+ * @param shift number of positions to shift by, the bitmap is cleared if
+ *              greater or equal than `bitmap.size`
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to
+ *         `bitmap`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_shift_right(struct tw_bitmap *bitmap,
+                                        uint64_t shift);
+
+/**
+ * Rotate the bits of a `struct tw_bitmap` toward higher positions, i.e. the
+ * bit at position `pos` moves to `(pos + shift) % bitmap.size`.
+ *
+ * @param bitmap non-null bitmap to rotate
+ * @param shift number of positions to rotate by
+ *
+ * @return `NULL` if pre-conditions are not met or allocation of the bits
+ *         wrapping around failed, otherwise a pointer to `bitmap`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_rotate_left(struct tw_bitmap *bitmap,
+                                        uint64_t shift);
+
+/**
+ * Rotate the bits of a `struct tw_bitmap` toward lower positions, i.e. the
+ * bit at position `pos` moves to `(pos - shift) % bitmap.size`.
+ *
+ * @param bitmap non-null bitmap to rotate
+ * @param shift number of positions to rotate by
+ *
+ * @return `NULL` if pre-conditions are not met or allocation of the bits
+ *         wrapping around failed, otherwise a pointer to `bitmap`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_rotate_right(struct tw_bitmap *bitmap,
+                                         uint64_t shift);
+
 /**
  * Verify if a `struct tw_bitmap` is empty.
  *
@@ -230,6 +593,84 @@ int64_t tw_bitmap_find_first_zero(const struct tw_bitmap *bitmap);
  */
 int64_t tw_bitmap_find_first_bit(const struct tw_bitmap *bitmap);
 
+/**
+ * Find the last zero in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to search
+ *
+ * @return `-1` if not found, otherwise the bit position
+ *
+ * @note group:bitmap
+ */
+int64_t tw_bitmap_find_last_zero(const struct tw_bitmap *bitmap);
+
+/**
+ * Find the last bit in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to search
+ *
+ * @return `-1` if not found, otherwise the bit position
+ *
+ * @note group:bitmap
+ */
+int64_t tw_bitmap_find_last_bit(const struct tw_bitmap *bitmap);
+
+/**
+ * Find the first zero at or after a position in a `struct tw_bitmap`.
+ *
+ * Regions without zeroes are skipped a vector at a time, thus scanning with a
+ * cursor, i.e. `from` set to the previous result plus one, is linear.
+ *
+ * @param bitmap non-null bitmap to search
+ * @param from first position to consider
+ *
+ * @return `-1` if not found, otherwise the bit position
+ *
+ * @note group:bitmap
+ */
+int64_t tw_bitmap_find_next_zero(const struct tw_bitmap *bitmap, uint64_t from);
+
+/**
+ * Find the first bit at or after a position in a `struct tw_bitmap`.
+ *
+ * Regions without active bits are skipped a vector at a time, thus scanning
+ * with a cursor, i.e. `from` set to the previous result plus one, is linear.
+ *
+ * @param bitmap non-null bitmap to search
+ * @param from first position to consider
+ *
+ * @return `-1` if not found, otherwise the bit position
+ *
+ * @note group:bitmap
+ */
+int64_t tw_bitmap_find_next_bit(const struct tw_bitmap *bitmap, uint64_t from);
+
+/**
+ * Find the last zero at or before a position in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to search
+ * @param from last position to consider, clamped to the last position of
+ *             `bitmap`
+ *
+ * @return `-1` if not found, otherwise the bit position
+ *
+ * @note group:bitmap
+ */
+int64_t tw_bitmap_find_prev_zero(const struct tw_bitmap *bitmap, uint64_t from);
+
+/**
+ * Find the last bit at or before a position in a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to search
+ * @param from last position to consider, clamped to the last position of
+ *             `bitmap`
+ *
+ * @return `-1` if not found, otherwise the bit position
+ *
+ * @note group:bitmap
+ */
+int64_t tw_bitmap_find_prev_bit(const struct tw_bitmap *bitmap, uint64_t from);
+
 /**
  * Negate all bits and zeroes in a `struct tw_bitmap`.
  *
@@ -242,10 +683,11 @@ int64_t tw_bitmap_find_first_bit(const struct tw_bitmap *bitmap);
 struct tw_bitmap *tw_bitmap_not(struct tw_bitmap *bitmap);
 
 /**
- * Verify if `struct tw_bitmap`s are equals.
+ * Verify if `struct tw_bitmap`s are equals, bits past the size of the smaller
+ * bitmap are compared as cleared.
  *
  * @param fst non-null first bitmap to check
- * @param snd non-null second bitmap to check of same size as `fst`
+ * @param snd non-null second bitmap to check
  *
  * @return `false` if pre-conditions are not met or bitmaps are not equal,
  *         otherwise returns `true`
@@ -258,9 +700,11 @@ bool tw_bitmap_equal(const struct tw_bitmap *fst, const struct tw_bitmap *snd);
  * Compute the in-place union of `struct tw_bitmap`s.
  *
  * @param src non-null source bitmap to union
- * @param dst non-null destination bitmap to union of same size as `src`
+ * @param dst non-null destination bitmap to union, grown to the size of `src`
+ *            if smaller, see `tw_bitmap_resize`
  *
- * @return `NULL` if pre-conditions are not met, otherwise pointer to `dst`
+ * @return `NULL` if pre-conditions are not met or growing failed, otherwise
+ *         pointer to `dst`
  *
  * @note group:bitmap
  */
@@ -270,8 +714,9 @@ struct tw_bitmap *tw_bitmap_union(const struct tw_bitmap *src,
 /**
  * Compute the in-place intersection of `struct tw_bitmap`s.
  *
- * @param src non-null source bitmap to union
- * @param dst non-null destination bitmap to intersect of same size as `src`
+ * @param src non-null source bitmap to intersect, bits past its size are
+ *            cleared from `dst`
+ * @param dst non-null destination bitmap to intersect
  *
  * @return `NULL` if pre-conditions are not met, otherwise pointer to `dst`
  *
@@ -283,14 +728,367 @@ struct tw_bitmap *tw_bitmap_intersection(const struct tw_bitmap *src,
 /**
  * Compute the in-place xor of `struct tw_bitmap`s.
  *
- * @param src non-null source bitmap to union
- * @param dst non-null destination bitmap to xor of same size as `src`
+ * @param src non-null source bitmap to xor
+ * @param dst non-null destination bitmap to xor, grown to the size of `src` if
+ *            smaller, see `tw_bitmap_resize`
  *
- * @return `NULL` if pre-conditions are not met, otherwise pointer to `dst`
+ * @return `NULL` if pre-conditions are not met or growing failed, otherwise
+ *         pointer to `dst`
  *
  * @note group:bitmap
  */
 struct tw_bitmap *tw_bitmap_xor(const struct tw_bitmap *src,
                                 struct tw_bitmap *dst);
 
+/**
+ * Compute the in-place difference of `struct tw_bitmap`s, i.e. the bits of
+ * `src` are cleared from `dst`.
+ *
+ * @param src non-null source bitmap to remove
+ * @param dst non-null destination bitmap
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise pointer to `dst`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_andnot(const struct tw_bitmap *src,
+                                   struct tw_bitmap *dst);
+
+/**
+ * Compute the union of `struct tw_bitmap`s into a third bitmap.
+ *
+ * Operands are left untouched, unless aliased by `out`, thus no copy is
+ * required to preserve them. Operands may differ in size, the bits past the
+ * smaller one are considered cleared.
+ *
+ * @param a non-null first operand
+ * @param b non-null second operand
+ * @param out non-null destination bitmap, resized to the larger operand, see
+ *            `tw_bitmap_resize`, its previous content is discarded, may be `a`
+ *            or `b`
+ *
+ * @return `NULL` if pre-conditions are not met or resizing failed, otherwise
+ *         pointer to `out`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_union_into(const struct tw_bitmap *a,
+                                       const struct tw_bitmap *b,
+                                       struct tw_bitmap *out);
+
+/**
+ * Compute the intersection of `struct tw_bitmap`s into a third bitmap, see
+ * `tw_bitmap_union_into`.
+ *
+ * @param a non-null first operand
+ * @param b non-null second operand
+ * @param out non-null destination bitmap, resized to the larger operand, may
+ *            be `a` or `b`
+ *
+ * @return `NULL` if pre-conditions are not met or resizing failed, otherwise
+ *         pointer to `out`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_intersection_into(const struct tw_bitmap *a,
+                                              const struct tw_bitmap *b,
+                                              struct tw_bitmap *out);
+
+/**
+ * Compute the xor of `struct tw_bitmap`s into a third bitmap, see
+ * `tw_bitmap_union_into`.
+ *
+ * @param a non-null first operand
+ * @param b non-null second operand
+ * @param out non-null destination bitmap, resized to the larger operand, may
+ *            be `a` or `b`
+ *
+ * @return `NULL` if pre-conditions are not met or resizing failed, otherwise
+ *         pointer to `out`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_xor_into(const struct tw_bitmap *a,
+                                     const struct tw_bitmap *b,
+                                     struct tw_bitmap *out);
+
+/**
+ * Compute `a AND NOT b` of `struct tw_bitmap`s into a third bitmap, i.e. the
+ * bits of `a` not in `b`, see `tw_bitmap_union_into`.
+ *
+ * @param a non-null first operand
+ * @param b non-null second operand
+ * @param out non-null destination bitmap, resized to the larger operand, may
+ *            be `a` or `b`
+ *
+ * @return `NULL` if pre-conditions are not met or resizing failed, otherwise
+ *         pointer to `out`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_andnot_into(const struct tw_bitmap *a,
+                                        const struct tw_bitmap *b,
+                                        struct tw_bitmap *out);
+
+/**
+ * Compute `a OR NOT b` of `struct tw_bitmap`s into a third bitmap, see
+ * `tw_bitmap_union_into`.
+ *
+ * @param a non-null first operand
+ * @param b non-null second operand
+ * @param out non-null destination bitmap, resized to the larger operand, may
+ *            be `a` or `b`
+ *
+ * @return `NULL` if pre-conditions are not met or resizing failed, otherwise
+ *         pointer to `out`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_ornot_into(const struct tw_bitmap *a,
+                                       const struct tw_bitmap *b,
+                                       struct tw_bitmap *out);
+
+/**
+ * Compute the union of many `struct tw_bitmap`s in a single pass.
+ *
+ * @param srcs non-null array of non-null source bitmaps, possibly of
+ *             different sizes
+ * @param n_srcs number of bitmaps in `srcs`, must be greater than 0
+ * @param dst non-null destination bitmap, grown to the largest source if
+ *            smaller, see `tw_bitmap_resize`, its previous content is
+ *            discarded unless it is also one of `srcs`
+ *
+ * @return `NULL` if pre-conditions are not met or growing failed, otherwise
+ *         pointer to `dst`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *tw_bitmap_union_many(const struct tw_bitmap *const *srcs,
+                                       size_t n_srcs, struct tw_bitmap *dst);
+
+/**
+ * Compute the intersection of many `struct tw_bitmap`s in a single pass.
+ *
+ * @param srcs non-null array of non-null source bitmaps, possibly of
+ *             different sizes
+ * @param n_srcs number of bitmaps in `srcs`, must be greater than 0
+ * @param dst non-null destination bitmap, grown to the smallest source if
+ *            smaller, its bits past the smallest source are cleared, its
+ *            previous content is discarded unless it is also one of `srcs`
+ *
+ * @return `NULL` if pre-conditions are not met or growing failed, otherwise
+ *         pointer to `dst`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap *
+tw_bitmap_intersection_many(const struct tw_bitmap *const *srcs, size_t n_srcs,
+                            struct tw_bitmap *dst);
+
+/**
+ * Count the active bits of the intersection of `struct tw_bitmap`s without
+ * materializing it.
+ *
+ * @param fst non-null first bitmap
+ * @param snd non-null second bitmap
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of active
+ *         bits in `fst & snd`
+ *
+ * @note group:bitmap
+ */
+uint64_t tw_bitmap_intersection_count(const struct tw_bitmap *fst,
+                                      const struct tw_bitmap *snd);
+
+/**
+ * Count the active bits of the union of `struct tw_bitmap`s without
+ * materializing it.
+ *
+ * @param fst non-null first bitmap
+ * @param snd non-null second bitmap
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of active
+ *         bits in `fst | snd`
+ *
+ * @note group:bitmap
+ */
+uint64_t tw_bitmap_union_count(const struct tw_bitmap *fst,
+                               const struct tw_bitmap *snd);
+
+/**
+ * Count the active bits of the xor of `struct tw_bitmap`s without
+ * materializing it.
+ *
+ * @param fst non-null first bitmap
+ * @param snd non-null second bitmap
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of active
+ *         bits in `fst ^ snd`
+ *
+ * @note group:bitmap
+ */
+uint64_t tw_bitmap_xor_count(const struct tw_bitmap *fst,
+                             const struct tw_bitmap *snd);
+
+/**
+ * Count the active bits of the difference of `struct tw_bitmap`s without
+ * materializing it.
+ *
+ * @param fst non-null first bitmap
+ * @param snd non-null second bitmap
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of active
+ *         bits in `fst & ~snd`
+ *
+ * @note group:bitmap
+ */
+uint64_t tw_bitmap_andnot_count(const struct tw_bitmap *fst,
+                                const struct tw_bitmap *snd);
+
+/**
+ * Compute the Jaccard index of `struct tw_bitmap`s, i.e. the ratio of the
+ * intersection count over the union count.
+ *
+ * @param fst non-null first bitmap
+ * @param snd non-null second bitmap
+ *
+ * @return `0.0` if pre-conditions are not met, `1.0` if both bitmaps are
+ *         empty, otherwise the Jaccard index in `[0.0, 1.0]`
+ *
+ * @note group:bitmap
+ */
+float tw_bitmap_jaccard(const struct tw_bitmap *fst,
+                        const struct tw_bitmap *snd);
+
+/**
+ * Verify if `struct tw_bitmap`s share an active bit, i.e. `fst & snd` is not
+ * empty. The scan stops on the first vector sharing a bit, thus it is
+ * considerably faster than `tw_bitmap_intersection_count` when the bitmaps
+ * intersect early.
+ *
+ * @param fst non-null first bitmap
+ * @param snd non-null second bitmap
+ *
+ * @return `false` if pre-conditions are not met or bitmaps are disjoint,
+ *         otherwise `true`
+ *
+ * @note group:bitmap
+ */
+bool tw_bitmap_intersects(const struct tw_bitmap *fst,
+                          const struct tw_bitmap *snd);
+
+/**
+ * Verify if `struct tw_bitmap`s share no active bit, see
+ * `tw_bitmap_intersects`.
+ *
+ * @param fst non-null first bitmap
+ * @param snd non-null second bitmap
+ *
+ * @return `false` if pre-conditions are not met or bitmaps intersect,
+ *         otherwise `true`
+ *
+ * @note group:bitmap
+ */
+bool tw_bitmap_is_disjoint(const struct tw_bitmap *fst,
+                           const struct tw_bitmap *snd);
+
+/**
+ * Verify if the active bits of a `struct tw_bitmap` are active in another,
+ * i.e. `fst & ~snd` is empty. The scan stops on the first vector witnessing
+ * a bit of `fst` missing from `snd`. Bits past the size of `snd` are
+ * compared as cleared.
+ *
+ * @param fst non-null bitmap to verify
+ * @param snd non-null bitmap to verify against
+ *
+ * @return `false` if pre-conditions are not met or `fst` is not a subset of
+ *         `snd`, otherwise `true`
+ *
+ * @note group:bitmap
+ */
+bool tw_bitmap_is_subset(const struct tw_bitmap *fst,
+                         const struct tw_bitmap *snd);
+
+/**
+ * Initialize a `struct tw_bitmap_iter` visiting active bits in increasing
+ * order.
+ *
+ * @param iter non-null iterator to initialize
+ * @param bitmap non-null bitmap to iterate upon
+ * @param start first position to consider
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to `iter`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap_iter *tw_bitmap_iter_init(struct tw_bitmap_iter *iter,
+                                           const struct tw_bitmap *bitmap,
+                                           uint64_t start);
+
+/**
+ * Retrieve the next active bit of an iterator initialized with
+ * `tw_bitmap_iter_init`.
+ *
+ * @param iter non-null iterator
+ * @param pos non-null pointer where the position is stored
+ *
+ * @return `false` if pre-conditions are not met or there are no more active
+ *         bits, otherwise `true`
+ *
+ * @note group:bitmap
+ */
+bool tw_bitmap_iter_next(struct tw_bitmap_iter *iter, uint64_t *pos);
+
+/**
+ * Initialize a `struct tw_bitmap_iter` visiting active bits in decreasing
+ * order.
+ *
+ * @param iter non-null iterator to initialize
+ * @param bitmap non-null bitmap to iterate upon
+ * @param start first position to consider, clamped to the last position of
+ *              `bitmap`
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to `iter`
+ *
+ * @note group:bitmap
+ */
+struct tw_bitmap_iter *
+tw_bitmap_iter_init_reverse(struct tw_bitmap_iter *iter,
+                            const struct tw_bitmap *bitmap, uint64_t start);
+
+/**
+ * Retrieve the previous active bit of an iterator initialized with
+ * `tw_bitmap_iter_init_reverse`.
+ *
+ * @param iter non-null iterator
+ * @param pos non-null pointer where the position is stored
+ *
+ * @return `false` if pre-conditions are not met or there are no more active
+ *         bits, otherwise `true`
+ *
+ * @note group:bitmap
+ */
+bool tw_bitmap_iter_prev(struct tw_bitmap_iter *iter, uint64_t *pos);
+
+/**
+ * Extract the positions of active bits of a `struct tw_bitmap` in increasing
+ * order.
+ *
+ * Extraction can be resumed by calling again with `start` set to the last
+ * extracted position plus one.
+ *
+ * @param bitmap non-null bitmap to extract from
+ * @param out non-null array of at least `max` positions
+ * @param start first position to consider, must be smaller than the size of
+ *              `bitmap`
+ * @param max maximum number of positions to extract
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of
+ *         positions stored in `out`
+ *
+ * @note group:bitmap
+ */
+uint64_t tw_bitmap_to_array(const struct tw_bitmap *bitmap, uint64_t *out,
+                            uint64_t start, uint64_t max);
+
 #endif /* TWIDDLE_BITMAP_H */
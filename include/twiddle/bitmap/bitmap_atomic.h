@@ -0,0 +1,166 @@
+#ifndef TWIDDLE_BITMAP_ATOMIC_H
+#define TWIDDLE_BITMAP_ATOMIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <twiddle/bitmap/bitmap.h>
+
+/** number of independent counters of active bits */
+#define TW_BITMAP_ATOMIC_STRIPES 16
+
+/**
+ * concurrent dense bitmap data structure
+ *
+ * Same layout as `struct tw_bitmap`, but bits are modified with atomic
+ * read-modify-write instructions such that multiple threads can set, clear
+ * and test bits without locking.
+ *
+ * Maintaining a single shared count would serialize writers on its cache
+ * line. Instead, each thread updates one of `TW_BITMAP_ATOMIC_STRIPES`
+ * counters living on distinct cache lines, and `tw_bitmap_atomic_count` sums
+ * them. The sum is exact once writers are done, while writing it is a
+ * snapshot of counters that may be in flight.
+ */
+struct tw_bitmap_atomic {
+  /** storage capacity in bits */
+  uint64_t size;
+  /** pointer to stored bits */
+  uint64_t *data;
+  /** per stripe difference of active bits, one cache line apart */
+  int64_t *counts;
+};
+
+/**
+ * Creates a `struct tw_bitmap_atomic` with the requested number of bits.
+ *
+ * @param size number of bits the bitmap should hold, must be smaller or equal
+ *             than `TW_BITMAP_MAX_BITS`
+ *
+ * @return `NULL` if allocation failed, otherwise a pointer to the newly
+ *         allocated `struct tw_bitmap_atomic`
+ *
+ * @note group:bitmap_atomic
+ */
+struct tw_bitmap_atomic *tw_bitmap_atomic_new(uint64_t size);
+
+/**
+ * Free a `struct tw_bitmap_atomic`.
+ *
+ * @param bitmap to free
+ *
+ * @note group:bitmap_atomic
+ */
+void tw_bitmap_atomic_free(struct tw_bitmap_atomic *bitmap);
+
+/**
+ * Set a position in a `struct tw_bitmap_atomic`.
+ *
+ * @param bitmap non-null bitmap to set position at
+ * @param pos position of the bit to set, must be smaller than `bitmap.size`
+ *
+ * @note group:bitmap_atomic
+ */
+void tw_bitmap_atomic_set(struct tw_bitmap_atomic *bitmap, uint64_t pos);
+
+/**
+ * Clear a position in a `struct tw_bitmap_atomic`.
+ *
+ * @param bitmap non-null bitmap to clear position at
+ * @param pos position of the bit to clear, must be smaller than `bitmap.size`
+ *
+ * @note group:bitmap_atomic
+ */
+void tw_bitmap_atomic_clear(struct tw_bitmap_atomic *bitmap, uint64_t pos);
+
+/**
+ * Test a position in a `struct tw_bitmap_atomic`.
+ *
+ * @param bitmap non-null bitmap to test position at
+ * @param pos position of the bit to test, must be smaller than `bitmap.size`
+ *
+ * @return `false` if pre-conditions are not met, otherwise return the value
+ *         pos in the bitmap
+ *
+ * @note group:bitmap_atomic
+ */
+bool tw_bitmap_atomic_test(const struct tw_bitmap_atomic *bitmap,
+                           uint64_t pos);
+
+/**
+ * Test a position in `struct tw_bitmap_atomic` and set the position
+ * afterward, as a single atomic operation. Of concurrent callers on an
+ * inactive position, exactly one observes `false`.
+ *
+ * @param bitmap non-null bitmap to test and set position at
+ * @param pos position of the bit to test and set, must be smaller than
+ *            `bitmap.size`
+ *
+ * @return `false` if pre-conditions are not met, otherwise return the value
+ *         pos in the bitmap before setting it
+ *
+ * @note group:bitmap_atomic
+ */
+bool tw_bitmap_atomic_test_and_set(struct tw_bitmap_atomic *bitmap,
+                                   uint64_t pos);
+
+/**
+ * Test a position in `struct tw_bitmap_atomic` and clear the position
+ * afterward, as a single atomic operation. Of concurrent callers on an
+ * active position, exactly one observes `true`.
+ *
+ * @param bitmap non-null bitmap to test and clear position at
+ * @param pos position of the bit to test and clear, must be smaller than
+ *            `bitmap.size`
+ *
+ * @return `false` if pre-conditions are not met, otherwise return the value
+ *         pos in the bitmap before clearing it
+ *
+ * @note group:bitmap_atomic
+ */
+bool tw_bitmap_atomic_test_and_clear(struct tw_bitmap_atomic *bitmap,
+                                     uint64_t pos);
+
+/**
+ * Count the number of active bits in a `struct tw_bitmap_atomic`.
+ *
+ * @param bitmap non-null bitmap to count
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of active
+ *         bits, exact if no writer is concurrently modifying `bitmap`
+ *
+ * @note group:bitmap_atomic
+ */
+uint64_t tw_bitmap_atomic_count(const struct tw_bitmap_atomic *bitmap);
+
+/**
+ * Clear all bits of a `struct tw_bitmap_atomic`.
+ *
+ * @param bitmap non-null bitmap to zero, must not be concurrently modified
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to
+ *         `bitmap`
+ *
+ * @note group:bitmap_atomic
+ */
+struct tw_bitmap_atomic *tw_bitmap_atomic_zero(struct tw_bitmap_atomic *bitmap);
+
+/**
+ * Copy a `struct tw_bitmap_atomic` into a `struct tw_bitmap`, e.g. to use
+ * set operations once ingestion is done.
+ *
+ * @param src non-null bitmap to copy from, words are read atomically but
+ *            writers modifying `src` during the copy may or may not be
+ *            observed
+ * @param dst non-null bitmap to copy to, resized to the size of `src`, see
+ *            `tw_bitmap_resize`
+ *
+ * @return `NULL` if pre-conditions are not met or resizing failed, otherwise
+ *         a pointer to `dst`
+ *
+ * @note group:bitmap_atomic
+ */
+struct tw_bitmap *tw_bitmap_atomic_copy(const struct tw_bitmap_atomic *src,
+                                        struct tw_bitmap *dst);
+
+#endif /* TWIDDLE_BITMAP_ATOMIC_H */
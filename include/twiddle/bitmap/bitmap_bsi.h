@@ -0,0 +1,210 @@
+#ifndef TWIDDLE_BITMAP_BSI_H
+#define TWIDDLE_BITMAP_BSI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** maximal number of bits of the values stored in a bit-sliced index */
+#define TW_BITMAP_BSI_MAX_BITS 64
+
+struct tw_bitmap;
+
+/**
+ * bit-sliced index data structure
+ *
+ * A bit-sliced index stores an unsigned integer value per row, e.g. an
+ * attribute of the rows of a table, as one `struct tw_bitmap` per bit of the
+ * values: the `i`-th slice holds the rows whose value has its `i`-th bit set.
+ * An additional bitmap holds the rows having a value.
+ *
+ * Predicates on values, e.g. `value < x`, evaluate to bitmaps of rows with a
+ * pass over the slices using the set operations kernels of `struct
+ * tw_bitmap` (O'Neil & Quass, "Improved Query Performance with Variant
+ * Indexes"), and aggregates are computed from the active bits counts of the
+ * slices. Resulting bitmaps combine with other predicates with the usual set
+ * operations, and may be used as filters of further queries.
+ */
+struct tw_bitmap_bsi {
+  /** number of rows */
+  uint64_t size;
+  /** number of bits of the stored values, i.e. number of slices */
+  uint8_t bits;
+  /** rows holding a value */
+  struct tw_bitmap *exists;
+  /** `slices[i]` holds the rows whose value has its `i`-th bit set */
+  struct tw_bitmap *slices[TW_BITMAP_BSI_MAX_BITS];
+};
+
+/** comparison operators of `tw_bitmap_bsi_compare` */
+enum tw_bitmap_bsi_op {
+  /** `value < x` */
+  TW_BITMAP_BSI_LT,
+  /** `value <= x` */
+  TW_BITMAP_BSI_LE,
+  /** `value > x` */
+  TW_BITMAP_BSI_GT,
+  /** `value >= x` */
+  TW_BITMAP_BSI_GE,
+  /** `value == x` */
+  TW_BITMAP_BSI_EQ,
+  /** `value != x` */
+  TW_BITMAP_BSI_NE,
+};
+
+/**
+ * Creates a `struct tw_bitmap_bsi` with the requested number of rows and bits
+ * per value.
+ *
+ * @param size number of rows the index should hold, must be smaller or equal
+ *             than `TW_BITMAP_MAX_BITS`
+ * @param bits number of bits of the values, between
+ *             `[1, TW_BITMAP_BSI_MAX_BITS]`
+ *
+ * @return `NULL` if allocation failed, otherwise a pointer to the newly
+ *         allocated `struct tw_bitmap_bsi`
+ *
+ * @note group:bitmap_bsi
+ */
+struct tw_bitmap_bsi *tw_bitmap_bsi_new(uint64_t size, uint8_t bits);
+
+/**
+ * Free a `struct tw_bitmap_bsi`.
+ *
+ * @param bsi to free
+ *
+ * @note group:bitmap_bsi
+ */
+void tw_bitmap_bsi_free(struct tw_bitmap_bsi *bsi);
+
+/**
+ * Set the value of a row in a `struct tw_bitmap_bsi`.
+ *
+ * @param bsi non-null index to set the value
+ * @param row row of the value, must be smaller than `bsi.size`
+ * @param value value of the row, must fit in `bsi.bits` bits
+ *
+ * @note group:bitmap_bsi
+ */
+void tw_bitmap_bsi_set(struct tw_bitmap_bsi *bsi, uint64_t row,
+                       uint64_t value);
+
+/**
+ * Remove the value of a row in a `struct tw_bitmap_bsi`.
+ *
+ * @param bsi non-null index to remove the value
+ * @param row row of the value, must be smaller than `bsi.size`
+ *
+ * @note group:bitmap_bsi
+ */
+void tw_bitmap_bsi_clear(struct tw_bitmap_bsi *bsi, uint64_t row);
+
+/**
+ * Get the value of a row in a `struct tw_bitmap_bsi`.
+ *
+ * @param bsi non-null index to get the value
+ * @param row row of the value, must be smaller than `bsi.size`
+ * @param value non-null pointer to store the value
+ *
+ * @return `false` if pre-conditions are not met or the row has no value, in
+ *         which case `value` is left untouched, otherwise `true`
+ *
+ * @note group:bitmap_bsi
+ */
+bool tw_bitmap_bsi_get(const struct tw_bitmap_bsi *bsi, uint64_t row,
+                       uint64_t *value);
+
+/**
+ * Count the number of rows holding a value in a `struct tw_bitmap_bsi`.
+ *
+ * @param bsi non-null index to count the rows
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of rows
+ *         holding a value
+ *
+ * @note group:bitmap_bsi
+ */
+uint64_t tw_bitmap_bsi_count(const struct tw_bitmap_bsi *bsi);
+
+/**
+ * Compute the rows of a `struct tw_bitmap_bsi` whose value compares with `x`.
+ *
+ * The slices are visited from the most significant bit, maintaining the rows
+ * whose value is equal to `x` so far, thus the evaluation stops early once
+ * none is left.
+ *
+ * @param bsi non-null index to compare
+ * @param op comparison operator, `value op x`
+ * @param x value to compare with
+ * @param filter rows to consider, all rows if `NULL`, otherwise distinct from
+ *               `dst` and of the same size
+ * @param dst non-null bitmap to store the rows, of size `bsi.size`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed,
+ *         otherwise a pointer to `dst`
+ *
+ * @note group:bitmap_bsi
+ */
+struct tw_bitmap *tw_bitmap_bsi_compare(const struct tw_bitmap_bsi *bsi,
+                                        enum tw_bitmap_bsi_op op, uint64_t x,
+                                        const struct tw_bitmap *filter,
+                                        struct tw_bitmap *dst);
+
+/**
+ * Compute the rows of a `struct tw_bitmap_bsi` whose value is within
+ * `[lo, hi]`.
+ *
+ * @param bsi non-null index to compare
+ * @param lo lower bound, inclusive
+ * @param hi upper bound, inclusive
+ * @param filter rows to consider, all rows if `NULL`, otherwise distinct from
+ *               `dst` and of the same size
+ * @param dst non-null bitmap to store the rows, of size `bsi.size`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed,
+ *         otherwise a pointer to `dst`
+ *
+ * @note group:bitmap_bsi
+ */
+struct tw_bitmap *tw_bitmap_bsi_between(const struct tw_bitmap_bsi *bsi,
+                                        uint64_t lo, uint64_t hi,
+                                        const struct tw_bitmap *filter,
+                                        struct tw_bitmap *dst);
+
+/**
+ * Sum the values of rows of a `struct tw_bitmap_bsi`, as the weighted counts
+ * of active bits of the slices.
+ *
+ * @param bsi non-null index to sum
+ * @param filter rows to sum, all rows if `NULL`, otherwise of size
+ *               `bsi.size`
+ *
+ * @return `0` if pre-conditions are not met, otherwise the sum of the values
+ *         modulo 2^64
+ *
+ * @note group:bitmap_bsi
+ */
+uint64_t tw_bitmap_bsi_sum(const struct tw_bitmap_bsi *bsi,
+                           const struct tw_bitmap *filter);
+
+/**
+ * Compute the `k` rows of a `struct tw_bitmap_bsi` with the largest values.
+ * Rows tied on the `k`-th largest value are selected by increasing row.
+ *
+ * @param bsi non-null index to select the rows
+ * @param k number of rows to select, all rows holding a value are selected
+ *          if fewer
+ * @param filter rows to consider, all rows if `NULL`, otherwise distinct from
+ *               `dst` and of the same size
+ * @param dst non-null bitmap to store the rows, of size `bsi.size`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed,
+ *         otherwise a pointer to `dst`
+ *
+ * @note group:bitmap_bsi
+ */
+struct tw_bitmap *tw_bitmap_bsi_top_k(const struct tw_bitmap_bsi *bsi,
+                                      uint64_t k,
+                                      const struct tw_bitmap *filter,
+                                      struct tw_bitmap *dst);
+
+#endif /* TWIDDLE_BITMAP_BSI_H */
@@ -0,0 +1,111 @@
+#ifndef TWIDDLE_BITMAP_MMAP_H
+#define TWIDDLE_BITMAP_MMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <twiddle/bitmap/bitmap.h>
+
+/**
+ * number of bits streamed set operations process at once, the next chunk is
+ * read ahead while the current one is combined
+ */
+#define TW_BITMAP_MMAP_CHUNK (1UL << 27)
+
+/**
+ * File-backed `struct tw_bitmap`
+ *
+ * The bits of the bitmap are a memory mapping of a file, such that bitmaps
+ * larger than the physical memory are paged in on demand and persist without
+ * a load step. The file starts with a page-sized header holding the size and
+ * the number of active bits, followed by the bits.
+ *
+ * File-backed bitmaps are regular `struct tw_bitmap` and support all bitmap
+ * operations. They are released with `tw_bitmap_free`, which persists the
+ * header.
+ */
+
+/**
+ * Creates a file-backed `struct tw_bitmap` with the requested number of bits.
+ *
+ * The file is created, or truncated if it exists, as a sparse file: bits are
+ * not written until they are set.
+ *
+ * @param path non-null path of the file backing the bitmap
+ * @param size number of bits the bitmap should hold, must be smaller or equal
+ *             than `TW_BITMAP_MAX_BITS`
+ *
+ * @return `NULL` if the file or the mapping could not be created, otherwise a
+ *         pointer to the newly allocated `struct tw_bitmap`
+ *
+ * @note group:bitmap_mmap
+ */
+struct tw_bitmap *tw_bitmap_create_mmap(const char *path, uint64_t size);
+
+/**
+ * Opens a file-backed `struct tw_bitmap` created by `tw_bitmap_create_mmap`.
+ *
+ * If the file was not released properly, e.g. the process crashed, the
+ * number of active bits is recounted.
+ *
+ * @param path non-null path of the file backing the bitmap
+ * @param writable if `true` modifications are written to the file, otherwise
+ *                 the file is opened read only and modifications are private
+ *                 to the returned bitmap
+ *
+ * @return `NULL` if the file could not be opened or is not a bitmap file,
+ *         otherwise a pointer to the newly allocated `struct tw_bitmap`
+ *
+ * @note group:bitmap_mmap
+ */
+struct tw_bitmap *tw_bitmap_open_mmap(const char *path, bool writable);
+
+/**
+ * Write the header and modified bits of a file-backed `struct tw_bitmap` to
+ * its file.
+ *
+ * @param bitmap non-null file-backed bitmap to synchronize
+ *
+ * @return `false` if pre-conditions are not met or writing failed, otherwise
+ *         `true`
+ *
+ * @note group:bitmap_mmap
+ */
+bool tw_bitmap_sync_mmap(struct tw_bitmap *bitmap);
+
+/**
+ * Computes the union of bitmaps chunk by chunk, such that bitmaps larger than
+ * the physical memory are streamed sequentially instead of randomly paged.
+ *
+ * The result is identical to `tw_bitmap_union`, the bitmaps need not be
+ * file-backed.
+ *
+ * @param src non-null bitmap to union with
+ * @param dst non-null bitmap to store the union, grown to the size of `src`
+ *            if smaller, see `tw_bitmap_resize`, thus file-backed bitmaps
+ *            must be at least as large as `src`
+ *
+ * @return `NULL` if pre-conditions are not met or growing failed, otherwise a
+ *         pointer to `dst`
+ *
+ * @note group:bitmap_mmap
+ */
+struct tw_bitmap *tw_bitmap_union_mmap(const struct tw_bitmap *src,
+                                       struct tw_bitmap *dst);
+
+/**
+ * Computes the intersection of bitmaps chunk by chunk, see
+ * `tw_bitmap_union_mmap`.
+ *
+ * @param src non-null bitmap to intersect with
+ * @param dst non-null bitmap to store the intersection, its bits past the
+ *            size of `src` are cleared
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to `dst`
+ *
+ * @note group:bitmap_mmap
+ */
+struct tw_bitmap *tw_bitmap_intersection_mmap(const struct tw_bitmap *src,
+                                              struct tw_bitmap *dst);
+
+#endif /* TWIDDLE_BITMAP_MMAP_H */
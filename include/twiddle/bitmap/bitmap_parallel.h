@@ -0,0 +1,146 @@
+#ifndef TWIDDLE_BITMAP_PARALLEL_H
+#define TWIDDLE_BITMAP_PARALLEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/utils/thread_pool.h>
+
+/**
+ * minimal number of bits processed by a task, smaller bitmaps are not split
+ * since waking threads would cost more than the operation
+ */
+#define TW_BITMAP_PARALLEL_MIN_CHUNK (1UL << 24)
+
+/**
+ * number of tasks per thread of the pool, more tasks balance threads slowed
+ * down by remote memory or preemption
+ */
+#define TW_BITMAP_PARALLEL_TASKS_PER_THREAD 4
+
+/**
+ * Multi-threaded operations on `struct tw_bitmap`
+ *
+ * A single thread does not saturate the memory bandwidth of a socket, let
+ * alone of multiple NUMA nodes. The following operations split the bitmap in
+ * chunks processed by the threads of a `struct tw_thread_pool`, each chunk
+ * with the SIMD kernels of the serial operation. Per-chunk counts are summed,
+ * thus results, including `count`, are identical to the serial operations.
+ *
+ * Bitmaps allocated with `TW_ALLOC_INTERLEAVE`, or zeroed with
+ * `tw_bitmap_zero_parallel` on first use, spread their pages on the nodes of
+ * the threads.
+ */
+
+/**
+ * Computes the union of bitmaps with a pool of threads, see
+ * `tw_bitmap_union`.
+ *
+ * @param src non-null bitmap to union with
+ * @param dst non-null bitmap to store the union, grown to the size of `src` if
+ *            smaller, see `tw_bitmap_resize`
+ * @param pool non-null pool executing the operation
+ *
+ * @return `NULL` if pre-conditions are not met or growing failed, otherwise
+ *         a pointer to `dst`
+ *
+ * @note group:bitmap_parallel
+ */
+struct tw_bitmap *tw_bitmap_union_parallel(const struct tw_bitmap *src,
+                                           struct tw_bitmap *dst,
+                                           struct tw_thread_pool *pool);
+
+/**
+ * Computes the intersection of bitmaps with a pool of threads, see
+ * `tw_bitmap_intersection`.
+ *
+ * @param src non-null bitmap to intersect with, bits past its size are
+ *            cleared from `dst`
+ * @param dst non-null bitmap to store the intersection
+ * @param pool non-null pool executing the operation
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to `dst`
+ *
+ * @note group:bitmap_parallel
+ */
+struct tw_bitmap *tw_bitmap_intersection_parallel(const struct tw_bitmap *src,
+                                                  struct tw_bitmap *dst,
+                                                  struct tw_thread_pool *pool);
+
+/**
+ * Computes the xor of bitmaps with a pool of threads, see `tw_bitmap_xor`.
+ *
+ * @param src non-null bitmap to xor with
+ * @param dst non-null bitmap to store the xor, grown to the size of `src` if
+ *            smaller, see `tw_bitmap_resize`
+ * @param pool non-null pool executing the operation
+ *
+ * @return `NULL` if pre-conditions are not met or growing failed, otherwise
+ *         a pointer to `dst`
+ *
+ * @note group:bitmap_parallel
+ */
+struct tw_bitmap *tw_bitmap_xor_parallel(const struct tw_bitmap *src,
+                                         struct tw_bitmap *dst,
+                                         struct tw_thread_pool *pool);
+
+/**
+ * Negate all bits of a bitmap with a pool of threads, see `tw_bitmap_not`.
+ *
+ * @param bitmap non-null bitmap to negate
+ * @param pool non-null pool executing the operation
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to
+ *         `bitmap`
+ *
+ * @note group:bitmap_parallel
+ */
+struct tw_bitmap *tw_bitmap_not_parallel(struct tw_bitmap *bitmap,
+                                         struct tw_thread_pool *pool);
+
+/**
+ * Verify if bitmaps are equal with a pool of threads, bits past the size of
+ * the smaller bitmap are compared as cleared, see `tw_bitmap_equal`.
+ *
+ * @param fst non-null first bitmap to check
+ * @param snd non-null second bitmap to check
+ * @param pool non-null pool executing the operation
+ *
+ * @return `true` if equal, `false` if not or pre-conditions are not met
+ *
+ * @note group:bitmap_parallel
+ */
+bool tw_bitmap_equal_parallel(const struct tw_bitmap *fst,
+                              const struct tw_bitmap *snd,
+                              struct tw_thread_pool *pool);
+
+/**
+ * Clear all bits of a bitmap with a pool of threads, see `tw_bitmap_zero`.
+ *
+ * @param bitmap non-null bitmap to zero
+ * @param pool non-null pool executing the operation
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to
+ *         `bitmap`
+ *
+ * @note group:bitmap_parallel
+ */
+struct tw_bitmap *tw_bitmap_zero_parallel(struct tw_bitmap *bitmap,
+                                          struct tw_thread_pool *pool);
+
+/**
+ * Set all bits of a bitmap with a pool of threads, see `tw_bitmap_fill`.
+ *
+ * @param bitmap non-null bitmap to fill
+ * @param pool non-null pool executing the operation
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to
+ *         `bitmap`
+ *
+ * @note group:bitmap_parallel
+ */
+struct tw_bitmap *tw_bitmap_fill_parallel(struct tw_bitmap *bitmap,
+                                          struct tw_thread_pool *pool);
+
+#endif /* TWIDDLE_BITMAP_PARALLEL_H */
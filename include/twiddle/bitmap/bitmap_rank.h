@@ -0,0 +1,121 @@
+#ifndef TWIDDLE_BITMAP_RANK_H
+#define TWIDDLE_BITMAP_RANK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <twiddle/bitmap/bitmap.h>
+
+/** number of active bits between select samples */
+#define TW_BITMAP_RANK_SAMPLE 512
+
+/**
+ * rank/select index over a `struct tw_bitmap`
+ *
+ * The index follows the rank9 layout [1]: for every block of 512 bits, it
+ * stores the number of active bits preceding the block and the 7 cumulative
+ * counts of the block's words packed as 9 bits integers. Rank queries are thus
+ * a constant number of memory accesses. Select queries start from a sampled
+ * block, every `TW_BITMAP_RANK_SAMPLE` active bits, and binary search the
+ * blocks up to the next sample.
+ *
+ * The index takes 25% of the bitmap's memory, plus one word per
+ * `TW_BITMAP_RANK_SAMPLE` active bits.
+ *
+ * Modifying the bitmap invalidates the index, which is transparently rebuilt
+ * by the next query. Rebuilding is a linear scan of the bitmap.
+ *
+ * [1] Vigna, Sebastiano. "Broadword implementation of rank/select queries."
+ *     International Workshop on Experimental and Efficient Algorithms (2008).
+ */
+struct tw_bitmap_rank {
+  /** indexed bitmap */
+  const struct tw_bitmap *bitmap;
+  /** generation of `bitmap` the index was built from */
+  uint64_t generation;
+  /** number of 512 bits blocks in `bitmap` */
+  uint64_t n_blocks;
+  /** per block, number of preceding active bits and packed word counts */
+  uint64_t *blocks;
+  /** number of samples */
+  uint64_t n_samples;
+  /** number of allocated samples */
+  uint64_t samples_size;
+  /** per `TW_BITMAP_RANK_SAMPLE` active bits, the block holding it */
+  uint64_t *samples;
+};
+
+/**
+ * Creates a `struct tw_bitmap_rank` indexing a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to index, it must outlive the index
+ *
+ * @return `NULL` if allocation failed, otherwise a pointer to the newly
+ *         allocated `struct tw_bitmap_rank`
+ *
+ * @note group:bitmap_rank
+ */
+struct tw_bitmap_rank *tw_bitmap_rank_new(const struct tw_bitmap *bitmap);
+
+/**
+ * Free a `struct tw_bitmap_rank`.
+ *
+ * @param rank to free
+ *
+ * @note group:bitmap_rank
+ */
+void tw_bitmap_rank_free(struct tw_bitmap_rank *rank);
+
+/**
+ * Verify if a `struct tw_bitmap_rank` must be rebuilt since its bitmap was
+ * modified.
+ *
+ * @param rank non-null index to verify
+ *
+ * @return `false` if pre-conditions are not met or the index is up to date,
+ *         otherwise `true`
+ *
+ * @note group:bitmap_rank
+ */
+bool tw_bitmap_rank_stale(const struct tw_bitmap_rank *rank);
+
+/**
+ * Rebuild a `struct tw_bitmap_rank` if its bitmap was modified.
+ *
+ * @param rank non-null index to rebuild
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed, otherwise
+ *         a pointer to `rank`
+ *
+ * @note group:bitmap_rank
+ */
+struct tw_bitmap_rank *tw_bitmap_rank_update(struct tw_bitmap_rank *rank);
+
+/**
+ * Count the active bits preceding a position, i.e. rank(pos).
+ *
+ * @param rank non-null index, rebuilt if stale
+ * @param pos position to count up to, exclusive
+ *
+ * @return `-1` if pre-conditions are not met or rebuilding failed, otherwise
+ *         the number of active bits in `[0, pos)`
+ *
+ * @note group:bitmap_rank
+ */
+int64_t tw_bitmap_rank_count(struct tw_bitmap_rank *rank, uint64_t pos);
+
+/**
+ * Find the position of the k-th active bit, i.e. select(k).
+ *
+ * @param rank non-null index, rebuilt if stale
+ * @param k zero-based rank of the active bit
+ *
+ * @return `-1` if pre-conditions are not met, rebuilding failed or there are
+ *         less than `k + 1` active bits, otherwise the position of the active
+ *         bit with `k` active bits preceding it
+ *
+ * @note group:bitmap_rank
+ */
+int64_t tw_bitmap_rank_select(struct tw_bitmap_rank *rank, uint64_t k);
+
+#endif /* TWIDDLE_BITMAP_RANK_H */
@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+struct tw_bitmap;
+
 struct tw_bitmap_rle_word {
   uint64_t pos;
   uint64_t count;
@@ -282,4 +284,82 @@ struct tw_bitmap_rle *tw_bitmap_rle_intersection(const struct tw_bitmap_rle *a,
                                                  const struct tw_bitmap_rle *b,
                                                  struct tw_bitmap_rle *dst);
 
+/**
+ * Verify if `struct tw_bitmap_rle`s share an active bit. Runs are walked in
+ * order until the first overlapping pair.
+ *
+ * @param a non-null first bitmap to check
+ * @param b non-null second bitmap to check of same size as `a`
+ *
+ * @return `false` if pre-conditions are not met or bitmaps are disjoint,
+ *         otherwise `true`
+ *
+ * @note group:bitmap_rle
+ */
+bool tw_bitmap_rle_intersects(const struct tw_bitmap_rle *a,
+                              const struct tw_bitmap_rle *b);
+
+/**
+ * Verify if `struct tw_bitmap_rle`s share no active bit, see
+ * `tw_bitmap_rle_intersects`.
+ *
+ * @param a non-null first bitmap to check
+ * @param b non-null second bitmap to check of same size as `a`
+ *
+ * @return `false` if pre-conditions are not met or bitmaps intersect,
+ *         otherwise `true`
+ *
+ * @note group:bitmap_rle
+ */
+bool tw_bitmap_rle_is_disjoint(const struct tw_bitmap_rle *a,
+                               const struct tw_bitmap_rle *b);
+
+/**
+ * Verify if the active bits of a `struct tw_bitmap_rle` are active in
+ * another. Runs are walked in order until the first run of `a` not covered
+ * by `b`.
+ *
+ * @param a non-null bitmap to check
+ * @param b non-null bitmap to check against of same size as `a`
+ *
+ * @return `false` if pre-conditions are not met or `a` is not a subset of
+ *         `b`, otherwise `true`
+ *
+ * @note group:bitmap_rle
+ */
+bool tw_bitmap_rle_is_subset(const struct tw_bitmap_rle *a,
+                             const struct tw_bitmap_rle *b);
+
+/**
+ * Convert a dense `struct tw_bitmap` in a `struct tw_bitmap_rle`.
+ *
+ * Run boundaries are found a word at a time, words without boundaries are
+ * skipped a vector at a time, thus the conversion is linear in the number of
+ * words holding boundaries rather than in the number of bits.
+ *
+ * @param src non-null bitmap to convert
+ * @param dst non-null bitmap to store the first `dst.size` bits of `src`,
+ *            `dst.size` must be smaller or equal than `src.size`
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to `dst`
+ *
+ * @note group:bitmap_rle
+ */
+struct tw_bitmap_rle *tw_bitmap_to_rle(const struct tw_bitmap *src,
+                                       struct tw_bitmap_rle *dst);
+
+/**
+ * Convert a `struct tw_bitmap_rle` in a dense `struct tw_bitmap`.
+ *
+ * @param src non-null bitmap to convert
+ * @param dst non-null bitmap to store the bits of `src`, zeroed beforehand,
+ *            `src.size` must be smaller or equal than `dst.size`
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to `dst`
+ *
+ * @note group:bitmap_rle
+ */
+struct tw_bitmap *tw_bitmap_rle_to_bitmap(const struct tw_bitmap_rle *src,
+                                          struct tw_bitmap *dst);
+
 #endif /* TWIDDLE_BITMAP_RLE_H */
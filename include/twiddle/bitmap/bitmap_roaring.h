@@ -0,0 +1,268 @@
+#ifndef TWIDDLE_BITMAP_ROARING_H
+#define TWIDDLE_BITMAP_ROARING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** number of bits covered by a container, its positions share upper bits */
+#define TW_BITMAP_ROARING_CONTAINER_BITS (1UL << 16)
+
+/** maximal number of active bits of an array container */
+#define TW_BITMAP_ROARING_ARRAY_MAX 4096
+
+struct tw_bitmap_roaring_container;
+
+/**
+ * roaring bitmap data structure
+ *
+ * Roaring bitmaps are compressed bitmaps adapting to the local density of
+ * active bits. Positions are partitioned in chunks of
+ * `TW_BITMAP_ROARING_CONTAINER_BITS` bits, and each non-empty chunk is stored
+ * in a container of one of the following kinds:
+ *
+ *  - array: sorted offsets of the active bits, for sparse chunks holding at
+ *    most `TW_BITMAP_ROARING_ARRAY_MAX` bits;
+ *  - bitset: a `struct tw_bitmap`, for dense chunks, combined with the SIMD
+ *    kernels of dense bitmaps;
+ *  - run: a `struct tw_bitmap_rle`, for chunks made of long runs, see
+ *    `tw_bitmap_roaring_optimize`.
+ *
+ * Unlike `struct tw_bitmap_rle`, positions can be set and cleared in any
+ * order. Containers change kind as their number of active bits crosses
+ * `TW_BITMAP_ROARING_ARRAY_MAX`.
+ */
+struct tw_bitmap_roaring {
+  /** storage capacity in bits */
+  uint64_t size;
+  /** number of active bits */
+  uint64_t count;
+  /** number of non-empty containers in @containers */
+  uint64_t n_containers;
+  /** number of allocated containers in @containers */
+  uint64_t alloc_containers;
+  /** containers sorted by increasing positions */
+  struct tw_bitmap_roaring_container *containers;
+};
+
+/**
+ * Creates a `struct tw_bitmap_roaring` with the requested number of bits.
+ *
+ * @param size number of bits the bitmap should hold, must be smaller or
+ *             equal than `TW_BITMAP_MAX_BITS`.
+ *
+ * @return `NULL` if allocation failed, otherwise a pointer to the newly
+ *         allocated `struct tw_bitmap_roaring`
+ *
+ * @note group:bitmap_roaring
+ */
+struct tw_bitmap_roaring *tw_bitmap_roaring_new(uint64_t size);
+
+/**
+ * Free a `struct tw_bitmap_roaring`.
+ *
+ * @param bitmap to free
+ *
+ * @note group:bitmap_roaring
+ */
+void tw_bitmap_roaring_free(struct tw_bitmap_roaring *bitmap);
+
+/**
+ * Copy a source bitmap into a specified bitmap.
+ *
+ * @param src non-null bitmap to copy from
+ * @param dst non-null bitmap to copy to, of the same size as `src`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed, in which
+ *         case `dst` is left untouched, otherwise a pointer to `dst`
+ *
+ * @note group:bitmap_roaring
+ */
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_copy(const struct tw_bitmap_roaring *src,
+                       struct tw_bitmap_roaring *dst);
+
+/**
+ * Clone a bitmap into a new allocated bitmap.
+ *
+ * @param bitmap non-null bitmap to clone
+ *
+ * @return `NULL` if failed, otherwise a newly allocated bitmap initialized
+ *         from the requested bitmap
+ *
+ * @note group:bitmap_roaring
+ */
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_clone(const struct tw_bitmap_roaring *bitmap);
+
+/**
+ * Set position in a `struct tw_bitmap_roaring`.
+ *
+ * @param bitmap non-null bitmap to set the position
+ * @param pos position of the bit to set, must be smaller than `bitmap.size'
+ *
+ * @note group:bitmap_roaring
+ */
+void tw_bitmap_roaring_set(struct tw_bitmap_roaring *bitmap, uint64_t pos);
+
+/**
+ * Clear position in a `struct tw_bitmap_roaring`.
+ *
+ * @param bitmap non-null bitmap to clear the position
+ * @param pos position of the bit to clear, must be smaller than
+ *            `bitmap.size'
+ *
+ * @note group:bitmap_roaring
+ */
+void tw_bitmap_roaring_clear(struct tw_bitmap_roaring *bitmap, uint64_t pos);
+
+/**
+ * Test a position in a `struct tw_bitmap_roaring`.
+ *
+ * @param bitmap non-null bitmap to test position at
+ * @param pos position of the bit to test, must be smaller than `bitmap.size'
+ *
+ * @return `false` if pre-conditions are not met, otherwise return the value
+ *         pos in the bitmap
+ *
+ * @note group:bitmap_roaring
+ */
+bool tw_bitmap_roaring_test(const struct tw_bitmap_roaring *bitmap,
+                            uint64_t pos);
+
+/**
+ * Verify if a `struct tw_bitmap_roaring` is empty.
+ *
+ * @param bitmap non-null bitmap to verify emptyness
+ *
+ * @return `false` if pre-conditions are not met, otherwise indicator if the
+ *         bitmap is empty
+ *
+ * @note group:bitmap_roaring
+ */
+bool tw_bitmap_roaring_empty(const struct tw_bitmap_roaring *bitmap);
+
+/**
+ * Count the number of active bits in a `struct tw_bitmap_roaring`.
+ *
+ * @param bitmap non-null bitmap to count the number of active bits
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of active
+ *         bits.
+ *
+ * @note group:bitmap_roaring
+ */
+uint64_t tw_bitmap_roaring_count(const struct tw_bitmap_roaring *bitmap);
+
+/**
+ * Clear all bits in a `struct tw_bitmap_roaring`, releasing its containers.
+ *
+ * @param bitmap non-null bitmap to clear
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise `bitmap' with
+ *         zeroed bits.
+ *
+ * @note group:bitmap_roaring
+ */
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_zero(struct tw_bitmap_roaring *bitmap);
+
+/**
+ * Convert containers to run containers when smaller, and run containers back
+ * to array or bitset containers otherwise.
+ *
+ * Runs are not maintained by `tw_bitmap_roaring_set` and
+ * `tw_bitmap_roaring_clear`, this is meant to be called once a bitmap is
+ * built, e.g. before storing it or intersecting it repeatedly.
+ *
+ * @param bitmap non-null bitmap to optimize
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to
+ *         `bitmap`
+ *
+ * @note group:bitmap_roaring
+ */
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_optimize(struct tw_bitmap_roaring *bitmap);
+
+/**
+ * Verify if `struct tw_bitmap_roaring`s are equal, regardless of the kind of
+ * their containers.
+ *
+ * @param fst non-null first bitmap to check
+ * @param snd non-null second bitmap to check
+ *
+ * @return `false` if pre-conditions are not met or bitmaps are not equal,
+ *         otherwise `true`
+ *
+ * @note group:bitmap_roaring
+ */
+bool tw_bitmap_roaring_equal(const struct tw_bitmap_roaring *fst,
+                             const struct tw_bitmap_roaring *snd);
+
+/**
+ * Compute the union of `struct tw_bitmap_roaring`s.
+ *
+ * @param src non-null bitmap to union with
+ * @param dst non-null bitmap to store the union, of the same size as `src`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed, in which
+ *         case `dst` is valid but its content unspecified, otherwise a
+ *         pointer to `dst`
+ *
+ * @note group:bitmap_roaring
+ */
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_union(const struct tw_bitmap_roaring *src,
+                        struct tw_bitmap_roaring *dst);
+
+/**
+ * Compute the intersection of `struct tw_bitmap_roaring`s.
+ *
+ * @param src non-null bitmap to intersect with
+ * @param dst non-null bitmap to store the intersection, of the same size as
+ *            `src`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed, in which
+ *         case `dst` is valid but its content unspecified, otherwise a
+ *         pointer to `dst`
+ *
+ * @note group:bitmap_roaring
+ */
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_intersection(const struct tw_bitmap_roaring *src,
+                               struct tw_bitmap_roaring *dst);
+
+/**
+ * Compute the symmetric difference of `struct tw_bitmap_roaring`s.
+ *
+ * @param src non-null bitmap to xor with
+ * @param dst non-null bitmap to store the xor, of the same size as `src`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed, in which
+ *         case `dst` is valid but its content unspecified, otherwise a
+ *         pointer to `dst`
+ *
+ * @note group:bitmap_roaring
+ */
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_xor(const struct tw_bitmap_roaring *src,
+                      struct tw_bitmap_roaring *dst);
+
+/**
+ * Clear in `dst` the active bits of `src`, i.e. `dst = dst AND NOT src`.
+ *
+ * @param src non-null bitmap of the bits to clear
+ * @param dst non-null bitmap to store the difference, of the same size as
+ *            `src`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed, in which
+ *         case `dst` is valid but its content unspecified, otherwise a
+ *         pointer to `dst`
+ *
+ * @note group:bitmap_roaring
+ */
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_andnot(const struct tw_bitmap_roaring *src,
+                         struct tw_bitmap_roaring *dst);
+
+#endif /* TWIDDLE_BITMAP_ROARING_H */
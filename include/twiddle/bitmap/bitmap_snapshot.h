@@ -0,0 +1,81 @@
+#ifndef TWIDDLE_BITMAP_SNAPSHOT_H
+#define TWIDDLE_BITMAP_SNAPSHOT_H
+
+#include <stdint.h>
+
+#include <twiddle/bitmap/bitmap.h>
+
+/**
+ * number of bytes shared between a bitmap and its snapshots as a unit, and
+ * thus copied on the first write, a multiple of pages
+ */
+#define TW_BITMAP_SNAPSHOT_CHUNK (1UL << 21)
+
+/**
+ * Copy-on-write snapshots of `struct tw_bitmap`
+ *
+ * The bits of a shared bitmap are mapped from chunks of a memory file, such
+ * that a snapshot maps the same chunks instead of copying them: taking a
+ * snapshot costs a few system calls per `TW_BITMAP_SNAPSHOT_CHUNK` bytes,
+ * whatever the number of bits. Chunks are reference counted, the first write
+ * to a chunk mapped by more than one bitmap copies it to a new chunk of the
+ * file, which replaces it in the written bitmap only. The cost of snapshots
+ * is thus proportional to the chunks modified afterward, by either side.
+ *
+ * Shared bitmaps and snapshots are regular `struct tw_bitmap`, writable and
+ * supporting all bitmap operations but resizing. They are released with
+ * `tw_bitmap_free`, and `tw_bitmap_clone` of a shared bitmap copies its bits
+ * like any other. A bitmap and its snapshots may be used and freed by different
+ * threads, e.g. a writer publishing consistent snapshots to readers, each
+ * bitmap requiring exclusive access for writes as usual.
+ *
+ * Writes fail, as if pre-conditions were not met, when a shared chunk cannot
+ * be copied, e.g. the memory is exhausted.
+ */
+
+/**
+ * Creates a shared `struct tw_bitmap` with the requested number of bits, see
+ * `tw_bitmap_snapshot`.
+ *
+ * @param size number of bits the bitmap should hold, must be smaller or equal
+ *             than `TW_BITMAP_MAX_BITS`
+ *
+ * @return `NULL` if allocation failed, otherwise a pointer to the newly
+ *         allocated `struct tw_bitmap`
+ *
+ * @note group:bitmap_snapshot
+ */
+struct tw_bitmap *tw_bitmap_new_shared(uint64_t size);
+
+/**
+ * Take a copy-on-write snapshot of a `struct tw_bitmap`.
+ *
+ * Bitmaps not created by `tw_bitmap_new_shared`, or as a snapshot, have their
+ * bits moved to a memory file by the first snapshot, which is thus a copy.
+ * Their bits are then remapped, invalidating pointers to them.
+ *
+ * @param bitmap non-null bitmap to snapshot, it must neither be file-backed
+ *               nor wrapped, see `tw_bitmap_wrap`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed,
+ *         otherwise a pointer to a newly allocated `struct tw_bitmap` holding
+ *         the bits of `bitmap`
+ *
+ * @note group:bitmap_snapshot
+ */
+struct tw_bitmap *tw_bitmap_snapshot(struct tw_bitmap *bitmap);
+
+/**
+ * Number of bytes of a `struct tw_bitmap` shared with other bitmaps, i.e. not
+ * copied since the last snapshot.
+ *
+ * @param bitmap non-null bitmap
+ *
+ * @return `0` if pre-conditions are not met or the bitmap is not shared,
+ *         otherwise the number of shared bytes, a multiple of chunks
+ *
+ * @note group:bitmap_snapshot
+ */
+uint64_t tw_bitmap_shared_size(const struct tw_bitmap *bitmap);
+
+#endif /* TWIDDLE_BITMAP_SNAPSHOT_H */
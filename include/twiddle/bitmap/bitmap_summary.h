@@ -0,0 +1,206 @@
+#ifndef TWIDDLE_BITMAP_SUMMARY_H
+#define TWIDDLE_BITMAP_SUMMARY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <twiddle/bitmap/bitmap.h>
+
+/** maximal number of levels, enough for `TW_BITMAP_MAX_BITS` bits */
+#define TW_BITMAP_SUMMARY_MAX_LEVELS 7
+
+/**
+ * hierarchical summary over a `struct tw_bitmap`
+ *
+ * The summary holds two hierarchies of bitmaps. In the first level, a bit per
+ * word of the bitmap tells if the word holds a zero, respectively an active
+ * bit. Each further level has a bit per word of the level below, up to a last
+ * level fitting in a single word: 64 words of the bitmap per bit of the first
+ * level, 4096 per bit of the second, and so on.
+ *
+ * Searching a zero or an active bit descends the hierarchy from the first
+ * word having one, skipping full or empty regions in a logarithmic number of
+ * steps instead of a linear scan. This makes the bitmap usable as an
+ * allocator of identifiers, see `tw_bitmap_summary_alloc_id`.
+ *
+ * Writes through the summary maintain it incrementally, by walking up the
+ * levels as long as a word changes from or to zero. Modifying the bitmap
+ * directly invalidates the summary, which is transparently rebuilt by the
+ * next operation. Rebuilding is a linear scan of the bitmap.
+ *
+ * The summary takes about 3% of the bitmap's memory.
+ */
+struct tw_bitmap_summary {
+  /** summarized bitmap */
+  struct tw_bitmap *bitmap;
+  /** generation of `bitmap` the summary was maintained to */
+  uint64_t generation;
+  /** size of `bitmap` the levels were allocated for */
+  uint64_t size;
+  /** number of levels */
+  uint8_t levels;
+  /** number of words of each level */
+  uint64_t words[TW_BITMAP_SUMMARY_MAX_LEVELS];
+  /** `zeros[l]` has a bit per word of the level below holding a zero */
+  uint64_t *zeros[TW_BITMAP_SUMMARY_MAX_LEVELS];
+  /** `ones[l]` has a bit per word of the level below holding an active bit */
+  uint64_t *ones[TW_BITMAP_SUMMARY_MAX_LEVELS];
+  /** storage of the levels of both hierarchies */
+  uint64_t *data;
+};
+
+/**
+ * Creates a `struct tw_bitmap_summary` over a `struct tw_bitmap`.
+ *
+ * @param bitmap non-null bitmap to summarize, it must outlive the summary
+ *
+ * @return `NULL` if allocation failed, otherwise a pointer to the newly
+ *         allocated `struct tw_bitmap_summary`
+ *
+ * @note group:bitmap_summary
+ */
+struct tw_bitmap_summary *tw_bitmap_summary_new(struct tw_bitmap *bitmap);
+
+/**
+ * Free a `struct tw_bitmap_summary`. The summarized bitmap is left untouched.
+ *
+ * @param summary to free
+ *
+ * @note group:bitmap_summary
+ */
+void tw_bitmap_summary_free(struct tw_bitmap_summary *summary);
+
+/**
+ * Verify if a `struct tw_bitmap_summary` must be rebuilt since its bitmap was
+ * modified directly.
+ *
+ * @param summary non-null summary to verify
+ *
+ * @return `false` if pre-conditions are not met or the summary is up to date,
+ *         otherwise `true`
+ *
+ * @note group:bitmap_summary
+ */
+bool tw_bitmap_summary_stale(const struct tw_bitmap_summary *summary);
+
+/**
+ * Rebuild a `struct tw_bitmap_summary` if its bitmap was modified directly.
+ *
+ * @param summary non-null summary to rebuild
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed, otherwise
+ *         a pointer to `summary`
+ *
+ * @note group:bitmap_summary
+ */
+struct tw_bitmap_summary *
+tw_bitmap_summary_update(struct tw_bitmap_summary *summary);
+
+/**
+ * Set a bit in the bitmap of a `struct tw_bitmap_summary`.
+ *
+ * @param summary non-null summary, rebuilt if stale
+ * @param pos position of the bit, must be smaller than `bitmap.size`
+ *
+ * @return `false` if pre-conditions are not met or rebuilding failed,
+ *         otherwise `true`
+ *
+ * @note group:bitmap_summary
+ */
+bool tw_bitmap_summary_set(struct tw_bitmap_summary *summary, uint64_t pos);
+
+/**
+ * Clear a bit in the bitmap of a `struct tw_bitmap_summary`.
+ *
+ * @param summary non-null summary, rebuilt if stale
+ * @param pos position of the bit, must be smaller than `bitmap.size`
+ *
+ * @return `false` if pre-conditions are not met or rebuilding failed,
+ *         otherwise `true`
+ *
+ * @note group:bitmap_summary
+ */
+bool tw_bitmap_summary_clear(struct tw_bitmap_summary *summary, uint64_t pos);
+
+/**
+ * Find the first zero at or after a position in the bitmap of a
+ * `struct tw_bitmap_summary`, in a logarithmic number of steps.
+ *
+ * @param summary non-null summary, rebuilt if stale
+ * @param from first position to consider
+ *
+ * @return `-1` if not found, pre-conditions are not met or rebuilding failed,
+ *         otherwise the bit position
+ *
+ * @note group:bitmap_summary
+ */
+int64_t tw_bitmap_summary_find_next_zero(struct tw_bitmap_summary *summary,
+                                         uint64_t from);
+
+/**
+ * Find the first zero in the bitmap of a `struct tw_bitmap_summary`.
+ *
+ * @param summary non-null summary, rebuilt if stale
+ *
+ * @return `-1` if not found, pre-conditions are not met or rebuilding failed,
+ *         otherwise the bit position
+ *
+ * @note group:bitmap_summary
+ */
+int64_t tw_bitmap_summary_find_first_zero(struct tw_bitmap_summary *summary);
+
+/**
+ * Find the first active bit at or after a position in the bitmap of a
+ * `struct tw_bitmap_summary`, in a logarithmic number of steps.
+ *
+ * @param summary non-null summary, rebuilt if stale
+ * @param from first position to consider
+ *
+ * @return `-1` if not found, pre-conditions are not met or rebuilding failed,
+ *         otherwise the bit position
+ *
+ * @note group:bitmap_summary
+ */
+int64_t tw_bitmap_summary_find_next_bit(struct tw_bitmap_summary *summary,
+                                        uint64_t from);
+
+/**
+ * Find the first active bit in the bitmap of a `struct tw_bitmap_summary`.
+ *
+ * @param summary non-null summary, rebuilt if stale
+ *
+ * @return `-1` if not found, pre-conditions are not met or rebuilding failed,
+ *         otherwise the bit position
+ *
+ * @note group:bitmap_summary
+ */
+int64_t tw_bitmap_summary_find_first_bit(struct tw_bitmap_summary *summary);
+
+/**
+ * Allocate the lowest free identifier, i.e. set the first zero of the bitmap
+ * of a `struct tw_bitmap_summary`.
+ *
+ * @param summary non-null summary, rebuilt if stale
+ *
+ * @return `-1` if every identifier is allocated, pre-conditions are not met
+ *         or rebuilding failed, otherwise the allocated identifier
+ *
+ * @note group:bitmap_summary
+ */
+int64_t tw_bitmap_summary_alloc_id(struct tw_bitmap_summary *summary);
+
+/**
+ * Free an identifier, i.e. clear its bit in the bitmap of a
+ * `struct tw_bitmap_summary`.
+ *
+ * @param summary non-null summary, rebuilt if stale
+ * @param id identifier to free, must be smaller than `bitmap.size`
+ *
+ * @return `false` if pre-conditions are not met, rebuilding failed or `id`
+ *         was not allocated, otherwise `true`
+ *
+ * @note group:bitmap_summary
+ */
+bool tw_bitmap_summary_free_id(struct tw_bitmap_summary *summary, uint64_t id);
+
+#endif /* TWIDDLE_BITMAP_SUMMARY_H */
@@ -0,0 +1,234 @@
+#ifndef TWIDDLE_BITMATRIX_H
+#define TWIDDLE_BITMATRIX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <twiddle/bitmap/bitmap.h>
+
+/**
+ * number of rows combined per pass over the destination when expanding a
+ * frontier, see `tw_bitmatrix_expand`
+ */
+#define TW_BITMATRIX_EXPAND_BATCH 16
+
+/**
+ * dense matrix of bits
+ *
+ * Rows are stored contiguously, each padded to a multiple of cache lines
+ * such that a row is a regular `struct tw_bitmap` of `row_bits` bits, see
+ * `tw_bitmatrix_row`. Row operations thus use the SIMD kernels of bitmaps.
+ * Padding bits past `n_cols` are always cleared.
+ *
+ * The matrix is suited to bit-parallel graph algorithms on adjacency
+ * matrices, where row `i` holds the successors of vertex `i`: a breadth-first
+ * search expands a frontier with the union of its vertices' rows, see
+ * `tw_bitmatrix_expand`, and predecessors are the rows of the transpose, see
+ * `tw_bitmatrix_transpose`.
+ */
+struct tw_bitmatrix {
+  /** number of rows */
+  uint64_t n_rows;
+  /** number of columns */
+  uint64_t n_cols;
+  /** bits per row, `n_cols` rounded to a multiple of cache lines */
+  uint64_t row_bits;
+  /** rows of `row_bits` bits */
+  uint64_t *data;
+  /** size in bytes of the mapping holding `data`, `0` if heap allocated */
+  uint64_t mapping_size;
+};
+
+/**
+ * Creates a `struct tw_bitmatrix` with the requested dimensions, all bits
+ * cleared.
+ *
+ * @param n_rows number of rows, must be greater than 0
+ * @param n_cols number of columns, must be greater than 0
+ *
+ * @return `NULL` if pre-conditions are not met, the matrix would hold more
+ *         than `TW_BITMAP_MAX_BITS` bits or allocation failed, otherwise a
+ *         pointer to the newly allocated `struct tw_bitmatrix`
+ *
+ * @note group:bitmatrix
+ */
+struct tw_bitmatrix *tw_bitmatrix_new(uint64_t n_rows, uint64_t n_cols);
+
+/**
+ * Free a `struct tw_bitmatrix`.
+ *
+ * @param matrix to free
+ *
+ * @note group:bitmatrix
+ */
+void tw_bitmatrix_free(struct tw_bitmatrix *matrix);
+
+/**
+ * Set a bit in a `struct tw_bitmatrix`.
+ *
+ * @param matrix non-null matrix
+ * @param row row of the bit, must be smaller than `matrix.n_rows`
+ * @param col column of the bit, must be smaller than `matrix.n_cols`
+ *
+ * @note group:bitmatrix
+ */
+void tw_bitmatrix_set(struct tw_bitmatrix *matrix, uint64_t row, uint64_t col);
+
+/**
+ * Clear a bit in a `struct tw_bitmatrix`.
+ *
+ * @param matrix non-null matrix
+ * @param row row of the bit, must be smaller than `matrix.n_rows`
+ * @param col column of the bit, must be smaller than `matrix.n_cols`
+ *
+ * @note group:bitmatrix
+ */
+void tw_bitmatrix_clear(struct tw_bitmatrix *matrix, uint64_t row,
+                        uint64_t col);
+
+/**
+ * Verify if a bit is set in a `struct tw_bitmatrix`.
+ *
+ * @param matrix non-null matrix
+ * @param row row of the bit, must be smaller than `matrix.n_rows`
+ * @param col column of the bit, must be smaller than `matrix.n_cols`
+ *
+ * @return `false` if pre-conditions are not met or the bit is cleared,
+ *         otherwise `true`
+ *
+ * @note group:bitmatrix
+ */
+bool tw_bitmatrix_test(const struct tw_bitmatrix *matrix, uint64_t row,
+                       uint64_t col);
+
+/**
+ * Initialize a `struct tw_bitmap` viewing a row of a `struct tw_bitmatrix`,
+ * such that any read-only bitmap operation applies to the row. Writes through
+ * the view modify the matrix, and must leave the padding bits cleared. The
+ * view must not be freed, and operations resizing it fail, e.g. the union
+ * with a larger bitmap.
+ *
+ * @param matrix non-null matrix
+ * @param row row to view, must be smaller than `matrix.n_rows`
+ * @param view non-null bitmap to initialize, of `matrix.row_bits` bits
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to `view`
+ *
+ * @note group:bitmatrix
+ */
+struct tw_bitmap *tw_bitmatrix_row(const struct tw_bitmatrix *matrix,
+                                   uint64_t row, struct tw_bitmap *view);
+
+/**
+ * Compute the union of two rows of a `struct tw_bitmatrix`, stored in the
+ * destination row.
+ *
+ * @param matrix non-null matrix
+ * @param src source row, must be smaller than `matrix.n_rows`
+ * @param dst destination row, must be smaller than `matrix.n_rows`
+ *
+ * @return `false` if pre-conditions are not met, otherwise `true`
+ *
+ * @note group:bitmatrix
+ */
+bool tw_bitmatrix_row_union(struct tw_bitmatrix *matrix, uint64_t src,
+                            uint64_t dst);
+
+/**
+ * Compute the intersection of two rows of a `struct tw_bitmatrix`, stored in
+ * the destination row.
+ *
+ * @param matrix non-null matrix
+ * @param src source row, must be smaller than `matrix.n_rows`
+ * @param dst destination row, must be smaller than `matrix.n_rows`
+ *
+ * @return `false` if pre-conditions are not met, otherwise `true`
+ *
+ * @note group:bitmatrix
+ */
+bool tw_bitmatrix_row_intersection(struct tw_bitmatrix *matrix, uint64_t src,
+                                   uint64_t dst);
+
+/**
+ * Count the active bits of a row of a `struct tw_bitmatrix`, e.g. the
+ * out-degree of a vertex.
+ *
+ * @param matrix non-null matrix
+ * @param row row to count, must be smaller than `matrix.n_rows`
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of active
+ *         bits of the row
+ *
+ * @note group:bitmatrix
+ */
+uint64_t tw_bitmatrix_row_count(const struct tw_bitmatrix *matrix,
+                                uint64_t row);
+
+/**
+ * Count the active bits of a column of a `struct tw_bitmatrix`, e.g. the
+ * in-degree of a vertex. Columns are strided, see `tw_bitmatrix_col_counts`
+ * to count all columns.
+ *
+ * @param matrix non-null matrix
+ * @param col column to count, must be smaller than `matrix.n_cols`
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of active
+ *         bits of the column
+ *
+ * @note group:bitmatrix
+ */
+uint64_t tw_bitmatrix_col_count(const struct tw_bitmatrix *matrix,
+                                uint64_t col);
+
+/**
+ * Count the active bits of every column of a `struct tw_bitmatrix` in a
+ * single pass, on blocks of 64 by 64 bits transposed in registers.
+ *
+ * @param matrix non-null matrix
+ * @param counts non-null array of `matrix.n_cols` counts to store
+ *
+ * @return `false` if pre-conditions are not met, otherwise `true`
+ *
+ * @note group:bitmatrix
+ */
+bool tw_bitmatrix_col_counts(const struct tw_bitmatrix *matrix,
+                             uint64_t *counts);
+
+/**
+ * Compute the transpose of a `struct tw_bitmatrix`, by blocks of 64 by 64
+ * bits transposed in registers.
+ *
+ * @param matrix non-null matrix to transpose
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed,
+ *         otherwise a pointer to a newly allocated `struct tw_bitmatrix` of
+ *         `matrix.n_cols` rows and `matrix.n_rows` columns
+ *
+ * @note group:bitmatrix
+ */
+struct tw_bitmatrix *tw_bitmatrix_transpose(const struct tw_bitmatrix *matrix);
+
+/**
+ * Expand a frontier of rows in a `struct tw_bitmatrix`, i.e. compute the
+ * union of the rows of the active bits of `frontier`, the successors of a
+ * set of vertices. Rows are combined `TW_BITMATRIX_EXPAND_BATCH` at a time,
+ * each batch a single pass over `next`.
+ *
+ * A breadth-first search then removes the visited vertices from `next`, e.g.
+ * with `tw_bitmap_andnot`, before expanding it.
+ *
+ * @param matrix non-null matrix
+ * @param frontier non-null rows to expand, of at least `matrix.n_rows` bits,
+ *                 active bits past `matrix.n_rows` are ignored
+ * @param next non-null destination bitmap of `matrix.row_bits` bits, distinct
+ *             from `frontier`, its previous content is discarded
+ *
+ * @return `NULL` if pre-conditions are not met, otherwise a pointer to `next`
+ *
+ * @note group:bitmatrix
+ */
+struct tw_bitmap *tw_bitmatrix_expand(const struct tw_bitmatrix *matrix,
+                                      const struct tw_bitmap *frontier,
+                                      struct tw_bitmap *next);
+
+#endif /* TWIDDLE_BITMATRIX_H */
@@ -6,6 +6,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <twiddle/utils/alloc.h>
+
 #define TW_LOG_2 0.6931471805599453
 
 #define tw_bloomfilter_optimal_m(n, p) (-n * log(p) / (TW_LOG_2 * TW_LOG_2))
@@ -40,6 +42,24 @@ struct tw_bloomfilter {
  */
 struct tw_bloomfilter *tw_bloomfilter_new(uint64_t size, uint16_t k);
 
+/**
+ * Allocate a `struct tw_bloomfilter` with allocation flags.
+ *
+ * @param size number of bits the bloomfilter should hold, between
+ *             (0, TW_BITMAP_MAX_BITS].
+ * @param k stricly positive number of hash functions used
+ * @param flags bitwise or of `enum tw_alloc_flags`, huge pages reduce TLB
+ *              misses of random probes in filters larger than the last level
+ *              cache
+ *
+ * @return `NULL` if allocation failed, otherwise a pointer to the newly
+ *         allocated `struct tw_bloomfilter`
+ *
+ * @note group:bloomfilter
+ */
+struct tw_bloomfilter *tw_bloomfilter_new_flags(uint64_t size, uint16_t k,
+                                                int flags);
+
 /**
  * Free a `struct tw_bloomfilter`.
  *
@@ -88,6 +108,22 @@ struct tw_bloomfilter *tw_bloomfilter_clone(const struct tw_bloomfilter *bf);
 void tw_bloomfilter_set(struct tw_bloomfilter *bf, const void *key,
                         size_t key_size);
 
+/**
+ * Set an element in a `struct tw_bloomfilter` without maintaining the number
+ * of active bits, see `tw_bitmap_set_nocount`.
+ *
+ * Suited to insert-heavy workloads, the count is recomputed by the next
+ * `tw_bloomfilter_count` or `tw_bloomfilter_density`.
+ *
+ * @param bf non-null bloomfilter affected
+ * @param key non-null buffer of the key to add
+ * @param key_size stricly positive size of the buffer key to add
+ *
+ * @note group:bloomfilter
+ */
+void tw_bloomfilter_set_nocount(struct tw_bloomfilter *bf, const void *key,
+                                size_t key_size);
+
 /**
  * Verify if an element is present in a `struct tw_bloomfilter`.
  *
@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <twiddle/utils/alloc.h>
+
 /**
  * minhash data structure
  *
@@ -43,6 +45,8 @@ struct tw_minhash {
   uint32_t n_registers;
   /** registers holding computed values */
   uint32_t *registers;
+  /** allocation flags of `registers`, see `enum tw_alloc_flags` */
+  int flags;
 };
 
 /**
@@ -61,6 +65,37 @@ struct tw_minhash {
  */
 struct tw_minhash *tw_minhash_new(uint32_t n_registers);
 
+/**
+ * Allocate a `struct tw_minhash` with allocation flags.
+ *
+ * @param n_registers stricly positive number of 32bit registers the structure
+ *                    holds
+ * @param flags bitwise or of `enum tw_alloc_flags`
+ *
+ * @return `NULL` if allocation failed, otherwise a pointer to the newly
+ *         allocated `struct tw_minhash`.
+ *
+ * @note group:minhash
+ */
+struct tw_minhash *tw_minhash_new_flags(uint32_t n_registers, int flags);
+
+/**
+ * Allocate a `struct tw_minhash` viewing caller registers in place, see
+ * `twiddle/utils/alloc.h`.
+ *
+ * @param registers non-null buffer of `n_registers` 32bit registers aligned
+ *                  on 64 bytes, e.g. a zeroed buffer or the registers of
+ *                  another minhash
+ * @param n_registers stricly positive multiple of 16 number of registers,
+ *                    i.e. the buffer is a multiple of cache lines
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed,
+ *         otherwise a pointer to the newly allocated `struct tw_minhash`
+ *
+ * @note group:minhash
+ */
+struct tw_minhash *tw_minhash_wrap(void *registers, uint32_t n_registers);
+
 /**
  * Free a `struct tw_minhash`.
  *
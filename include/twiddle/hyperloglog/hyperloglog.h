@@ -5,6 +5,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <twiddle/utils/alloc.h>
+
 #define TW_HLL_ERROR_FOR_REG(reg) (1.04 / sqrt((double)(reg)))
 #define TW_HLL_REG_FOR_ERROR(err) (1.0816 / ((err) * (err)))
 
@@ -54,6 +56,8 @@ struct tw_hyperloglog {
   uint8_t precision;
   /** allocated array containing the 8bit registers */
   uint8_t *registers;
+  /** allocation flags of `registers`, see `enum tw_alloc_flags` */
+  int flags;
 };
 
 /**
@@ -70,6 +74,39 @@ struct tw_hyperloglog {
  */
 struct tw_hyperloglog *tw_hyperloglog_new(uint8_t precision);
 
+/**
+ * Allocate a `struct tw_hyperloglog` with allocation flags.
+ *
+ * @param precision power-of-2 exponent number of bucket hyperloglog should use,
+ *                  must be greater or equal than `TW_HLL_MIN_PRECISION and
+ *                  smaller or equal than `TW_HLL_MAX_PRECISION`
+ * @param flags bitwise or of `enum tw_alloc_flags`
+ *
+ * @return `NULL` if allocation failed, otherwise a pointer to the newly
+ *         allocated `struct tw_hyperloglog`.
+ *
+ * @note group:hyperloglog
+ */
+struct tw_hyperloglog *tw_hyperloglog_new_flags(uint8_t precision, int flags);
+
+/**
+ * Allocate a `struct tw_hyperloglog` viewing caller registers in place, see
+ * `twiddle/utils/alloc.h`.
+ *
+ * @param registers non-null buffer of `2^precision` 8bit registers aligned
+ *                  on 64 bytes, e.g. a zeroed buffer or the registers of
+ *                  another hyperloglog
+ * @param precision power-of-2 exponent number of registers, must be greater
+ *                  or equal than `TW_HLL_MIN_PRECISION` and smaller or equal
+ *                  than `TW_HLL_MAX_PRECISION`
+ *
+ * @return `NULL` if pre-conditions are not met or allocation failed,
+ *         otherwise a pointer to the newly allocated `struct tw_hyperloglog`
+ *
+ * @note group:hyperloglog
+ */
+struct tw_hyperloglog *tw_hyperloglog_wrap(void *registers, uint8_t precision);
+
 /**
  * Free a `struct tw_hyperloglog`.
  *
@@ -0,0 +1,40 @@
+#ifndef TWIDDLE_UTILS_ALLOC_H
+#define TWIDDLE_UTILS_ALLOC_H
+
+/**
+ * Allocation flags of the `*_new_flags` constructors, for data structures
+ * large enough to suffer from TLB misses and remote NUMA accesses.
+ *
+ * Without flags, memory is allocated on the heap and zeroed by the calling
+ * thread. With flags, memory is mapped anonymously: it is zeroed lazily by the
+ * kernel when first touched, on the node dictated by the placement flags.
+ * Flags are hints, an allocation succeeds with regular pages and the default
+ * placement when the host cannot honour them.
+ *
+ * The `*_wrap` constructors instead view memory owned by the caller in place,
+ * e.g. received in a network buffer or a shared memory segment, without
+ * copying. Such memory must outlive the structure viewing it, and is left
+ * untouched when the structure is freed.
+ */
+enum tw_alloc_flags {
+  /** heap allocation, as the `*_new` constructors */
+  TW_ALLOC_DEFAULT = 0,
+  /** transparent huge pages, i.e. 2MB aligned mapping and `MADV_HUGEPAGE` */
+  TW_ALLOC_HUGE_PAGES = 1 << 0,
+  /**
+   * explicit huge pages (`MAP_HUGETLB`) from the pool reserved by the system
+   * administrator, falls back on transparent huge pages
+   */
+  TW_ALLOC_HUGETLB = 1 << 1,
+  /** pages are interleaved across all allowed NUMA nodes */
+  TW_ALLOC_INTERLEAVE = 1 << 2,
+  /** pages are bound to the NUMA node given by `TW_ALLOC_NODE` */
+  TW_ALLOC_BIND = 1 << 3,
+};
+
+#define TW_ALLOC_NODE_SHIFT 16
+
+/** bind pages to a NUMA node, e.g. `TW_ALLOC_HUGE_PAGES | TW_ALLOC_NODE(1)` */
+#define TW_ALLOC_NODE(node) (TW_ALLOC_BIND | ((node) << TW_ALLOC_NODE_SHIFT))
+
+#endif /* TWIDDLE_UTILS_ALLOC_H */
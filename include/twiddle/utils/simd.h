@@ -0,0 +1,51 @@
+#ifndef TWIDDLE_UTILS_SIMD_H
+#define TWIDDLE_UTILS_SIMD_H
+
+/**
+ * Instruction sets libtwiddle kernels are specialized for, ordered from the
+ * least to the most capable. Each level implies the previous ones.
+ */
+enum tw_simd_level {
+  /** plain C, no SIMD instructions */
+  TW_SIMD_PORTABLE = 0,
+  /** 128 bits vectors (AVX encoded SSE4.2) and POPCNT */
+  TW_SIMD_AVX = 1,
+  /** 256 bits vectors, BMI1 and BMI2 */
+  TW_SIMD_AVX2 = 2,
+  /** 512 bits vectors (AVX512F and AVX512BW) */
+  TW_SIMD_AVX512 = 3,
+  /** Ice Lake extensions to AVX512 (VPOPCNTDQ, BITALG and VBMI2) */
+  TW_SIMD_AVX512_ICL = 4,
+};
+
+#define TW_SIMD_LEVELS (TW_SIMD_AVX512_ICL + 1)
+
+/**
+ * Retrieve the instruction set used by libtwiddle's kernels.
+ *
+ * The level is resolved once, on first use, as the most capable instruction
+ * set both compiled in the library and supported by the running CPU and
+ * operating system. It can be lowered by setting the `TWIDDLE_SIMD`
+ * environment variable to one of `portable`, `avx`, `avx2`, `avx512` or
+ * `avx512icl`. A level not supported by the host is never selected, the best
+ * supported level below it is used instead.
+ *
+ * @return the selected `enum tw_simd_level`
+ *
+ * @note group:simd
+ */
+enum tw_simd_level tw_simd_level(void);
+
+/**
+ * Retrieve the name of a `enum tw_simd_level`.
+ *
+ * @param level to name
+ *
+ * @return `NULL` if `level` is invalid, otherwise the name as accepted by the
+ *         `TWIDDLE_SIMD` environment variable
+ *
+ * @note group:simd
+ */
+const char *tw_simd_level_name(enum tw_simd_level level);
+
+#endif /* TWIDDLE_UTILS_SIMD_H */
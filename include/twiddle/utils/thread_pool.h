@@ -0,0 +1,73 @@
+#ifndef TWIDDLE_UTILS_THREAD_POOL_H
+#define TWIDDLE_UTILS_THREAD_POOL_H
+
+#include <stddef.h>
+
+#define TW_THREAD_POOL_MAX_THREADS 64
+
+/**
+ * fixed-size pool of threads executing parallel loops
+ *
+ * The pool is opaque, it is shared by the `*_parallel` operations such that
+ * threads are spawned once instead of once per operation. The calling thread
+ * takes part in the loops, thus a pool of `n_threads` spawns `n_threads - 1`
+ * threads.
+ *
+ * A pool runs a single loop at a time, callers on different threads must
+ * use different pools or serialize their calls.
+ */
+struct tw_thread_pool;
+
+/**
+ * Creates a `struct tw_thread_pool`.
+ *
+ * @param n_threads number of threads running loops, including the calling
+ *                  thread, between [1, TW_THREAD_POOL_MAX_THREADS]
+ *
+ * @return `NULL` if pre-conditions are not met or threads could not be
+ *         spawned, otherwise a pointer to the newly allocated pool
+ *
+ * @note group:thread_pool
+ */
+struct tw_thread_pool *tw_thread_pool_new(size_t n_threads);
+
+/**
+ * Free a `struct tw_thread_pool`, joining its threads.
+ *
+ * @param pool to free
+ *
+ * @note group:thread_pool
+ */
+void tw_thread_pool_free(struct tw_thread_pool *pool);
+
+/**
+ * Retrieve the number of threads of a `struct tw_thread_pool`.
+ *
+ * @param pool non-null pool
+ *
+ * @return `0` if pre-conditions are not met, otherwise the number of threads
+ *         running loops, including the calling thread
+ *
+ * @note group:thread_pool
+ */
+size_t tw_thread_pool_size(const struct tw_thread_pool *pool);
+
+/**
+ * Run `fn(arg, task)` for each task in `[0, n_tasks)` and wait for their
+ * completion.
+ *
+ * Tasks are picked dynamically by idle threads, such that uneven tasks are
+ * balanced. There's no ordering guarantee between tasks.
+ *
+ * @param pool non-null pool
+ * @param fn non-null function executing a task
+ * @param arg opaque argument passed to `fn`
+ * @param n_tasks number of tasks to execute
+ *
+ * @note group:thread_pool
+ */
+void tw_thread_pool_run(struct tw_thread_pool *pool,
+                        void (*fn)(void *arg, size_t task), void *arg,
+                        size_t n_tasks);
+
+#endif /* TWIDDLE_UTILS_THREAD_POOL_H */
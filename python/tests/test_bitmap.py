@@ -1,6 +1,6 @@
 from hypothesis import given
 from test_helpers import TwiddleTest, single_set, double_set
-from twiddle import Bitmap
+from twiddle import ALLOC_HUGE_PAGES, ALLOC_INTERLEAVE, Bitmap, ThreadPool
 
 class TestBitmap(TwiddleTest):
   @given(single_set)
@@ -23,6 +23,57 @@ class TestBitmap(TwiddleTest):
     assert(first == expected)
 
 
+  @given(single_set)
+  def test_bitmap_find_next_prev(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.from_indices(n, xs)
+
+    assert(x.find_last_bit() == max(xs))
+    for pos in [0, min(xs), n / 2, max(xs)]:
+      after, before = [i for i in xs if i >= pos], [i for i in xs if i <= pos]
+      assert(x.find_next_bit(pos) == (min(after) if after else -1))
+      assert(x.find_prev_bit(pos) == (max(before) if before else -1))
+
+
+  @given(single_set)
+  def test_bitmap_ranges(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.from_indices(n, xs)
+    start, end = min(xs), max(xs)
+    inside = len([i for i in xs if start <= i <= end])
+
+    assert(x.count_range(start, end) == inside)
+    assert(x.test_range_any(start, end))
+    assert(x.test_range_all(start, end) == (inside == end - start + 1))
+
+    x.flip_range(start, end)
+    assert(x.count_range(start, end) == end - start + 1 - inside)
+    x.set_range(start, end)
+    assert(x.test_range_all(start, end))
+    x.clear_range(start, end)
+    assert(not x.test_range_any(start, end))
+    assert(x.count() == 0)
+
+
+  @given(double_set)
+  def test_bitmap_many_positions(self, n_xs_ys):
+    n, xs, ys = n_xs_ys
+    x = Bitmap.from_indices(n, xs)
+
+    assert(x.test_many(ys) == [y in xs for y in ys])
+    assert(x.set_many(ys) == len(ys - xs))
+    assert(x.clear_many(xs | ys) == len(xs | ys))
+    assert(x.count() == 0)
+
+
+  @given(single_set)
+  def test_bitmap_iter(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.from_indices(n, xs)
+
+    assert(list(x) == sorted(xs))
+
+
   @given(single_set)
   def test_bitmap_negation(self, n_xs):
     n, xs = n_xs
@@ -77,3 +128,147 @@ class TestBitmap(TwiddleTest):
     # tests __ixor__
     x ^= y
     assert(x == z)
+
+
+  @given(double_set)
+  def test_bitmap_many(self, n_xs_ys):
+    n, xs, ys = n_xs_ys
+    x, y = Bitmap.from_indices(n, xs), Bitmap.from_indices(n, ys)
+
+    assert(Bitmap.union_many([x, y, x]) == x | y)
+    assert(Bitmap.intersection_many([x, y, x]) == x & y)
+    assert(Bitmap.union_many([x]) == x)
+
+
+  @given(double_set)
+  def test_bitmap_counts(self, n_xs_ys):
+    n, xs, ys = n_xs_ys
+    x, y = Bitmap.from_indices(n, xs), Bitmap.from_indices(n, ys)
+
+    assert(x.intersection_count(y) == len(xs & ys))
+    assert(x.union_count(y) == len(xs | ys))
+    assert(x.xor_count(y) == len(xs ^ ys))
+    assert(x.andnot_count(y) == len(xs - ys))
+
+    expected = 1.0 if not (xs | ys) else len(xs & ys) / float(len(xs | ys))
+    assert(abs(x.jaccard(y) - expected) < 1e-6)
+
+
+  @given(single_set)
+  def test_bitmap_flags(self, n_xs):
+    n, xs = n_xs
+
+    for flags in [ALLOC_HUGE_PAGES, ALLOC_INTERLEAVE]:
+      x = Bitmap.from_indices(n, xs)
+      y = Bitmap(n, flags=flags)
+      y.set_many(xs)
+      assert(x == y)
+
+
+  @given(single_set)
+  def test_bitmap_nocount(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap(n)
+
+    for i in xs:
+      x.set_nocount(i)
+    assert(x.count() == len(xs))
+
+    x.clear_nocount(min(xs))
+    assert(x.count() == len(xs) - 1)
+    assert(min(xs) not in x)
+
+
+  @given(double_set)
+  def test_bitmap_parallel(self, n_xs_ys):
+    n, xs, ys = n_xs_ys
+    x, y = Bitmap.from_indices(n, xs), Bitmap.from_indices(n, ys)
+    pool = ThreadPool(4)
+
+    assert(Bitmap.copy(x).union_parallel(y, pool) == x | y)
+    assert(Bitmap.copy(x).intersection_parallel(y, pool) == x & y)
+    assert(Bitmap.copy(x).xor_parallel(y, pool) == x ^ y)
+    assert(Bitmap.copy(x).not_parallel(pool) == -x)
+    assert(x.equal_parallel(Bitmap.copy(x), pool))
+
+    x.fill_parallel(pool)
+    assert(x.full())
+    x.zero_parallel(pool)
+    assert(x.empty())
+
+
+  @given(double_set)
+  def test_bitmap_andnot(self, n_xs_ys):
+    n, xs, ys = n_xs_ys
+    x, y = Bitmap.from_indices(n, xs), Bitmap.from_indices(n, ys)
+
+    # tests __sub__
+    z = x - y
+    assert(z == Bitmap.from_indices(n, xs - ys))
+
+    # tests __isub__
+    x -= y
+    assert(x == z)
+
+    ornot = [i for i in x.ornot(y) if i < n]
+    assert(ornot == sorted(xs - ys | set(range(n)) - ys))
+
+
+  @given(single_set)
+  def test_bitmap_resize(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.from_indices(n, xs)
+
+    x.reserve(8 * n)
+    x.resize(4 * n)
+    assert(len(x) == 4 * n)
+    x[4 * n - 1] = True
+    assert(x.count() == len(xs) + 1)
+
+    x.resize(n)
+    assert(x == Bitmap.from_indices(n, xs))
+
+
+  @given(single_set)
+  def test_bitmap_shifts(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.from_indices(n, xs)
+    shift = min(xs) + 1
+
+    assert([i for i in x << shift if i < n] ==
+           sorted(i + shift for i in xs if i + shift < n))
+    assert(list(x >> shift) == sorted(i - shift for i in xs if i >= shift))
+
+    y = Bitmap.copy(x)
+    y.rotate_left(shift)
+    assert(y.count() == len(xs))
+    y.rotate_right(shift)
+    assert(y == x)
+
+    x <<= n + 512
+    assert(x.empty())
+
+
+  @given(double_set)
+  def test_bitmap_snapshot(self, n_xs_ys):
+    n, xs, ys = n_xs_ys
+    x = Bitmap.create_shared(n)
+    x.set_many(xs)
+
+    snapshot = x.snapshot()
+    x.zero()
+    x.set_many(ys)
+
+    assert(snapshot == Bitmap.from_indices(n, xs))
+    assert(x == Bitmap.from_indices(n, ys))
+
+
+  @given(double_set)
+  def test_bitmap_relations(self, n_xs_ys):
+    n, xs, ys = n_xs_ys
+    x, y = Bitmap.from_indices(n, xs), Bitmap.from_indices(n, ys)
+
+    assert(x.intersects(y) == bool(xs & ys))
+    assert(x.isdisjoint(y) == (not xs & ys))
+    assert(x.issubset(y) == xs.issubset(ys))
+    assert((x & y).issubset(x))
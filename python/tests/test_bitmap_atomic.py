@@ -0,0 +1,40 @@
+from hypothesis import given
+from test_helpers import TwiddleTest, single_set
+from threading import Thread
+from twiddle import BitmapAtomic
+
+class TestBitmapAtomic(TwiddleTest):
+  @given(single_set)
+  def test_bitmap_atomic_set(self, n_xs):
+    n, xs = n_xs
+    x = BitmapAtomic(n)
+
+    for i in xs:
+      assert(not x.test_and_set(i))
+      assert(x.test_and_set(i))
+
+    assert(x.count() == len(xs))
+    assert(list(x.to_bitmap()) == sorted(xs))
+
+    for i in xs:
+      assert(x.test_and_clear(i))
+    assert(x.count() == 0)
+
+
+  @given(single_set)
+  def test_bitmap_atomic_threads(self, n_xs):
+    n, xs = n_xs
+    x = BitmapAtomic(n)
+    won = []
+
+    def race():
+      won.append(len([i for i in xs if not x.test_and_set(i)]))
+
+    threads = [Thread(target=race) for _ in range(4)]
+    for t in threads:
+      t.start()
+    for t in threads:
+      t.join()
+
+    assert(sum(won) == len(xs))
+    assert(x.count() == len(xs))
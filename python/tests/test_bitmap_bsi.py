@@ -0,0 +1,56 @@
+from hypothesis import given
+from test_helpers import TwiddleTest, single_set
+from twiddle import Bitmap, BitmapBSI
+
+BITS = 16
+
+class TestBitmapBSI(TwiddleTest):
+  @given(single_set)
+  def test_bitmap_bsi_values(self, n_xs):
+    n, xs = n_xs
+    bsi = BitmapBSI(n, BITS)
+
+    for i in xs:
+      bsi[i] = i
+    assert(bsi.count() == len(xs))
+    assert(all(bsi[i] == (i if i in xs else None) for i in range(n)))
+
+    del bsi[min(xs)]
+    assert(bsi[min(xs)] is None)
+
+
+  @given(single_set)
+  def test_bitmap_bsi_compare(self, n_xs):
+    n, xs = n_xs
+    bsi = BitmapBSI(n, BITS)
+    for i in xs:
+      bsi[i] = i
+    pivot = sorted(xs)[len(xs) / 2]
+
+    for op, pred in [(BitmapBSI.LT, lambda i: i < pivot),
+                     (BitmapBSI.LE, lambda i: i <= pivot),
+                     (BitmapBSI.GT, lambda i: i > pivot),
+                     (BitmapBSI.GE, lambda i: i >= pivot),
+                     (BitmapBSI.EQ, lambda i: i == pivot),
+                     (BitmapBSI.NE, lambda i: i != pivot)]:
+      expected = Bitmap.from_indices(n, [i for i in xs if pred(i)])
+      assert(bsi.compare(op, pivot) == expected)
+
+    expected = Bitmap.from_indices(n, [i for i in xs if min(xs) <= i <= pivot])
+    assert(bsi.between(min(xs), pivot) == expected)
+
+
+  @given(single_set)
+  def test_bitmap_bsi_aggregates(self, n_xs):
+    n, xs = n_xs
+    bsi = BitmapBSI(n, BITS)
+    for i in xs:
+      bsi[i] = i
+    evens = Bitmap.from_indices(n, range(0, n, 2))
+
+    assert(bsi.sum() == sum(xs))
+    assert(bsi.sum(evens) == sum(i for i in xs if i % 2 == 0))
+
+    k = (len(xs) + 1) / 2
+    top = Bitmap.from_indices(n, sorted(xs)[-k:])
+    assert(bsi.top_k(k) == top)
@@ -0,0 +1,27 @@
+from hypothesis import given
+from os import close, unlink
+from tempfile import mkstemp
+from test_helpers import TwiddleTest, single_set
+from twiddle import Bitmap
+
+class TestBitmapMmap(TwiddleTest):
+  def setUp(self):
+    fd, self.path = mkstemp()
+    close(fd)
+
+
+  def tearDown(self):
+    unlink(self.path)
+
+
+  @given(single_set)
+  def test_bitmap_mmap_persist(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.create_mmap(self.path, n)
+    x.set_many(xs)
+    assert(x.sync_mmap())
+    del x
+
+    y = Bitmap.open_mmap(self.path)
+    assert(list(y) == sorted(xs))
+    assert(y.count() == len(xs))
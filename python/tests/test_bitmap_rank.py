@@ -0,0 +1,37 @@
+from hypothesis import given
+from test_helpers import TwiddleTest, single_set
+from twiddle import Bitmap, BitmapRank
+
+class TestBitmapRank(TwiddleTest):
+  @given(single_set)
+  def test_bitmap_rank_count(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.from_indices(n, xs)
+    rank = BitmapRank(x)
+
+    for pos in [0, n / 2, n - 1, n]:
+      assert(rank.count(pos) == len([i for i in xs if i < pos]))
+
+
+  @given(single_set)
+  def test_bitmap_rank_select(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.from_indices(n, xs)
+    rank = BitmapRank(x)
+
+    for k, pos in enumerate(sorted(xs)):
+      assert(rank.select(k) == pos)
+    assert(rank.select(len(xs)) == -1)
+
+
+  @given(single_set)
+  def test_bitmap_rank_stale(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.from_indices(n, xs)
+    rank = BitmapRank(x)
+
+    first = min(xs)
+    x[first] = False
+    assert(rank.stale())
+    assert(rank.count(first + 1) == 0)
+    assert(not rank.stale())
@@ -1,6 +1,6 @@
 from hypothesis import given, example
 from test_helpers import TwiddleTest, single_set, double_set
-from twiddle import BitmapRLE
+from twiddle import Bitmap, BitmapRLE
 
 class TestBitmapRLE(TwiddleTest):
   @given(single_set)
@@ -63,3 +63,24 @@ class TestBitmapRLE(TwiddleTest):
     # tests __iand__
     x &= y
     assert(x == z)
+
+
+  @given(single_set)
+  def test_bitmap_conversion(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.from_indices(n, xs)
+
+    y = BitmapRLE.from_bitmap(x)
+    assert(y == BitmapRLE.from_indices(n, xs))
+    assert(y.to_bitmap() == x)
+
+
+  @given(double_set)
+  def test_bitmap_relations(self, n_xs_ys):
+    n, xs, ys = n_xs_ys
+    x, y = BitmapRLE.from_indices(n, xs), BitmapRLE.from_indices(n, ys)
+
+    assert(x.intersects(y) == bool(xs & ys))
+    assert(x.isdisjoint(y) == (not xs & ys))
+    assert(x.issubset(y) == xs.issubset(ys))
+    assert((x & y).issubset(x))
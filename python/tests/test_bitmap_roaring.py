@@ -0,0 +1,42 @@
+from hypothesis import given
+from test_helpers import TwiddleTest, single_set, double_set
+from twiddle import BitmapRoaring
+
+class TestBitmapRoaring(TwiddleTest):
+  @given(single_set)
+  def test_bitmap_roaring_set_clear(self, n_xs):
+    n, xs = n_xs
+    x = BitmapRoaring.from_indices(n, xs)
+
+    assert(x.count() == len(xs))
+    assert(all(i in x for i in xs))
+
+    for i in xs:
+      x[i] = False
+    assert(x.empty())
+
+
+  @given(single_set)
+  def test_bitmap_roaring_optimize(self, n_xs):
+    n, xs = n_xs
+    x = BitmapRoaring.from_indices(n, xs)
+    y = BitmapRoaring.copy(x)
+
+    y.optimize()
+    assert(x == y)
+
+
+  @given(double_set)
+  def test_bitmap_roaring_ops(self, n_xs_ys):
+    n, xs, ys = n_xs_ys
+    x, y = BitmapRoaring.from_indices(n, xs), BitmapRoaring.from_indices(n, ys)
+
+    assert(x | y == BitmapRoaring.from_indices(n, xs | ys))
+    assert(x & y == BitmapRoaring.from_indices(n, xs & ys))
+    assert(x ^ y == BitmapRoaring.from_indices(n, xs ^ ys))
+    assert(x - y == BitmapRoaring.from_indices(n, xs - ys))
+
+    # tests __isub__
+    z = x - y
+    x -= y
+    assert(x == z)
@@ -0,0 +1,42 @@
+from hypothesis import given
+from test_helpers import TwiddleTest, single_set
+from twiddle import Bitmap, BitmapSummary
+
+class TestBitmapSummary(TwiddleTest):
+  @given(single_set)
+  def test_bitmap_summary_find(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap.from_indices(n, xs)
+    summary = BitmapSummary(x)
+
+    assert(summary.find_first_bit() == x.find_first_bit())
+    assert(summary.find_first_zero() == x.find_first_zero())
+    for pos in [0, n / 2, n - 1]:
+      assert(summary.find_next_bit(pos) == x.find_next_bit(pos))
+      assert(summary.find_next_zero(pos) == x.find_next_zero(pos))
+
+
+  @given(single_set)
+  def test_bitmap_summary_ids(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap(n)
+    summary = BitmapSummary(x)
+
+    for i in range(len(xs)):
+      assert(summary.alloc_id() == i)
+    assert(summary.free_id(0))
+    assert(summary.alloc_id() == 0)
+    assert(x.count() == len(xs))
+
+
+  @given(single_set)
+  def test_bitmap_summary_stale(self, n_xs):
+    n, xs = n_xs
+    x = Bitmap(n)
+    summary = BitmapSummary(x)
+
+    x.set_many(xs)
+    assert(summary.stale())
+    summary.update()
+    assert(not summary.stale())
+    assert(summary.find_first_bit() == min(xs))
@@ -0,0 +1,45 @@
+from hypothesis import given
+from test_helpers import TwiddleTest, single_set
+from twiddle import Bitmap, BitMatrix
+
+class TestBitMatrix(TwiddleTest):
+  @given(single_set)
+  def test_bitmatrix_cells(self, n_xs):
+    n, xs = n_xs
+    m = BitMatrix(3, n)
+
+    for i in xs:
+      m[i % 3, i] = True
+
+    assert(all(m[i % 3, i] for i in xs))
+    assert(sum(m.row_count(r) for r in range(3)) == len(xs))
+    assert(m.col_counts() == [1 if i in xs else 0 for i in range(n)])
+    assert(list(m.row(0)) == sorted(i for i in xs if i % 3 == 0))
+
+
+  @given(single_set)
+  def test_bitmatrix_transpose(self, n_xs):
+    n, xs = n_xs
+    m = BitMatrix(3, n)
+    for i in xs:
+      m[i % 3, i] = True
+
+    t = m.transpose()
+    assert(all(t[i, i % 3] for i in xs))
+    assert(t.col_count(0) == m.row_count(0))
+
+
+  @given(single_set)
+  def test_bitmatrix_rows(self, n_xs):
+    n, xs = n_xs
+    m = BitMatrix(3, n)
+    for i in xs:
+      m[i % 3, i] = True
+
+    expected = Bitmap.from_indices(n, [i for i in xs if i % 3 != 2])
+    assert(m.expand(Bitmap.from_indices(3, [0, 1])) == expected)
+
+    m.row_union(0, 1)
+    assert(m.row(1) == expected)
+    m.row_intersection(2, 1)
+    assert(m.row(1).empty())
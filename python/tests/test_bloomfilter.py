@@ -1,6 +1,6 @@
 from hypothesis import given
 from test_helpers import TwiddleTest, single_set, double_set
-from twiddle import BloomFilter
+from twiddle import ALLOC_HUGE_PAGES, BloomFilter
 
 class TestBloomFilter(TwiddleTest):
   @given(single_set)
@@ -40,3 +40,28 @@ class TestBloomFilter(TwiddleTest):
     x &= y
     for e in zs:
       assert(e in x)
+
+
+  @given(single_set)
+  def test_bloomfilter_flags(self, n_xs):
+    n, xs = n_xs
+    x = BloomFilter.from_iterable(n, 8, xs)
+    y = BloomFilter(n, 8, flags=ALLOC_HUGE_PAGES)
+
+    for e in xs:
+      y.set(e)
+
+    assert(x == y)
+
+
+  @given(single_set)
+  def test_bloomfilter_nocount(self, n_xs):
+    n, xs = n_xs
+    x = BloomFilter.from_iterable(n, 8, xs)
+    y = BloomFilter(n, 8)
+
+    for e in xs:
+      y.set_nocount(e)
+
+    assert(x == y)
+    assert(x.count() == y.count())
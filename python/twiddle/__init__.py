@@ -1,13 +1,35 @@
+from alloc          import ALLOC_DEFAULT, ALLOC_HUGE_PAGES, ALLOC_HUGETLB, \
+                           ALLOC_INTERLEAVE, ALLOC_BIND, alloc_node
 from bitmap         import Bitmap
+from bitmap_atomic  import BitmapAtomic
+from bitmap_bsi     import BitmapBSI
+from bitmap_rank    import BitmapRank
 from bitmap_rle     import BitmapRLE
+from bitmap_roaring import BitmapRoaring
+from bitmap_summary import BitmapSummary
+from bitmatrix      import BitMatrix
 from bloomfilter    import BloomFilter
 from bloomfilter_a2 import BloomFilterA2
 from hyperloglog    import HyperLogLog
 from minhash        import MinHash
+from thread_pool    import ThreadPool
 
-__all__ = [ 'Bitmap',
+__all__ = [ 'ALLOC_DEFAULT',
+            'ALLOC_HUGE_PAGES',
+            'ALLOC_HUGETLB',
+            'ALLOC_INTERLEAVE',
+            'ALLOC_BIND',
+            'alloc_node',
+            'Bitmap',
+            'BitmapAtomic',
+            'BitmapBSI',
+            'BitmapRank',
             'BitmapRLE',
+            'BitmapRoaring',
+            'BitmapSummary',
+            'BitMatrix',
             'BloomFilter',
             'BloomFilterA2',
             'HyperLogLog',
-            'MinHash']
+            'MinHash',
+            'ThreadPool']
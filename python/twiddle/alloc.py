@@ -0,0 +1,13 @@
+# allocation flags of the `flags` constructors, see `enum tw_alloc_flags`
+
+ALLOC_DEFAULT     = 0
+ALLOC_HUGE_PAGES  = 1 << 0
+ALLOC_HUGETLB     = 1 << 1
+ALLOC_INTERLEAVE  = 1 << 2
+ALLOC_BIND        = 1 << 3
+
+ALLOC_NODE_SHIFT  = 16
+
+
+def alloc_node(node):
+  return ALLOC_BIND | (node << ALLOC_NODE_SHIFT)
@@ -1,8 +1,9 @@
 from c import libtwiddle
+from ctypes import POINTER, c_uint64, c_ulong, c_void_p, cast
 
 class Bitmap(object):
-  def __init__(self, size, ptr=None):
-    self.bitmap = ptr if ptr else libtwiddle.tw_bitmap_new(size)
+  def __init__(self, size, ptr=None, flags=0):
+    self.bitmap = ptr if ptr else libtwiddle.tw_bitmap_new_flags(size, flags)
     self.size   = size
 
 
@@ -16,16 +17,91 @@ class Bitmap(object):
     return cls(b.size, ptr=libtwiddle.tw_bitmap_clone(b.bitmap))
 
 
+  @classmethod
+  def create_mmap(cls, path, size):
+    ptr = libtwiddle.tw_bitmap_create_mmap(path, size)
+    if not ptr:
+      raise IOError("unable to create bitmap file %s" % path)
+    return cls(size, ptr=ptr)
+
+
+  @classmethod
+  def open_mmap(cls, path, writable=False):
+    ptr = libtwiddle.tw_bitmap_open_mmap(path, writable)
+    if not ptr:
+      raise IOError("unable to open bitmap file %s" % path)
+    # the size is the first field of `struct tw_bitmap`
+    return cls(cast(ptr, POINTER(c_uint64))[0], ptr=ptr)
+
+
+  def sync_mmap(self):
+    return libtwiddle.tw_bitmap_sync_mmap(self.bitmap)
+
+
+  @classmethod
+  def create_shared(cls, size):
+    ptr = libtwiddle.tw_bitmap_new_shared(size)
+    if not ptr:
+      raise MemoryError("unable to create shared bitmap")
+    return cls(size, ptr=ptr)
+
+
+  def snapshot(self):
+    ptr = libtwiddle.tw_bitmap_snapshot(self.bitmap)
+    if not ptr:
+      raise MemoryError("unable to snapshot bitmap")
+    return Bitmap(self.size, ptr=ptr)
+
+
+  def shared_size(self):
+    return libtwiddle.tw_bitmap_shared_size(self.bitmap)
+
+
+  def resize(self, size):
+    if not libtwiddle.tw_bitmap_resize(self.bitmap, size):
+      raise MemoryError("unable to resize bitmap to %d bits" % size)
+    self.size = size
+
+
+  def reserve(self, capacity):
+    if not libtwiddle.tw_bitmap_reserve(self.bitmap, capacity):
+      raise MemoryError("unable to reserve %d bits" % capacity)
+
+
   @classmethod
   def from_indices(cls, size, indices):
     bitmap = Bitmap(size)
-
-    for idx in indices:
-      bitmap[idx] = True
+    bitmap.set_many(indices)
 
     return bitmap
 
 
+  @classmethod
+  def __many(cls, bitmaps, func):
+    if not bitmaps or not all(isinstance(b, Bitmap) for b in bitmaps):
+      raise ValueError("Must combine a non-empty sequence of Bitmap")
+
+    size = bitmaps[0].size
+    if any(b.size != size for b in bitmaps):
+      raise ValueError("Bitmaps must be of equal size to be combined")
+
+    ret = cls(size)
+    srcs = (c_void_p * len(bitmaps))(*[b.bitmap for b in bitmaps])
+    func(srcs, len(bitmaps), ret.bitmap)
+
+    return ret
+
+
+  @classmethod
+  def union_many(cls, bitmaps):
+    return cls.__many(bitmaps, libtwiddle.tw_bitmap_union_many)
+
+
+  @classmethod
+  def intersection_many(cls, bitmaps):
+    return cls.__many(bitmaps, libtwiddle.tw_bitmap_intersection_many)
+
+
   def __len__(self):
     return self.size
 
@@ -49,6 +125,25 @@ class Bitmap(object):
       libtwiddle.tw_bitmap_clear(self.bitmap, i)
 
 
+  def set_nocount(self, i):
+    if (i < 0) or (i >= len(self)):
+      raise ValueError("index must be within bitmap bounds")
+    libtwiddle.tw_bitmap_set_nocount(self.bitmap, i)
+
+
+  def clear_nocount(self, i):
+    if (i < 0) or (i >= len(self)):
+      raise ValueError("index must be within bitmap bounds")
+    libtwiddle.tw_bitmap_clear_nocount(self.bitmap, i)
+
+
+  def __iter__(self):
+    count = self.count()
+    out = (c_ulong * max(count, 1))()
+    n = libtwiddle.tw_bitmap_to_array(self.bitmap, out, 0, count)
+    return iter(out[:n])
+
+
   def __contains__(self, x):
     if (x < 0) or (x > self.size - 1):
       return False
@@ -87,8 +182,13 @@ class Bitmap(object):
     return self.__op(other, func, copy=lambda x: x)
 
 
+  def __into(self, other, func):
+    return self.__op(other, lambda b, ret: func(self.bitmap, b, ret),
+                     copy=lambda x: Bitmap(x.size))
+
+
   def __or__(self, other):
-    return self.__op(other, libtwiddle.tw_bitmap_union)
+    return self.__into(other, libtwiddle.tw_bitmap_union_into)
 
 
   def __ior__(self, other):
@@ -96,7 +196,7 @@ class Bitmap(object):
 
 
   def __and__(self, other):
-    return self.__op(other, libtwiddle.tw_bitmap_intersection)
+    return self.__into(other, libtwiddle.tw_bitmap_intersection_into)
 
 
   def __iand__(self, other):
@@ -104,13 +204,108 @@ class Bitmap(object):
 
 
   def __xor__(self, other):
-    return self.__op(other, libtwiddle.tw_bitmap_xor)
+    return self.__into(other, libtwiddle.tw_bitmap_xor_into)
 
 
   def __ixor__(self, other):
     return self.__iop(other, libtwiddle.tw_bitmap_xor)
 
 
+  def __sub__(self, other):
+    return self.__into(other, libtwiddle.tw_bitmap_andnot_into)
+
+
+  def __isub__(self, other):
+    return self.__iop(other, libtwiddle.tw_bitmap_andnot)
+
+
+  def ornot(self, other):
+    return self.__into(other, libtwiddle.tw_bitmap_ornot_into)
+
+
+  def __shift(self, n, func, copy=lambda x: Bitmap.copy(x)):
+    if n < 0:
+      raise ValueError("shift must be positive")
+
+    ret = copy(self)
+    func(ret.bitmap, n)
+
+    return ret
+
+
+  def __lshift__(self, n):
+    return self.__shift(n, libtwiddle.tw_bitmap_shift_left)
+
+
+  def __ilshift__(self, n):
+    return self.__shift(n, libtwiddle.tw_bitmap_shift_left, copy=lambda x: x)
+
+
+  def __rshift__(self, n):
+    return self.__shift(n, libtwiddle.tw_bitmap_shift_right)
+
+
+  def __irshift__(self, n):
+    return self.__shift(n, libtwiddle.tw_bitmap_shift_right, copy=lambda x: x)
+
+
+  def rotate_left(self, n):
+    self.__shift(n, libtwiddle.tw_bitmap_rotate_left, copy=lambda x: x)
+
+
+  def rotate_right(self, n):
+    self.__shift(n, libtwiddle.tw_bitmap_rotate_right, copy=lambda x: x)
+
+
+  def __count(self, other, func):
+    if not isinstance(other, Bitmap):
+      raise ValueError("Must compare Bitmap to Bitmap")
+
+    if self.size != other.size:
+      raise ValueError("Bitmaps must be of equal size to be comparable")
+
+    return func(self.bitmap, other.bitmap)
+
+
+  def intersection_count(self, other):
+    return self.__count(other, libtwiddle.tw_bitmap_intersection_count)
+
+
+  def union_count(self, other):
+    return self.__count(other, libtwiddle.tw_bitmap_union_count)
+
+
+  def xor_count(self, other):
+    return self.__count(other, libtwiddle.tw_bitmap_xor_count)
+
+
+  def andnot_count(self, other):
+    return self.__count(other, libtwiddle.tw_bitmap_andnot_count)
+
+
+  def jaccard(self, other):
+    return self.__count(other, libtwiddle.tw_bitmap_jaccard)
+
+
+  def __relation(self, other, func):
+    if not isinstance(other, Bitmap):
+      raise ValueError("Must compare Bitmap to Bitmap")
+
+    return func(self.bitmap, other.bitmap)
+
+
+  def intersects(self, other):
+    return self.__relation(other, libtwiddle.tw_bitmap_intersects)
+
+
+  def isdisjoint(self, other):
+    return self.__relation(other, libtwiddle.tw_bitmap_is_disjoint)
+
+
+  def issubset(self, other):
+    return self.__relation(other, libtwiddle.tw_bitmap_is_subset)
+
+
   def empty(self):
     return libtwiddle.tw_bitmap_empty(self.bitmap)
 
@@ -141,3 +336,121 @@ class Bitmap(object):
 
   def find_first_bit(self):
     return libtwiddle.tw_bitmap_find_first_bit(self.bitmap)
+
+
+  def find_last_zero(self):
+    return libtwiddle.tw_bitmap_find_last_zero(self.bitmap)
+
+
+  def find_last_bit(self):
+    return libtwiddle.tw_bitmap_find_last_bit(self.bitmap)
+
+
+  def find_next_zero(self, pos):
+    return libtwiddle.tw_bitmap_find_next_zero(self.bitmap, pos)
+
+
+  def find_next_bit(self, pos):
+    return libtwiddle.tw_bitmap_find_next_bit(self.bitmap, pos)
+
+
+  def find_prev_zero(self, pos):
+    return libtwiddle.tw_bitmap_find_prev_zero(self.bitmap, pos)
+
+
+  def find_prev_bit(self, pos):
+    return libtwiddle.tw_bitmap_find_prev_bit(self.bitmap, pos)
+
+
+  @staticmethod
+  def __positions(positions):
+    positions = list(positions)
+    return (c_ulong * len(positions))(*positions), len(positions)
+
+
+  def set_many(self, positions):
+    array, n = Bitmap.__positions(positions)
+    return libtwiddle.tw_bitmap_set_many(self.bitmap, array, n)
+
+
+  def clear_many(self, positions):
+    array, n = Bitmap.__positions(positions)
+    return libtwiddle.tw_bitmap_clear_many(self.bitmap, array, n)
+
+
+  def test_many(self, positions):
+    array, n = Bitmap.__positions(positions)
+    results = Bitmap(max(n, 1))
+    libtwiddle.tw_bitmap_test_many(self.bitmap, array, n, results.bitmap)
+    return [results[i] for i in range(n)]
+
+
+  def set_range(self, start, end):
+    libtwiddle.tw_bitmap_set_range(self.bitmap, start, end)
+
+
+  def clear_range(self, start, end):
+    libtwiddle.tw_bitmap_clear_range(self.bitmap, start, end)
+
+
+  def flip_range(self, start, end):
+    libtwiddle.tw_bitmap_flip_range(self.bitmap, start, end)
+
+
+  def count_range(self, start, end):
+    return libtwiddle.tw_bitmap_count_range(self.bitmap, start, end)
+
+
+  def test_range_all(self, start, end):
+    return libtwiddle.tw_bitmap_test_range_all(self.bitmap, start, end)
+
+
+  def test_range_any(self, start, end):
+    return libtwiddle.tw_bitmap_test_range_any(self.bitmap, start, end)
+
+
+  def __parallel(self, other, pool, func, grow):
+    if not isinstance(other, Bitmap):
+      raise ValueError("Must compare Bitmap to Bitmap")
+
+    func(other.bitmap, self.bitmap, pool.pool)
+    if grow:
+      self.size = max(self.size, other.size)
+
+    return self
+
+
+  def union_parallel(self, other, pool):
+    return self.__parallel(other, pool, libtwiddle.tw_bitmap_union_parallel,
+                           True)
+
+
+  def intersection_parallel(self, other, pool):
+    return self.__parallel(other, pool,
+                           libtwiddle.tw_bitmap_intersection_parallel, False)
+
+
+  def xor_parallel(self, other, pool):
+    return self.__parallel(other, pool, libtwiddle.tw_bitmap_xor_parallel,
+                           True)
+
+
+  def not_parallel(self, pool):
+    libtwiddle.tw_bitmap_not_parallel(self.bitmap, pool.pool)
+    return self
+
+
+  def equal_parallel(self, other, pool):
+    if not isinstance(other, Bitmap):
+      raise ValueError("Must compare Bitmap to Bitmap")
+
+    return libtwiddle.tw_bitmap_equal_parallel(self.bitmap, other.bitmap,
+                                               pool.pool)
+
+
+  def zero_parallel(self, pool):
+    libtwiddle.tw_bitmap_zero_parallel(self.bitmap, pool.pool)
+
+
+  def fill_parallel(self, pool):
+    libtwiddle.tw_bitmap_fill_parallel(self.bitmap, pool.pool)
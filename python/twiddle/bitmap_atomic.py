@@ -0,0 +1,62 @@
+from c import libtwiddle
+from bitmap import Bitmap
+
+class BitmapAtomic(object):
+  def __init__(self, size):
+    self.bitmap = libtwiddle.tw_bitmap_atomic_new(size)
+    self.size   = size
+
+
+  def __del__(self):
+    if self.bitmap:
+      libtwiddle.tw_bitmap_atomic_free(self.bitmap)
+
+
+  def __len__(self):
+    return self.size
+
+
+  def __check(self, i):
+    if (i < 0) or (i >= len(self)):
+      raise ValueError("index must be within bitmap bounds")
+
+
+  def __getitem__(self, i):
+    self.__check(i)
+    return libtwiddle.tw_bitmap_atomic_test(self.bitmap, i)
+
+
+  def __setitem__(self, i, value):
+    self.__check(i)
+
+    if not isinstance(value, bool):
+      raise ValueError("BitmapAtomic accepts only bool values")
+
+    if value:
+      libtwiddle.tw_bitmap_atomic_set(self.bitmap, i)
+    else:
+      libtwiddle.tw_bitmap_atomic_clear(self.bitmap, i)
+
+
+  def test_and_set(self, i):
+    self.__check(i)
+    return libtwiddle.tw_bitmap_atomic_test_and_set(self.bitmap, i)
+
+
+  def test_and_clear(self, i):
+    self.__check(i)
+    return libtwiddle.tw_bitmap_atomic_test_and_clear(self.bitmap, i)
+
+
+  def count(self):
+    return libtwiddle.tw_bitmap_atomic_count(self.bitmap)
+
+
+  def zero(self):
+    libtwiddle.tw_bitmap_atomic_zero(self.bitmap)
+
+
+  def to_bitmap(self):
+    ret = Bitmap(self.size)
+    libtwiddle.tw_bitmap_atomic_copy(self.bitmap, ret.bitmap)
+    return ret
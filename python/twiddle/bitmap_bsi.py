@@ -0,0 +1,84 @@
+from c import libtwiddle
+from bitmap import Bitmap
+from ctypes import byref, c_uint64
+
+class BitmapBSI(object):
+  # comparison operators, see `enum tw_bitmap_bsi_op`
+  LT, LE, GT, GE, EQ, NE = range(6)
+
+
+  def __init__(self, size, bits):
+    self.bsi  = libtwiddle.tw_bitmap_bsi_new(size, bits)
+    self.size = size
+    self.bits = bits
+
+
+  def __del__(self):
+    if self.bsi:
+      libtwiddle.tw_bitmap_bsi_free(self.bsi)
+
+
+  def __len__(self):
+    return self.size
+
+
+  def __check(self, row):
+    if (row < 0) or (row >= len(self)):
+      raise ValueError("row must be within index bounds")
+
+
+  def __getitem__(self, row):
+    self.__check(row)
+
+    value = c_uint64(0)
+    if not libtwiddle.tw_bitmap_bsi_get(self.bsi, row, byref(value)):
+      return None
+
+    return value.value
+
+
+  def __setitem__(self, row, value):
+    self.__check(row)
+
+    if (value < 0) or (value >= 1 << self.bits):
+      raise ValueError("value must fit in the bits of the index")
+
+    libtwiddle.tw_bitmap_bsi_set(self.bsi, row, value)
+
+
+  def __delitem__(self, row):
+    self.__check(row)
+    libtwiddle.tw_bitmap_bsi_clear(self.bsi, row)
+
+
+  def count(self):
+    return libtwiddle.tw_bitmap_bsi_count(self.bsi)
+
+
+  def __rows(self, func, filter):
+    ret = Bitmap(self.size)
+
+    if not func(filter.bitmap if filter else None, ret.bitmap):
+      raise MemoryError("unable to select rows of BitmapBSI")
+
+    return ret
+
+
+  def compare(self, op, x, filter=None):
+    return self.__rows(lambda f, dst:
+        libtwiddle.tw_bitmap_bsi_compare(self.bsi, op, x, f, dst), filter)
+
+
+  def between(self, lo, hi, filter=None):
+    return self.__rows(lambda f, dst:
+        libtwiddle.tw_bitmap_bsi_between(self.bsi, lo, hi, f, dst), filter)
+
+
+  def top_k(self, k, filter=None):
+    return self.__rows(lambda f, dst:
+        libtwiddle.tw_bitmap_bsi_top_k(self.bsi, k, f, dst), filter)
+
+
+  def sum(self, filter=None):
+    return libtwiddle.tw_bitmap_bsi_sum(self.bsi,
+                                        filter.bitmap if filter else None)
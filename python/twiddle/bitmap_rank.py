@@ -0,0 +1,28 @@
+from c import libtwiddle
+
+class BitmapRank(object):
+  def __init__(self, bitmap):
+    # keep a reference, the index must not outlive the bitmap
+    self.bitmap = bitmap
+    self.rank   = libtwiddle.tw_bitmap_rank_new(bitmap.bitmap)
+
+
+  def __del__(self):
+    if self.rank:
+      libtwiddle.tw_bitmap_rank_free(self.rank)
+
+
+  def stale(self):
+    return libtwiddle.tw_bitmap_rank_stale(self.rank)
+
+
+  def count(self, pos):
+    if pos < 0:
+      raise ValueError("position must be positive")
+    return libtwiddle.tw_bitmap_rank_count(self.rank, pos)
+
+
+  def select(self, k):
+    if k < 0:
+      raise ValueError("rank must be positive")
+    return libtwiddle.tw_bitmap_rank_select(self.rank, k)
@@ -1,4 +1,5 @@
 from c import libtwiddle
+from bitmap import Bitmap
 
 class BitmapRLE(object):
   def __init__(self, size, ptr=None):
@@ -26,6 +27,22 @@ class BitmapRLE(object):
     return bitmap
 
 
+  @classmethod
+  def from_bitmap(cls, b):
+    if not isinstance(b, Bitmap):
+      raise ValueError("BitmapRLE converts only Bitmap")
+
+    ret = cls(b.size)
+    libtwiddle.tw_bitmap_to_rle(b.bitmap, ret.bitmap)
+    return ret
+
+
+  def to_bitmap(self):
+    ret = Bitmap(self.size)
+    libtwiddle.tw_bitmap_rle_to_bitmap(self.bitmap, ret.bitmap)
+    return ret
+
+
   def __len__(self):
     return self.size
 
@@ -131,3 +148,22 @@ class BitmapRLE(object):
 
   def find_first_bit(self):
     return libtwiddle.tw_bitmap_rle_find_first_bit(self.bitmap)
+
+
+  def __relation(self, other, func):
+    if not isinstance(other, BitmapRLE):
+      raise ValueError("Must compare BitmapRLE to BitmapRLE")
+
+    return func(self.bitmap, other.bitmap)
+
+
+  def intersects(self, other):
+    return self.__relation(other, libtwiddle.tw_bitmap_rle_intersects)
+
+
+  def isdisjoint(self, other):
+    return self.__relation(other, libtwiddle.tw_bitmap_rle_is_disjoint)
+
+
+  def issubset(self, other):
+    return self.__relation(other, libtwiddle.tw_bitmap_rle_is_subset)
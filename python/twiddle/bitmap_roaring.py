@@ -0,0 +1,130 @@
+from c import libtwiddle
+
+class BitmapRoaring(object):
+  def __init__(self, size, ptr=None):
+    self.bitmap = ptr if ptr else libtwiddle.tw_bitmap_roaring_new(size)
+    self.size   = size
+
+
+  def __del__(self):
+    if self.bitmap:
+      libtwiddle.tw_bitmap_roaring_free(self.bitmap)
+
+
+  @classmethod
+  def copy(cls, b):
+    return cls(b.size, ptr=libtwiddle.tw_bitmap_roaring_clone(b.bitmap))
+
+
+  @classmethod
+  def from_indices(cls, size, indices):
+    bitmap = BitmapRoaring(size)
+
+    for idx in indices:
+      bitmap[idx] = True
+
+    return bitmap
+
+
+  def __len__(self):
+    return self.size
+
+
+  def __getitem__(self, i):
+    if (i < 0) or (i >= len(self)):
+      raise ValueError("index must be within bitmap bounds")
+    return libtwiddle.tw_bitmap_roaring_test(self.bitmap, i)
+
+
+  def __setitem__(self, i, value):
+    if (i < 0) or (i >= len(self)):
+      raise ValueError("index must be within bitmap bounds")
+
+    if not isinstance(value, bool):
+      raise ValueError("BitmapRoaring accepts only bool values")
+
+    if value:
+      libtwiddle.tw_bitmap_roaring_set(self.bitmap, i)
+    else:
+      libtwiddle.tw_bitmap_roaring_clear(self.bitmap, i)
+
+
+  def __contains__(self, x):
+    if (x < 0) or (x > self.size - 1):
+      return False
+
+    return self[x]
+
+
+  def __eq__(self, other):
+    if not isinstance(other, BitmapRoaring):
+      return False
+
+    return libtwiddle.tw_bitmap_roaring_equal(self.bitmap, other.bitmap)
+
+
+  def __op(self, other, func, copy=lambda x: BitmapRoaring.copy(x)):
+    if not isinstance(other, BitmapRoaring):
+      raise ValueError("Must compare BitmapRoaring to BitmapRoaring")
+
+    if self.size != other.size:
+      raise ValueError("BitmapRoaring must be of equal size to be comparable")
+
+    ret = copy(self)
+
+    if not func(other.bitmap, ret.bitmap):
+      raise MemoryError("unable to combine BitmapRoaring")
+
+    return ret
+
+
+  def __iop(self, other, func):
+    return self.__op(other, func, copy=lambda x: x)
+
+
+  def __or__(self, other):
+    return self.__op(other, libtwiddle.tw_bitmap_roaring_union)
+
+
+  def __ior__(self, other):
+    return self.__iop(other, libtwiddle.tw_bitmap_roaring_union)
+
+
+  def __and__(self, other):
+    return self.__op(other, libtwiddle.tw_bitmap_roaring_intersection)
+
+
+  def __iand__(self, other):
+    return self.__iop(other, libtwiddle.tw_bitmap_roaring_intersection)
+
+
+  def __xor__(self, other):
+    return self.__op(other, libtwiddle.tw_bitmap_roaring_xor)
+
+
+  def __ixor__(self, other):
+    return self.__iop(other, libtwiddle.tw_bitmap_roaring_xor)
+
+
+  def __sub__(self, other):
+    return self.__op(other, libtwiddle.tw_bitmap_roaring_andnot)
+
+
+  def __isub__(self, other):
+    return self.__iop(other, libtwiddle.tw_bitmap_roaring_andnot)
+
+
+  def empty(self):
+    return libtwiddle.tw_bitmap_roaring_empty(self.bitmap)
+
+
+  def count(self):
+    return libtwiddle.tw_bitmap_roaring_count(self.bitmap)
+
+
+  def zero(self):
+    libtwiddle.tw_bitmap_roaring_zero(self.bitmap)
+
+
+  def optimize(self):
+    libtwiddle.tw_bitmap_roaring_optimize(self.bitmap)
@@ -0,0 +1,60 @@
+from c import libtwiddle
+
+class BitmapSummary(object):
+  def __init__(self, bitmap):
+    # keep a reference, the summary must not outlive the bitmap
+    self.bitmap  = bitmap
+    self.summary = libtwiddle.tw_bitmap_summary_new(bitmap.bitmap)
+
+
+  def __del__(self):
+    if self.summary:
+      libtwiddle.tw_bitmap_summary_free(self.summary)
+
+
+  def __check(self, pos):
+    if (pos < 0) or (pos >= len(self.bitmap)):
+      raise ValueError("position must be within bitmap bounds")
+
+
+  def stale(self):
+    return libtwiddle.tw_bitmap_summary_stale(self.summary)
+
+
+  def update(self):
+    libtwiddle.tw_bitmap_summary_update(self.summary)
+
+
+  def set(self, pos):
+    self.__check(pos)
+    return libtwiddle.tw_bitmap_summary_set(self.summary, pos)
+
+
+  def clear(self, pos):
+    self.__check(pos)
+    return libtwiddle.tw_bitmap_summary_clear(self.summary, pos)
+
+
+  def find_first_zero(self):
+    return libtwiddle.tw_bitmap_summary_find_first_zero(self.summary)
+
+
+  def find_first_bit(self):
+    return libtwiddle.tw_bitmap_summary_find_first_bit(self.summary)
+
+
+  def find_next_zero(self, pos):
+    return libtwiddle.tw_bitmap_summary_find_next_zero(self.summary, pos)
+
+
+  def find_next_bit(self, pos):
+    return libtwiddle.tw_bitmap_summary_find_next_bit(self.summary, pos)
+
+
+  def alloc_id(self):
+    return libtwiddle.tw_bitmap_summary_alloc_id(self.summary)
+
+
+  def free_id(self, i):
+    self.__check(i)
+    return libtwiddle.tw_bitmap_summary_free_id(self.summary, i)
@@ -0,0 +1,91 @@
+from c import libtwiddle
+from bitmap import Bitmap
+from ctypes import POINTER, c_uint64, cast
+
+class BitMatrix(object):
+  def __init__(self, n_rows, n_cols, ptr=None):
+    self.matrix = ptr if ptr else libtwiddle.tw_bitmatrix_new(n_rows, n_cols)
+    self.n_rows = n_rows
+    self.n_cols = n_cols
+
+
+  def __del__(self):
+    if self.matrix:
+      libtwiddle.tw_bitmatrix_free(self.matrix)
+
+
+  def __check(self, row, col):
+    if (row < 0) or (row >= self.n_rows) or (col < 0) or (col >= self.n_cols):
+      raise ValueError("cell must be within matrix bounds")
+
+
+  def __getitem__(self, cell):
+    row, col = cell
+    self.__check(row, col)
+    return libtwiddle.tw_bitmatrix_test(self.matrix, row, col)
+
+
+  def __setitem__(self, cell, value):
+    row, col = cell
+    self.__check(row, col)
+
+    if not isinstance(value, bool):
+      raise ValueError("BitMatrix accepts only bool values")
+
+    if value:
+      libtwiddle.tw_bitmatrix_set(self.matrix, row, col)
+    else:
+      libtwiddle.tw_bitmatrix_clear(self.matrix, row, col)
+
+
+  def row_count(self, row):
+    self.__check(row, 0)
+    return libtwiddle.tw_bitmatrix_row_count(self.matrix, row)
+
+
+  def col_count(self, col):
+    self.__check(0, col)
+    return libtwiddle.tw_bitmatrix_col_count(self.matrix, col)
+
+
+  def col_counts(self):
+    counts = (c_uint64 * self.n_cols)()
+    libtwiddle.tw_bitmatrix_col_counts(self.matrix, counts)
+    return counts[:]
+
+
+  def row_union(self, src, dst):
+    self.__check(src, 0)
+    self.__check(dst, 0)
+    libtwiddle.tw_bitmatrix_row_union(self.matrix, src, dst)
+
+
+  def row_intersection(self, src, dst):
+    self.__check(src, 0)
+    self.__check(dst, 0)
+    libtwiddle.tw_bitmatrix_row_intersection(self.matrix, src, dst)
+
+
+  def transpose(self):
+    ptr = libtwiddle.tw_bitmatrix_transpose(self.matrix)
+    if not ptr:
+      raise MemoryError("unable to transpose BitMatrix")
+    return BitMatrix(self.n_cols, self.n_rows, ptr=ptr)
+
+
+  def expand(self, frontier):
+    if not isinstance(frontier, Bitmap) or len(frontier) < self.n_rows:
+      raise ValueError("frontier must be a Bitmap of at least n_rows bits")
+
+    # `row_bits` is the third field of `struct tw_bitmatrix`
+    row_bits = cast(self.matrix, POINTER(c_uint64))[2]
+    ret = Bitmap(row_bits)
+    libtwiddle.tw_bitmatrix_expand(self.matrix, frontier.bitmap, ret.bitmap)
+    ret.resize(self.n_cols)
+
+    return ret
+
+
+  def row(self, row):
+    self.__check(row, 0)
+    return self.expand(Bitmap.from_indices(self.n_rows, [row]))
@@ -2,8 +2,9 @@ from c import libtwiddle
 from ctypes import c_int, c_long, pointer
 
 class BloomFilter(object):
-  def __init__(self, size, k, ptr=None):
-    self.bloomfilter = ptr if ptr else libtwiddle.tw_bloomfilter_new(size, k)
+  def __init__(self, size, k, ptr=None, flags=0):
+    self.bloomfilter = ptr if ptr else \
+                       libtwiddle.tw_bloomfilter_new_flags(size, k, flags)
     self.size        = size
     self.k           = k
 
@@ -42,6 +43,11 @@ class BloomFilter(object):
     libtwiddle.tw_bloomfilter_set(self.bloomfilter, h, 8)
 
 
+  def set_nocount(self, x):
+    h = pointer(c_long(hash(x)))
+    libtwiddle.tw_bloomfilter_set_nocount(self.bloomfilter, h, 8)
+
+
   def test(self, x):
     return self[x]
 
@@ -22,6 +22,9 @@ libtwiddle = CDLL(find_twiddle_so())
 libtwiddle.tw_bitmap_new.argtypes = [c_ulong]
 libtwiddle.tw_bitmap_new.restype  = c_void_p
 
+libtwiddle.tw_bitmap_new_flags.argtypes = [c_ulong, c_int]
+libtwiddle.tw_bitmap_new_flags.restype  = c_void_p
+
 libtwiddle.tw_bitmap_free.argtypes = [c_void_p]
 libtwiddle.tw_bitmap_free.restype  = None
 
@@ -37,6 +40,12 @@ libtwiddle.tw_bitmap_set.restype  = None
 libtwiddle.tw_bitmap_clear.argtypes = [c_void_p, c_ulong]
 libtwiddle.tw_bitmap_clear.restype  = None
 
+libtwiddle.tw_bitmap_set_nocount.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_set_nocount.restype  = None
+
+libtwiddle.tw_bitmap_clear_nocount.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_clear_nocount.restype  = None
+
 libtwiddle.tw_bitmap_test.argtypes = [c_void_p, c_ulong]
 libtwiddle.tw_bitmap_test.restype  = c_bool
 
@@ -67,6 +76,49 @@ libtwiddle.tw_bitmap_find_first_zero.restype  = c_int64
 libtwiddle.tw_bitmap_find_first_bit.argtypes = [c_void_p]
 libtwiddle.tw_bitmap_find_first_bit.restype  = c_int64
 
+libtwiddle.tw_bitmap_find_last_zero.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_find_last_zero.restype  = c_int64
+
+libtwiddle.tw_bitmap_find_last_bit.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_find_last_bit.restype  = c_int64
+
+libtwiddle.tw_bitmap_find_next_zero.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_find_next_zero.restype  = c_int64
+
+libtwiddle.tw_bitmap_find_next_bit.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_find_next_bit.restype  = c_int64
+
+libtwiddle.tw_bitmap_find_prev_zero.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_find_prev_zero.restype  = c_int64
+
+libtwiddle.tw_bitmap_find_prev_bit.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_find_prev_bit.restype  = c_int64
+
+libtwiddle.tw_bitmap_set_range.argtypes = [c_void_p, c_ulong, c_ulong]
+
+libtwiddle.tw_bitmap_clear_range.argtypes = [c_void_p, c_ulong, c_ulong]
+
+libtwiddle.tw_bitmap_flip_range.argtypes = [c_void_p, c_ulong, c_ulong]
+
+libtwiddle.tw_bitmap_count_range.argtypes = [c_void_p, c_ulong, c_ulong]
+libtwiddle.tw_bitmap_count_range.restype  = c_ulong
+
+libtwiddle.tw_bitmap_test_range_all.argtypes = [c_void_p, c_ulong, c_ulong]
+libtwiddle.tw_bitmap_test_range_all.restype  = c_bool
+
+libtwiddle.tw_bitmap_test_range_any.argtypes = [c_void_p, c_ulong, c_ulong]
+libtwiddle.tw_bitmap_test_range_any.restype  = c_bool
+
+libtwiddle.tw_bitmap_set_many.argtypes = [c_void_p, c_void_p, c_ulong]
+libtwiddle.tw_bitmap_set_many.restype  = c_ulong
+
+libtwiddle.tw_bitmap_clear_many.argtypes = [c_void_p, c_void_p, c_ulong]
+libtwiddle.tw_bitmap_clear_many.restype  = c_ulong
+
+libtwiddle.tw_bitmap_test_many.argtypes = [c_void_p, c_void_p, c_ulong,
+                                           c_void_p]
+libtwiddle.tw_bitmap_test_many.restype  = c_void_p
+
 libtwiddle.tw_bitmap_not.argtypes = [c_void_p]
 libtwiddle.tw_bitmap_not.restype  = c_void_p
 
@@ -82,6 +134,184 @@ libtwiddle.tw_bitmap_intersection.restype  = c_void_p
 libtwiddle.tw_bitmap_xor.argtypes = [c_void_p, c_void_p]
 libtwiddle.tw_bitmap_xor.restype  = c_void_p
 
+libtwiddle.tw_bitmap_to_array.argtypes = [c_void_p, POINTER(c_ulong), c_ulong, c_ulong]
+libtwiddle.tw_bitmap_to_array.restype  = c_ulong
+
+libtwiddle.tw_bitmap_union_many.argtypes = [POINTER(c_void_p), c_ulong, c_void_p]
+libtwiddle.tw_bitmap_union_many.restype  = c_void_p
+
+libtwiddle.tw_bitmap_intersection_many.argtypes = [POINTER(c_void_p), c_ulong, c_void_p]
+libtwiddle.tw_bitmap_intersection_many.restype  = c_void_p
+
+libtwiddle.tw_bitmap_intersection_count.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_intersection_count.restype  = c_ulong
+
+libtwiddle.tw_bitmap_union_count.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_union_count.restype  = c_ulong
+
+libtwiddle.tw_bitmap_xor_count.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_xor_count.restype  = c_ulong
+
+libtwiddle.tw_bitmap_andnot_count.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_andnot_count.restype  = c_ulong
+
+libtwiddle.tw_bitmap_jaccard.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_jaccard.restype  = c_float
+
+libtwiddle.tw_bitmap_andnot.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_andnot.restype  = c_void_p
+
+libtwiddle.tw_bitmap_union_into.argtypes = [c_void_p, c_void_p, c_void_p]
+libtwiddle.tw_bitmap_union_into.restype  = c_void_p
+
+libtwiddle.tw_bitmap_intersection_into.argtypes = [c_void_p, c_void_p, c_void_p]
+libtwiddle.tw_bitmap_intersection_into.restype  = c_void_p
+
+libtwiddle.tw_bitmap_xor_into.argtypes = [c_void_p, c_void_p, c_void_p]
+libtwiddle.tw_bitmap_xor_into.restype  = c_void_p
+
+libtwiddle.tw_bitmap_andnot_into.argtypes = [c_void_p, c_void_p, c_void_p]
+libtwiddle.tw_bitmap_andnot_into.restype  = c_void_p
+
+libtwiddle.tw_bitmap_ornot_into.argtypes = [c_void_p, c_void_p, c_void_p]
+libtwiddle.tw_bitmap_ornot_into.restype  = c_void_p
+
+libtwiddle.tw_bitmap_resize.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_resize.restype  = c_void_p
+
+libtwiddle.tw_bitmap_reserve.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_reserve.restype  = c_void_p
+
+libtwiddle.tw_bitmap_shift_left.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_shift_left.restype  = c_void_p
+
+libtwiddle.tw_bitmap_shift_right.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_shift_right.restype  = c_void_p
+
+libtwiddle.tw_bitmap_rotate_left.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_rotate_left.restype  = c_void_p
+
+libtwiddle.tw_bitmap_rotate_right.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_rotate_right.restype  = c_void_p
+
+libtwiddle.tw_bitmap_intersects.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_intersects.restype  = c_bool
+
+libtwiddle.tw_bitmap_is_disjoint.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_is_disjoint.restype  = c_bool
+
+libtwiddle.tw_bitmap_is_subset.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_is_subset.restype  = c_bool
+
+# BITMAP_PARALLEL
+
+libtwiddle.tw_thread_pool_new.argtypes = [c_size_t]
+libtwiddle.tw_thread_pool_new.restype  = c_void_p
+
+libtwiddle.tw_thread_pool_free.argtypes = [c_void_p]
+libtwiddle.tw_thread_pool_free.restype  = None
+
+libtwiddle.tw_thread_pool_size.argtypes = [c_void_p]
+libtwiddle.tw_thread_pool_size.restype  = c_size_t
+
+libtwiddle.tw_bitmap_union_parallel.argtypes = [c_void_p, c_void_p, c_void_p]
+libtwiddle.tw_bitmap_union_parallel.restype  = c_void_p
+
+libtwiddle.tw_bitmap_intersection_parallel.argtypes = [c_void_p, c_void_p,
+                                                       c_void_p]
+libtwiddle.tw_bitmap_intersection_parallel.restype  = c_void_p
+
+libtwiddle.tw_bitmap_xor_parallel.argtypes = [c_void_p, c_void_p, c_void_p]
+libtwiddle.tw_bitmap_xor_parallel.restype  = c_void_p
+
+libtwiddle.tw_bitmap_not_parallel.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_not_parallel.restype  = c_void_p
+
+libtwiddle.tw_bitmap_equal_parallel.argtypes = [c_void_p, c_void_p, c_void_p]
+libtwiddle.tw_bitmap_equal_parallel.restype  = c_bool
+
+libtwiddle.tw_bitmap_zero_parallel.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_zero_parallel.restype  = c_void_p
+
+libtwiddle.tw_bitmap_fill_parallel.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_fill_parallel.restype  = c_void_p
+
+# BITMAP_SNAPSHOT
+
+libtwiddle.tw_bitmap_new_shared.argtypes = [c_ulong]
+libtwiddle.tw_bitmap_new_shared.restype  = c_void_p
+
+libtwiddle.tw_bitmap_snapshot.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_snapshot.restype  = c_void_p
+
+libtwiddle.tw_bitmap_shared_size.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_shared_size.restype  = c_ulong
+
+# BITMAP_RANK
+
+libtwiddle.tw_bitmap_create_mmap.argtypes = [c_char_p, c_ulong]
+libtwiddle.tw_bitmap_create_mmap.restype  = c_void_p
+
+libtwiddle.tw_bitmap_open_mmap.argtypes = [c_char_p, c_bool]
+libtwiddle.tw_bitmap_open_mmap.restype  = c_void_p
+
+libtwiddle.tw_bitmap_sync_mmap.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_sync_mmap.restype  = c_bool
+
+libtwiddle.tw_bitmap_union_mmap.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_union_mmap.restype  = c_void_p
+
+libtwiddle.tw_bitmap_intersection_mmap.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_intersection_mmap.restype  = c_void_p
+
+libtwiddle.tw_bitmap_atomic_new.argtypes = [c_ulong]
+libtwiddle.tw_bitmap_atomic_new.restype  = c_void_p
+
+libtwiddle.tw_bitmap_atomic_free.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_atomic_free.restype  = None
+
+libtwiddle.tw_bitmap_atomic_set.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_atomic_set.restype  = None
+
+libtwiddle.tw_bitmap_atomic_clear.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_atomic_clear.restype  = None
+
+libtwiddle.tw_bitmap_atomic_test.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_atomic_test.restype  = c_bool
+
+libtwiddle.tw_bitmap_atomic_test_and_set.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_atomic_test_and_set.restype  = c_bool
+
+libtwiddle.tw_bitmap_atomic_test_and_clear.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_atomic_test_and_clear.restype  = c_bool
+
+libtwiddle.tw_bitmap_atomic_count.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_atomic_count.restype  = c_ulong
+
+libtwiddle.tw_bitmap_atomic_zero.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_atomic_zero.restype  = c_void_p
+
+libtwiddle.tw_bitmap_atomic_copy.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_atomic_copy.restype  = c_void_p
+
+libtwiddle.tw_bitmap_rank_new.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_rank_new.restype  = c_void_p
+
+libtwiddle.tw_bitmap_rank_free.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_rank_free.restype  = None
+
+libtwiddle.tw_bitmap_rank_stale.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_rank_stale.restype  = c_bool
+
+libtwiddle.tw_bitmap_rank_update.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_rank_update.restype  = c_void_p
+
+libtwiddle.tw_bitmap_rank_count.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_rank_count.restype  = c_int64
+
+libtwiddle.tw_bitmap_rank_select.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_rank_select.restype  = c_int64
+
 # BITMAP_RLE
 
 libtwiddle.tw_bitmap_rle_new.argtypes = [c_ulong]
@@ -138,11 +368,190 @@ libtwiddle.tw_bitmap_rle_union.restype  = c_void_p
 libtwiddle.tw_bitmap_rle_intersection.argtypes = [c_void_p, c_void_p, c_void_p]
 libtwiddle.tw_bitmap_rle_intersection.restype  = c_void_p
 
+libtwiddle.tw_bitmap_rle_intersects.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_rle_intersects.restype  = c_bool
+
+libtwiddle.tw_bitmap_rle_is_disjoint.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_rle_is_disjoint.restype  = c_bool
+
+libtwiddle.tw_bitmap_rle_is_subset.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_rle_is_subset.restype  = c_bool
+
+libtwiddle.tw_bitmap_to_rle.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_to_rle.restype  = c_void_p
+
+libtwiddle.tw_bitmap_rle_to_bitmap.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_rle_to_bitmap.restype  = c_void_p
+
+# BITMAP_ROARING
+
+libtwiddle.tw_bitmap_roaring_new.argtypes = [c_ulong]
+libtwiddle.tw_bitmap_roaring_new.restype  = c_void_p
+
+libtwiddle.tw_bitmap_roaring_free.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_roaring_free.restype  = None
+
+libtwiddle.tw_bitmap_roaring_copy.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_roaring_copy.restype  = c_void_p
+
+libtwiddle.tw_bitmap_roaring_clone.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_roaring_clone.restype  = c_void_p
+
+libtwiddle.tw_bitmap_roaring_set.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_roaring_set.restype  = None
+
+libtwiddle.tw_bitmap_roaring_clear.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_roaring_clear.restype  = None
+
+libtwiddle.tw_bitmap_roaring_test.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_roaring_test.restype  = c_bool
+
+libtwiddle.tw_bitmap_roaring_empty.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_roaring_empty.restype  = c_bool
+
+libtwiddle.tw_bitmap_roaring_count.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_roaring_count.restype  = c_ulong
+
+libtwiddle.tw_bitmap_roaring_zero.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_roaring_zero.restype  = c_void_p
+
+libtwiddle.tw_bitmap_roaring_optimize.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_roaring_optimize.restype  = c_void_p
+
+libtwiddle.tw_bitmap_roaring_equal.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_roaring_equal.restype  = c_bool
+
+libtwiddle.tw_bitmap_roaring_union.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_roaring_union.restype  = c_void_p
+
+libtwiddle.tw_bitmap_roaring_intersection.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_roaring_intersection.restype  = c_void_p
+
+libtwiddle.tw_bitmap_roaring_xor.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_roaring_xor.restype  = c_void_p
+
+libtwiddle.tw_bitmap_roaring_andnot.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_roaring_andnot.restype  = c_void_p
+
+# BITMAP_BSI
+
+libtwiddle.tw_bitmap_bsi_new.argtypes = [c_ulong, c_ubyte]
+libtwiddle.tw_bitmap_bsi_new.restype  = c_void_p
+
+libtwiddle.tw_bitmap_bsi_free.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_bsi_free.restype  = None
+
+libtwiddle.tw_bitmap_bsi_set.argtypes = [c_void_p, c_ulong, c_uint64]
+libtwiddle.tw_bitmap_bsi_set.restype  = None
+
+libtwiddle.tw_bitmap_bsi_clear.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_bsi_clear.restype  = None
+
+libtwiddle.tw_bitmap_bsi_get.argtypes = [c_void_p, c_ulong, POINTER(c_uint64)]
+libtwiddle.tw_bitmap_bsi_get.restype  = c_bool
+
+libtwiddle.tw_bitmap_bsi_count.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_bsi_count.restype  = c_ulong
+
+libtwiddle.tw_bitmap_bsi_compare.argtypes = [c_void_p, c_int, c_uint64,
+                                             c_void_p, c_void_p]
+libtwiddle.tw_bitmap_bsi_compare.restype  = c_void_p
+
+libtwiddle.tw_bitmap_bsi_between.argtypes = [c_void_p, c_uint64, c_uint64,
+                                             c_void_p, c_void_p]
+libtwiddle.tw_bitmap_bsi_between.restype  = c_void_p
+
+libtwiddle.tw_bitmap_bsi_sum.argtypes = [c_void_p, c_void_p]
+libtwiddle.tw_bitmap_bsi_sum.restype  = c_uint64
+
+libtwiddle.tw_bitmap_bsi_top_k.argtypes = [c_void_p, c_ulong, c_void_p,
+                                           c_void_p]
+libtwiddle.tw_bitmap_bsi_top_k.restype  = c_void_p
+
+# BITMAP_SUMMARY
+
+libtwiddle.tw_bitmap_summary_new.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_summary_new.restype  = c_void_p
+
+libtwiddle.tw_bitmap_summary_free.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_summary_free.restype  = None
+
+libtwiddle.tw_bitmap_summary_stale.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_summary_stale.restype  = c_bool
+
+libtwiddle.tw_bitmap_summary_update.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_summary_update.restype  = c_void_p
+
+libtwiddle.tw_bitmap_summary_set.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_summary_set.restype  = c_bool
+
+libtwiddle.tw_bitmap_summary_clear.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_summary_clear.restype  = c_bool
+
+libtwiddle.tw_bitmap_summary_find_first_zero.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_summary_find_first_zero.restype  = c_int64
+
+libtwiddle.tw_bitmap_summary_find_next_zero.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_summary_find_next_zero.restype  = c_int64
+
+libtwiddle.tw_bitmap_summary_find_first_bit.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_summary_find_first_bit.restype  = c_int64
+
+libtwiddle.tw_bitmap_summary_find_next_bit.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_summary_find_next_bit.restype  = c_int64
+
+libtwiddle.tw_bitmap_summary_alloc_id.argtypes = [c_void_p]
+libtwiddle.tw_bitmap_summary_alloc_id.restype  = c_int64
+
+libtwiddle.tw_bitmap_summary_free_id.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmap_summary_free_id.restype  = c_bool
+
+# BITMATRIX
+
+libtwiddle.tw_bitmatrix_new.argtypes = [c_ulong, c_ulong]
+libtwiddle.tw_bitmatrix_new.restype  = c_void_p
+
+libtwiddle.tw_bitmatrix_free.argtypes = [c_void_p]
+libtwiddle.tw_bitmatrix_free.restype  = None
+
+libtwiddle.tw_bitmatrix_set.argtypes = [c_void_p, c_ulong, c_ulong]
+libtwiddle.tw_bitmatrix_set.restype  = None
+
+libtwiddle.tw_bitmatrix_clear.argtypes = [c_void_p, c_ulong, c_ulong]
+libtwiddle.tw_bitmatrix_clear.restype  = None
+
+libtwiddle.tw_bitmatrix_test.argtypes = [c_void_p, c_ulong, c_ulong]
+libtwiddle.tw_bitmatrix_test.restype  = c_bool
+
+libtwiddle.tw_bitmatrix_row_union.argtypes = [c_void_p, c_ulong, c_ulong]
+libtwiddle.tw_bitmatrix_row_union.restype  = c_bool
+
+libtwiddle.tw_bitmatrix_row_intersection.argtypes = [c_void_p, c_ulong, c_ulong]
+libtwiddle.tw_bitmatrix_row_intersection.restype  = c_bool
+
+libtwiddle.tw_bitmatrix_row_count.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmatrix_row_count.restype  = c_ulong
+
+libtwiddle.tw_bitmatrix_col_count.argtypes = [c_void_p, c_ulong]
+libtwiddle.tw_bitmatrix_col_count.restype  = c_ulong
+
+libtwiddle.tw_bitmatrix_col_counts.argtypes = [c_void_p, POINTER(c_uint64)]
+libtwiddle.tw_bitmatrix_col_counts.restype  = c_bool
+
+libtwiddle.tw_bitmatrix_transpose.argtypes = [c_void_p]
+libtwiddle.tw_bitmatrix_transpose.restype  = c_void_p
+
+libtwiddle.tw_bitmatrix_expand.argtypes = [c_void_p, c_void_p, c_void_p]
+libtwiddle.tw_bitmatrix_expand.restype  = c_void_p
+
 # BLOOMFILTER
 
 libtwiddle.tw_bloomfilter_new.argtypes = [c_ulong, c_ushort]
 libtwiddle.tw_bloomfilter_new.restype  = c_void_p
 
+libtwiddle.tw_bloomfilter_new_flags.argtypes = [c_ulong, c_ushort, c_int]
+libtwiddle.tw_bloomfilter_new_flags.restype  = c_void_p
+
 libtwiddle.tw_bloomfilter_free.argtypes = [c_void_p]
 libtwiddle.tw_bloomfilter_free.restype  = None
 
@@ -155,6 +564,9 @@ libtwiddle.tw_bloomfilter_clone.restype  = c_void_p
 libtwiddle.tw_bloomfilter_set.argtypes = [c_void_p, c_void_p, c_ulong]
 libtwiddle.tw_bloomfilter_set.restype  = None
 
+libtwiddle.tw_bloomfilter_set_nocount.argtypes = [c_void_p, c_void_p, c_ulong]
+libtwiddle.tw_bloomfilter_set_nocount.restype  = None
+
 libtwiddle.tw_bloomfilter_test.argtypes = [c_void_p, c_void_p, c_ulong]
 libtwiddle.tw_bloomfilter_test.restype  = c_bool
 
@@ -249,6 +661,9 @@ libtwiddle.tw_bloomfilter_a2_xor.restype  = c_void_p
 libtwiddle.tw_hyperloglog_new.argtypes = [c_ushort]
 libtwiddle.tw_hyperloglog_new.restype  = c_void_p
 
+libtwiddle.tw_hyperloglog_new_flags.argtypes = [c_ubyte, c_int]
+libtwiddle.tw_hyperloglog_new_flags.restype  = c_void_p
+
 libtwiddle.tw_hyperloglog_free.argtypes = [c_void_p]
 libtwiddle.tw_hyperloglog_free.restype  = None
 
@@ -275,6 +690,9 @@ libtwiddle.tw_hyperloglog_merge.restype  = c_void_p
 libtwiddle.tw_minhash_new.argtypes = [c_uint]
 libtwiddle.tw_minhash_new.restype  = c_void_p
 
+libtwiddle.tw_minhash_new_flags.argtypes = [c_uint, c_int]
+libtwiddle.tw_minhash_new_flags.restype  = c_void_p
+
 libtwiddle.tw_minhash_free.argtypes = [c_void_p]
 libtwiddle.tw_minhash_free.restype  = None
 
@@ -2,8 +2,9 @@ from c import libtwiddle
 from ctypes import c_long, pointer
 
 class HyperLogLog(object):
-  def __init__(self, precision, ptr=None):
-    self.hyperloglog = ptr if ptr else libtwiddle.tw_hyperloglog_new(precision)
+  def __init__(self, precision, ptr=None, flags=0):
+    self.hyperloglog = ptr if ptr else \
+                       libtwiddle.tw_hyperloglog_new_flags(precision, flags)
     self.precision   = precision
 
 
@@ -2,8 +2,9 @@ from c import libtwiddle
 from ctypes import c_long, pointer
 
 class MinHash(object):
-  def __init__(self, n_registers, ptr=None):
-    self.minhash     = ptr if ptr else libtwiddle.tw_minhash_new(n_registers)
+  def __init__(self, n_registers, ptr=None, flags=0):
+    self.minhash     = ptr if ptr else \
+                       libtwiddle.tw_minhash_new_flags(n_registers, flags)
     self.n_registers = n_registers
 
 
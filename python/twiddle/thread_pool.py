@@ -0,0 +1,16 @@
+from c import libtwiddle
+
+class ThreadPool(object):
+  def __init__(self, n_threads):
+    self.pool = libtwiddle.tw_thread_pool_new(n_threads)
+    if not self.pool:
+      raise MemoryError("unable to start a pool of %d threads" % n_threads)
+
+
+  def __del__(self):
+    if self.pool:
+      libtwiddle.tw_thread_pool_free(self.pool)
+
+
+  def __len__(self):
+    return libtwiddle.tw_thread_pool_size(self.pool)
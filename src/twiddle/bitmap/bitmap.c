@@ -3,17 +3,20 @@
 #include <x86intrin.h>
 
 #include <twiddle/bitmap/bitmap.h>
+#include <twiddle/utils/simd.h>
 
 #include "../macrology.h"
+#include "../utils/pages.h"
+#include "../utils/popcount.h"
+#include "bitmap_internal.h"
 
-#define TW_BYTES_PER_BITMAP sizeof(uint64_t)
-#define TW_BITS_PER_BITMAP (TW_BYTES_PER_BITMAP * TW_BITS_IN_WORD)
+#define TW_BITMAP_POS(nbits) (nbits / TW_BITS_PER_BITMAP)
 
-#define BITMAP_POS(pos) (pos / TW_BITS_PER_BITMAP)
-#define MASK(pos) (1ULL << (pos % TW_BITS_PER_BITMAP))
+/* bytes allocated for `nbits`, a multiple of cache lines */
+#define TW_BITMAP_DATA_SIZE(nbits)                                             \
+  TW_ALLOC_TO_CACHELINE(TW_BITMAP_PER_BITS(nbits) * TW_BYTES_PER_BITMAP)
 
-#define TW_BITMAP_PER_BITS(nbits) TW_DIV_ROUND_UP(nbits, TW_BITS_PER_BITMAP)
-#define TW_BITMAP_POS(nbits) (nbits / TW_BITS_PER_BITMAP)
+static uint64_t tw_bitmap_recount(const struct tw_bitmap *bitmap);
 
 static inline void tw_bitmap_clear_extra_bits(struct tw_bitmap *bitmap)
 {
@@ -26,7 +29,12 @@ static inline void tw_bitmap_clear_extra_bits(struct tw_bitmap *bitmap)
 
 struct tw_bitmap *tw_bitmap_new(uint64_t size)
 {
-  if (0 == size || size > TW_BITMAP_MAX_BITS) {
+  return tw_bitmap_new_flags(size, TW_ALLOC_DEFAULT);
+}
+
+struct tw_bitmap *tw_bitmap_new_flags(uint64_t size, int flags)
+{
+  if (0 == size || size > TW_BITMAP_MAX_BITS || (flags & TW_ALLOC_WRAPPED)) {
     return NULL;
   }
 
@@ -36,34 +44,80 @@ struct tw_bitmap *tw_bitmap_new(uint64_t size)
     return NULL;
   }
 
-  const size_t data_size =
-      TW_ALLOC_TO_CACHELINE(TW_BITMAP_PER_BITS(size) * TW_BYTES_PER_BITMAP);
+  const size_t data_size = TW_BITMAP_DATA_SIZE(size);
+
+  if (flags != TW_ALLOC_DEFAULT) {
+    /* mapped pages are already zeroed */
+    if ((bitmap->data = tw_pages_alloc(data_size, flags)) == NULL) {
+      free(bitmap);
+      return NULL;
+    }
+    bitmap->mapping = bitmap->data;
+    bitmap->mapping_size = tw_pages_size(data_size, flags);
+  } else {
+    if ((bitmap->data = malloc_aligned(TW_CACHELINE, data_size)) == NULL) {
+      free(bitmap);
+      return NULL;
+    }
+    memset(bitmap->data, 0, data_size);
+  }
+
+  bitmap->size = data_size * TW_BITS_IN_WORD;
+  bitmap->flags = flags;
+  bitmap->capacity = bitmap->mapping
+                         ? bitmap->mapping_size * TW_BITS_IN_WORD
+                         : bitmap->size;
+  return bitmap;
+}
+
+struct tw_bitmap *tw_bitmap_wrap(void *data, uint64_t size)
+{
+  if (!data || (uintptr_t)data % TW_CACHELINE || 0 == size ||
+      size > TW_BITMAP_MAX_BITS ||
+      size != TW_BITMAP_DATA_SIZE(size) * TW_BITS_IN_WORD) {
+    return NULL;
+  }
 
-  if ((bitmap->data = malloc_aligned(TW_CACHELINE, data_size)) == NULL) {
-    free(bitmap);
+  struct tw_bitmap *bitmap = calloc(1, sizeof(struct tw_bitmap));
+  if (!bitmap) {
     return NULL;
   }
 
-  memset(bitmap->data, 0, data_size);
+  /* counted on demand, wrapping is constant time */
+  bitmap->size = bitmap->capacity = size;
+  bitmap->data = data;
+  bitmap->stale = true;
+  bitmap->flags = TW_ALLOC_WRAPPED;
 
-  bitmap->size = data_size * TW_BITS_IN_WORD;
   return bitmap;
 }
 
 void tw_bitmap_free(struct tw_bitmap *bitmap)
 {
-  free(bitmap->data);
+  if (bitmap->cow) {
+    tw_bitmap_cow_free(bitmap);
+  } else if (tw_bitmap_is_file_backed(bitmap)) {
+    tw_bitmap_unmap(bitmap);
+  } else if (bitmap->mapping) {
+    tw_pages_free(bitmap->mapping, bitmap->mapping_size, bitmap->flags);
+  } else if (!tw_bitmap_is_wrapped(bitmap)) {
+    free(bitmap->data);
+  }
   free(bitmap);
 }
 
 struct tw_bitmap *tw_bitmap_copy(const struct tw_bitmap *src,
                                  struct tw_bitmap *dst)
 {
-  if (!src || !dst || dst->size != src->size) {
+  if (!src || !dst ||
+      (dst->size != src->size && !tw_bitmap_resize(dst, src->size)) ||
+      !tw_bitmap_all_writable(dst)) {
     return NULL;
   }
 
   dst->count = src->count;
+  dst->stale = src->stale;
+  dst->generation++;
   memcpy(dst->data, src->data,
          TW_BITMAP_PER_BITS(src->size) * TW_BYTES_PER_BITMAP);
 
@@ -93,9 +147,12 @@ inline void tw_bitmap_set(struct tw_bitmap *bitmap, uint64_t pos)
   const uint64_t old_bitmap = bitmap->data[BITMAP_POS(pos)];
   const uint64_t new_bitmap = old_bitmap | MASK(pos);
   const bool changed = (old_bitmap != new_bitmap);
+  if (changed && !tw_bitmap_writable_pos(bitmap, pos)) {
+    return;
+  }
   bitmap->count += changed;
+  bitmap->generation += changed;
   bitmap->data[BITMAP_POS(pos)] = new_bitmap;
-  ;
 }
 
 inline void tw_bitmap_clear(struct tw_bitmap *bitmap, uint64_t pos)
@@ -107,10 +164,37 @@ inline void tw_bitmap_clear(struct tw_bitmap *bitmap, uint64_t pos)
   const uint64_t old_bitmap = bitmap->data[BITMAP_POS(pos)];
   const uint64_t new_bitmap = old_bitmap & ~MASK(pos);
   const bool changed = (old_bitmap != new_bitmap);
+  if (changed && !tw_bitmap_writable_pos(bitmap, pos)) {
+    return;
+  }
   bitmap->count -= changed;
+  bitmap->generation += changed;
   bitmap->data[BITMAP_POS(pos)] = new_bitmap;
 }
 
+void tw_bitmap_set_nocount(struct tw_bitmap *bitmap, uint64_t pos)
+{
+  if (!bitmap || pos >= bitmap->size ||
+      !tw_bitmap_writable_pos(bitmap, pos)) {
+    return;
+  }
+
+  /* `generation` is bumped once by the recount ending the stale run */
+  bitmap->data[BITMAP_POS(pos)] |= MASK(pos);
+  bitmap->stale = true;
+}
+
+void tw_bitmap_clear_nocount(struct tw_bitmap *bitmap, uint64_t pos)
+{
+  if (!bitmap || pos >= bitmap->size ||
+      !tw_bitmap_writable_pos(bitmap, pos)) {
+    return;
+  }
+
+  bitmap->data[BITMAP_POS(pos)] &= ~MASK(pos);
+  bitmap->stale = true;
+}
+
 bool tw_bitmap_test(const struct tw_bitmap *bitmap, uint64_t pos)
 {
   if (!bitmap || pos >= bitmap->size) {
@@ -129,7 +213,11 @@ bool tw_bitmap_test_and_set(struct tw_bitmap *bitmap, uint64_t pos)
   const uint64_t old_bitmap = bitmap->data[BITMAP_POS(pos)];
   const uint64_t new_bitmap = old_bitmap | MASK(pos);
   const bool changed = (old_bitmap != new_bitmap);
+  if (changed && !tw_bitmap_writable_pos(bitmap, pos)) {
+    return false;
+  }
   bitmap->count += changed;
+  bitmap->generation += changed;
   bitmap->data[BITMAP_POS(pos)] = new_bitmap;
   return !changed;
 }
@@ -143,7 +231,11 @@ bool tw_bitmap_test_and_clear(struct tw_bitmap *bitmap, uint64_t pos)
   const uint64_t old_bitmap = bitmap->data[BITMAP_POS(pos)];
   const uint64_t new_bitmap = old_bitmap & ~MASK(pos);
   const bool changed = (old_bitmap != new_bitmap);
+  if (changed && !tw_bitmap_writable_pos(bitmap, pos)) {
+    return false;
+  }
   bitmap->count -= changed;
+  bitmap->generation += changed;
   bitmap->data[BITMAP_POS(pos)] = new_bitmap;
   return changed;
 }
@@ -154,7 +246,7 @@ bool tw_bitmap_empty(const struct tw_bitmap *bitmap)
     return false;
   }
 
-  return bitmap->count == 0;
+  return tw_bitmap_recount(bitmap) == 0;
 }
 
 bool tw_bitmap_full(const struct tw_bitmap *bitmap)
@@ -163,7 +255,7 @@ bool tw_bitmap_full(const struct tw_bitmap *bitmap)
     return false;
   }
 
-  return bitmap->size == bitmap->count;
+  return bitmap->size == tw_bitmap_recount(bitmap);
 }
 
 uint64_t tw_bitmap_count(const struct tw_bitmap *bitmap)
@@ -172,7 +264,7 @@ uint64_t tw_bitmap_count(const struct tw_bitmap *bitmap)
     return 0;
   }
 
-  return bitmap->count;
+  return tw_bitmap_recount(bitmap);
 }
 
 float tw_bitmap_density(const struct tw_bitmap *bitmap)
@@ -181,12 +273,12 @@ float tw_bitmap_density(const struct tw_bitmap *bitmap)
     return 0.0f;
   }
 
-  return bitmap->count / (float)bitmap->size;
+  return tw_bitmap_recount(bitmap) / (float)bitmap->size;
 }
 
 struct tw_bitmap *tw_bitmap_zero(struct tw_bitmap *bitmap)
 {
-  if (!bitmap) {
+  if (!bitmap || !tw_bitmap_all_writable(bitmap)) {
     return NULL;
   }
 
@@ -194,13 +286,15 @@ struct tw_bitmap *tw_bitmap_zero(struct tw_bitmap *bitmap)
          TW_BITMAP_PER_BITS(bitmap->size) * TW_BYTES_PER_BITMAP);
 
   bitmap->count = 0U;
+  bitmap->stale = false;
+  bitmap->generation++;
 
   return bitmap;
 }
 
 struct tw_bitmap *tw_bitmap_fill(struct tw_bitmap *bitmap)
 {
-  if (!bitmap) {
+  if (!bitmap || !tw_bitmap_all_writable(bitmap)) {
     return NULL;
   }
 
@@ -210,238 +304,2060 @@ struct tw_bitmap *tw_bitmap_fill(struct tw_bitmap *bitmap)
   tw_bitmap_clear_extra_bits(bitmap);
 
   bitmap->count = bitmap->size;
+  bitmap->stale = false;
+  bitmap->generation++;
 
   return bitmap;
 }
 
-int64_t tw_bitmap_find_first_zero(const struct tw_bitmap *bitmap)
-{
-  if (!bitmap) {
-    return -1;
+#define VECTORS_IN_BITS(simd_t, n_bits)                                        \
+  (n_bits / (sizeof(simd_t) * TW_BITS_IN_WORD))
+
+/* portable kernels may be instantiated with words as vectors */
+#define tw_word_set1(x) (x)
+#define tw_word_load(addr) (*(addr))
+#define tw_word_store(addr, w) (*(addr) = (w))
+#define tw_word_xor(a, b) ((a) ^ (b))
+#define tw_word_equal(a, b) ((a) == (b))
+#define tw_word_zero(w) ((w) == 0)
+#define tw_word_full(w) ((w) == ~0UL)
+#define tw_word_or(a, b) ((a) | (b))
+#define tw_word_and(a, b) ((a) & (b))
+#define tw_word_andnot(a, b) ((a) & ~(b))
+#define tw_word_disjoint(a, b) (((a) & (b)) == 0)
+#define tw_word_subset(a, b) (((a) & ~(b)) == 0)
+#define tw_word_ornot(a, b) ((a) | ~(b))
+#define tw_word_shld(hi, lo, l, r) (((hi) << (l)) | ((lo) >> (r)))
+#define tw_word_shrd(lo, hi, l, r) (((lo) >> (l)) | ((hi) << (r)))
+
+/**
+ * SIMD kernels are instantiated once per instruction set from the following
+ * loops, and selected at runtime via `tw_bitmap_kernels_()`.
+ */
+
+#define BITMAP_NOT_LOOP(simd_t, simd_set1, simd_load, simd_xor, simd_store)    \
+  const simd_t mask = simd_set1(~0);                                           \
+  for (size_t i = 0; i < VECTORS_IN_BITS(simd_t, size); ++i) {                 \
+    simd_t *addr = (simd_t *)bitmap->data + i;                                 \
+    const simd_t res = simd_xor(simd_load(addr), mask);                        \
+    simd_store(addr, res);                                                     \
   }
 
-  /**
-   * This check is required since we allocate memory on multiple of uint64_t.
-   * Thus if bitmap.size is not aligned on 64 bits, a full bitmap
-   * would incorrectly report nbits+1 as the position of the first zero.
-   */
-  if (tw_unlikely(tw_bitmap_full(bitmap))) {
-    return -1;
+#define BITMAP_NOT_KERNEL(name, target, simd_t, simd_set1, simd_load,          \
+                          simd_xor, simd_store)                                \
+  static target void name(struct tw_bitmap *bitmap)                            \
+  {                                                                            \
+    const uint64_t size = bitmap->size;                                        \
+    BITMAP_NOT_LOOP(simd_t, simd_set1, simd_load, simd_xor, simd_store)        \
   }
 
-  for (size_t i = 0; i < TW_BITMAP_PER_BITS(bitmap->size); ++i) {
-    const int pos = __builtin_ffsll(~bitmap->data[i]);
-    if (pos) {
-      return (i * TW_BITS_PER_BITMAP) + (pos - 1);
-    }
+/**
+ * Relations hold if `simd_pred` holds on every pair of vectors, the loop
+ * exits on the first pair witnessing otherwise.
+ */
+#define BITMAP_ALL_LOOP(simd_t, simd_load, simd_pred)                          \
+  for (size_t i = 0; i < VECTORS_IN_BITS(simd_t, size); ++i) {                 \
+    const simd_t fst_vec = simd_load((simd_t *)fst->data + i),                 \
+                 snd_vec = simd_load((simd_t *)snd->data + i);                 \
+    if (!simd_pred(fst_vec, snd_vec)) {                                        \
+      return false;                                                            \
+    }                                                                          \
   }
 
-  return -1;
-}
+#define BITMAP_ALL_KERNEL(name, target, simd_t, simd_load, simd_pred)          \
+  static target bool name(const struct tw_bitmap *fst,                         \
+                          const struct tw_bitmap *snd)                         \
+  {                                                                            \
+    const uint64_t size = fst->size;                                           \
+    BITMAP_ALL_LOOP(simd_t, simd_load, simd_pred)                              \
+    return true;                                                               \
+  }
 
-int64_t tw_bitmap_find_first_bit(const struct tw_bitmap *bitmap)
-{
-  if (!bitmap) {
-    return -1;
+/**
+ * Boolean operations store their result and count it in a single pass, the
+ * vector returned by `name##_vec` is fed to a `TW_POPCNT_*` kernel.
+ */
+#define BITMAP_OP_KERNEL(name, target, simd_t, simd_load, simd_op, simd_store, \
+                         simd_popcnt)                                          \
+  static inline target simd_t name##_vec(const struct tw_bitmap *src,          \
+                                         struct tw_bitmap *dst, size_t i)      \
+  {                                                                            \
+    simd_t *src_vec = (simd_t *)src->data + i,                                 \
+           *dst_vec = (simd_t *)dst->data + i;                                 \
+    const simd_t res = simd_op(simd_load(src_vec), simd_load(dst_vec));        \
+    simd_store(dst_vec, res);                                                  \
+    return res;                                                                \
+  }                                                                            \
+                                                                               \
+  static target uint64_t name(const struct tw_bitmap *src,                     \
+                              struct tw_bitmap *dst)                           \
+  {                                                                            \
+    uint64_t count = 0;                                                        \
+    simd_popcnt(count, VECTORS_IN_BITS(simd_t, src->size), name##_vec, src,    \
+                dst);                                                          \
+    return count;                                                              \
   }
 
-  /**
-   * This check is required since we allocate memory on multiple of bitmap_t
-   * Thus if bitmap.size is not aligned on 64 bits, a full bitmap
-   * filled with tw_bitmap_fill and then cleared manually with
-   * tw_bitmap_clear,
-   * could report the first bit to be greater than nbits.
-   */
-  if (tw_unlikely(tw_bitmap_empty(bitmap))) {
-    return -1;
+/**
+ * Three-operand boolean operations, `out = a op b`, where `out` may alias
+ * either operand. In-place operations are a special case, thus the
+ * destination is never copied beforehand.
+ */
+#define BITMAP_OP3_KERNEL(name, target, simd_t, simd_load, simd_op,            \
+                          simd_store, simd_popcnt)                             \
+  static inline target simd_t name##_vec(const struct tw_bitmap *a,            \
+                                         const struct tw_bitmap *b,            \
+                                         struct tw_bitmap *out, size_t i)      \
+  {                                                                            \
+    const simd_t res = simd_op(simd_load((simd_t *)a->data + i),               \
+                               simd_load((simd_t *)b->data + i));              \
+    simd_store((simd_t *)out->data + i, res);                                  \
+    return res;                                                                \
+  }                                                                            \
+                                                                               \
+  static target uint64_t name(const struct tw_bitmap *a,                       \
+                              const struct tw_bitmap *b,                       \
+                              struct tw_bitmap *out)                           \
+  {                                                                            \
+    uint64_t count = 0;                                                        \
+    simd_popcnt(count, VECTORS_IN_BITS(simd_t, out->size), name##_vec, a, b,   \
+                out);                                                          \
+    return count;                                                              \
+  }
+
+#define BITMAP_OP3_KERNELS(isa, target, simd_t, simd_load, simd_or, simd_and,  \
+                           simd_xor, simd_andnot, simd_ornot, simd_store,      \
+                           simd_popcnt)                                        \
+  BITMAP_OP3_KERNEL(tw_bitmap_or3_##isa, target, simd_t, simd_load, simd_or,   \
+                    simd_store, simd_popcnt)                                   \
+  BITMAP_OP3_KERNEL(tw_bitmap_and3_##isa, target, simd_t, simd_load, simd_and, \
+                    simd_store, simd_popcnt)                                   \
+  BITMAP_OP3_KERNEL(tw_bitmap_xor3_##isa, target, simd_t, simd_load, simd_xor, \
+                    simd_store, simd_popcnt)                                   \
+  BITMAP_OP3_KERNEL(tw_bitmap_andnot3_##isa, target, simd_t, simd_load,        \
+                    simd_andnot, simd_store, simd_popcnt)                      \
+  BITMAP_OP3_KERNEL(tw_bitmap_ornot3_##isa, target, simd_t, simd_load,         \
+                    simd_ornot, simd_store, simd_popcnt)
+
+/**
+ * Count the active bits of a boolean operation without storing its result.
+ */
+#define BITMAP_COUNT_KERNEL(name, target, simd_t, simd_load, simd_op,          \
+                            simd_popcnt)                                       \
+  static inline target simd_t name##_vec(const struct tw_bitmap *fst,          \
+                                         const struct tw_bitmap *snd,          \
+                                         size_t i)                             \
+  {                                                                            \
+    return simd_op(simd_load((simd_t *)fst->data + i),                         \
+                   simd_load((simd_t *)snd->data + i));                        \
+  }                                                                            \
+                                                                               \
+  static target uint64_t name(const struct tw_bitmap *fst,                     \
+                              const struct tw_bitmap *snd)                     \
+  {                                                                            \
+    uint64_t count = 0;                                                        \
+    simd_popcnt(count, VECTORS_IN_BITS(simd_t, fst->size), name##_vec, fst,    \
+                snd);                                                          \
+    return count;                                                              \
+  }
+
+/**
+ * N-ary operations fold every source's i-th vector before storing it in the
+ * destination, thus the destination is written once and counted once. Folding
+ * stops early once the vector reaches the operation's absorbing element, e.g.
+ * zero for an intersection.
+ */
+#define BITMAP_MANY_KERNEL(name, target, simd_t, simd_load, simd_op,           \
+                           simd_store, simd_absorbing, simd_popcnt)            \
+  static inline target simd_t name##_vec(const struct tw_bitmap *const *srcs,  \
+                                         size_t n_srcs, struct tw_bitmap *dst, \
+                                         size_t i)                             \
+  {                                                                            \
+    simd_t res = simd_load((simd_t *)srcs[0]->data + i);                       \
+    for (size_t k = 1; k < n_srcs && !simd_absorbing(res); ++k) {              \
+      res = simd_op(res, simd_load((simd_t *)srcs[k]->data + i));              \
+    }                                                                          \
+    simd_store((simd_t *)dst->data + i, res);                                  \
+    return res;                                                                \
+  }                                                                            \
+                                                                               \
+  static target uint64_t name(const struct tw_bitmap *const *srcs,             \
+                              size_t n_srcs, struct tw_bitmap *dst)            \
+  {                                                                            \
+    uint64_t count = 0;                                                        \
+    simd_popcnt(count, VECTORS_IN_BITS(simd_t, dst->size), name##_vec, srcs,   \
+                n_srcs, dst);                                                  \
+    return count;                                                              \
   }
 
+static void tw_bitmap_not_port(struct tw_bitmap *bitmap)
+{
   for (size_t i = 0; i < TW_BITMAP_PER_BITS(bitmap->size); ++i) {
-    const int pos = __builtin_ffsll(bitmap->data[i]);
-    if (pos) {
-      return (i * TW_BITS_PER_BITMAP) + (pos - 1);
+    bitmap->data[i] ^= ~0UL;
+  }
+}
+
+static bool tw_bitmap_equal_port(const struct tw_bitmap *fst,
+                                 const struct tw_bitmap *snd)
+{
+  for (size_t i = 0; i < TW_BITMAP_PER_BITS(fst->size); ++i) {
+    if (fst->data[i] != snd->data[i]) {
+      return false;
     }
   }
 
-  return -1;
+  return true;
 }
 
-#define VECTORS_IN_BITS(simd_t, n_bits)                                        \
-  (n_bits / (sizeof(simd_t) * TW_BITS_IN_WORD))
+BITMAP_ALL_KERNEL(tw_bitmap_disjoint_port, , uint64_t, tw_word_load,
+                  tw_word_disjoint)
+BITMAP_ALL_KERNEL(tw_bitmap_subset_port, , uint64_t, tw_word_load,
+                  tw_word_subset)
+
+#define BITMAP_OP_PORT(name, op)                                               \
+  static inline uint64_t name##_word(const struct tw_bitmap *src,              \
+                                     struct tw_bitmap *dst, size_t i)          \
+  {                                                                            \
+    return dst->data[i] = dst->data[i] op src->data[i];                        \
+  }                                                                            \
+                                                                               \
+  static uint64_t name(const struct tw_bitmap *src, struct tw_bitmap *dst)     \
+  {                                                                            \
+    uint64_t count = 0;                                                        \
+    TW_POPCNT_PORT(count, TW_BITMAP_PER_BITS(src->size), name##_word, src,     \
+                   dst);                                                       \
+    return count;                                                              \
+  }
 
-#define BITMAP_NOT_LOOP(simd_t, simd_set1, simd_load, simd_xor, simd_store)    \
-  const simd_t mask = simd_set1(~0);                                           \
-  for (size_t i = 0; i < VECTORS_IN_BITS(simd_t, size); ++i) {                 \
-    simd_t *addr = (simd_t *)bitmap->data + i;                                 \
-    const simd_t res = simd_xor(simd_load(addr), mask);                        \
-    simd_store(addr, res);                                                     \
+BITMAP_OP_PORT(tw_bitmap_or_port, |)
+BITMAP_OP_PORT(tw_bitmap_and_port, &)
+BITMAP_OP_PORT(tw_bitmap_xor_port, ^)
+
+#define BITMAP_MANY_PORT(name, op, absorbing)                                  \
+  static inline uint64_t name##_word(const struct tw_bitmap *const *srcs,      \
+                                     size_t n_srcs, struct tw_bitmap *dst,     \
+                                     size_t i)                                 \
+  {                                                                            \
+    uint64_t res = srcs[0]->data[i];                                           \
+    for (size_t k = 1; k < n_srcs && !absorbing(res); ++k) {                   \
+      res = res op srcs[k]->data[i];                                           \
+    }                                                                          \
+    return dst->data[i] = res;                                                 \
+  }                                                                            \
+                                                                               \
+  static uint64_t name(const struct tw_bitmap *const *srcs, size_t n_srcs,     \
+                       struct tw_bitmap *dst)                                  \
+  {                                                                            \
+    uint64_t count = 0;                                                        \
+    TW_POPCNT_PORT(count, TW_BITMAP_PER_BITS(dst->size), name##_word, srcs,    \
+                   n_srcs, dst);                                               \
+    return count;                                                              \
   }
 
-struct tw_bitmap *tw_bitmap_not(struct tw_bitmap *bitmap)
+BITMAP_OP3_KERNELS(port, , uint64_t, tw_word_load, tw_word_or, tw_word_and,
+                   tw_word_xor, tw_word_andnot, tw_word_ornot, tw_word_store,
+                   TW_POPCNT_PORT)
+
+BITMAP_MANY_PORT(tw_bitmap_or_many_port, |, tw_word_full)
+BITMAP_MANY_PORT(tw_bitmap_and_many_port, &, tw_word_zero)
+
+static inline uint64_t
+tw_bitmap_and_count_port_word(const struct tw_bitmap *fst,
+                              const struct tw_bitmap *snd, size_t i)
 {
-  if (!bitmap) {
-    return NULL;
-  }
+  return fst->data[i] & snd->data[i];
+}
 
-  const uint64_t size = bitmap->size;
+static uint64_t tw_bitmap_and_count_port(const struct tw_bitmap *fst,
+                                         const struct tw_bitmap *snd)
+{
+  uint64_t count = 0;
+  TW_POPCNT_PORT(count, TW_BITMAP_PER_BITS(fst->size),
+                 tw_bitmap_and_count_port_word, fst, snd);
+  return count;
+}
+
+#ifdef USE_AVX
+BITMAP_NOT_KERNEL(tw_bitmap_not_avx, TW_TARGET_AVX, __m128i, _mm_set1_epi8,
+                  _mm_load_si128, _mm_xor_si128, _mm_store_si128)
+BITMAP_ALL_KERNEL(tw_bitmap_equal_avx, TW_TARGET_AVX, __m128i, _mm_load_si128,
+                  tw_mm_equal)
+BITMAP_ALL_KERNEL(tw_bitmap_disjoint_avx, TW_TARGET_AVX, __m128i,
+                  _mm_load_si128, tw_mm_disjoint)
+BITMAP_ALL_KERNEL(tw_bitmap_subset_avx, TW_TARGET_AVX, __m128i, _mm_load_si128,
+                  tw_mm_subset)
+BITMAP_OP_KERNEL(tw_bitmap_or_avx, TW_TARGET_AVX, __m128i, _mm_load_si128,
+                 _mm_or_si128, _mm_store_si128, TW_POPCNT_AVX)
+BITMAP_OP_KERNEL(tw_bitmap_and_avx, TW_TARGET_AVX, __m128i, _mm_load_si128,
+                 _mm_and_si128, _mm_store_si128, TW_POPCNT_AVX)
+BITMAP_OP_KERNEL(tw_bitmap_xor_avx, TW_TARGET_AVX, __m128i, _mm_load_si128,
+                 _mm_xor_si128, _mm_store_si128, TW_POPCNT_AVX)
+BITMAP_OP3_KERNELS(avx, TW_TARGET_AVX, __m128i, _mm_load_si128, _mm_or_si128,
+                   _mm_and_si128, _mm_xor_si128, tw_mm_andnot, tw_mm_ornot,
+                   _mm_store_si128, TW_POPCNT_AVX)
+BITMAP_COUNT_KERNEL(tw_bitmap_and_count_avx, TW_TARGET_AVX, __m128i,
+                    _mm_load_si128, _mm_and_si128, TW_POPCNT_AVX)
+BITMAP_MANY_KERNEL(tw_bitmap_or_many_avx, TW_TARGET_AVX, __m128i,
+                   _mm_load_si128, _mm_or_si128, _mm_store_si128, tw_mm_full,
+                   TW_POPCNT_AVX)
+BITMAP_MANY_KERNEL(tw_bitmap_and_many_avx, TW_TARGET_AVX, __m128i,
+                   _mm_load_si128, _mm_and_si128, _mm_store_si128, tw_mm_zero,
+                   TW_POPCNT_AVX)
+#endif
+
+#ifdef USE_AVX2
+BITMAP_NOT_KERNEL(tw_bitmap_not_avx2, TW_TARGET_AVX2, __m256i,
+                  _mm256_set1_epi8, _mm256_load_si256, _mm256_xor_si256,
+                  _mm256_store_si256)
+BITMAP_ALL_KERNEL(tw_bitmap_equal_avx2, TW_TARGET_AVX2, __m256i,
+                  _mm256_load_si256, tw_mm256_equal)
+BITMAP_ALL_KERNEL(tw_bitmap_disjoint_avx2, TW_TARGET_AVX2, __m256i,
+                  _mm256_load_si256, tw_mm256_disjoint)
+BITMAP_ALL_KERNEL(tw_bitmap_subset_avx2, TW_TARGET_AVX2, __m256i,
+                  _mm256_load_si256, tw_mm256_subset)
+BITMAP_OP_KERNEL(tw_bitmap_or_avx2, TW_TARGET_AVX2, __m256i, _mm256_load_si256,
+                 _mm256_or_si256, _mm256_store_si256, TW_POPCNT_AVX2)
+BITMAP_OP_KERNEL(tw_bitmap_and_avx2, TW_TARGET_AVX2, __m256i, _mm256_load_si256,
+                 _mm256_and_si256, _mm256_store_si256, TW_POPCNT_AVX2)
+BITMAP_OP_KERNEL(tw_bitmap_xor_avx2, TW_TARGET_AVX2, __m256i, _mm256_load_si256,
+                 _mm256_xor_si256, _mm256_store_si256, TW_POPCNT_AVX2)
+BITMAP_OP3_KERNELS(avx2, TW_TARGET_AVX2, __m256i, _mm256_load_si256,
+                   _mm256_or_si256, _mm256_and_si256, _mm256_xor_si256,
+                   tw_mm256_andnot, tw_mm256_ornot, _mm256_store_si256,
+                   TW_POPCNT_AVX2)
+BITMAP_COUNT_KERNEL(tw_bitmap_and_count_avx2, TW_TARGET_AVX2, __m256i,
+                    _mm256_load_si256, _mm256_and_si256, TW_POPCNT_AVX2)
+BITMAP_MANY_KERNEL(tw_bitmap_or_many_avx2, TW_TARGET_AVX2, __m256i,
+                   _mm256_load_si256, _mm256_or_si256, _mm256_store_si256,
+                   tw_mm256_full, TW_POPCNT_AVX2)
+BITMAP_MANY_KERNEL(tw_bitmap_and_many_avx2, TW_TARGET_AVX2, __m256i,
+                   _mm256_load_si256, _mm256_and_si256, _mm256_store_si256,
+                   tw_mm256_zero, TW_POPCNT_AVX2)
+#endif
 
 #ifdef USE_AVX512
-  BITMAP_NOT_LOOP(__m512i, _mm512_set1_epi8, _mm512_load_si512,
-                  _mm512_xor_si512, _mm512_store_si512)
-#elif defined USE_AVX2
-  BITMAP_NOT_LOOP(__m256i, _mm256_set1_epi8, _mm256_load_si256,
-                  _mm256_xor_si256, _mm256_store_si256)
-#elif defined USE_AVX
-  BITMAP_NOT_LOOP(__m128i, _mm_set1_epi8, _mm_load_si128, _mm_xor_si128,
-                  _mm_store_si128)
-#else
-  for (size_t i = 0; i < TW_BITMAP_PER_BITS(size); ++i) {
-    bitmap->data[i] ^= ~0UL;
-  }
+BITMAP_NOT_KERNEL(tw_bitmap_not_avx512, TW_TARGET_AVX512, __m512i,
+                  _mm512_set1_epi8, _mm512_load_si512, _mm512_xor_si512,
+                  _mm512_store_si512)
+BITMAP_ALL_KERNEL(tw_bitmap_equal_avx512, TW_TARGET_AVX512, __m512i,
+                  _mm512_load_si512, tw_mm512_equal)
+BITMAP_ALL_KERNEL(tw_bitmap_disjoint_avx512, TW_TARGET_AVX512, __m512i,
+                  _mm512_load_si512, tw_mm512_disjoint)
+BITMAP_ALL_KERNEL(tw_bitmap_subset_avx512, TW_TARGET_AVX512, __m512i,
+                  _mm512_load_si512, tw_mm512_subset)
+BITMAP_OP_KERNEL(tw_bitmap_or_avx512, TW_TARGET_AVX512, __m512i,
+                 _mm512_load_si512, _mm512_or_si512, _mm512_store_si512,
+                 TW_POPCNT_AVX512)
+BITMAP_OP_KERNEL(tw_bitmap_and_avx512, TW_TARGET_AVX512, __m512i,
+                 _mm512_load_si512, _mm512_and_si512, _mm512_store_si512,
+                 TW_POPCNT_AVX512)
+BITMAP_OP_KERNEL(tw_bitmap_xor_avx512, TW_TARGET_AVX512, __m512i,
+                 _mm512_load_si512, _mm512_xor_si512, _mm512_store_si512,
+                 TW_POPCNT_AVX512)
+BITMAP_OP3_KERNELS(avx512, TW_TARGET_AVX512, __m512i, _mm512_load_si512,
+                   _mm512_or_si512, _mm512_and_si512, _mm512_xor_si512,
+                   tw_mm512_andnot, tw_mm512_ornot, _mm512_store_si512,
+                   TW_POPCNT_AVX512)
+BITMAP_COUNT_KERNEL(tw_bitmap_and_count_avx512, TW_TARGET_AVX512, __m512i,
+                    _mm512_load_si512, _mm512_and_si512, TW_POPCNT_AVX512)
+BITMAP_MANY_KERNEL(tw_bitmap_or_many_avx512, TW_TARGET_AVX512, __m512i,
+                   _mm512_load_si512, _mm512_or_si512, _mm512_store_si512,
+                   tw_mm512_full, TW_POPCNT_AVX512)
+BITMAP_MANY_KERNEL(tw_bitmap_and_many_avx512, TW_TARGET_AVX512, __m512i,
+                   _mm512_load_si512, _mm512_and_si512, _mm512_store_si512,
+                   tw_mm512_zero, TW_POPCNT_AVX512)
 #endif
 
-  bitmap->count = bitmap->size - bitmap->count;
+#ifdef USE_AVX512_ICL
+BITMAP_OP_KERNEL(tw_bitmap_or_avx512_icl, TW_TARGET_AVX512_ICL, __m512i,
+                 _mm512_load_si512, _mm512_or_si512, _mm512_store_si512,
+                 TW_POPCNT_AVX512_ICL)
+BITMAP_OP_KERNEL(tw_bitmap_and_avx512_icl, TW_TARGET_AVX512_ICL, __m512i,
+                 _mm512_load_si512, _mm512_and_si512, _mm512_store_si512,
+                 TW_POPCNT_AVX512_ICL)
+BITMAP_OP_KERNEL(tw_bitmap_xor_avx512_icl, TW_TARGET_AVX512_ICL, __m512i,
+                 _mm512_load_si512, _mm512_xor_si512, _mm512_store_si512,
+                 TW_POPCNT_AVX512_ICL)
+BITMAP_OP3_KERNELS(avx512_icl, TW_TARGET_AVX512_ICL, __m512i,
+                   _mm512_load_si512, _mm512_or_si512, _mm512_and_si512,
+                   _mm512_xor_si512, tw_mm512_andnot, tw_mm512_ornot,
+                   _mm512_store_si512, TW_POPCNT_AVX512_ICL)
+BITMAP_COUNT_KERNEL(tw_bitmap_and_count_avx512_icl, TW_TARGET_AVX512_ICL,
+                    __m512i, _mm512_load_si512, _mm512_and_si512,
+                    TW_POPCNT_AVX512_ICL)
+BITMAP_MANY_KERNEL(tw_bitmap_or_many_avx512_icl, TW_TARGET_AVX512_ICL, __m512i,
+                   _mm512_load_si512, _mm512_or_si512, _mm512_store_si512,
+                   tw_mm512_full, TW_POPCNT_AVX512_ICL)
+BITMAP_MANY_KERNEL(tw_bitmap_and_many_avx512_icl, TW_TARGET_AVX512_ICL, __m512i,
+                   _mm512_load_si512, _mm512_and_si512, _mm512_store_si512,
+                   tw_mm512_zero, TW_POPCNT_AVX512_ICL)
+#endif
 
-  return bitmap;
-}
+/**
+ * Positions extraction decodes a word at a time with `word_fn`, which writes
+ * all the active positions of a word. `word_fn` may write up to
+ * `TW_BITS_PER_BITMAP` positions, thus words are decoded one position at a
+ * time when nearing `max`.
+ */
+#define BITMAP_TO_ARRAY_KERNEL(name, target, word_fn)                          \
+  static target uint64_t name(const struct tw_bitmap *bitmap, uint64_t *out,   \
+                              uint64_t start, uint64_t max)                    \
+  {                                                                            \
+    const uint64_t n_words = TW_BITMAP_PER_BITS(bitmap->size);                 \
+    uint64_t i = BITMAP_POS(start), n = 0;                                     \
+    uint64_t word = bitmap->data[i] & (~0ULL << (start % TW_BITS_PER_BITMAP)); \
+    for (;;) {                                                                 \
+      const uint64_t base = i * TW_BITS_PER_BITMAP;                            \
+      if (tw_likely(n + TW_BITS_PER_BITMAP <= max)) {                          \
+        n += word_fn(word, base, out + n);                                     \
+      } else {                                                                 \
+        for (; word && n < max; word &= word - 1) {                            \
+          out[n++] = base + __builtin_ctzll(word);                             \
+        }                                                                      \
+        if (n == max) {                                                        \
+          break;                                                               \
+        }                                                                      \
+      }                                                                        \
+      if (++i == n_words) {                                                    \
+        break;                                                                 \
+      }                                                                        \
+      word = bitmap->data[i];                                                  \
+    }                                                                          \
+    return n;                                                                  \
+  }
 
-bool tw_bitmap_equal(const struct tw_bitmap *fst, const struct tw_bitmap *snd)
+/* tzcnt and blsr when compiled with BMI */
+#define BITMAP_WORD_TO_ARRAY(name, target)                                     \
+  static inline target uint64_t name(uint64_t word, uint64_t base,             \
+                                     uint64_t *out)                            \
+  {                                                                            \
+    uint64_t n = 0;                                                            \
+    for (; word; word &= word - 1) {                                           \
+      out[n++] = base + __builtin_ctzll(word);                                 \
+    }                                                                          \
+    return n;                                                                  \
+  }
+
+BITMAP_WORD_TO_ARRAY(tw_bitmap_word_to_array_port, )
+BITMAP_TO_ARRAY_KERNEL(tw_bitmap_to_array_port, , tw_bitmap_word_to_array_port)
+
+#ifdef USE_AVX
+BITMAP_WORD_TO_ARRAY(tw_bitmap_word_to_array_avx, TW_TARGET_AVX)
+BITMAP_TO_ARRAY_KERNEL(tw_bitmap_to_array_avx, TW_TARGET_AVX,
+                       tw_bitmap_word_to_array_avx)
+#endif
+
+#ifdef USE_AVX2
+BITMAP_WORD_TO_ARRAY(tw_bitmap_word_to_array_avx2, TW_TARGET_AVX2)
+BITMAP_TO_ARRAY_KERNEL(tw_bitmap_to_array_avx2, TW_TARGET_AVX2,
+                       tw_bitmap_word_to_array_avx2)
+#endif
+
+#ifdef USE_AVX512
+BITMAP_WORD_TO_ARRAY(tw_bitmap_word_to_array_avx512_sparse, TW_TARGET_AVX512)
+
+/**
+ * Dense words are decoded a byte at a time, VPCOMPRESSQ packs the positions
+ * selected by the byte. Each store writes 8 positions, of which only the
+ * active ones are kept by advancing `out` by the byte's popcount.
+ */
+static inline TW_TARGET_AVX512 uint64_t
+tw_bitmap_word_to_array_avx512(uint64_t word, uint64_t base, uint64_t *out)
 {
-  if (!fst || !snd) {
-    return false;
+  if (__builtin_popcountll(word) < 8) {
+    return tw_bitmap_word_to_array_avx512_sparse(word, base, out);
   }
 
-  if (fst->size != snd->size || fst->count != snd->count) {
-    return false;
+  const __m512i step = _mm512_set1_epi64(8);
+  __m512i pos = _mm512_add_epi64(_mm512_set1_epi64(base),
+                                 _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+  uint64_t n = 0;
+  for (size_t i = 0; i < sizeof(word); ++i) {
+    const __mmask8 mask = (__mmask8)(word >> (i * 8));
+    _mm512_storeu_si512(out + n, _mm512_maskz_compress_epi64(mask, pos));
+    n += __builtin_popcount(mask);
+    pos = _mm512_add_epi64(pos, step);
   }
 
-  const uint64_t size = fst->size;
+  return n;
+}
+
+BITMAP_TO_ARRAY_KERNEL(tw_bitmap_to_array_avx512, TW_TARGET_AVX512,
+                       tw_bitmap_word_to_array_avx512)
+#endif
 
-#define BITMAP_EQ_LOOP(simd_t, simd_load, simd_equal)                          \
-  for (size_t i = 0; i < VECTORS_IN_BITS(simd_t, size); ++i) {                 \
-    simd_t *fst_addr = (simd_t *)fst->data + i,                                \
-           *snd_addr = (simd_t *)snd->data + i;                                \
-    if (!simd_equal(simd_load(fst_addr), simd_load(snd_addr))) {               \
-      return false;                                                            \
+/**
+ * Searches skip whole vectors equal to `skip`, i.e. without active bits when
+ * searching bits or without zeroes when searching zeroes. Words are xored with
+ * `skip` such that both searches look for an active bit. The first word is
+ * masked to ignore positions before (or after) `from`, then words are scanned
+ * up to the vector alignment. The portable kernel uses words as vectors.
+ */
+#define BITMAP_FIND_KERNELS(isa, target, simd_t, simd_set1, simd_load,         \
+                            simd_equal)                                        \
+  static target int64_t tw_bitmap_find_next_##isa(                             \
+      const struct tw_bitmap *bitmap, uint64_t from, uint64_t skip)            \
+  {                                                                            \
+    const size_t n_words = TW_BITMAP_PER_BITS(bitmap->size);                   \
+    const size_t words_per_simd = sizeof(simd_t) / sizeof(uint64_t);          \
+    const uint64_t *data = bitmap->data;                                       \
+    size_t i = BITMAP_POS(from);                                               \
+    uint64_t word = (data[i] ^ skip) & (~0ULL << (from % TW_BITS_PER_BITMAP)); \
+    if (word) {                                                                \
+      return i * TW_BITS_PER_BITMAP + __builtin_ctzll(word);                   \
+    }                                                                          \
+    for (++i; i % words_per_simd && i < n_words; ++i) {                        \
+      if ((word = data[i] ^ skip)) {                                           \
+        return i * TW_BITS_PER_BITMAP + __builtin_ctzll(word);                 \
+      }                                                                        \
+    }                                                                          \
+    const simd_t skip_vec = simd_set1(skip);                                   \
+    for (; i < n_words; i += words_per_simd) {                                 \
+      if (!simd_equal(simd_load((simd_t *)(data + i)), skip_vec)) {            \
+        break;                                                                 \
+      }                                                                        \
+    }                                                                          \
+    for (; i < n_words; ++i) {                                                 \
+      if ((word = data[i] ^ skip)) {                                           \
+        return i * TW_BITS_PER_BITMAP + __builtin_ctzll(word);                 \
+      }                                                                        \
+    }                                                                          \
+    return -1;                                                                 \
+  }                                                                            \
+                                                                               \
+  static target int64_t tw_bitmap_find_prev_##isa(                             \
+      const struct tw_bitmap *bitmap, uint64_t from, uint64_t skip)            \
+  {                                                                            \
+    const size_t words_per_simd = sizeof(simd_t) / sizeof(uint64_t);          \
+    const uint64_t *data = bitmap->data;                                       \
+    const size_t last = TW_BITS_PER_BITMAP - 1;                                \
+    size_t i = BITMAP_POS(from);                                               \
+    uint64_t word =                                                            \
+        (data[i] ^ skip) & (~0ULL >> (last - from % TW_BITS_PER_BITMAP));      \
+    if (word) {                                                                \
+      return i * TW_BITS_PER_BITMAP + last - __builtin_clzll(word);            \
     }                                                                          \
+    while (i % words_per_simd) {                                               \
+      if ((word = data[--i] ^ skip)) {                                         \
+        return i * TW_BITS_PER_BITMAP + last - __builtin_clzll(word);          \
+      }                                                                        \
+    }                                                                          \
+    const simd_t skip_vec = simd_set1(skip);                                   \
+    for (; i; i -= words_per_simd) {                                           \
+      const simd_t *addr = (simd_t *)(data + i - words_per_simd);              \
+      if (!simd_equal(simd_load(addr), skip_vec)) {                            \
+        break;                                                                 \
+      }                                                                        \
+    }                                                                          \
+    while (i) {                                                                \
+      if ((word = data[--i] ^ skip)) {                                         \
+        return i * TW_BITS_PER_BITMAP + last - __builtin_clzll(word);          \
+      }                                                                        \
+    }                                                                          \
+    return -1;                                                                 \
   }
 
-/* AVX512 does not have movemask_epi8 equivalent, fallback to AVX2 */
+BITMAP_FIND_KERNELS(port, , uint64_t, tw_word_set1, tw_word_load,
+                    tw_word_equal)
+
+#ifdef USE_AVX
+BITMAP_FIND_KERNELS(avx, TW_TARGET_AVX, __m128i, _mm_set1_epi64x,
+                    _mm_load_si128, tw_mm_equal)
+#endif
+
 #ifdef USE_AVX2
-  BITMAP_EQ_LOOP(__m256i, _mm256_load_si256, tw_mm256_equal)
-#elif defined USE_AVX
-  BITMAP_EQ_LOOP(__m128i, _mm_load_si128, tw_mm_equal)
-#else
-  for (size_t i = 0; i < TW_BITMAP_PER_BITS(size); ++i) {
-    if (fst->data[i] != snd->data[i]) {
-      return false;
-    }
+BITMAP_FIND_KERNELS(avx2, TW_TARGET_AVX2, __m256i, _mm256_set1_epi64x,
+                    _mm256_load_si256, tw_mm256_equal)
+#endif
+
+#ifdef USE_AVX512
+BITMAP_FIND_KERNELS(avx512, TW_TARGET_AVX512, __m512i, _mm512_set1_epi64,
+                    _mm512_load_si512, tw_mm512_equal)
+#endif
+
+/**
+ * Range operations handle the partial first and last words with masks, the
+ * words in between are processed by the following kernels. These words are
+ * not aligned on vectors, thus kernels use unaligned loads and handle the
+ * remaining words one at a time.
+ */
+#define BITMAP_RANGE_KERNELS(isa, target, simd_t, simd_set1, simd_loadu,       \
+                             simd_storeu, simd_xor, simd_equal, simd_popcnt)   \
+  static inline target simd_t tw_words_count_##isa##_vec(const uint64_t *data, \
+                                                         size_t i)             \
+  {                                                                            \
+    return simd_loadu((simd_t *)data + i);                                     \
+  }                                                                            \
+                                                                               \
+  static target uint64_t tw_words_count_##isa(const uint64_t *data, size_t n)  \
+  {                                                                            \
+    const size_t words_per_simd = sizeof(simd_t) / sizeof(uint64_t);          \
+    const size_t n_vectors = n / words_per_simd;                               \
+    uint64_t count = 0;                                                        \
+    simd_popcnt(count, n_vectors, tw_words_count_##isa##_vec, data);           \
+    for (size_t i = n_vectors * words_per_simd; i < n; ++i) {                  \
+      count += __builtin_popcountll(data[i]);                                  \
+    }                                                                          \
+    return count;                                                              \
+  }                                                                            \
+                                                                               \
+  static inline target simd_t tw_words_flip_##isa##_vec(uint64_t *data,        \
+                                                        simd_t ones, size_t i) \
+  {                                                                            \
+    simd_t *addr = (simd_t *)data + i;                                         \
+    const simd_t res = simd_xor(simd_loadu(addr), ones);                       \
+    simd_storeu(addr, res);                                                    \
+    return res;                                                                \
+  }                                                                            \
+                                                                               \
+  static target uint64_t tw_words_flip_##isa(uint64_t *data, size_t n)         \
+  {                                                                            \
+    const size_t words_per_simd = sizeof(simd_t) / sizeof(uint64_t);          \
+    const size_t n_vectors = n / words_per_simd;                               \
+    const simd_t ones = simd_set1(~0ULL);                                      \
+    uint64_t count = 0;                                                        \
+    simd_popcnt(count, n_vectors, tw_words_flip_##isa##_vec, data, ones);      \
+    for (size_t i = n_vectors * words_per_simd; i < n; ++i) {                  \
+      data[i] = ~data[i];                                                      \
+      count += __builtin_popcountll(data[i]);                                  \
+    }                                                                          \
+    return count;                                                              \
+  }                                                                            \
+                                                                               \
+  static target bool tw_words_all_##isa(const uint64_t *data, size_t n,        \
+                                        uint64_t value)                        \
+  {                                                                            \
+    const size_t words_per_simd = sizeof(simd_t) / sizeof(uint64_t);          \
+    const size_t n_vectors = n / words_per_simd;                               \
+    const simd_t value_vec = simd_set1(value);                                 \
+    for (size_t i = 0; i < n_vectors; ++i) {                                   \
+      if (!simd_equal(simd_loadu((simd_t *)data + i), value_vec)) {            \
+        return false;                                                          \
+      }                                                                        \
+    }                                                                          \
+    for (size_t i = n_vectors * words_per_simd; i < n; ++i) {                  \
+      if (data[i] != value) {                                                  \
+        return false;                                                          \
+      }                                                                        \
+    }                                                                          \
+    return true;                                                               \
   }
+
+BITMAP_RANGE_KERNELS(port, , uint64_t, tw_word_set1, tw_word_load,
+                     tw_word_store, tw_word_xor, tw_word_equal, TW_POPCNT_PORT)
+
+#ifdef USE_AVX
+BITMAP_RANGE_KERNELS(avx, TW_TARGET_AVX, __m128i, _mm_set1_epi64x,
+                     _mm_loadu_si128, _mm_storeu_si128, _mm_xor_si128,
+                     tw_mm_equal, TW_POPCNT_AVX)
 #endif
 
-#undef BITMAP_EQ_LOOP
+#ifdef USE_AVX2
+BITMAP_RANGE_KERNELS(avx2, TW_TARGET_AVX2, __m256i, _mm256_set1_epi64x,
+                     _mm256_loadu_si256, _mm256_storeu_si256, _mm256_xor_si256,
+                     tw_mm256_equal, TW_POPCNT_AVX2)
+#endif
 
-  return true;
-}
+#ifdef USE_AVX512
+BITMAP_RANGE_KERNELS(avx512, TW_TARGET_AVX512, __m512i, _mm512_set1_epi64,
+                     _mm512_loadu_si512, _mm512_storeu_si512, _mm512_xor_si512,
+                     tw_mm512_equal, TW_POPCNT_AVX512)
+#endif
 
-#define BITMAP_OP_LOOP(simd_t, simd_load, simd_op, simd_store)                 \
-  const size_t uint64_t_per_simd_t = sizeof(simd_t) / sizeof(uint64_t);        \
-  for (size_t i = 0; i < VECTORS_IN_BITS(simd_t, size); ++i) {                 \
-    simd_t *src_vec = (simd_t *)src->data + i,                                 \
-           *dst_vec = (simd_t *)dst->data + i;                                 \
-    const simd_t res = simd_op(simd_load(src_vec), simd_load(dst_vec));        \
-    simd_store(dst_vec, res);                                                  \
-    for (size_t j = 0; j < uint64_t_per_simd_t; j++) {                         \
-      count += __builtin_popcountl(dst->data[i * uint64_t_per_simd_t + j]);    \
+#ifdef USE_AVX512_ICL
+BITMAP_RANGE_KERNELS(avx512_icl, TW_TARGET_AVX512_ICL, __m512i,
+                     _mm512_set1_epi64, _mm512_loadu_si512,
+                     _mm512_storeu_si512, _mm512_xor_si512, tw_mm512_equal,
+                     TW_POPCNT_AVX512_ICL)
+#endif
+
+/**
+ * Funnel shifts of words by `shift` bits within `[1, 63]`, each word being
+ * completed by the bits shifted out of its neighbour:
+ *
+ *  - `tw_words_shl`: `dst[i] = src[i] << shift | src[i - 1] >> (64 - shift)`,
+ *    moving bits toward higher positions, words are visited downward thus
+ *    `dst` may overlap `src` from above;
+ *  - `tw_words_shr`: `dst[i] = src[i] >> shift | src[i + 1] << (64 - shift)`,
+ *    moving bits toward lower positions, words are visited upward thus `dst`
+ *    may overlap `src` from below.
+ *
+ * Words past either end of `src` are read as zero. Vectors combine two
+ * unaligned loads offset by a word, or a single `VPSHLDVQ`/`VPSHRDVQ` with
+ * AVX512-VBMI2.
+ */
+#define BITMAP_SHIFT_KERNELS(isa, target, simd_t, count_t, count_set,          \
+                             simd_loadu, simd_storeu, simd_shld, simd_shrd)    \
+  static target void tw_words_shl_##isa(uint64_t *dst, const uint64_t *src,    \
+                                        size_t n, unsigned shift)              \
+  {                                                                            \
+    const size_t words_per_simd = sizeof(simd_t) / sizeof(uint64_t);           \
+    const count_t left = count_set(shift), right = count_set(64 - shift);      \
+    size_t i = n;                                                              \
+    for (; i % words_per_simd; --i) {                                          \
+      dst[i - 1] = tw_word_shld(src[i - 1], (i > 1) ? src[i - 2] : 0, shift,   \
+                                64 - shift);                                   \
+    }                                                                          \
+    for (; i > words_per_simd; i -= words_per_simd) {                          \
+      const size_t j = i - words_per_simd;                                     \
+      const simd_t hi = simd_loadu((const simd_t *)(src + j));                 \
+      const simd_t lo = simd_loadu((const simd_t *)(src + j - 1));             \
+      simd_storeu((simd_t *)(dst + j), simd_shld(hi, lo, left, right));        \
+    }                                                                          \
+    for (; i > 0; --i) {                                                       \
+      dst[i - 1] = tw_word_shld(src[i - 1], (i > 1) ? src[i - 2] : 0, shift,   \
+                                64 - shift);                                   \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static target void tw_words_shr_##isa(uint64_t *dst, const uint64_t *src,    \
+                                        size_t n, unsigned shift)              \
+  {                                                                            \
+    const size_t words_per_simd = sizeof(simd_t) / sizeof(uint64_t);           \
+    const count_t right = count_set(shift), left = count_set(64 - shift);      \
+    size_t i = 0;                                                              \
+    for (; i + words_per_simd < n; i += words_per_simd) {                      \
+      const simd_t lo = simd_loadu((const simd_t *)(src + i));                 \
+      const simd_t hi = simd_loadu((const simd_t *)(src + i + 1));             \
+      simd_storeu((simd_t *)(dst + i), simd_shrd(lo, hi, right, left));        \
+    }                                                                          \
+    for (; i < n; ++i) {                                                       \
+      dst[i] = tw_word_shrd(src[i], (i + 1 < n) ? src[i + 1] : 0, shift,       \
+                            64 - shift);                                       \
     }                                                                          \
   }
 
-struct tw_bitmap *tw_bitmap_union(const struct tw_bitmap *src,
-                                  struct tw_bitmap *dst)
-{
-  if (!src || !dst || src->size != dst->size) {
-    return NULL;
-  }
+BITMAP_SHIFT_KERNELS(port, , uint64_t, unsigned, tw_word_set1, tw_word_load,
+                     tw_word_store, tw_word_shld, tw_word_shrd)
+
+/* vector shifts by a count held in the low quadword of a `__m128i` */
+#define tw_mm_shld(hi, lo, l, r)                                               \
+  _mm_or_si128(_mm_sll_epi64(hi, l), _mm_srl_epi64(lo, r))
+#define tw_mm_shrd(lo, hi, l, r)                                               \
+  _mm_or_si128(_mm_srl_epi64(lo, l), _mm_sll_epi64(hi, r))
+#define tw_mm256_shld(hi, lo, l, r)                                            \
+  _mm256_or_si256(_mm256_sll_epi64(hi, l), _mm256_srl_epi64(lo, r))
+#define tw_mm256_shrd(lo, hi, l, r)                                            \
+  _mm256_or_si256(_mm256_srl_epi64(lo, l), _mm256_sll_epi64(hi, r))
+#define tw_mm512_shld(hi, lo, l, r)                                            \
+  _mm512_or_si512(_mm512_sll_epi64(hi, l), _mm512_srl_epi64(lo, r))
+#define tw_mm512_shrd(lo, hi, l, r)                                            \
+  _mm512_or_si512(_mm512_srl_epi64(lo, l), _mm512_sll_epi64(hi, r))
+/* the complementary count `r` is implied by the concatenated shift */
+#define tw_mm512_shldv(hi, lo, l, r) ((void)(r), _mm512_shldv_epi64(hi, lo, l))
+#define tw_mm512_shrdv(lo, hi, l, r) ((void)(r), _mm512_shrdv_epi64(lo, hi, l))
+
+#ifdef USE_AVX
+BITMAP_SHIFT_KERNELS(avx, TW_TARGET_AVX, __m128i, __m128i, _mm_cvtsi32_si128,
+                     _mm_loadu_si128, _mm_storeu_si128, tw_mm_shld,
+                     tw_mm_shrd)
+#endif
 
-  const uint64_t size = src->size;
+#ifdef USE_AVX2
+BITMAP_SHIFT_KERNELS(avx2, TW_TARGET_AVX2, __m256i, __m128i,
+                     _mm_cvtsi32_si128, _mm256_loadu_si256,
+                     _mm256_storeu_si256, tw_mm256_shld, tw_mm256_shrd)
+#endif
 
-  uint64_t count = 0;
 #ifdef USE_AVX512
-  BITMAP_OP_LOOP(__m512i, _mm512_load_si512, _mm512_or_si512,
-                 _mm512_store_si512)
-#elif defined USE_AVX2
-  BITMAP_OP_LOOP(__m256i, _mm256_load_si256, _mm256_or_si256,
-                 _mm256_store_si256)
-#elif defined USE_AVX
-  BITMAP_OP_LOOP(__m128i, _mm_load_si128, _mm_or_si128, _mm_store_si128)
-#else
-  for (size_t i = 0; i < TW_BITMAP_PER_BITS(size); ++i) {
-    dst->data[i] |= src->data[i];
-    count += __builtin_popcountl(dst->data[i]);
+BITMAP_SHIFT_KERNELS(avx512, TW_TARGET_AVX512, __m512i, __m128i,
+                     _mm_cvtsi32_si128, _mm512_loadu_si512,
+                     _mm512_storeu_si512, tw_mm512_shld, tw_mm512_shrd)
+#endif
+
+#ifdef USE_AVX512_ICL
+BITMAP_SHIFT_KERNELS(avx512_icl, TW_TARGET_AVX512_ICL, __m512i, __m512i,
+                     _mm512_set1_epi64, _mm512_loadu_si512,
+                     _mm512_storeu_si512, tw_mm512_shldv, tw_mm512_shrdv)
+#endif
+
+enum tw_bitmap_op3 {
+  TW_BITMAP_OR3,
+  TW_BITMAP_AND3,
+  TW_BITMAP_XOR3,
+  TW_BITMAP_ANDNOT3,
+  TW_BITMAP_ORNOT3,
+  TW_BITMAP_OP3S,
+};
+
+#define TW_BITMAP_OP3_KERNELS(isa)                                             \
+  {                                                                            \
+    [TW_BITMAP_OR3] = tw_bitmap_or3_##isa,                                     \
+    [TW_BITMAP_AND3] = tw_bitmap_and3_##isa,                                   \
+    [TW_BITMAP_XOR3] = tw_bitmap_xor3_##isa,                                   \
+    [TW_BITMAP_ANDNOT3] = tw_bitmap_andnot3_##isa,                             \
+    [TW_BITMAP_ORNOT3] = tw_bitmap_ornot3_##isa,                               \
+  }
+
+struct tw_bitmap_kernels {
+  void (*bitwise_not)(struct tw_bitmap *bitmap);
+  bool (*equal)(const struct tw_bitmap *fst, const struct tw_bitmap *snd);
+  bool (*disjoint)(const struct tw_bitmap *fst, const struct tw_bitmap *snd);
+  bool (*subset)(const struct tw_bitmap *fst, const struct tw_bitmap *snd);
+  uint64_t (*bitwise_or)(const struct tw_bitmap *src, struct tw_bitmap *dst);
+  uint64_t (*bitwise_and)(const struct tw_bitmap *src, struct tw_bitmap *dst);
+  uint64_t (*bitwise_xor)(const struct tw_bitmap *src, struct tw_bitmap *dst);
+  uint64_t (*and_count)(const struct tw_bitmap *fst,
+                        const struct tw_bitmap *snd);
+  /* three-operand operations, indexed by `enum tw_bitmap_op3` */
+  uint64_t (*op3[TW_BITMAP_OP3S])(const struct tw_bitmap *a,
+                                  const struct tw_bitmap *b,
+                                  struct tw_bitmap *out);
+  uint64_t (*or_many)(const struct tw_bitmap *const *srcs, size_t n_srcs,
+                      struct tw_bitmap *dst);
+  uint64_t (*and_many)(const struct tw_bitmap *const *srcs, size_t n_srcs,
+                       struct tw_bitmap *dst);
+  uint64_t (*to_array)(const struct tw_bitmap *bitmap, uint64_t *out,
+                       uint64_t start, uint64_t max);
+  int64_t (*find_next)(const struct tw_bitmap *bitmap, uint64_t from,
+                       uint64_t skip);
+  int64_t (*find_prev)(const struct tw_bitmap *bitmap, uint64_t from,
+                       uint64_t skip);
+  uint64_t (*words_count)(const uint64_t *data, size_t n);
+  uint64_t (*words_flip)(uint64_t *data, size_t n);
+  bool (*words_all)(const uint64_t *data, size_t n, uint64_t value);
+  void (*words_shl)(uint64_t *dst, const uint64_t *src, size_t n,
+                    unsigned shift);
+  void (*words_shr)(uint64_t *dst, const uint64_t *src, size_t n,
+                    unsigned shift);
+};
+
+#define TW_BITMAP_KERNELS(isa)                                                 \
+  {                                                                            \
+    .bitwise_not = tw_bitmap_not_##isa, .equal = tw_bitmap_equal_##isa,        \
+    .disjoint = tw_bitmap_disjoint_##isa, .subset = tw_bitmap_subset_##isa,    \
+    .bitwise_or = tw_bitmap_or_##isa, .bitwise_and = tw_bitmap_and_##isa,      \
+    .bitwise_xor = tw_bitmap_xor_##isa,                                        \
+    .and_count = tw_bitmap_and_count_##isa,                                    \
+    .op3 = TW_BITMAP_OP3_KERNELS(isa),                                         \
+    .or_many = tw_bitmap_or_many_##isa, .and_many = tw_bitmap_and_many_##isa,  \
+    .to_array = tw_bitmap_to_array_##isa,                                      \
+    .find_next = tw_bitmap_find_next_##isa,                                    \
+    .find_prev = tw_bitmap_find_prev_##isa,                                    \
+    .words_count = tw_words_count_##isa, .words_flip = tw_words_flip_##isa,    \
+    .words_all = tw_words_all_##isa, .words_shl = tw_words_shl_##isa,          \
+    .words_shr = tw_words_shr_##isa,                                           \
   }
+
+static const struct tw_bitmap_kernels tw_bitmap_kernels[TW_SIMD_LEVELS] = {
+    [TW_SIMD_PORTABLE] = TW_BITMAP_KERNELS(port),
+#ifdef USE_AVX
+    [TW_SIMD_AVX] = TW_BITMAP_KERNELS(avx),
+#endif
+#ifdef USE_AVX2
+    [TW_SIMD_AVX2] = TW_BITMAP_KERNELS(avx2),
+#endif
+#ifdef USE_AVX512
+    [TW_SIMD_AVX512] = TW_BITMAP_KERNELS(avx512),
+#endif
+#ifdef USE_AVX512_ICL
+    [TW_SIMD_AVX512_ICL] =
+        {
+            .bitwise_not = tw_bitmap_not_avx512,
+            .equal = tw_bitmap_equal_avx512,
+            .disjoint = tw_bitmap_disjoint_avx512,
+            .subset = tw_bitmap_subset_avx512,
+            .bitwise_or = tw_bitmap_or_avx512_icl,
+            .bitwise_and = tw_bitmap_and_avx512_icl,
+            .bitwise_xor = tw_bitmap_xor_avx512_icl,
+            .and_count = tw_bitmap_and_count_avx512_icl,
+            .op3 = TW_BITMAP_OP3_KERNELS(avx512_icl),
+            .or_many = tw_bitmap_or_many_avx512_icl,
+            .and_many = tw_bitmap_and_many_avx512_icl,
+            .to_array = tw_bitmap_to_array_avx512,
+            .find_next = tw_bitmap_find_next_avx512,
+            .find_prev = tw_bitmap_find_prev_avx512,
+            .words_count = tw_words_count_avx512_icl,
+            .words_flip = tw_words_flip_avx512_icl,
+            .words_all = tw_words_all_avx512_icl,
+            .words_shl = tw_words_shl_avx512_icl,
+            .words_shr = tw_words_shr_avx512_icl,
+        },
 #endif
+};
+
+static inline const struct tw_bitmap_kernels *tw_bitmap_kernels_(void)
+{
+  return &tw_bitmap_kernels[tw_simd_level()];
+}
 
-  dst->count = count;
+/**
+ * Number of active bits, recomputed if `_nocount` writes left it outdated.
+ * The cached count is not part of the bitmap's logical value, thus it is
+ * refreshed even through a const pointer.
+ */
+static uint64_t tw_bitmap_recount(const struct tw_bitmap *bitmap)
+{
+  if (tw_unlikely(bitmap->stale)) {
+    struct tw_bitmap *mut = (struct tw_bitmap *)bitmap;
+    mut->count = tw_bitmap_kernels_()->words_count(
+        bitmap->data, TW_BITMAP_PER_BITS(bitmap->size));
+    mut->stale = false;
+    mut->generation++;
+  }
 
-  return dst;
+  return bitmap->count;
 }
 
-struct tw_bitmap *tw_bitmap_intersection(const struct tw_bitmap *src,
-                                         struct tw_bitmap *dst)
+/**
+ * Grow the allocation of `bitmap` to `capacity` bits, keeping the invariant
+ * that bits past `bitmap->size` are cleared. Heap allocations move to a
+ * mapping once large enough, mappings are then remapped by the kernel which
+ * moves page table entries instead of copying bytes.
+ */
+static bool tw_bitmap_grow(struct tw_bitmap *bitmap, uint64_t capacity)
+{
+  const size_t used = bitmap->size / TW_BITS_IN_WORD;
+  const size_t bytes = capacity / TW_BITS_IN_WORD;
+
+  if (bitmap->mapping) {
+    void *pages = tw_pages_remap(bitmap->mapping, bitmap->mapping_size, bytes,
+                                 bitmap->flags);
+    if (!pages) {
+      return false;
+    }
+    bitmap->data = bitmap->mapping = pages;
+    bitmap->mapping_size = tw_pages_size(bytes, bitmap->flags);
+  } else if (bytes >= TW_BITMAP_REMAP_MIN) {
+    /* mapped pages are already zeroed */
+    void *pages = tw_pages_alloc(bytes, TW_ALLOC_DEFAULT);
+    if (!pages) {
+      return false;
+    }
+    memcpy(pages, bitmap->data, used);
+    free(bitmap->data);
+    bitmap->data = bitmap->mapping = pages;
+    bitmap->mapping_size = tw_pages_size(bytes, TW_ALLOC_DEFAULT);
+  } else {
+    uint64_t *data = malloc_aligned(TW_CACHELINE, bytes);
+    if (!data) {
+      return false;
+    }
+    memcpy(data, bitmap->data, used);
+    memset((char *)data + used, 0, bytes - used);
+    free(bitmap->data);
+    bitmap->data = data;
+  }
+
+  bitmap->capacity =
+      bitmap->mapping ? bitmap->mapping_size * TW_BITS_IN_WORD : capacity;
+
+  return true;
+}
+
+struct tw_bitmap *tw_bitmap_resize(struct tw_bitmap *bitmap, uint64_t size)
 {
-  if (!src || !dst || src->size != dst->size) {
+  if (!bitmap || 0 == size || size > TW_BITMAP_MAX_BITS ||
+      tw_bitmap_is_file_backed(bitmap) || bitmap->cow ||
+      tw_bitmap_is_wrapped(bitmap)) {
     return NULL;
   }
 
-  const uint64_t size = src->size;
+  size = TW_BITMAP_DATA_SIZE(size) * TW_BITS_IN_WORD;
 
-  uint64_t count = 0;
-#ifdef USE_AVX512
-  BITMAP_OP_LOOP(__m512i, _mm512_load_si512, _mm512_and_si512,
-                 _mm512_store_si512)
-#elif defined USE_AVX2
-  BITMAP_OP_LOOP(__m256i, _mm256_load_si256, _mm256_and_si256,
-                 _mm256_store_si256)
-#elif defined USE_AVX
-  BITMAP_OP_LOOP(__m128i, _mm_load_si128, _mm_and_si128, _mm_store_si128)
-#else
-  for (size_t i = 0; i < TW_BITMAP_PER_BITS(size); ++i) {
-    dst->data[i] &= src->data[i];
-    count += __builtin_popcountl(dst->data[i]);
+  if (size > bitmap->capacity) {
+    const uint64_t doubled = tw_min(2 * bitmap->capacity, TW_BITMAP_MAX_BITS);
+    if (!tw_bitmap_grow(bitmap, tw_max(size, doubled)) &&
+        !tw_bitmap_grow(bitmap, size)) {
+      return NULL;
+    }
+  } else if (size < bitmap->size) {
+    uint64_t *tail = bitmap->data + BITMAP_POS(size);
+    const size_t n_words = TW_BITMAP_PER_BITS(bitmap->size - size);
+    if (!bitmap->stale) {
+      bitmap->count -= tw_bitmap_kernels_()->words_count(tail, n_words);
+    }
+    memset(tail, 0, n_words * TW_BYTES_PER_BITMAP);
   }
-#endif
 
-  dst->count = count;
+  bitmap->size = size;
+  bitmap->generation++;
 
-  return dst;
+  return bitmap;
 }
 
-struct tw_bitmap *tw_bitmap_xor(const struct tw_bitmap *src,
-                                struct tw_bitmap *dst)
+struct tw_bitmap *tw_bitmap_reserve(struct tw_bitmap *bitmap,
+                                    uint64_t capacity)
 {
-  if (!src || !dst || src->size != dst->size) {
+  if (!bitmap || capacity > TW_BITMAP_MAX_BITS ||
+      tw_bitmap_is_file_backed(bitmap) || bitmap->cow ||
+      tw_bitmap_is_wrapped(bitmap)) {
     return NULL;
   }
 
-  const uint64_t size = src->size;
+  capacity = TW_BITMAP_DATA_SIZE(capacity) * TW_BITS_IN_WORD;
+  if (capacity > bitmap->capacity && !tw_bitmap_grow(bitmap, capacity)) {
+    return NULL;
+  }
 
-  uint64_t count = 0;
-#ifdef USE_AVX512
-  BITMAP_OP_LOOP(__m512i, _mm512_load_si512, _mm512_xor_si512,
-                 _mm512_store_si512)
-#elif defined USE_AVX2
-  BITMAP_OP_LOOP(__m256i, _mm256_load_si256, _mm256_xor_si256,
-                 _mm256_store_si256)
-#elif defined USE_AVX
-  BITMAP_OP_LOOP(__m128i, _mm_load_si128, _mm_xor_si128, _mm_store_si128)
-#else
-  for (size_t i = 0; i < TW_BITMAP_PER_BITS(size); ++i) {
-    dst->data[i] ^= src->data[i];
-    count += __builtin_popcountl(dst->data[i]);
+  return bitmap;
+}
+
+struct tw_bitmap *tw_bitmap_not(struct tw_bitmap *bitmap)
+{
+  if (!bitmap || !tw_bitmap_all_writable(bitmap)) {
+    return NULL;
   }
-#endif
 
-  dst->count = count;
+  tw_bitmap_kernels_()->bitwise_not(bitmap);
 
-  return dst;
+  bitmap->count = bitmap->size - bitmap->count;
+  bitmap->generation++;
+
+  return bitmap;
+}
+
+/**
+ * Bitmaps of different sizes are combined on views of their common prefix,
+ * sizes being multiples of 512 bits the kernels see whole vectors, while the
+ * missing tail of the smaller bitmap is treated as cleared.
+ */
+static inline struct tw_bitmap tw_bitmap_view(const struct tw_bitmap *bitmap,
+                                              uint64_t size)
+{
+  return (struct tw_bitmap){.size = size, .data = bitmap->data};
+}
+
+uint64_t tw_bitmap_tail_count(const struct tw_bitmap *bitmap, uint64_t from)
+{
+  if (from >= bitmap->size) {
+    return 0;
+  }
+
+  return tw_bitmap_kernels_()->words_count(
+      bitmap->data + BITMAP_POS(from),
+      TW_BITMAP_PER_BITS(bitmap->size - from));
+}
+
+bool tw_bitmap_equal(const struct tw_bitmap *fst, const struct tw_bitmap *snd)
+{
+  if (!fst || !snd) {
+    return false;
+  }
+
+  if (tw_bitmap_recount(fst) != tw_bitmap_recount(snd)) {
+    return false;
+  }
+
+  /* with equal counts and prefixes, the larger tail is cleared too */
+  const uint64_t size = tw_min(fst->size, snd->size);
+  const struct tw_bitmap fst_view = tw_bitmap_view(fst, size);
+  const struct tw_bitmap snd_view = tw_bitmap_view(snd, size);
+
+  return tw_bitmap_kernels_()->equal(&fst_view, &snd_view);
+}
+
+struct tw_bitmap *tw_bitmap_union(const struct tw_bitmap *src,
+                                  struct tw_bitmap *dst)
+{
+  if (!src || !dst ||
+      (src->size > dst->size && !tw_bitmap_resize(dst, src->size)) ||
+      !tw_bitmap_all_writable(dst)) {
+    return NULL;
+  }
+
+  const struct tw_bitmap src_view = tw_bitmap_view(src, src->size);
+  struct tw_bitmap dst_view = tw_bitmap_view(dst, src->size);
+
+  dst->count = tw_bitmap_kernels_()->bitwise_or(&src_view, &dst_view) +
+               tw_bitmap_tail_count(dst, src->size);
+  dst->stale = false;
+  dst->generation++;
+
+  return dst;
+}
+
+struct tw_bitmap *tw_bitmap_intersection(const struct tw_bitmap *src,
+                                         struct tw_bitmap *dst)
+{
+  if (!src || !dst || !tw_bitmap_all_writable(dst)) {
+    return NULL;
+  }
+
+  const uint64_t size = tw_min(src->size, dst->size);
+  const struct tw_bitmap src_view = tw_bitmap_view(src, size);
+  struct tw_bitmap dst_view = tw_bitmap_view(dst, size);
+
+  dst->count = tw_bitmap_kernels_()->bitwise_and(&src_view, &dst_view);
+  memset(dst->data + BITMAP_POS(size), 0, (dst->size - size) / TW_BITS_IN_WORD);
+  dst->stale = false;
+  dst->generation++;
+
+  return dst;
+}
+
+struct tw_bitmap *tw_bitmap_xor(const struct tw_bitmap *src,
+                                struct tw_bitmap *dst)
+{
+  if (!src || !dst ||
+      (src->size > dst->size && !tw_bitmap_resize(dst, src->size)) ||
+      !tw_bitmap_all_writable(dst)) {
+    return NULL;
+  }
+
+  const struct tw_bitmap src_view = tw_bitmap_view(src, src->size);
+  struct tw_bitmap dst_view = tw_bitmap_view(dst, src->size);
+
+  dst->count = tw_bitmap_kernels_()->bitwise_xor(&src_view, &dst_view) +
+               tw_bitmap_tail_count(dst, src->size);
+  dst->stale = false;
+  dst->generation++;
+
+  return dst;
+}
+
+/**
+ * Store the bits `[from, size)` of a three-operand operation, where only the
+ * larger operand has bits, the smaller being treated as cleared. Returns the
+ * number of active bits stored.
+ */
+static uint64_t tw_bitmap_op3_tail(enum tw_bitmap_op3 op,
+                                   const struct tw_bitmap *larger,
+                                   bool a_is_larger, struct tw_bitmap *out,
+                                   uint64_t from, uint64_t size)
+{
+  uint64_t *tail = out->data + BITMAP_POS(from);
+  const uint64_t *larger_tail = larger->data + BITMAP_POS(from);
+  const size_t n_words = TW_BITMAP_PER_BITS(size - from);
+  const size_t n_bytes = n_words * TW_BYTES_PER_BITMAP;
+
+  /* `a OR NOT 0` is full, `a AND 0` and `0 AND NOT b` are cleared */
+  if (op == TW_BITMAP_ORNOT3 && a_is_larger) {
+    memset(tail, 0xff, n_bytes);
+    return size - from;
+  }
+  if (op == TW_BITMAP_AND3 || (op == TW_BITMAP_ANDNOT3 && !a_is_larger)) {
+    memset(tail, 0, n_bytes);
+    return 0;
+  }
+
+  /* `out` may alias the larger operand */
+  if (tail != larger_tail) {
+    memcpy(tail, larger_tail, n_bytes);
+  }
+
+  /* `0 OR NOT b` */
+  if (op == TW_BITMAP_ORNOT3) {
+    return tw_bitmap_kernels_()->words_flip(tail, n_words);
+  }
+
+  return tw_bitmap_kernels_()->words_count(tail, n_words);
+}
+
+static struct tw_bitmap *tw_bitmap_op3(enum tw_bitmap_op3 op,
+                                       const struct tw_bitmap *a,
+                                       const struct tw_bitmap *b,
+                                       struct tw_bitmap *out)
+{
+  if (!a || !b || !out) {
+    return NULL;
+  }
+
+  /* sizes are read before resizing `out`, which may alias an operand */
+  const bool a_is_larger = a->size > b->size;
+  const struct tw_bitmap *larger = a_is_larger ? a : b;
+  const uint64_t common = tw_min(a->size, b->size);
+  const uint64_t size = larger->size;
+
+  if ((out->size != size && !tw_bitmap_resize(out, size)) ||
+      !tw_bitmap_all_writable(out)) {
+    return NULL;
+  }
+
+  const struct tw_bitmap a_view = tw_bitmap_view(a, common);
+  const struct tw_bitmap b_view = tw_bitmap_view(b, common);
+  struct tw_bitmap out_view = tw_bitmap_view(out, common);
+
+  out->count = tw_bitmap_kernels_()->op3[op](&a_view, &b_view, &out_view);
+  if (common < size) {
+    out->count +=
+        tw_bitmap_op3_tail(op, larger, a_is_larger, out, common, size);
+  }
+  out->stale = false;
+  out->generation++;
+
+  return out;
+}
+
+struct tw_bitmap *tw_bitmap_andnot(const struct tw_bitmap *src,
+                                   struct tw_bitmap *dst)
+{
+  if (!src || !dst || !tw_bitmap_all_writable(dst)) {
+    return NULL;
+  }
+
+  const uint64_t size = tw_min(src->size, dst->size);
+  const struct tw_bitmap src_view = tw_bitmap_view(src, size);
+  struct tw_bitmap dst_view = tw_bitmap_view(dst, size);
+
+  dst->count = tw_bitmap_kernels_()->op3[TW_BITMAP_ANDNOT3](
+                   &dst_view, &src_view, &dst_view) +
+               tw_bitmap_tail_count(dst, size);
+  dst->stale = false;
+  dst->generation++;
+
+  return dst;
+}
+
+struct tw_bitmap *tw_bitmap_union_into(const struct tw_bitmap *a,
+                                       const struct tw_bitmap *b,
+                                       struct tw_bitmap *out)
+{
+  return tw_bitmap_op3(TW_BITMAP_OR3, a, b, out);
+}
+
+struct tw_bitmap *tw_bitmap_intersection_into(const struct tw_bitmap *a,
+                                              const struct tw_bitmap *b,
+                                              struct tw_bitmap *out)
+{
+  return tw_bitmap_op3(TW_BITMAP_AND3, a, b, out);
+}
+
+struct tw_bitmap *tw_bitmap_xor_into(const struct tw_bitmap *a,
+                                     const struct tw_bitmap *b,
+                                     struct tw_bitmap *out)
+{
+  return tw_bitmap_op3(TW_BITMAP_XOR3, a, b, out);
+}
+
+struct tw_bitmap *tw_bitmap_andnot_into(const struct tw_bitmap *a,
+                                        const struct tw_bitmap *b,
+                                        struct tw_bitmap *out)
+{
+  return tw_bitmap_op3(TW_BITMAP_ANDNOT3, a, b, out);
+}
+
+struct tw_bitmap *tw_bitmap_ornot_into(const struct tw_bitmap *a,
+                                       const struct tw_bitmap *b,
+                                       struct tw_bitmap *out)
+{
+  return tw_bitmap_op3(TW_BITMAP_ORNOT3, a, b, out);
+}
+
+/* smallest and largest sizes of the sources, `false` if one is `NULL` */
+static bool tw_bitmap_many_sizes(const struct tw_bitmap *const *srcs,
+                                 size_t n_srcs, uint64_t *min, uint64_t *max)
+{
+  if (!srcs || n_srcs == 0) {
+    return false;
+  }
+
+  *min = TW_BITMAP_MAX_BITS;
+  *max = 0;
+  for (size_t k = 0; k < n_srcs; ++k) {
+    if (!srcs[k]) {
+      return false;
+    }
+    *min = tw_min(*min, srcs[k]->size);
+    *max = tw_max(*max, srcs[k]->size);
+  }
+
+  return true;
+}
+
+struct tw_bitmap *tw_bitmap_union_many(const struct tw_bitmap *const *srcs,
+                                       size_t n_srcs, struct tw_bitmap *dst)
+{
+  uint64_t common, size;
+  if (!dst || !tw_bitmap_many_sizes(srcs, n_srcs, &common, &size) ||
+      (size > dst->size && !tw_bitmap_resize(dst, size)) ||
+      !tw_bitmap_all_writable(dst)) {
+    return NULL;
+  }
+
+  /* the kernel reads the sources up to the size of the view */
+  struct tw_bitmap dst_view = tw_bitmap_view(dst, common);
+  dst->count = tw_bitmap_kernels_()->or_many(srcs, n_srcs, &dst_view);
+
+  if (common < size) {
+    /* a source aliasing `dst` holds its own tail already */
+    bool aliased = false;
+    for (size_t k = 0; k < n_srcs; ++k) {
+      aliased |= srcs[k] == dst;
+    }
+    if (!aliased) {
+      memset(dst->data + BITMAP_POS(common), 0,
+             (size - common) / TW_BITS_IN_WORD);
+    }
+
+    for (size_t k = 0; k < n_srcs; ++k) {
+      if (srcs[k]->size > common && srcs[k] != dst) {
+        const uint64_t tail = srcs[k]->size - common;
+        const struct tw_bitmap src_tail = {
+            .size = tail, .data = srcs[k]->data + BITMAP_POS(common)};
+        struct tw_bitmap dst_tail = {.size = tail,
+                                     .data = dst->data + BITMAP_POS(common)};
+        tw_bitmap_kernels_()->bitwise_or(&src_tail, &dst_tail);
+      }
+    }
+    dst->count += tw_bitmap_tail_count(dst, common);
+  }
+
+  /* sources smaller than `dst` leave its tail cleared */
+  memset(dst->data + BITMAP_POS(size), 0, (dst->size - size) / TW_BITS_IN_WORD);
+  dst->stale = false;
+  dst->generation++;
+
+  return dst;
+}
+
+struct tw_bitmap *
+tw_bitmap_intersection_many(const struct tw_bitmap *const *srcs, size_t n_srcs,
+                            struct tw_bitmap *dst)
+{
+  uint64_t common, size;
+  if (!dst || !tw_bitmap_many_sizes(srcs, n_srcs, &common, &size) ||
+      (common > dst->size && !tw_bitmap_resize(dst, common)) ||
+      !tw_bitmap_all_writable(dst)) {
+    return NULL;
+  }
+
+  /* the kernel reads the sources up to the size of the view */
+  struct tw_bitmap dst_view = tw_bitmap_view(dst, common);
+  dst->count = tw_bitmap_kernels_()->and_many(srcs, n_srcs, &dst_view);
+  memset(dst->data + BITMAP_POS(common), 0,
+         (dst->size - common) / TW_BITS_IN_WORD);
+  dst->stale = false;
+  dst->generation++;
+
+  return dst;
+}
+
+/* active bits of `fst & snd`, on their common prefix */
+static uint64_t tw_bitmap_and_count(const struct tw_bitmap *fst,
+                                    const struct tw_bitmap *snd)
+{
+  const uint64_t size = tw_min(fst->size, snd->size);
+  const struct tw_bitmap fst_view = tw_bitmap_view(fst, size);
+  const struct tw_bitmap snd_view = tw_bitmap_view(snd, size);
+
+  return tw_bitmap_kernels_()->and_count(&fst_view, &snd_view);
+}
+
+uint64_t tw_bitmap_intersection_count(const struct tw_bitmap *fst,
+                                      const struct tw_bitmap *snd)
+{
+  if (!fst || !snd) {
+    return 0;
+  }
+
+  return tw_bitmap_and_count(fst, snd);
+}
+
+/**
+ * The remaining counts derive from the intersection's by inclusion-exclusion
+ * since both operands maintain their own count, i.e. a single pass over the
+ * data is required.
+ */
+
+uint64_t tw_bitmap_union_count(const struct tw_bitmap *fst,
+                               const struct tw_bitmap *snd)
+{
+  if (!fst || !snd) {
+    return 0;
+  }
+
+  return tw_bitmap_recount(fst) + tw_bitmap_recount(snd) -
+         tw_bitmap_and_count(fst, snd);
+}
+
+uint64_t tw_bitmap_xor_count(const struct tw_bitmap *fst,
+                             const struct tw_bitmap *snd)
+{
+  if (!fst || !snd) {
+    return 0;
+  }
+
+  return tw_bitmap_recount(fst) + tw_bitmap_recount(snd) -
+         2 * tw_bitmap_and_count(fst, snd);
+}
+
+uint64_t tw_bitmap_andnot_count(const struct tw_bitmap *fst,
+                                const struct tw_bitmap *snd)
+{
+  if (!fst || !snd) {
+    return 0;
+  }
+
+  return tw_bitmap_recount(fst) - tw_bitmap_and_count(fst, snd);
+}
+
+float tw_bitmap_jaccard(const struct tw_bitmap *fst,
+                        const struct tw_bitmap *snd)
+{
+  if (!fst || !snd) {
+    return 0.0f;
+  }
+
+  const uint64_t n_and = tw_bitmap_and_count(fst, snd);
+  const uint64_t n_or = tw_bitmap_recount(fst) + tw_bitmap_recount(snd) - n_and;
+
+  /* two empty sets are identical */
+  if (n_or == 0) {
+    return 1.0f;
+  }
+
+  return n_and / (float)n_or;
+}
+
+/**
+ * Relations exit on the first witness vector rather than materializing or
+ * counting the intersection. Cached counts reject trivial cases first, unless
+ * outdated as recounting would cost a full pass.
+ */
+#define tw_bitmap_known_empty(bitmap) (!(bitmap)->stale && !(bitmap)->count)
+
+bool tw_bitmap_intersects(const struct tw_bitmap *fst,
+                          const struct tw_bitmap *snd)
+{
+  if (!fst || !snd || tw_bitmap_known_empty(fst) ||
+      tw_bitmap_known_empty(snd)) {
+    return false;
+  }
+
+  const uint64_t size = tw_min(fst->size, snd->size);
+  const struct tw_bitmap fst_view = tw_bitmap_view(fst, size);
+  const struct tw_bitmap snd_view = tw_bitmap_view(snd, size);
+
+  return !tw_bitmap_kernels_()->disjoint(&fst_view, &snd_view);
+}
+
+bool tw_bitmap_is_disjoint(const struct tw_bitmap *fst,
+                           const struct tw_bitmap *snd)
+{
+  return fst && snd && !tw_bitmap_intersects(fst, snd);
+}
+
+bool tw_bitmap_is_subset(const struct tw_bitmap *fst,
+                         const struct tw_bitmap *snd)
+{
+  if (!fst || !snd) {
+    return false;
+  }
+
+  if (tw_bitmap_known_empty(fst)) {
+    return true;
+  }
+
+  if (!fst->stale && !snd->stale && fst->count > snd->count) {
+    return false;
+  }
+
+  /* bits of `fst` past the size of `snd` must be cleared */
+  const struct tw_bitmap_kernels *kernels = tw_bitmap_kernels_();
+  if (fst->size > snd->size &&
+      !kernels->words_all(fst->data + BITMAP_POS(snd->size),
+                          TW_BITMAP_PER_BITS(fst->size - snd->size), 0ULL)) {
+    return false;
+  }
+
+  const uint64_t size = tw_min(fst->size, snd->size);
+  const struct tw_bitmap fst_view = tw_bitmap_view(fst, size);
+  const struct tw_bitmap snd_view = tw_bitmap_view(snd, size);
+
+  return kernels->subset(&fst_view, &snd_view);
+}
+
+struct tw_bitmap_iter *tw_bitmap_iter_init(struct tw_bitmap_iter *iter,
+                                           const struct tw_bitmap *bitmap,
+                                           uint64_t start)
+{
+  if (!iter || !bitmap) {
+    return NULL;
+  }
+
+  iter->bitmap = bitmap;
+
+  if (start >= bitmap->size) {
+    iter->index = TW_BITMAP_PER_BITS(bitmap->size);
+    iter->word = 0;
+    return iter;
+  }
+
+  iter->index = BITMAP_POS(start);
+  iter->word =
+      bitmap->data[iter->index] & (~0ULL << (start % TW_BITS_PER_BITMAP));
+
+  return iter;
+}
+
+bool tw_bitmap_iter_next(struct tw_bitmap_iter *iter, uint64_t *pos)
+{
+  if (!iter || !pos) {
+    return false;
+  }
+
+  const uint64_t n_words = TW_BITMAP_PER_BITS(iter->bitmap->size);
+  while (!iter->word) {
+    if (iter->index + 1 >= n_words) {
+      iter->index = n_words;
+      return false;
+    }
+    iter->word = iter->bitmap->data[++iter->index];
+  }
+
+  *pos = iter->index * TW_BITS_PER_BITMAP + __builtin_ctzll(iter->word);
+  iter->word &= iter->word - 1;
+
+  return true;
+}
+
+struct tw_bitmap_iter *
+tw_bitmap_iter_init_reverse(struct tw_bitmap_iter *iter,
+                            const struct tw_bitmap *bitmap, uint64_t start)
+{
+  if (!iter || !bitmap) {
+    return NULL;
+  }
+
+  iter->bitmap = bitmap;
+
+  start = tw_min(start, bitmap->size - 1);
+  iter->index = BITMAP_POS(start);
+  iter->word = bitmap->data[iter->index] &
+               (~0ULL >> (TW_BITS_PER_BITMAP - 1 - start % TW_BITS_PER_BITMAP));
+
+  return iter;
+}
+
+bool tw_bitmap_iter_prev(struct tw_bitmap_iter *iter, uint64_t *pos)
+{
+  if (!iter || !pos) {
+    return false;
+  }
+
+  while (!iter->word) {
+    if (iter->index == 0) {
+      return false;
+    }
+    iter->word = iter->bitmap->data[--iter->index];
+  }
+
+  const uint64_t bit = TW_BITS_PER_BITMAP - 1 - __builtin_clzll(iter->word);
+  *pos = iter->index * TW_BITS_PER_BITMAP + bit;
+  iter->word ^= 1ULL << bit;
+
+  return true;
+}
+
+uint64_t tw_bitmap_to_array(const struct tw_bitmap *bitmap, uint64_t *out,
+                            uint64_t start, uint64_t max)
+{
+  if (!bitmap || !out || start >= bitmap->size || max == 0) {
+    return 0;
+  }
+
+  return tw_bitmap_kernels_()->to_array(bitmap, out, start, max);
+}
+
+/* `skip` values of the find kernels */
+#define TW_FIND_BIT 0ULL
+#define TW_FIND_ZERO ~0ULL
+
+int64_t tw_bitmap_find_first_zero(const struct tw_bitmap *bitmap)
+{
+  if (!bitmap) {
+    return -1;
+  }
+
+  if (tw_unlikely(tw_bitmap_full(bitmap))) {
+    return -1;
+  }
+
+  return tw_bitmap_kernels_()->find_next(bitmap, 0, TW_FIND_ZERO);
+}
+
+int64_t tw_bitmap_find_first_bit(const struct tw_bitmap *bitmap)
+{
+  if (!bitmap) {
+    return -1;
+  }
+
+  if (tw_unlikely(tw_bitmap_empty(bitmap))) {
+    return -1;
+  }
+
+  return tw_bitmap_kernels_()->find_next(bitmap, 0, TW_FIND_BIT);
+}
+
+int64_t tw_bitmap_find_last_zero(const struct tw_bitmap *bitmap)
+{
+  if (!bitmap || tw_bitmap_full(bitmap)) {
+    return -1;
+  }
+
+  return tw_bitmap_kernels_()->find_prev(bitmap, bitmap->size - 1,
+                                         TW_FIND_ZERO);
+}
+
+int64_t tw_bitmap_find_last_bit(const struct tw_bitmap *bitmap)
+{
+  if (!bitmap || tw_bitmap_empty(bitmap)) {
+    return -1;
+  }
+
+  return tw_bitmap_kernels_()->find_prev(bitmap, bitmap->size - 1,
+                                         TW_FIND_BIT);
+}
+
+int64_t tw_bitmap_find_next_zero(const struct tw_bitmap *bitmap, uint64_t from)
+{
+  if (!bitmap || from >= bitmap->size) {
+    return -1;
+  }
+
+  return tw_bitmap_kernels_()->find_next(bitmap, from, TW_FIND_ZERO);
+}
+
+int64_t tw_bitmap_find_next_bit(const struct tw_bitmap *bitmap, uint64_t from)
+{
+  if (!bitmap || from >= bitmap->size) {
+    return -1;
+  }
+
+  return tw_bitmap_kernels_()->find_next(bitmap, from, TW_FIND_BIT);
+}
+
+int64_t tw_bitmap_find_prev_zero(const struct tw_bitmap *bitmap, uint64_t from)
+{
+  if (!bitmap) {
+    return -1;
+  }
+
+  from = tw_min(from, bitmap->size - 1);
+  return tw_bitmap_kernels_()->find_prev(bitmap, from, TW_FIND_ZERO);
+}
+
+int64_t tw_bitmap_find_prev_bit(const struct tw_bitmap *bitmap, uint64_t from)
+{
+  if (!bitmap) {
+    return -1;
+  }
+
+  from = tw_min(from, bitmap->size - 1);
+  return tw_bitmap_kernels_()->find_prev(bitmap, from, TW_FIND_BIT);
+}
+
+/**
+ * Masks of the first and last words of the range [start, end], which is
+ * within a single word when `first == last`.
+ */
+#define TW_RANGE_DECLARE(start, end)                                           \
+  const uint64_t first = BITMAP_POS(start), last = BITMAP_POS(end);            \
+  const uint64_t first_mask = ~0ULL << ((start) % TW_BITS_PER_BITMAP);         \
+  const uint64_t last_mask =                                                   \
+      ~0ULL >> (TW_BITS_PER_BITMAP - 1 - (end) % TW_BITS_PER_BITMAP);          \
+  const uint64_t n_middle = (first < last) ? last - first - 1 : 0
+
+#define tw_range_valid(bitmap, start, end)                                     \
+  ((bitmap) && (start) <= (end) && (end) < (bitmap)->size)
+
+void tw_bitmap_set_range(struct tw_bitmap *bitmap, uint64_t start,
+                         uint64_t end)
+{
+  if (!tw_range_valid(bitmap, start, end) ||
+      !tw_bitmap_writable(bitmap, BITMAP_POS(start), BITMAP_POS(end))) {
+    return;
+  }
+
+  TW_RANGE_DECLARE(start, end);
+  uint64_t *data = bitmap->data;
+
+  if (first == last) {
+    const uint64_t mask = first_mask & last_mask;
+    bitmap->count += __builtin_popcountll(mask & ~data[first]);
+    data[first] |= mask;
+  } else {
+    const uint64_t n_set =
+        tw_bitmap_kernels_()->words_count(data + first + 1, n_middle);
+    bitmap->count += n_middle * TW_BITS_PER_BITMAP - n_set;
+    memset(data + first + 1, 0xFF, n_middle * TW_BYTES_PER_BITMAP);
+
+    bitmap->count += __builtin_popcountll(first_mask & ~data[first]) +
+                     __builtin_popcountll(last_mask & ~data[last]);
+    data[first] |= first_mask;
+    data[last] |= last_mask;
+  }
+
+  bitmap->generation++;
+}
+
+void tw_bitmap_clear_range(struct tw_bitmap *bitmap, uint64_t start,
+                           uint64_t end)
+{
+  if (!tw_range_valid(bitmap, start, end) ||
+      !tw_bitmap_writable(bitmap, BITMAP_POS(start), BITMAP_POS(end))) {
+    return;
+  }
+
+  TW_RANGE_DECLARE(start, end);
+  uint64_t *data = bitmap->data;
+
+  if (first == last) {
+    const uint64_t mask = first_mask & last_mask;
+    bitmap->count -= __builtin_popcountll(mask & data[first]);
+    data[first] &= ~mask;
+  } else {
+    bitmap->count -=
+        tw_bitmap_kernels_()->words_count(data + first + 1, n_middle);
+    memset(data + first + 1, 0, n_middle * TW_BYTES_PER_BITMAP);
+
+    bitmap->count -= __builtin_popcountll(first_mask & data[first]) +
+                     __builtin_popcountll(last_mask & data[last]);
+    data[first] &= ~first_mask;
+    data[last] &= ~last_mask;
+  }
+
+  bitmap->generation++;
+}
+
+void tw_bitmap_flip_range(struct tw_bitmap *bitmap, uint64_t start,
+                          uint64_t end)
+{
+  if (!tw_range_valid(bitmap, start, end) ||
+      !tw_bitmap_writable(bitmap, BITMAP_POS(start), BITMAP_POS(end))) {
+    return;
+  }
+
+  TW_RANGE_DECLARE(start, end);
+  uint64_t *data = bitmap->data;
+
+  /* count = count - old + new, with old + new = range length */
+  const uint64_t length = end - start + 1;
+  uint64_t n_new = 0;
+
+  if (first == last) {
+    const uint64_t mask = first_mask & last_mask;
+    data[first] ^= mask;
+    n_new = __builtin_popcountll(mask & data[first]);
+  } else {
+    n_new = tw_bitmap_kernels_()->words_flip(data + first + 1, n_middle);
+
+    data[first] ^= first_mask;
+    data[last] ^= last_mask;
+    n_new += __builtin_popcountll(first_mask & data[first]) +
+             __builtin_popcountll(last_mask & data[last]);
+  }
+
+  bitmap->count = bitmap->count - (length - n_new) + n_new;
+  bitmap->generation++;
+}
+
+uint64_t tw_bitmap_count_range(const struct tw_bitmap *bitmap, uint64_t start,
+                               uint64_t end)
+{
+  if (!tw_range_valid(bitmap, start, end)) {
+    return 0;
+  }
+
+  TW_RANGE_DECLARE(start, end);
+  const uint64_t *data = bitmap->data;
+
+  if (first == last) {
+    return __builtin_popcountll(first_mask & last_mask & data[first]);
+  }
+
+  return __builtin_popcountll(first_mask & data[first]) +
+         tw_bitmap_kernels_()->words_count(data + first + 1, n_middle) +
+         __builtin_popcountll(last_mask & data[last]);
+}
+
+bool tw_bitmap_test_range_all(const struct tw_bitmap *bitmap, uint64_t start,
+                              uint64_t end)
+{
+  if (!tw_range_valid(bitmap, start, end)) {
+    return false;
+  }
+
+  TW_RANGE_DECLARE(start, end);
+  const uint64_t *data = bitmap->data;
+
+  if (first == last) {
+    const uint64_t mask = first_mask & last_mask;
+    return (data[first] & mask) == mask;
+  }
+
+  return (data[first] & first_mask) == first_mask &&
+         (data[last] & last_mask) == last_mask &&
+         tw_bitmap_kernels_()->words_all(data + first + 1, n_middle, ~0ULL);
+}
+
+bool tw_bitmap_test_range_any(const struct tw_bitmap *bitmap, uint64_t start,
+                              uint64_t end)
+{
+  if (!tw_range_valid(bitmap, start, end)) {
+    return false;
+  }
+
+  TW_RANGE_DECLARE(start, end);
+  const uint64_t *data = bitmap->data;
+
+  if (first == last) {
+    return (data[first] & first_mask & last_mask) != 0;
+  }
+
+  return (data[first] & first_mask) || (data[last] & last_mask) ||
+         !tw_bitmap_kernels_()->words_all(data + first + 1, n_middle, 0ULL);
+}
+
+/**
+ * Shifts move whole words by `shift / 64`, and funnel shift them by the
+ * remaining `shift % 64` bits in the same pass. Sizes being multiples of
+ * words, no extra bit past the size has to be cleared afterward.
+ */
+
+/* move the `n` words of `src` into `dst` by `shift` positions upward */
+static void tw_words_shift_up(uint64_t *dst, const uint64_t *src, size_t n,
+                              uint64_t shift)
+{
+  const size_t offset = shift / TW_BITS_PER_BITMAP;
+  const unsigned bits = shift % TW_BITS_PER_BITMAP;
+
+  if (bits) {
+    tw_bitmap_kernels_()->words_shl(dst + offset, src, n - offset, bits);
+  } else {
+    memmove(dst + offset, src, (n - offset) * TW_BYTES_PER_BITMAP);
+  }
+  memset(dst, 0, offset * TW_BYTES_PER_BITMAP);
+}
+
+/* move the `n` words of `src` into `dst` by `shift` positions downward */
+static void tw_words_shift_down(uint64_t *dst, const uint64_t *src, size_t n,
+                                uint64_t shift)
+{
+  const size_t offset = shift / TW_BITS_PER_BITMAP;
+  const unsigned bits = shift % TW_BITS_PER_BITMAP;
+
+  if (bits) {
+    tw_bitmap_kernels_()->words_shr(dst, src + offset, n - offset, bits);
+  } else {
+    memmove(dst, src + offset, (n - offset) * TW_BYTES_PER_BITMAP);
+  }
+  memset(dst + n - offset, 0, offset * TW_BYTES_PER_BITMAP);
+}
+
+struct tw_bitmap *tw_bitmap_shift_left(struct tw_bitmap *bitmap,
+                                       uint64_t shift)
+{
+  if (!bitmap || !tw_bitmap_all_writable(bitmap)) {
+    return NULL;
+  }
+
+  if (shift >= bitmap->size) {
+    return tw_bitmap_zero(bitmap);
+  }
+
+  if (shift == 0) {
+    return bitmap;
+  }
+
+  const uint64_t size = bitmap->size;
+  if (!bitmap->stale) {
+    bitmap->count -= tw_bitmap_count_range(bitmap, size - shift, size - 1);
+  }
+
+  tw_words_shift_up(bitmap->data, bitmap->data, TW_BITMAP_PER_BITS(size),
+                    shift);
+  bitmap->generation++;
+
+  return bitmap;
+}
+
+struct tw_bitmap *tw_bitmap_shift_right(struct tw_bitmap *bitmap,
+                                        uint64_t shift)
+{
+  if (!bitmap || !tw_bitmap_all_writable(bitmap)) {
+    return NULL;
+  }
+
+  if (shift >= bitmap->size) {
+    return tw_bitmap_zero(bitmap);
+  }
+
+  if (shift == 0) {
+    return bitmap;
+  }
+
+  const uint64_t size = bitmap->size;
+  if (!bitmap->stale) {
+    bitmap->count -= tw_bitmap_count_range(bitmap, 0, shift - 1);
+  }
+
+  tw_words_shift_down(bitmap->data, bitmap->data, TW_BITMAP_PER_BITS(size),
+                      shift);
+  bitmap->generation++;
+
+  return bitmap;
+}
+
+struct tw_bitmap *tw_bitmap_rotate_left(struct tw_bitmap *bitmap,
+                                        uint64_t shift)
+{
+  if (!bitmap || !tw_bitmap_all_writable(bitmap)) {
+    return NULL;
+  }
+
+  const uint64_t size = bitmap->size;
+  shift %= size;
+
+  if (shift == 0) {
+    return bitmap;
+  }
+
+  /**
+   * The `shift` bits wrapping around are moved down to position 0 in a
+   * temporary buffer, and merged back once the bitmap is shifted.
+   */
+  const uint64_t wrap = size - shift;
+  const size_t n_words = TW_BITMAP_PER_BITS(size);
+  const size_t first = BITMAP_POS(wrap);
+  const size_t n_wrapped = TW_BITMAP_PER_BITS(shift);
+
+  uint64_t *wrapped = malloc((n_words - first) * TW_BYTES_PER_BITMAP);
+  if (!wrapped) {
+    return NULL;
+  }
+
+  tw_words_shift_down(wrapped, bitmap->data + first, n_words - first,
+                      wrap % TW_BITS_PER_BITMAP);
+  tw_words_shift_up(bitmap->data, bitmap->data, n_words, shift);
+
+  for (size_t i = 0; i < n_wrapped; ++i) {
+    bitmap->data[i] |= wrapped[i];
+  }
+  free(wrapped);
+
+  bitmap->generation++;
+
+  return bitmap;
+}
+
+struct tw_bitmap *tw_bitmap_rotate_right(struct tw_bitmap *bitmap,
+                                         uint64_t shift)
+{
+  if (!bitmap) {
+    return NULL;
+  }
+
+  return tw_bitmap_rotate_left(bitmap, bitmap->size - shift % bitmap->size);
+}
+
+/**
+ * Prefetch the word of the position `TW_BITMAP_PREFETCH_DISTANCE` ahead, such
+ * that cache misses of consecutive positions are serviced concurrently.
+ */
+#define tw_bitmap_prefetch_ahead(bitmap, positions, n_positions, i, rw)        \
+  do {                                                                         \
+    const size_t ahead = (i) + TW_BITMAP_PREFETCH_DISTANCE;                    \
+    if (ahead < (n_positions) && (positions)[ahead] < (bitmap)->size) {        \
+      __builtin_prefetch(                                                      \
+          &(bitmap)->data[BITMAP_POS((positions)[ahead])], rw, 0);             \
+    }                                                                          \
+  } while (0)
+
+uint64_t tw_bitmap_set_many(struct tw_bitmap *bitmap, const uint64_t *positions,
+                            size_t n_positions)
+{
+  if (!bitmap || !positions) {
+    return 0;
+  }
+
+  uint64_t *data = bitmap->data;
+  const uint64_t size = bitmap->size;
+  uint64_t changed = 0;
+
+  for (size_t i = 0; i < n_positions; ++i) {
+    tw_bitmap_prefetch_ahead(bitmap, positions, n_positions, i, 1);
+
+    const uint64_t pos = positions[i];
+    if (pos >= size) {
+      continue;
+    }
+
+    const uint64_t old_bitmap = data[BITMAP_POS(pos)];
+    if (!(old_bitmap & MASK(pos)) && !tw_bitmap_writable_pos(bitmap, pos)) {
+      continue;
+    }
+    changed += !(old_bitmap & MASK(pos));
+    data[BITMAP_POS(pos)] = old_bitmap | MASK(pos);
+  }
+
+  bitmap->count += changed;
+  bitmap->generation += changed;
+
+  return changed;
+}
+
+uint64_t tw_bitmap_clear_many(struct tw_bitmap *bitmap,
+                              const uint64_t *positions, size_t n_positions)
+{
+  if (!bitmap || !positions) {
+    return 0;
+  }
+
+  uint64_t *data = bitmap->data;
+  const uint64_t size = bitmap->size;
+  uint64_t changed = 0;
+
+  for (size_t i = 0; i < n_positions; ++i) {
+    tw_bitmap_prefetch_ahead(bitmap, positions, n_positions, i, 1);
+
+    const uint64_t pos = positions[i];
+    if (pos >= size) {
+      continue;
+    }
+
+    const uint64_t old_bitmap = data[BITMAP_POS(pos)];
+    if ((old_bitmap & MASK(pos)) && !tw_bitmap_writable_pos(bitmap, pos)) {
+      continue;
+    }
+    changed += !!(old_bitmap & MASK(pos));
+    data[BITMAP_POS(pos)] = old_bitmap & ~MASK(pos);
+  }
+
+  bitmap->count -= changed;
+  bitmap->generation += changed;
+
+  return changed;
+}
+
+struct tw_bitmap *tw_bitmap_test_many(const struct tw_bitmap *bitmap,
+                                      const uint64_t *positions,
+                                      size_t n_positions,
+                                      struct tw_bitmap *results)
+{
+  if (!bitmap || !positions || !results || bitmap == results ||
+      n_positions > results->size || !tw_bitmap_all_writable(results)) {
+    return NULL;
+  }
+
+  const uint64_t *data = bitmap->data;
+  const uint64_t size = bitmap->size;
+  uint64_t count = 0;
+
+  /* results are packed in a word before being stored */
+  for (size_t w = 0; w < TW_BITMAP_PER_BITS(results->size); ++w) {
+    const size_t begin = w * TW_BITS_PER_BITMAP;
+    const size_t end = tw_min(begin + TW_BITS_PER_BITMAP, n_positions);
+    uint64_t word = 0;
+
+    for (size_t i = begin; i < end; ++i) {
+      tw_bitmap_prefetch_ahead(bitmap, positions, n_positions, i, 0);
+
+      const uint64_t pos = positions[i];
+      if (pos < size) {
+        word |= ((data[BITMAP_POS(pos)] >> (pos % TW_BITS_PER_BITMAP)) & 1ULL)
+                << (i - begin);
+      }
+    }
+
+    count += __builtin_popcountll(word);
+    results->data[w] = word;
+  }
+
+  results->count = count;
+  results->stale = false;
+  results->generation++;
+
+  return results;
 }
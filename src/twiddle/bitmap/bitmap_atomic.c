@@ -0,0 +1,197 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_atomic.h>
+
+#include "../macrology.h"
+#include "bitmap_internal.h"
+
+/* counters are spread one cache line apart to avoid false sharing */
+#define TW_COUNT_STRIDE (TW_CACHELINE / sizeof(int64_t))
+#define TW_COUNTS_SIZE (TW_BITMAP_ATOMIC_STRIPES * TW_CACHELINE)
+
+/**
+ * Stripe of the calling thread, assigned round-robin on the first write such
+ * that up to `TW_BITMAP_ATOMIC_STRIPES` threads never share a counter.
+ */
+static unsigned tw_bitmap_atomic_next_stripe = 0;
+static _Thread_local int tw_bitmap_atomic_stripe_ = -1;
+
+static inline int64_t *tw_bitmap_atomic_counter(struct tw_bitmap_atomic *bitmap)
+{
+  if (tw_unlikely(tw_bitmap_atomic_stripe_ < 0)) {
+    const unsigned next = __atomic_fetch_add(&tw_bitmap_atomic_next_stripe, 1,
+                                             __ATOMIC_RELAXED);
+    tw_bitmap_atomic_stripe_ = next % TW_BITMAP_ATOMIC_STRIPES;
+  }
+
+  return bitmap->counts + tw_bitmap_atomic_stripe_ * TW_COUNT_STRIDE;
+}
+
+#define tw_bitmap_atomic_count_add(bitmap, delta)                              \
+  __atomic_fetch_add(tw_bitmap_atomic_counter(bitmap), (delta),                \
+                     __ATOMIC_RELAXED)
+
+struct tw_bitmap_atomic *tw_bitmap_atomic_new(uint64_t size)
+{
+  if (0 == size || size > TW_BITMAP_MAX_BITS) {
+    return NULL;
+  }
+
+  struct tw_bitmap_atomic *bitmap = calloc(1, sizeof(struct tw_bitmap_atomic));
+
+  if (!bitmap) {
+    return NULL;
+  }
+
+  const size_t data_size =
+      TW_ALLOC_TO_CACHELINE(TW_BITMAP_PER_BITS(size) * TW_BYTES_PER_BITMAP);
+
+  if ((bitmap->data = malloc_aligned(TW_CACHELINE, data_size)) == NULL) {
+    free(bitmap);
+    return NULL;
+  }
+
+  if ((bitmap->counts = malloc_aligned(TW_CACHELINE, TW_COUNTS_SIZE)) == NULL) {
+    free(bitmap->data);
+    free(bitmap);
+    return NULL;
+  }
+
+  memset(bitmap->data, 0, data_size);
+  memset(bitmap->counts, 0, TW_COUNTS_SIZE);
+
+  bitmap->size = data_size * TW_BITS_IN_WORD;
+  return bitmap;
+}
+
+void tw_bitmap_atomic_free(struct tw_bitmap_atomic *bitmap)
+{
+  free(bitmap->counts);
+  free(bitmap->data);
+  free(bitmap);
+}
+
+bool tw_bitmap_atomic_test_and_set(struct tw_bitmap_atomic *bitmap,
+                                   uint64_t pos)
+{
+  if (!bitmap || pos >= bitmap->size) {
+    return false;
+  }
+
+  uint64_t *word = &bitmap->data[BITMAP_POS(pos)];
+
+  /* avoid taking the cache line exclusively when the bit is already set */
+  if (__atomic_load_n(word, __ATOMIC_ACQUIRE) & MASK(pos)) {
+    return true;
+  }
+
+  const uint64_t old = __atomic_fetch_or(word, MASK(pos), __ATOMIC_ACQ_REL);
+  const bool was_set = !!(old & MASK(pos));
+  if (!was_set) {
+    tw_bitmap_atomic_count_add(bitmap, 1);
+  }
+
+  return was_set;
+}
+
+bool tw_bitmap_atomic_test_and_clear(struct tw_bitmap_atomic *bitmap,
+                                     uint64_t pos)
+{
+  if (!bitmap || pos >= bitmap->size) {
+    return false;
+  }
+
+  uint64_t *word = &bitmap->data[BITMAP_POS(pos)];
+
+  if (!(__atomic_load_n(word, __ATOMIC_ACQUIRE) & MASK(pos))) {
+    return false;
+  }
+
+  const uint64_t old = __atomic_fetch_and(word, ~MASK(pos), __ATOMIC_ACQ_REL);
+  const bool was_set = !!(old & MASK(pos));
+  if (was_set) {
+    tw_bitmap_atomic_count_add(bitmap, -1);
+  }
+
+  return was_set;
+}
+
+void tw_bitmap_atomic_set(struct tw_bitmap_atomic *bitmap, uint64_t pos)
+{
+  tw_bitmap_atomic_test_and_set(bitmap, pos);
+}
+
+void tw_bitmap_atomic_clear(struct tw_bitmap_atomic *bitmap, uint64_t pos)
+{
+  tw_bitmap_atomic_test_and_clear(bitmap, pos);
+}
+
+bool tw_bitmap_atomic_test(const struct tw_bitmap_atomic *bitmap,
+                           uint64_t pos)
+{
+  if (!bitmap || pos >= bitmap->size) {
+    return false;
+  }
+
+  return !!(__atomic_load_n(&bitmap->data[BITMAP_POS(pos)], __ATOMIC_ACQUIRE) &
+            MASK(pos));
+}
+
+uint64_t tw_bitmap_atomic_count(const struct tw_bitmap_atomic *bitmap)
+{
+  if (!bitmap) {
+    return 0;
+  }
+
+  int64_t count = 0;
+  for (size_t i = 0; i < TW_BITMAP_ATOMIC_STRIPES; ++i) {
+    count += __atomic_load_n(&bitmap->counts[i * TW_COUNT_STRIDE],
+                             __ATOMIC_RELAXED);
+  }
+
+  /* a concurrent snapshot may be transiently out of bounds */
+  if (count < 0) {
+    return 0;
+  }
+
+  return tw_min((uint64_t)count, bitmap->size);
+}
+
+struct tw_bitmap_atomic *tw_bitmap_atomic_zero(struct tw_bitmap_atomic *bitmap)
+{
+  if (!bitmap) {
+    return NULL;
+  }
+
+  memset(bitmap->data, 0, bitmap->size / TW_BITS_IN_WORD);
+  memset(bitmap->counts, 0, TW_COUNTS_SIZE);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  return bitmap;
+}
+
+struct tw_bitmap *tw_bitmap_atomic_copy(const struct tw_bitmap_atomic *src,
+                                        struct tw_bitmap *dst)
+{
+  if (!src || !dst ||
+      (dst->size != src->size && !tw_bitmap_resize(dst, src->size)) ||
+      !tw_bitmap_all_writable(dst)) {
+    return NULL;
+  }
+
+  uint64_t count = 0;
+  for (size_t i = 0; i < TW_BITMAP_PER_BITS(src->size); ++i) {
+    const uint64_t word = __atomic_load_n(&src->data[i], __ATOMIC_ACQUIRE);
+    count += __builtin_popcountll(word);
+    dst->data[i] = word;
+  }
+
+  /* the count of the copied words, not of a later snapshot of the stripes */
+  dst->count = count;
+  dst->stale = false;
+  dst->generation++;
+
+  return dst;
+}
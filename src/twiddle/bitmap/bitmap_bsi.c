@@ -0,0 +1,321 @@
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_bsi.h>
+
+struct tw_bitmap_bsi *tw_bitmap_bsi_new(uint64_t size, uint8_t bits)
+{
+  if (0 == size || size > TW_BITMAP_MAX_BITS || 0 == bits ||
+      bits > TW_BITMAP_BSI_MAX_BITS) {
+    return NULL;
+  }
+
+  struct tw_bitmap_bsi *bsi = calloc(1, sizeof(struct tw_bitmap_bsi));
+  if (!bsi) {
+    return NULL;
+  }
+
+  bsi->size = size;
+  bsi->bits = bits;
+
+  if (!(bsi->exists = tw_bitmap_new(size))) {
+    free(bsi);
+    return NULL;
+  }
+
+  for (uint8_t i = 0; i < bits; ++i) {
+    if (!(bsi->slices[i] = tw_bitmap_new(size))) {
+      tw_bitmap_bsi_free(bsi);
+      return NULL;
+    }
+  }
+
+  return bsi;
+}
+
+void tw_bitmap_bsi_free(struct tw_bitmap_bsi *bsi)
+{
+  if (!bsi) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < bsi->bits && bsi->slices[i]; ++i) {
+    tw_bitmap_free(bsi->slices[i]);
+  }
+  tw_bitmap_free(bsi->exists);
+  free(bsi);
+}
+
+/* verify if `value` fits in the `bsi.bits` bits of the values */
+static inline bool tw_bitmap_bsi_fits(const struct tw_bitmap_bsi *bsi,
+                                      uint64_t value)
+{
+  return bsi->bits == TW_BITMAP_BSI_MAX_BITS || (value >> bsi->bits) == 0;
+}
+
+void tw_bitmap_bsi_set(struct tw_bitmap_bsi *bsi, uint64_t row,
+                       uint64_t value)
+{
+  if (!bsi || row >= bsi->size || !tw_bitmap_bsi_fits(bsi, value)) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < bsi->bits; ++i) {
+    if ((value >> i) & 1) {
+      tw_bitmap_set(bsi->slices[i], row);
+    } else {
+      tw_bitmap_clear(bsi->slices[i], row);
+    }
+  }
+
+  tw_bitmap_set(bsi->exists, row);
+}
+
+void tw_bitmap_bsi_clear(struct tw_bitmap_bsi *bsi, uint64_t row)
+{
+  if (!bsi || row >= bsi->size) {
+    return;
+  }
+
+  for (uint8_t i = 0; i < bsi->bits; ++i) {
+    tw_bitmap_clear(bsi->slices[i], row);
+  }
+
+  tw_bitmap_clear(bsi->exists, row);
+}
+
+bool tw_bitmap_bsi_get(const struct tw_bitmap_bsi *bsi, uint64_t row,
+                       uint64_t *value)
+{
+  if (!bsi || !value || row >= bsi->size ||
+      !tw_bitmap_test(bsi->exists, row)) {
+    return false;
+  }
+
+  uint64_t result = 0;
+  for (uint8_t i = 0; i < bsi->bits; ++i) {
+    result |= (uint64_t)tw_bitmap_test(bsi->slices[i], row) << i;
+  }
+  *value = result;
+
+  return true;
+}
+
+uint64_t tw_bitmap_bsi_count(const struct tw_bitmap_bsi *bsi)
+{
+  if (!bsi) {
+    return 0;
+  }
+
+  return tw_bitmap_count(bsi->exists);
+}
+
+static bool tw_bitmap_bsi_valid(const struct tw_bitmap_bsi *bsi,
+                                const struct tw_bitmap *filter,
+                                const struct tw_bitmap *dst)
+{
+  return bsi && dst && dst->size == bsi->exists->size &&
+         (!filter || filter->size == bsi->exists->size);
+}
+
+/* rows holding a value, restricted to `filter` if non-null */
+static struct tw_bitmap *tw_bitmap_bsi_rows(const struct tw_bitmap_bsi *bsi,
+                                            const struct tw_bitmap *filter,
+                                            struct tw_bitmap *dst)
+{
+  return filter ? tw_bitmap_intersection_into(bsi->exists, filter, dst)
+                : tw_bitmap_copy(bsi->exists, dst);
+}
+
+struct tw_bitmap *tw_bitmap_bsi_compare(const struct tw_bitmap_bsi *bsi,
+                                        enum tw_bitmap_bsi_op op, uint64_t x,
+                                        const struct tw_bitmap *filter,
+                                        struct tw_bitmap *dst)
+{
+  if (!tw_bitmap_bsi_valid(bsi, filter, dst) || op > TW_BITMAP_BSI_NE) {
+    return NULL;
+  }
+
+  struct tw_bitmap *eq = tw_bitmap_new(bsi->size);
+  if (!eq) {
+    return NULL;
+  }
+
+  struct tw_bitmap *tmp = tw_bitmap_new(bsi->size);
+  if (!tmp) {
+    tw_bitmap_free(eq);
+    return NULL;
+  }
+
+  const bool less = (op == TW_BITMAP_BSI_LT || op == TW_BITMAP_BSI_LE);
+  const bool greater = (op == TW_BITMAP_BSI_GT || op == TW_BITMAP_BSI_GE);
+
+  /**
+   * `eq` holds the rows whose value equals `x` on the visited bits, and `dst`
+   * accumulates the rows found smaller (or greater) on the first differing
+   * bit, depending on the operator.
+   */
+  tw_bitmap_bsi_rows(bsi, filter, eq);
+  tw_bitmap_zero(dst);
+
+  if (!tw_bitmap_bsi_fits(bsi, x)) {
+    /* every value is smaller than `x` */
+    if (less) {
+      tw_bitmap_copy(eq, dst);
+    }
+    tw_bitmap_zero(eq);
+  }
+
+  for (int i = bsi->bits - 1; i >= 0 && !tw_bitmap_empty(eq); --i) {
+    const struct tw_bitmap *slice = bsi->slices[i];
+
+    if ((x >> i) & 1) {
+      if (less) {
+        tw_bitmap_andnot_into(eq, slice, tmp);
+        tw_bitmap_union(tmp, dst);
+      }
+      tw_bitmap_intersection(slice, eq);
+    } else {
+      if (greater) {
+        tw_bitmap_intersection_into(eq, slice, tmp);
+        tw_bitmap_union(tmp, dst);
+      }
+      tw_bitmap_andnot(slice, eq);
+    }
+  }
+
+  switch (op) {
+  case TW_BITMAP_BSI_LE:
+  case TW_BITMAP_BSI_GE:
+    tw_bitmap_union(eq, dst);
+    break;
+  case TW_BITMAP_BSI_EQ:
+    tw_bitmap_copy(eq, dst);
+    break;
+  case TW_BITMAP_BSI_NE:
+    tw_bitmap_bsi_rows(bsi, filter, dst);
+    tw_bitmap_andnot(eq, dst);
+    break;
+  default:
+    break;
+  }
+
+  tw_bitmap_free(tmp);
+  tw_bitmap_free(eq);
+
+  return dst;
+}
+
+struct tw_bitmap *tw_bitmap_bsi_between(const struct tw_bitmap_bsi *bsi,
+                                        uint64_t lo, uint64_t hi,
+                                        const struct tw_bitmap *filter,
+                                        struct tw_bitmap *dst)
+{
+  if (!tw_bitmap_bsi_valid(bsi, filter, dst)) {
+    return NULL;
+  }
+
+  struct tw_bitmap *ge = tw_bitmap_new(bsi->size);
+  if (!ge) {
+    return NULL;
+  }
+
+  /* the second pass starts from the rows of the first, and may stop early */
+  struct tw_bitmap *res =
+      tw_bitmap_bsi_compare(bsi, TW_BITMAP_BSI_GE, lo, filter, ge)
+          ? tw_bitmap_bsi_compare(bsi, TW_BITMAP_BSI_LE, hi, ge, dst)
+          : NULL;
+
+  tw_bitmap_free(ge);
+
+  return res;
+}
+
+uint64_t tw_bitmap_bsi_sum(const struct tw_bitmap_bsi *bsi,
+                           const struct tw_bitmap *filter)
+{
+  if (!bsi || (filter && filter->size != bsi->exists->size)) {
+    return 0;
+  }
+
+  /* slices only hold rows with a value, their maintained count is exact */
+  uint64_t sum = 0;
+  for (uint8_t i = 0; i < bsi->bits; ++i) {
+    const uint64_t n =
+        filter ? tw_bitmap_intersection_count(bsi->slices[i], filter)
+               : tw_bitmap_count(bsi->slices[i]);
+    sum += n << i;
+  }
+
+  return sum;
+}
+
+struct tw_bitmap *tw_bitmap_bsi_top_k(const struct tw_bitmap_bsi *bsi,
+                                      uint64_t k,
+                                      const struct tw_bitmap *filter,
+                                      struct tw_bitmap *dst)
+{
+  if (!tw_bitmap_bsi_valid(bsi, filter, dst)) {
+    return NULL;
+  }
+
+  struct tw_bitmap *candidates = tw_bitmap_new(bsi->size);
+  if (!candidates) {
+    return NULL;
+  }
+
+  struct tw_bitmap *tmp = tw_bitmap_new(bsi->size);
+  if (!tmp) {
+    tw_bitmap_free(candidates);
+    return NULL;
+  }
+
+  /**
+   * `dst` holds the rows known to be in the top `k`, and `candidates` the
+   * rows whose value equals the `k`-th largest on the visited bits. On each
+   * slice, candidates with the bit set are selected if they fit in `k`,
+   * otherwise candidates without the bit are discarded.
+   */
+  tw_bitmap_zero(dst);
+  tw_bitmap_bsi_rows(bsi, filter, candidates);
+
+  if (tw_bitmap_count(candidates) <= k) {
+    tw_bitmap_copy(candidates, dst);
+    tw_bitmap_free(tmp);
+    tw_bitmap_free(candidates);
+    return dst;
+  }
+
+  for (int i = bsi->bits - 1; i >= 0; --i) {
+    const struct tw_bitmap *slice = bsi->slices[i];
+
+    tw_bitmap_intersection_into(candidates, slice, tmp);
+    const uint64_t n = tw_bitmap_count(dst) + tw_bitmap_count(tmp);
+
+    if (n > k) {
+      tw_bitmap_intersection(slice, candidates);
+    } else {
+      tw_bitmap_union(tmp, dst);
+      tw_bitmap_andnot(slice, candidates);
+      if (n == k) {
+        break;
+      }
+    }
+  }
+
+  /* remaining candidates are tied, the lowest rows are kept */
+  uint64_t keep = k - tw_bitmap_count(dst);
+  int64_t last = -1;
+  while (keep-- > 0) {
+    last = tw_bitmap_find_next_bit(candidates, last + 1);
+  }
+  if ((uint64_t)(last + 1) < candidates->size) {
+    tw_bitmap_clear_range(candidates, last + 1, candidates->size - 1);
+  }
+  tw_bitmap_union(candidates, dst);
+
+  tw_bitmap_free(tmp);
+  tw_bitmap_free(candidates);
+
+  return dst;
+}
@@ -0,0 +1,65 @@
+#ifndef TWIDDLE_BITMAP_INTERNAL_H
+#define TWIDDLE_BITMAP_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <twiddle/bitmap/bitmap.h>
+
+#include "../macrology.h"
+#include "../utils/pages.h"
+
+#define TW_BYTES_PER_BITMAP sizeof(uint64_t)
+#define TW_BITS_PER_BITMAP (TW_BYTES_PER_BITMAP * TW_BITS_IN_WORD)
+
+#define BITMAP_POS(pos) (pos / TW_BITS_PER_BITMAP)
+#define MASK(pos) (1ULL << (pos % TW_BITS_PER_BITMAP))
+
+#define TW_BITMAP_PER_BITS(nbits) TW_DIV_ROUND_UP(nbits, TW_BITS_PER_BITMAP)
+
+/* shared by the translation units of bitmaps, not exported by the library */
+#define TW_BITMAP_INTERNAL __attribute__((visibility("hidden")))
+
+/* the bits of file-backed bitmaps follow a header, see bitmap_mmap.c */
+#define tw_bitmap_is_file_backed(bitmap)                                       \
+  ((bitmap)->mapping && (void *)(bitmap)->data != (bitmap)->mapping)
+
+/* the bits of wrapped bitmaps are owned by the caller, see `tw_bitmap_wrap` */
+#define tw_bitmap_is_wrapped(bitmap) ((bitmap)->flags & TW_ALLOC_WRAPPED)
+
+/**
+ * Number of active bits from `from`, a multiple of 512, to the end of the
+ * bitmap, see bitmap.c.
+ */
+TW_BITMAP_INTERNAL uint64_t tw_bitmap_tail_count(const struct tw_bitmap *bitmap,
+                                                 uint64_t from);
+
+/**
+ * Release the mapping of a file-backed bitmap, see bitmap_mmap.c.
+ */
+TW_BITMAP_INTERNAL void tw_bitmap_unmap(struct tw_bitmap *bitmap);
+
+/**
+ * Copy the shared chunks of the words `[first_word, last_word]` of a shared
+ * bitmap, see bitmap_snapshot.c. Returns `false` if a chunk could not be
+ * copied, the bitmap must then be left untouched.
+ */
+TW_BITMAP_INTERNAL bool tw_bitmap_unshare(struct tw_bitmap *bitmap,
+                                          uint64_t first_word,
+                                          uint64_t last_word);
+
+/**
+ * Release the chunks of a shared bitmap, see bitmap_snapshot.c.
+ */
+TW_BITMAP_INTERNAL void tw_bitmap_cow_free(struct tw_bitmap *bitmap);
+
+/* shared bitmaps are written once the chunks to modify are copied */
+#define tw_bitmap_writable(bitmap, first_word, last_word)                      \
+  (tw_likely(!(bitmap)->cow) ||                                                \
+   tw_bitmap_unshare(bitmap, first_word, last_word))
+#define tw_bitmap_writable_pos(bitmap, pos)                                    \
+  tw_bitmap_writable(bitmap, BITMAP_POS(pos), BITMAP_POS(pos))
+#define tw_bitmap_all_writable(bitmap)                                         \
+  tw_bitmap_writable(bitmap, 0, TW_BITMAP_PER_BITS((bitmap)->size) - 1)
+
+#endif /* TWIDDLE_BITMAP_INTERNAL_H */
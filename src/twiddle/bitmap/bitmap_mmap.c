@@ -0,0 +1,268 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_mmap.h>
+
+#include "../macrology.h"
+#include "bitmap_internal.h"
+
+#define TW_BITMAP_MMAP_MAGIC "TWBITMAP"
+#define TW_BITMAP_MMAP_VERSION 1
+/* a page, such that bits are page aligned in the mapping */
+#define TW_BITMAP_MMAP_HEADER_SIZE 4096
+
+struct tw_bitmap_mmap_header {
+  char magic[8];
+  uint32_t version;
+  /** set while the file is opened writable, `count` is then stale */
+  uint32_t dirty;
+  uint64_t size;
+  uint64_t count;
+};
+
+static_assert(sizeof(struct tw_bitmap_mmap_header) <=
+                  TW_BITMAP_MMAP_HEADER_SIZE,
+              "header must fit before the bits");
+
+/* file-backed bitmaps have their header mapped before the bits */
+#define tw_bitmap_mmap_header(bitmap)                                          \
+  ((struct tw_bitmap_mmap_header *)(bitmap)->mapping)
+
+/* map `fd` and wrap it in a `struct tw_bitmap`, the descriptor is closed */
+static struct tw_bitmap *tw_bitmap_mmap_fd(int fd, uint64_t mapping_size,
+                                           int prot, int flags)
+{
+  struct tw_bitmap *bitmap = calloc(1, sizeof(struct tw_bitmap));
+  if (!bitmap) {
+    close(fd);
+    return NULL;
+  }
+
+  void *mapping = mmap(NULL, mapping_size, prot, flags, fd, 0);
+  close(fd);
+
+  if (mapping == MAP_FAILED) {
+    free(bitmap);
+    return NULL;
+  }
+
+  const struct tw_bitmap_mmap_header *header = mapping;
+  bitmap->size = header->size;
+  bitmap->count = header->count;
+  /* the file is sized to the bits, file-backed bitmaps are not resized */
+  bitmap->capacity = header->size;
+  bitmap->data =
+      (uint64_t *)((char *)mapping + TW_BITMAP_MMAP_HEADER_SIZE);
+  bitmap->mapping = mapping;
+  bitmap->mapping_size = mapping_size;
+
+  return bitmap;
+}
+
+struct tw_bitmap *tw_bitmap_create_mmap(const char *path, uint64_t size)
+{
+  if (!path || 0 == size || size > TW_BITMAP_MAX_BITS) {
+    return NULL;
+  }
+
+  const uint64_t data_size =
+      TW_ALLOC_TO_CACHELINE(TW_BITMAP_PER_BITS(size) * TW_BYTES_PER_BITMAP);
+  const uint64_t mapping_size = TW_BITMAP_MMAP_HEADER_SIZE + data_size;
+
+  const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  /* extending the file leaves a hole, read as zeroes without storage */
+  struct tw_bitmap_mmap_header header = {
+      .magic = TW_BITMAP_MMAP_MAGIC,
+      .version = TW_BITMAP_MMAP_VERSION,
+      .dirty = 1,
+      .size = data_size * TW_BITS_IN_WORD,
+      .count = 0,
+  };
+  if (ftruncate(fd, mapping_size) != 0 ||
+      pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+    close(fd);
+    return NULL;
+  }
+
+  return tw_bitmap_mmap_fd(fd, mapping_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED);
+}
+
+struct tw_bitmap *tw_bitmap_open_mmap(const char *path, bool writable)
+{
+  if (!path) {
+    return NULL;
+  }
+
+  const int fd = open(path, writable ? O_RDWR : O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  struct tw_bitmap_mmap_header header;
+  struct stat st;
+  if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+      fstat(fd, &st) != 0) {
+    close(fd);
+    return NULL;
+  }
+
+  const uint64_t data_size = header.size / TW_BITS_IN_WORD;
+  if (memcmp(header.magic, TW_BITMAP_MMAP_MAGIC, sizeof(header.magic)) ||
+      header.version != TW_BITMAP_MMAP_VERSION || header.size == 0 ||
+      header.size > TW_BITMAP_MAX_BITS ||
+      data_size % TW_CACHELINE != 0 ||
+      (uint64_t)st.st_size != TW_BITMAP_MMAP_HEADER_SIZE + data_size) {
+    close(fd);
+    return NULL;
+  }
+
+  /* read only files are mapped privately, modifications are copied on write */
+  struct tw_bitmap *bitmap = tw_bitmap_mmap_fd(
+      fd, st.st_size, PROT_READ | PROT_WRITE,
+      writable ? MAP_SHARED : MAP_PRIVATE);
+  if (!bitmap) {
+    return NULL;
+  }
+
+  if (header.dirty) {
+    bitmap->count = tw_bitmap_count_range(bitmap, 0, bitmap->size - 1);
+  }
+
+  if (writable) {
+    tw_bitmap_mmap_header(bitmap)->dirty = 1;
+  }
+
+  return bitmap;
+}
+
+bool tw_bitmap_sync_mmap(struct tw_bitmap *bitmap)
+{
+  if (!bitmap || !tw_bitmap_is_file_backed(bitmap)) {
+    return false;
+  }
+
+  /* the header stays dirty, the bitmap may be modified after synchronizing */
+  tw_bitmap_mmap_header(bitmap)->count = tw_bitmap_count(bitmap);
+
+  return msync(bitmap->mapping, bitmap->mapping_size, MS_SYNC) == 0;
+}
+
+/**
+ * Release the mapping of a bitmap, called by `tw_bitmap_free`. The header of
+ * a file-backed bitmap is marked clean only once its bits are persisted, a
+ * crash in between leaves it dirty and the count is recovered on open.
+ */
+void tw_bitmap_unmap(struct tw_bitmap *bitmap)
+{
+  if (tw_bitmap_is_file_backed(bitmap) && tw_bitmap_sync_mmap(bitmap)) {
+    tw_bitmap_mmap_header(bitmap)->dirty = 0;
+  }
+
+  munmap(bitmap->mapping, bitmap->mapping_size);
+}
+
+/* hint the kernel that `[offset, offset + length)` bytes of bits are needed */
+static void tw_bitmap_mmap_advise(const struct tw_bitmap *bitmap,
+                                  uint64_t offset, uint64_t length, int advice)
+{
+  if (!bitmap->mapping) {
+    return;
+  }
+
+  /* bits are page aligned, and chunks a multiple of pages */
+  const uint64_t data_offset = (char *)bitmap->data - (char *)bitmap->mapping;
+  const uint64_t end = tw_min(data_offset + offset + length,
+                              bitmap->mapping_size);
+  madvise((char *)bitmap->mapping + data_offset + offset,
+          end - data_offset - offset, advice);
+}
+
+typedef struct tw_bitmap *(*tw_bitmap_op)(const struct tw_bitmap *src,
+                                          struct tw_bitmap *dst);
+
+/**
+ * Apply `op` on views of `TW_BITMAP_MMAP_CHUNK` bits, reading ahead the next
+ * chunk. Views are regular bitmaps, thus each chunk uses the SIMD kernels.
+ * With `grow`, `dst` is first resized to the size of a larger `src` and keeps
+ * its bits past `src`, otherwise they are cleared.
+ */
+static struct tw_bitmap *tw_bitmap_chunked(const struct tw_bitmap *src,
+                                           struct tw_bitmap *dst,
+                                           tw_bitmap_op op, bool grow)
+{
+  if (!src || !dst ||
+      (grow && src->size > dst->size && !tw_bitmap_resize(dst, src->size)) ||
+      !tw_bitmap_all_writable(dst)) {
+    return NULL;
+  }
+
+  const uint64_t size = tw_min(src->size, dst->size);
+
+  static_assert(TW_BITMAP_MMAP_CHUNK % (TW_CACHELINE * TW_BITS_IN_WORD) == 0,
+                "chunks must be a multiple of the bitmap's alignment");
+  const uint64_t chunk_bytes = TW_BITMAP_MMAP_CHUNK / TW_BITS_IN_WORD;
+  const uint64_t data_size = size / TW_BITS_IN_WORD;
+
+  tw_bitmap_mmap_advise(src, 0, data_size, MADV_SEQUENTIAL);
+  tw_bitmap_mmap_advise(dst, 0, data_size, MADV_SEQUENTIAL);
+
+  uint64_t count = 0;
+  for (uint64_t offset = 0; offset < data_size; offset += chunk_bytes) {
+    const uint64_t next = offset + chunk_bytes;
+    if (next < data_size) {
+      tw_bitmap_mmap_advise(src, next, chunk_bytes, MADV_WILLNEED);
+      tw_bitmap_mmap_advise(dst, next, chunk_bytes, MADV_WILLNEED);
+    }
+
+    const uint64_t length = tw_min(chunk_bytes, data_size - offset);
+    const struct tw_bitmap src_view = {
+        .size = length * TW_BITS_IN_WORD,
+        .data = src->data + offset / TW_BYTES_PER_BITMAP,
+    };
+    struct tw_bitmap dst_view = {
+        .size = length * TW_BITS_IN_WORD,
+        .data = dst->data + offset / TW_BYTES_PER_BITMAP,
+    };
+
+    op(&src_view, &dst_view);
+    count += dst_view.count;
+  }
+
+  tw_bitmap_mmap_advise(src, 0, data_size, MADV_NORMAL);
+  tw_bitmap_mmap_advise(dst, 0, data_size, MADV_NORMAL);
+
+  if (grow) {
+    count += tw_bitmap_tail_count(dst, size);
+  } else {
+    memset(dst->data + BITMAP_POS(size), 0,
+           (dst->size - size) / TW_BITS_IN_WORD);
+  }
+
+  dst->count = count;
+  dst->stale = false;
+  dst->generation++;
+
+  return dst;
+}
+
+struct tw_bitmap *tw_bitmap_union_mmap(const struct tw_bitmap *src,
+                                       struct tw_bitmap *dst)
+{
+  return tw_bitmap_chunked(src, dst, tw_bitmap_union, true);
+}
+
+struct tw_bitmap *tw_bitmap_intersection_mmap(const struct tw_bitmap *src,
+                                              struct tw_bitmap *dst)
+{
+  return tw_bitmap_chunked(src, dst, tw_bitmap_intersection, false);
+}
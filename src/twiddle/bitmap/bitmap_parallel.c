@@ -0,0 +1,258 @@
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_parallel.h>
+
+#include "../macrology.h"
+#include "bitmap_internal.h"
+
+/* bitmaps are allocated, and thus split, in cache lines */
+#define TW_BITS_PER_CACHELINE (TW_CACHELINE * TW_BITS_IN_WORD)
+
+#define TW_BITMAP_PARALLEL_MAX_TASKS                                           \
+  (TW_THREAD_POOL_MAX_THREADS * TW_BITMAP_PARALLEL_TASKS_PER_THREAD)
+
+/**
+ * Applied on views of a chunk of the bitmaps, returns the number of active
+ * bits of `dst` once modified, or non-zero if chunks differ for `equal`.
+ */
+typedef uint64_t (*tw_bitmap_chunk_op)(const struct tw_bitmap *src,
+                                       struct tw_bitmap *dst);
+
+struct tw_bitmap_parallel {
+  tw_bitmap_chunk_op op;
+  const struct tw_bitmap *src;
+  struct tw_bitmap *dst;
+  uint64_t size;
+  /* bits per task, a multiple of cache lines */
+  uint64_t chunk;
+  /* set once a task returns non-zero, remaining tasks are skipped */
+  bool stop_on_nonzero;
+  bool stop;
+  uint64_t results[TW_BITMAP_PARALLEL_MAX_TASKS];
+};
+
+static void tw_bitmap_parallel_task(void *opaque, size_t task)
+{
+  struct tw_bitmap_parallel *parallel = (struct tw_bitmap_parallel *)opaque;
+
+  if (parallel->stop_on_nonzero &&
+      __atomic_load_n(&parallel->stop, __ATOMIC_RELAXED)) {
+    return;
+  }
+
+  const uint64_t offset = task * parallel->chunk;
+  const uint64_t size = tw_min(parallel->chunk, parallel->size - offset);
+  const uint64_t word = offset / TW_BITS_PER_BITMAP;
+
+  /**
+   * views are regular bitmaps, thus each chunk uses the SIMD kernels and the
+   * size semantics of the serial operation, chunks past the end of a smaller
+   * `src` seeing an empty source
+   */
+  const struct tw_bitmap *src = parallel->src;
+  const uint64_t src_size =
+      src && offset < src->size ? tw_min(size, src->size - offset) : 0;
+  const struct tw_bitmap src_view = {
+      .size = src_size, .data = src_size ? src->data + word : NULL,
+  };
+  struct tw_bitmap dst_view = {
+      .size = size, .data = parallel->dst->data + word,
+  };
+
+  const uint64_t result = parallel->op(&src_view, &dst_view);
+  parallel->results[task] = result;
+
+  if (parallel->stop_on_nonzero && result) {
+    __atomic_store_n(&parallel->stop, true, __ATOMIC_RELAXED);
+  }
+}
+
+/* split `dst` in tasks for `pool`, returns the sum of the tasks' results */
+static uint64_t tw_bitmap_parallel_run(tw_bitmap_chunk_op op,
+                                       const struct tw_bitmap *src,
+                                       struct tw_bitmap *dst,
+                                       struct tw_thread_pool *pool,
+                                       bool stop_on_nonzero)
+{
+  const uint64_t max_tasks =
+      tw_thread_pool_size(pool) * TW_BITMAP_PARALLEL_TASKS_PER_THREAD;
+  const uint64_t chunk = tw_max(TW_DIV_ROUND_UP(dst->size, max_tasks),
+                                TW_BITMAP_PARALLEL_MIN_CHUNK);
+
+  struct tw_bitmap_parallel parallel = {
+      .op = op,
+      .src = src,
+      .dst = dst,
+      .size = dst->size,
+      .chunk = TW_DIV_ROUND_UP(chunk, TW_BITS_PER_CACHELINE) *
+               TW_BITS_PER_CACHELINE,
+      .stop_on_nonzero = stop_on_nonzero,
+  };
+
+  const size_t n_tasks = TW_DIV_ROUND_UP(dst->size, parallel.chunk);
+  tw_thread_pool_run(pool, tw_bitmap_parallel_task, &parallel, n_tasks);
+
+  uint64_t result = 0;
+  for (size_t i = 0; i < n_tasks; ++i) {
+    result += parallel.results[i];
+  }
+
+  return result;
+}
+
+static uint64_t tw_bitmap_union_chunk(const struct tw_bitmap *src,
+                                      struct tw_bitmap *dst)
+{
+  return tw_bitmap_union(src, dst)->count;
+}
+
+static uint64_t tw_bitmap_intersection_chunk(const struct tw_bitmap *src,
+                                             struct tw_bitmap *dst)
+{
+  return tw_bitmap_intersection(src, dst)->count;
+}
+
+static uint64_t tw_bitmap_xor_chunk(const struct tw_bitmap *src,
+                                    struct tw_bitmap *dst)
+{
+  return tw_bitmap_xor(src, dst)->count;
+}
+
+static uint64_t tw_bitmap_not_chunk(const struct tw_bitmap *src,
+                                    struct tw_bitmap *dst)
+{
+  (void)src;
+  tw_bitmap_not(dst);
+  return 0;
+}
+
+/* views have no count, thus `tw_bitmap_equal` compares the bits only */
+static uint64_t tw_bitmap_differ_chunk(const struct tw_bitmap *src,
+                                       struct tw_bitmap *dst)
+{
+  return !tw_bitmap_equal(src, dst);
+}
+
+static uint64_t tw_bitmap_zero_chunk(const struct tw_bitmap *src,
+                                     struct tw_bitmap *dst)
+{
+  (void)src;
+  tw_bitmap_zero(dst);
+  return 0;
+}
+
+static uint64_t tw_bitmap_fill_chunk(const struct tw_bitmap *src,
+                                     struct tw_bitmap *dst)
+{
+  (void)src;
+  return tw_bitmap_fill(dst)->count;
+}
+
+/* as the serial operations, `dst` is grown to the size of `src` if `grow` */
+static struct tw_bitmap *tw_bitmap_binary_parallel(tw_bitmap_chunk_op op,
+                                                   const struct tw_bitmap *src,
+                                                   struct tw_bitmap *dst,
+                                                   struct tw_thread_pool *pool,
+                                                   bool grow)
+{
+  if (!src || !dst || !pool ||
+      (grow && src->size > dst->size && !tw_bitmap_resize(dst, src->size)) ||
+      !tw_bitmap_all_writable(dst)) {
+    return NULL;
+  }
+
+  dst->count = tw_bitmap_parallel_run(op, src, dst, pool, false);
+  dst->stale = false;
+  dst->generation++;
+
+  return dst;
+}
+
+struct tw_bitmap *tw_bitmap_union_parallel(const struct tw_bitmap *src,
+                                           struct tw_bitmap *dst,
+                                           struct tw_thread_pool *pool)
+{
+  return tw_bitmap_binary_parallel(tw_bitmap_union_chunk, src, dst, pool,
+                                   true);
+}
+
+struct tw_bitmap *tw_bitmap_intersection_parallel(const struct tw_bitmap *src,
+                                                  struct tw_bitmap *dst,
+                                                  struct tw_thread_pool *pool)
+{
+  return tw_bitmap_binary_parallel(tw_bitmap_intersection_chunk, src, dst,
+                                   pool, false);
+}
+
+struct tw_bitmap *tw_bitmap_xor_parallel(const struct tw_bitmap *src,
+                                         struct tw_bitmap *dst,
+                                         struct tw_thread_pool *pool)
+{
+  return tw_bitmap_binary_parallel(tw_bitmap_xor_chunk, src, dst, pool, true);
+}
+
+struct tw_bitmap *tw_bitmap_not_parallel(struct tw_bitmap *bitmap,
+                                         struct tw_thread_pool *pool)
+{
+  if (!bitmap || !pool || !tw_bitmap_all_writable(bitmap)) {
+    return NULL;
+  }
+
+  tw_bitmap_parallel_run(tw_bitmap_not_chunk, NULL, bitmap, pool, false);
+
+  /* as `tw_bitmap_not`, an outdated count stays outdated */
+  bitmap->count = bitmap->size - bitmap->count;
+  bitmap->generation++;
+
+  return bitmap;
+}
+
+bool tw_bitmap_equal_parallel(const struct tw_bitmap *fst,
+                              const struct tw_bitmap *snd,
+                              struct tw_thread_pool *pool)
+{
+  if (!fst || !snd || !pool) {
+    return false;
+  }
+
+  if (tw_bitmap_count(fst) != tw_bitmap_count(snd)) {
+    return false;
+  }
+
+  /**
+   * `snd` is only read by the comparison, with equal counts and prefixes the
+   * larger tail is cleared too
+   */
+  return tw_bitmap_parallel_run(tw_bitmap_differ_chunk, fst,
+                                (struct tw_bitmap *)snd, pool, true) == 0;
+}
+
+struct tw_bitmap *tw_bitmap_zero_parallel(struct tw_bitmap *bitmap,
+                                          struct tw_thread_pool *pool)
+{
+  if (!bitmap || !pool || !tw_bitmap_all_writable(bitmap)) {
+    return NULL;
+  }
+
+  tw_bitmap_parallel_run(tw_bitmap_zero_chunk, NULL, bitmap, pool, false);
+
+  bitmap->count = 0;
+  bitmap->stale = false;
+  bitmap->generation++;
+
+  return bitmap;
+}
+
+struct tw_bitmap *tw_bitmap_fill_parallel(struct tw_bitmap *bitmap,
+                                          struct tw_thread_pool *pool)
+{
+  if (!bitmap || !pool || !tw_bitmap_all_writable(bitmap)) {
+    return NULL;
+  }
+
+  bitmap->count =
+      tw_bitmap_parallel_run(tw_bitmap_fill_chunk, NULL, bitmap, pool, false);
+  bitmap->stale = false;
+  bitmap->generation++;
+
+  return bitmap;
+}
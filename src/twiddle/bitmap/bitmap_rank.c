@@ -0,0 +1,263 @@
+#include <stdlib.h>
+#include <x86intrin.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_rank.h>
+#include <twiddle/utils/simd.h>
+
+#include "../macrology.h"
+
+#define TW_BITS_PER_WORD 64
+#define TW_WORDS_PER_BLOCK 8
+#define TW_BITS_PER_BLOCK (TW_BITS_PER_WORD * TW_WORDS_PER_BLOCK)
+
+/* 9 bits cumulative count of the i-th word in a block, i in [0, 8) */
+#define tw_rank_relative(packed, i)                                            \
+  ((i) ? (((packed) >> (9 * ((i)-1))) & 0x1FF) : 0)
+
+/* position of the r-th active bit of a word, by clearing the lowest bits */
+#define BITMAP_SELECT_WORD_LOOP(name, target)                                  \
+  static inline target uint64_t name(uint64_t word, uint64_t r)                \
+  {                                                                            \
+    for (; r; --r) {                                                           \
+      word &= word - 1;                                                        \
+    }                                                                          \
+    return __builtin_ctzll(word);                                              \
+  }
+
+/**
+ * Kernels are instantiated per instruction set since building and ranking
+ * are dominated by popcount, and selecting in a word benefits from PDEP.
+ */
+#define BITMAP_RANK_KERNELS(isa, target, select_word)                          \
+  static target void tw_bitmap_rank_build_##isa(struct tw_bitmap_rank *rank)   \
+  {                                                                            \
+    const uint64_t *data = rank->bitmap->data;                                 \
+    uint64_t count = 0, sample = 0;                                            \
+    for (size_t b = 0; b < rank->n_blocks; ++b) {                              \
+      uint64_t packed = 0, in_block = 0;                                       \
+      for (size_t w = 0; w < TW_WORDS_PER_BLOCK; ++w) {                        \
+        if (w) {                                                               \
+          packed |= in_block << (9 * (w - 1));                                 \
+        }                                                                      \
+        in_block += __builtin_popcountll(data[b * TW_WORDS_PER_BLOCK + w]);    \
+      }                                                                        \
+      rank->blocks[2 * b] = count;                                             \
+      rank->blocks[2 * b + 1] = packed;                                        \
+      count += in_block;                                                       \
+      for (; sample * TW_BITMAP_RANK_SAMPLE < count; ++sample) {               \
+        rank->samples[sample] = b;                                             \
+      }                                                                        \
+    }                                                                          \
+    rank->n_samples = sample;                                                  \
+  }                                                                            \
+                                                                               \
+  static target uint64_t tw_bitmap_rank_count_##isa(                           \
+      const struct tw_bitmap_rank *rank, uint64_t pos)                         \
+  {                                                                            \
+    const uint64_t word = pos / TW_BITS_PER_WORD;                              \
+    const uint64_t *entry = rank->blocks + 2 * (pos / TW_BITS_PER_BLOCK);      \
+    const uint64_t mask = (1ULL << (pos % TW_BITS_PER_WORD)) - 1;              \
+    return entry[0] + tw_rank_relative(entry[1], word % TW_WORDS_PER_BLOCK) +  \
+           __builtin_popcountll(rank->bitmap->data[word] & mask);              \
+  }                                                                            \
+                                                                               \
+  static target uint64_t tw_bitmap_rank_select_##isa(                          \
+      const struct tw_bitmap_rank *rank, uint64_t k)                           \
+  {                                                                            \
+    const uint64_t *blocks = rank->blocks;                                     \
+    const uint64_t sample = k / TW_BITMAP_RANK_SAMPLE;                         \
+    uint64_t lo = rank->samples[sample];                                       \
+    uint64_t hi = (sample + 1 < rank->n_samples) ? rank->samples[sample + 1]   \
+                                                 : rank->n_blocks - 1;         \
+    /* last block with at most k preceding active bits */                      \
+    while (lo < hi) {                                                          \
+      const uint64_t mid = lo + (hi - lo + 1) / 2;                             \
+      if (blocks[2 * mid] <= k) {                                              \
+        lo = mid;                                                              \
+      } else {                                                                 \
+        hi = mid - 1;                                                          \
+      }                                                                        \
+    }                                                                          \
+    const uint64_t r = k - blocks[2 * lo], packed = blocks[2 * lo + 1];        \
+    uint64_t w = TW_WORDS_PER_BLOCK - 1;                                       \
+    while (tw_rank_relative(packed, w) > r) {                                  \
+      --w;                                                                     \
+    }                                                                          \
+    const uint64_t word = lo * TW_WORDS_PER_BLOCK + w;                         \
+    return word * TW_BITS_PER_WORD +                                           \
+           select_word(rank->bitmap->data[word],                               \
+                       r - tw_rank_relative(packed, w));                       \
+  }
+
+BITMAP_SELECT_WORD_LOOP(tw_select_word_port, )
+BITMAP_RANK_KERNELS(port, , tw_select_word_port)
+
+#ifdef USE_AVX
+BITMAP_SELECT_WORD_LOOP(tw_select_word_avx, TW_TARGET_AVX)
+BITMAP_RANK_KERNELS(avx, TW_TARGET_AVX, tw_select_word_avx)
+#endif
+
+#ifdef USE_AVX2
+/* deposit the r-th active bit of word at its position */
+static inline TW_TARGET_AVX2 uint64_t tw_select_word_avx2(uint64_t word,
+                                                          uint64_t r)
+{
+  return _tzcnt_u64(_pdep_u64(1ULL << r, word));
+}
+
+BITMAP_RANK_KERNELS(avx2, TW_TARGET_AVX2, tw_select_word_avx2)
+#endif
+
+struct tw_bitmap_rank_kernels {
+  void (*build)(struct tw_bitmap_rank *rank);
+  uint64_t (*count)(const struct tw_bitmap_rank *rank, uint64_t pos);
+  uint64_t (*select)(const struct tw_bitmap_rank *rank, uint64_t k);
+};
+
+#define TW_BITMAP_RANK_KERNELS(isa)                                            \
+  {                                                                            \
+    .build = tw_bitmap_rank_build_##isa, .count = tw_bitmap_rank_count_##isa,  \
+    .select = tw_bitmap_rank_select_##isa,                                     \
+  }
+
+/* scalar kernels, AVX512 levels have nothing more to offer */
+static const struct tw_bitmap_rank_kernels
+    tw_bitmap_rank_kernels[TW_SIMD_LEVELS] = {
+        [TW_SIMD_PORTABLE] = TW_BITMAP_RANK_KERNELS(port),
+#ifdef USE_AVX
+        [TW_SIMD_AVX] = TW_BITMAP_RANK_KERNELS(avx),
+#endif
+#ifdef USE_AVX2
+        [TW_SIMD_AVX2] = TW_BITMAP_RANK_KERNELS(avx2),
+#endif
+#ifdef USE_AVX512
+        [TW_SIMD_AVX512] = TW_BITMAP_RANK_KERNELS(avx2),
+#endif
+#ifdef USE_AVX512_ICL
+        [TW_SIMD_AVX512_ICL] = TW_BITMAP_RANK_KERNELS(avx2),
+#endif
+};
+
+static inline const struct tw_bitmap_rank_kernels *
+tw_bitmap_rank_kernels_(void)
+{
+  return &tw_bitmap_rank_kernels[tw_simd_level()];
+}
+
+/* (re)allocate arrays for the current size and count of the bitmap */
+static struct tw_bitmap_rank *tw_bitmap_rank_alloc(struct tw_bitmap_rank *rank)
+{
+  const struct tw_bitmap *bitmap = rank->bitmap;
+  const uint64_t n_blocks = TW_DIV_ROUND_UP(bitmap->size, TW_BITS_PER_BLOCK);
+  const uint64_t n_samples =
+      TW_DIV_ROUND_UP(tw_bitmap_count(bitmap), TW_BITMAP_RANK_SAMPLE);
+
+  if (n_blocks != rank->n_blocks || !rank->blocks) {
+    uint64_t *blocks = realloc(rank->blocks, 2 * n_blocks * sizeof(uint64_t));
+    if (!blocks) {
+      return NULL;
+    }
+    rank->blocks = blocks;
+    rank->n_blocks = n_blocks;
+  }
+
+  /* at least one sample, such that an empty bitmap is still indexed */
+  if (n_samples > rank->samples_size || !rank->samples) {
+    const uint64_t samples_size = tw_max(n_samples, 1);
+    uint64_t *samples = realloc(rank->samples, samples_size * sizeof(uint64_t));
+    if (!samples) {
+      return NULL;
+    }
+    rank->samples = samples;
+    rank->samples_size = samples_size;
+  }
+
+  return rank;
+}
+
+struct tw_bitmap_rank *tw_bitmap_rank_new(const struct tw_bitmap *bitmap)
+{
+  if (!bitmap) {
+    return NULL;
+  }
+
+  struct tw_bitmap_rank *rank = calloc(1, sizeof(struct tw_bitmap_rank));
+  if (!rank) {
+    return NULL;
+  }
+
+  rank->bitmap = bitmap;
+  /* forces the initial build */
+  rank->generation = bitmap->generation - 1;
+
+  if (!tw_bitmap_rank_update(rank)) {
+    tw_bitmap_rank_free(rank);
+    return NULL;
+  }
+
+  return rank;
+}
+
+void tw_bitmap_rank_free(struct tw_bitmap_rank *rank)
+{
+  free(rank->samples);
+  free(rank->blocks);
+  free(rank);
+}
+
+bool tw_bitmap_rank_stale(const struct tw_bitmap_rank *rank)
+{
+  if (!rank) {
+    return false;
+  }
+
+  return rank->bitmap->stale ||
+         rank->generation != rank->bitmap->generation;
+}
+
+struct tw_bitmap_rank *tw_bitmap_rank_update(struct tw_bitmap_rank *rank)
+{
+  if (!rank) {
+    return NULL;
+  }
+
+  if (!tw_bitmap_rank_stale(rank)) {
+    return rank;
+  }
+
+  if (!tw_bitmap_rank_alloc(rank)) {
+    return NULL;
+  }
+
+  tw_bitmap_rank_kernels_()->build(rank);
+  rank->generation = rank->bitmap->generation;
+
+  return rank;
+}
+
+int64_t tw_bitmap_rank_count(struct tw_bitmap_rank *rank, uint64_t pos)
+{
+  if (!tw_bitmap_rank_update(rank)) {
+    return -1;
+  }
+
+  if (pos >= rank->bitmap->size) {
+    return rank->bitmap->count;
+  }
+
+  return tw_bitmap_rank_kernels_()->count(rank, pos);
+}
+
+int64_t tw_bitmap_rank_select(struct tw_bitmap_rank *rank, uint64_t k)
+{
+  if (!tw_bitmap_rank_update(rank)) {
+    return -1;
+  }
+
+  if (k >= rank->bitmap->count) {
+    return -1;
+  }
+
+  return tw_bitmap_rank_kernels_()->select(rank, k);
+}
@@ -6,6 +6,8 @@
 
 #include "../macrology.h"
 
+#define TW_BITS_PER_BITMAP (sizeof(uint64_t) * TW_BITS_IN_WORD)
+
 #define TW_BITMAP_RLE_WORD_PER_CACHELINE                                       \
   (TW_CACHELINE / sizeof(struct tw_bitmap_rle_word))
 
@@ -505,3 +507,160 @@ struct tw_bitmap_rle *tw_bitmap_rle_intersection(const struct tw_bitmap_rle *a,
 
   return dst;
 }
+
+bool tw_bitmap_rle_intersects(const struct tw_bitmap_rle *a,
+                              const struct tw_bitmap_rle *b)
+{
+  if (!a || !b || a->size != b->size || tw_bitmap_rle_empty(a) ||
+      tw_bitmap_rle_empty(b)) {
+    return false;
+  }
+
+  const uint64_t a_last_idx = a->last_word_idx + 1,
+                 b_last_idx = b->last_word_idx + 1;
+  uint64_t a_idx = 0, b_idx = 0;
+
+  /* same walk as tw_bitmap_rle_intersection, stopping on the first overlap */
+  while (a_idx < a_last_idx && b_idx < b_last_idx) {
+    const struct tw_bitmap_rle_word a_word = a->data[a_idx],
+                                    b_word = b->data[b_idx];
+    const uint64_t a_end = tw_bitmap_rle_word_end(a_word),
+                   b_end = tw_bitmap_rle_word_end(b_word);
+
+    if (a_word.pos <= b_end && b_word.pos <= a_end) {
+      return true;
+    }
+
+    if (a_end <= b_end) {
+      ++a_idx;
+    } else {
+      ++b_idx;
+    }
+  }
+
+  return false;
+}
+
+bool tw_bitmap_rle_is_disjoint(const struct tw_bitmap_rle *a,
+                               const struct tw_bitmap_rle *b)
+{
+  return a && b && a->size == b->size && !tw_bitmap_rle_intersects(a, b);
+}
+
+bool tw_bitmap_rle_is_subset(const struct tw_bitmap_rle *a,
+                             const struct tw_bitmap_rle *b)
+{
+  if (!a || !b || a->size != b->size) {
+    return false;
+  }
+
+  if (tw_bitmap_rle_empty(a)) {
+    return true;
+  }
+
+  if (a->count > b->count || a->last_pos > b->last_pos) {
+    return false;
+  }
+
+  /**
+   * Words of `b` are maximal runs, see tw_bitmap_rle_equal, thus every word
+   * of `a` must be contained in a single word of `b`.
+   */
+  const uint64_t a_last_idx = a->last_word_idx + 1,
+                 b_last_idx = b->last_word_idx + 1;
+  uint64_t b_idx = 0;
+
+  for (uint64_t a_idx = 0; a_idx < a_last_idx; ++a_idx) {
+    const struct tw_bitmap_rle_word a_word = a->data[a_idx];
+
+    while (b_idx < b_last_idx &&
+           tw_bitmap_rle_word_end(b->data[b_idx]) < a_word.pos) {
+      ++b_idx;
+    }
+
+    if (b_idx == b_last_idx || b->data[b_idx].pos > a_word.pos ||
+        tw_bitmap_rle_word_end(b->data[b_idx]) <
+            tw_bitmap_rle_word_end(a_word)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+struct tw_bitmap_rle *tw_bitmap_to_rle(const struct tw_bitmap *src,
+                                       struct tw_bitmap_rle *dst)
+{
+  if (!src || !dst || dst->size > src->size) {
+    return NULL;
+  }
+
+  tw_bitmap_rle_zero(dst);
+
+  const uint64_t size = dst->size;
+  const uint64_t n_words = TW_DIV_ROUND_UP(size, TW_BITS_PER_BITMAP);
+
+  /* value of the last visited bit, and first position of its run */
+  bool in_run = false;
+  uint64_t start = 0;
+
+  uint64_t i = 0;
+  while (i < n_words) {
+    const uint64_t word = src->data[i];
+
+    if (word == (in_run ? ~0UL : 0UL)) {
+      /* no boundary, jump to the next one with the vectorized search */
+      const int64_t next =
+          in_run ? tw_bitmap_find_next_zero(src, i * TW_BITS_PER_BITMAP)
+                 : tw_bitmap_find_next_bit(src, i * TW_BITS_PER_BITMAP);
+      if (next < 0 || (uint64_t)next >= size) {
+        break;
+      }
+      i = next / TW_BITS_PER_BITMAP;
+      continue;
+    }
+
+    /* bits differing from their predecessor start or end a run */
+    uint64_t edges = word ^ ((word << 1) | in_run);
+    for (; edges; edges &= edges - 1) {
+      const uint64_t pos = i * TW_BITS_PER_BITMAP + __builtin_ctzll(edges);
+      if (pos >= size) {
+        break;
+      }
+
+      if (in_run) {
+        tw_bitmap_rle_set_range(dst, start, pos - 1);
+      } else {
+        start = pos;
+      }
+      in_run = !in_run;
+    }
+
+    ++i;
+  }
+
+  if (in_run) {
+    tw_bitmap_rle_set_range(dst, start, size - 1);
+  }
+
+  return dst;
+}
+
+struct tw_bitmap *tw_bitmap_rle_to_bitmap(const struct tw_bitmap_rle *src,
+                                          struct tw_bitmap *dst)
+{
+  if (!src || !dst || src->size > dst->size || !tw_bitmap_zero(dst)) {
+    return NULL;
+  }
+
+  if (tw_bitmap_rle_empty(src)) {
+    return dst;
+  }
+
+  for (uint64_t i = 0; i <= src->last_word_idx; ++i) {
+    const struct tw_bitmap_rle_word word = src->data[i];
+    tw_bitmap_set_range(dst, word.pos, tw_bitmap_rle_word_end(word));
+  }
+
+  return dst;
+}
@@ -0,0 +1,1013 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_rle.h>
+#include <twiddle/bitmap/bitmap_roaring.h>
+
+#include "../macrology.h"
+
+#define TW_ROARING_BITS TW_BITMAP_ROARING_CONTAINER_BITS
+#define TW_ROARING_ARRAY_MAX TW_BITMAP_ROARING_ARRAY_MAX
+#define TW_ROARING_WORD_BITS (sizeof(uint64_t) * TW_BITS_IN_WORD)
+#define TW_ROARING_WORDS (TW_ROARING_BITS / TW_ROARING_WORD_BITS)
+
+#define tw_roaring_key(pos) ((pos) / TW_ROARING_BITS)
+#define tw_roaring_low(pos) ((uint16_t)((pos) % TW_ROARING_BITS))
+
+enum tw_roaring_type {
+  TW_ROARING_ARRAY,
+  TW_ROARING_BITSET,
+  TW_ROARING_RUN,
+};
+
+struct tw_bitmap_roaring_container {
+  /** upper bits shared by the positions of the container */
+  uint64_t key;
+  /** number of active bits */
+  uint32_t count;
+  /** number of allocated offsets in @array */
+  uint32_t capacity;
+  enum tw_roaring_type type;
+  union {
+    uint16_t *array;
+    struct tw_bitmap *bitset;
+    struct tw_bitmap_rle *run;
+  };
+};
+
+enum tw_roaring_op {
+  TW_ROARING_OR,
+  TW_ROARING_AND,
+  TW_ROARING_XOR,
+  TW_ROARING_ANDNOT,
+};
+
+/**
+ * Containers
+ */
+
+static void tw_roaring_container_free(struct tw_bitmap_roaring_container *c)
+{
+  switch (c->type) {
+  case TW_ROARING_ARRAY:
+    free(c->array);
+    break;
+  case TW_ROARING_BITSET:
+    tw_bitmap_free(c->bitset);
+    break;
+  case TW_ROARING_RUN:
+    tw_bitmap_rle_free(c->run);
+    break;
+  }
+}
+
+static bool
+tw_roaring_container_clone(const struct tw_bitmap_roaring_container *c,
+                           struct tw_bitmap_roaring_container *dst)
+{
+  *dst = *c;
+
+  switch (c->type) {
+  case TW_ROARING_ARRAY:
+    dst->capacity = c->count;
+    dst->array = malloc(tw_max(c->count, 1) * sizeof(uint16_t));
+    if (!dst->array) {
+      return false;
+    }
+    memcpy(dst->array, c->array, c->count * sizeof(uint16_t));
+    return true;
+  case TW_ROARING_BITSET:
+    dst->bitset = tw_bitmap_clone(c->bitset);
+    return dst->bitset != NULL;
+  case TW_ROARING_RUN:
+    dst->run = tw_bitmap_rle_clone(c->run);
+    return dst->run != NULL;
+  }
+
+  return false;
+}
+
+/* index of the first offset greater or equal than `low` */
+static uint32_t tw_roaring_array_lower_bound(const uint16_t *array,
+                                             uint32_t n, uint16_t low)
+{
+  uint32_t lo = 0, hi = n;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    if (array[mid] < low) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+static bool tw_roaring_array_reserve(struct tw_bitmap_roaring_container *c,
+                                     uint32_t capacity)
+{
+  if (capacity <= c->capacity) {
+    return true;
+  }
+
+  capacity = tw_max(capacity, 2 * c->capacity);
+  uint16_t *array = realloc(c->array, capacity * sizeof(uint16_t));
+  if (!array) {
+    return false;
+  }
+
+  c->array = array;
+  c->capacity = capacity;
+
+  return true;
+}
+
+/* runs are sorted, non-adjacent, thus searched by dichotomy */
+static bool tw_roaring_run_test(const struct tw_bitmap_rle *run, uint16_t low)
+{
+  if (!run->count) {
+    return false;
+  }
+
+  uint64_t lo = 0, hi = run->last_word_idx + 1;
+  while (lo < hi) {
+    const uint64_t mid = lo + (hi - lo) / 2;
+    const struct tw_bitmap_rle_word word = run->data[mid];
+    if (low < word.pos) {
+      hi = mid;
+    } else if (low >= word.pos + word.count) {
+      lo = mid + 1;
+    } else {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static bool
+tw_roaring_container_test(const struct tw_bitmap_roaring_container *c,
+                          uint16_t low)
+{
+  switch (c->type) {
+  case TW_ROARING_ARRAY: {
+    const uint32_t i = tw_roaring_array_lower_bound(c->array, c->count, low);
+    return i < c->count && c->array[i] == low;
+  }
+  case TW_ROARING_BITSET:
+    return tw_bitmap_test(c->bitset, low);
+  case TW_ROARING_RUN:
+    return tw_roaring_run_test(c->run, low);
+  }
+
+  return false;
+}
+
+/* set the active bits of a non-bitset container in a zeroed `bitset` */
+static void
+tw_roaring_container_to_bits(const struct tw_bitmap_roaring_container *c,
+                             struct tw_bitmap *bitset)
+{
+  if (c->type == TW_ROARING_ARRAY) {
+    for (uint32_t i = 0; i < c->count; ++i) {
+      tw_bitmap_set(bitset, c->array[i]);
+    }
+  } else if (c->type == TW_ROARING_RUN) {
+    tw_bitmap_rle_to_bitmap(c->run, bitset);
+  }
+}
+
+static bool tw_roaring_to_bitset(struct tw_bitmap_roaring_container *c)
+{
+  if (c->type == TW_ROARING_BITSET) {
+    return true;
+  }
+
+  struct tw_bitmap *bitset = tw_bitmap_new(TW_ROARING_BITS);
+  if (!bitset) {
+    return false;
+  }
+
+  tw_roaring_container_to_bits(c, bitset);
+  tw_roaring_container_free(c);
+  c->type = TW_ROARING_BITSET;
+  c->capacity = 0;
+  c->bitset = bitset;
+
+  return true;
+}
+
+static bool tw_roaring_to_array(struct tw_bitmap_roaring_container *c)
+{
+  if (c->type == TW_ROARING_ARRAY) {
+    return true;
+  }
+
+  uint16_t *array = malloc(tw_max(c->count, 1) * sizeof(uint16_t));
+  if (!array) {
+    return false;
+  }
+
+  uint32_t n = 0;
+  if (c->type == TW_ROARING_BITSET) {
+    const uint64_t *data = c->bitset->data;
+    for (uint32_t i = 0; i < TW_ROARING_WORDS; ++i) {
+      const uint32_t base = i * TW_ROARING_WORD_BITS;
+      for (uint64_t word = data[i]; word; word &= word - 1) {
+        array[n++] = (uint16_t)(base + __builtin_ctzll(word));
+      }
+    }
+  } else if (c->run->count) {
+    for (uint64_t i = 0; i <= c->run->last_word_idx; ++i) {
+      const struct tw_bitmap_rle_word word = c->run->data[i];
+      for (uint64_t j = 0; j < word.count; ++j) {
+        array[n++] = (uint16_t)(word.pos + j);
+      }
+    }
+  }
+
+  tw_roaring_container_free(c);
+  c->type = TW_ROARING_ARRAY;
+  c->capacity = tw_max(c->count, 1);
+  c->array = array;
+
+  return true;
+}
+
+static bool tw_roaring_to_run(struct tw_bitmap_roaring_container *c)
+{
+  if (c->type == TW_ROARING_RUN) {
+    return true;
+  }
+
+  struct tw_bitmap_rle *run = tw_bitmap_rle_new(TW_ROARING_BITS);
+  if (!run) {
+    return false;
+  }
+
+  if (c->type == TW_ROARING_ARRAY) {
+    uint32_t start = 0;
+    for (uint32_t i = 1; i <= c->count; ++i) {
+      if (i == c->count || c->array[i] != c->array[i - 1] + 1) {
+        tw_bitmap_rle_set_range(run, c->array[start], c->array[i - 1]);
+        start = i;
+      }
+    }
+  } else {
+    tw_bitmap_to_rle(c->bitset, run);
+  }
+
+  tw_roaring_container_free(c);
+  c->type = TW_ROARING_RUN;
+  c->capacity = 0;
+  c->run = run;
+
+  return true;
+}
+
+/* number of runs of consecutive active bits */
+static uint64_t
+tw_roaring_container_runs(const struct tw_bitmap_roaring_container *c)
+{
+  uint64_t runs = 0;
+
+  switch (c->type) {
+  case TW_ROARING_ARRAY:
+    for (uint32_t i = 0; i < c->count; ++i) {
+      runs += (i == 0 || c->array[i] != c->array[i - 1] + 1);
+    }
+    break;
+  case TW_ROARING_BITSET: {
+    /* a run starts on an active bit preceded by an inactive one */
+    uint64_t carry = 0;
+    for (uint32_t i = 0; i < TW_ROARING_WORDS; ++i) {
+      const uint64_t word = c->bitset->data[i];
+      runs += __builtin_popcountll(word & ~((word << 1) | carry));
+      carry = word >> (TW_ROARING_WORD_BITS - 1);
+    }
+    break;
+  }
+  case TW_ROARING_RUN:
+    runs = c->run->count ? c->run->last_word_idx + 1 : 0;
+    break;
+  }
+
+  return runs;
+}
+
+/**
+ * Pick the kind of a container from its number of active bits, a failed
+ * conversion keeps the current kind since all kinds hold any content.
+ */
+static void tw_roaring_container_fit(struct tw_bitmap_roaring_container *c)
+{
+  if (c->type == TW_ROARING_ARRAY && c->count > TW_ROARING_ARRAY_MAX) {
+    tw_roaring_to_bitset(c);
+  } else if (c->type == TW_ROARING_BITSET &&
+             c->count <= TW_ROARING_ARRAY_MAX) {
+    tw_roaring_to_array(c);
+  }
+}
+
+/* runs are not updated in place, returns `true` if `low` was inactive */
+static bool tw_roaring_container_set(struct tw_bitmap_roaring_container *c,
+                                     uint16_t low)
+{
+  if (c->type == TW_ROARING_RUN) {
+    if (tw_roaring_run_test(c->run, low)) {
+      return false;
+    }
+
+    if (c->count >= TW_ROARING_ARRAY_MAX ? !tw_roaring_to_bitset(c)
+                                         : !tw_roaring_to_array(c)) {
+      return false;
+    }
+  }
+
+  if (c->type == TW_ROARING_ARRAY) {
+    const uint32_t i = tw_roaring_array_lower_bound(c->array, c->count, low);
+    if (i < c->count && c->array[i] == low) {
+      return false;
+    }
+
+    if (c->count < TW_ROARING_ARRAY_MAX || !tw_roaring_to_bitset(c)) {
+      if (!tw_roaring_array_reserve(c, c->count + 1)) {
+        return false;
+      }
+
+      memmove(&c->array[i + 1], &c->array[i],
+              (c->count - i) * sizeof(uint16_t));
+      c->array[i] = low;
+      c->count++;
+
+      return true;
+    }
+  }
+
+  if (tw_bitmap_test_and_set(c->bitset, low)) {
+    return false;
+  }
+  c->count++;
+
+  return true;
+}
+
+/* returns `true` if `low` was active */
+static bool tw_roaring_container_clear(struct tw_bitmap_roaring_container *c,
+                                       uint16_t low)
+{
+  if (c->type == TW_ROARING_RUN) {
+    if (!tw_roaring_run_test(c->run, low)) {
+      return false;
+    }
+
+    if (c->count > TW_ROARING_ARRAY_MAX ? !tw_roaring_to_bitset(c)
+                                        : !tw_roaring_to_array(c)) {
+      return false;
+    }
+  }
+
+  if (c->type == TW_ROARING_ARRAY) {
+    const uint32_t i = tw_roaring_array_lower_bound(c->array, c->count, low);
+    if (i == c->count || c->array[i] != low) {
+      return false;
+    }
+
+    memmove(&c->array[i], &c->array[i + 1],
+            (c->count - i - 1) * sizeof(uint16_t));
+    c->count--;
+
+    return true;
+  }
+
+  if (!tw_bitmap_test_and_clear(c->bitset, low)) {
+    return false;
+  }
+  c->count--;
+
+  /* half the threshold, alternating set and clear do not convert back */
+  if (c->count <= TW_ROARING_ARRAY_MAX / 2) {
+    tw_roaring_to_array(c);
+  }
+
+  return true;
+}
+
+/* merge sorted arrays of offsets, `d = d op s` */
+static bool tw_roaring_array_op(enum tw_roaring_op op,
+                                const struct tw_bitmap_roaring_container *s,
+                                struct tw_bitmap_roaring_container *d)
+{
+  const bool keep_d = (op != TW_ROARING_AND);
+  const bool keep_s = (op == TW_ROARING_OR || op == TW_ROARING_XOR);
+  const bool keep_both = (op == TW_ROARING_OR || op == TW_ROARING_AND);
+
+  const uint32_t capacity = tw_max(d->count + (keep_s ? s->count : 0), 1);
+  uint16_t *out = malloc(capacity * sizeof(uint16_t));
+  if (!out) {
+    return false;
+  }
+
+  uint32_t i = 0, j = 0, n = 0;
+  while (i < d->count && j < s->count) {
+    const uint16_t a = d->array[i], b = s->array[j];
+    if (a < b) {
+      if (keep_d) {
+        out[n++] = a;
+      }
+      ++i;
+    } else if (b < a) {
+      if (keep_s) {
+        out[n++] = b;
+      }
+      ++j;
+    } else {
+      if (keep_both) {
+        out[n++] = a;
+      }
+      ++i;
+      ++j;
+    }
+  }
+
+  for (; keep_d && i < d->count; ++i) {
+    out[n++] = d->array[i];
+  }
+  for (; keep_s && j < s->count; ++j) {
+    out[n++] = s->array[j];
+  }
+
+  free(d->array);
+  d->array = out;
+  d->capacity = capacity;
+  d->count = n;
+
+  return true;
+}
+
+/* `d = d op s` for `op` preserving runs, i.e. union and intersection */
+static bool tw_roaring_run_op(enum tw_roaring_op op,
+                              const struct tw_bitmap_roaring_container *s,
+                              struct tw_bitmap_roaring_container *d)
+{
+  struct tw_bitmap_rle *run = tw_bitmap_rle_new(TW_ROARING_BITS);
+  if (!run) {
+    return false;
+  }
+
+  if (op == TW_ROARING_OR) {
+    tw_bitmap_rle_union(d->run, s->run, run);
+  } else {
+    tw_bitmap_rle_intersection(d->run, s->run, run);
+  }
+
+  tw_bitmap_rle_free(d->run);
+  d->run = run;
+  d->count = run->count;
+
+  return true;
+}
+
+/* `d = d op s` for an array `d`, keeping the offsets found, or not, in `s` */
+static void tw_roaring_array_filter(enum tw_roaring_op op,
+                                    const struct tw_bitmap_roaring_container *s,
+                                    struct tw_bitmap_roaring_container *d)
+{
+  const bool keep = (op == TW_ROARING_AND);
+
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < d->count; ++i) {
+    const uint16_t low = d->array[i];
+    if (tw_roaring_container_test(s, low) == keep) {
+      d->array[n++] = low;
+    }
+  }
+
+  d->count = n;
+}
+
+/* `d = d op s` with `d` converted to a bitset, using the dense kernels */
+static bool tw_roaring_bitset_op(enum tw_roaring_op op,
+                                 const struct tw_bitmap_roaring_container *s,
+                                 struct tw_bitmap_roaring_container *d)
+{
+  if (!tw_roaring_to_bitset(d)) {
+    return false;
+  }
+
+  struct tw_bitmap *tmp = NULL;
+  const struct tw_bitmap *bits = s->bitset;
+  if (s->type != TW_ROARING_BITSET) {
+    if (!(tmp = tw_bitmap_new(TW_ROARING_BITS))) {
+      return false;
+    }
+    tw_roaring_container_to_bits(s, tmp);
+    bits = tmp;
+  }
+
+  switch (op) {
+  case TW_ROARING_OR:
+    tw_bitmap_union(bits, d->bitset);
+    break;
+  case TW_ROARING_AND:
+    tw_bitmap_intersection(bits, d->bitset);
+    break;
+  case TW_ROARING_XOR:
+    tw_bitmap_xor(bits, d->bitset);
+    break;
+  case TW_ROARING_ANDNOT:
+    tw_bitmap_andnot(bits, d->bitset);
+    break;
+  }
+  d->count = tw_bitmap_count(d->bitset);
+
+  if (tmp) {
+    tw_bitmap_free(tmp);
+  }
+
+  return true;
+}
+
+static bool tw_roaring_container_op(enum tw_roaring_op op,
+                                    const struct tw_bitmap_roaring_container *s,
+                                    struct tw_bitmap_roaring_container *d)
+{
+  bool ok = true;
+
+  if (s->type == TW_ROARING_ARRAY && d->type == TW_ROARING_ARRAY) {
+    ok = tw_roaring_array_op(op, s, d);
+  } else if (s->type == TW_ROARING_RUN && d->type == TW_ROARING_RUN &&
+             (op == TW_ROARING_OR || op == TW_ROARING_AND)) {
+    ok = tw_roaring_run_op(op, s, d);
+  } else if (d->type == TW_ROARING_ARRAY &&
+             (op == TW_ROARING_AND || op == TW_ROARING_ANDNOT)) {
+    tw_roaring_array_filter(op, s, d);
+  } else if (s->type == TW_ROARING_ARRAY && op == TW_ROARING_AND) {
+    /* the intersection is a subset of the array, filter it instead */
+    struct tw_bitmap_roaring_container tmp;
+    if (!(ok = tw_roaring_container_clone(s, &tmp))) {
+      return false;
+    }
+    tw_roaring_array_filter(op, d, &tmp);
+    tw_roaring_container_free(d);
+    *d = tmp;
+  } else {
+    ok = tw_roaring_bitset_op(op, s, d);
+  }
+
+  tw_roaring_container_fit(d);
+
+  return ok;
+}
+
+/**
+ * Containers of a bitmap
+ */
+
+/* index of the first container with a key greater or equal than `key` */
+static uint64_t tw_roaring_lower_bound(const struct tw_bitmap_roaring *bitmap,
+                                       uint64_t key)
+{
+  uint64_t lo = 0, hi = bitmap->n_containers;
+  while (lo < hi) {
+    const uint64_t mid = lo + (hi - lo) / 2;
+    if (bitmap->containers[mid].key < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+static const struct tw_bitmap_roaring_container *
+tw_roaring_find(const struct tw_bitmap_roaring *bitmap, uint64_t key)
+{
+  const uint64_t i = tw_roaring_lower_bound(bitmap, key);
+  if (i == bitmap->n_containers || bitmap->containers[i].key != key) {
+    return NULL;
+  }
+
+  return &bitmap->containers[i];
+}
+
+/* insert an empty array container at index `i` */
+static struct tw_bitmap_roaring_container *
+tw_roaring_insert(struct tw_bitmap_roaring *bitmap, uint64_t i, uint64_t key)
+{
+  if (bitmap->n_containers == bitmap->alloc_containers) {
+    const uint64_t alloc = tw_max(2 * bitmap->alloc_containers, 4);
+    struct tw_bitmap_roaring_container *containers = realloc(
+        bitmap->containers, alloc * sizeof(struct tw_bitmap_roaring_container));
+    if (!containers) {
+      return NULL;
+    }
+
+    bitmap->containers = containers;
+    bitmap->alloc_containers = alloc;
+  }
+
+  struct tw_bitmap_roaring_container *c = &bitmap->containers[i];
+  memmove(c + 1, c,
+          (bitmap->n_containers - i) *
+              sizeof(struct tw_bitmap_roaring_container));
+  bitmap->n_containers++;
+
+  *c = (struct tw_bitmap_roaring_container){
+      .key = key, .type = TW_ROARING_ARRAY,
+  };
+
+  return c;
+}
+
+static void tw_roaring_remove(struct tw_bitmap_roaring *bitmap, uint64_t i)
+{
+  struct tw_bitmap_roaring_container *c = &bitmap->containers[i];
+  tw_roaring_container_free(c);
+  memmove(c, c + 1,
+          (bitmap->n_containers - i - 1) *
+              sizeof(struct tw_bitmap_roaring_container));
+  bitmap->n_containers--;
+}
+
+static void tw_roaring_free_containers(struct tw_bitmap_roaring_container *c,
+                                       uint64_t n)
+{
+  for (uint64_t i = 0; i < n; ++i) {
+    tw_roaring_container_free(&c[i]);
+  }
+  free(c);
+}
+
+/**
+ * Public API
+ */
+
+struct tw_bitmap_roaring *tw_bitmap_roaring_new(uint64_t size)
+{
+  if (!size || size > TW_BITMAP_MAX_BITS) {
+    return NULL;
+  }
+
+  struct tw_bitmap_roaring *bitmap =
+      calloc(1, sizeof(struct tw_bitmap_roaring));
+  if (!bitmap) {
+    return NULL;
+  }
+
+  bitmap->size = size;
+
+  return bitmap;
+}
+
+void tw_bitmap_roaring_free(struct tw_bitmap_roaring *bitmap)
+{
+  if (!bitmap) {
+    return;
+  }
+
+  tw_roaring_free_containers(bitmap->containers, bitmap->n_containers);
+  free(bitmap);
+}
+
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_copy(const struct tw_bitmap_roaring *src,
+                       struct tw_bitmap_roaring *dst)
+{
+  if (!src || !dst || src->size != dst->size) {
+    return NULL;
+  }
+
+  if (src == dst) {
+    return dst;
+  }
+
+  const uint64_t n = src->n_containers;
+  struct tw_bitmap_roaring_container *containers =
+      malloc(tw_max(n, 1) * sizeof(struct tw_bitmap_roaring_container));
+  if (!containers) {
+    return NULL;
+  }
+
+  for (uint64_t i = 0; i < n; ++i) {
+    if (!tw_roaring_container_clone(&src->containers[i], &containers[i])) {
+      tw_roaring_free_containers(containers, i);
+      return NULL;
+    }
+  }
+
+  tw_roaring_free_containers(dst->containers, dst->n_containers);
+  dst->containers = containers;
+  dst->n_containers = n;
+  dst->alloc_containers = tw_max(n, 1);
+  dst->count = src->count;
+
+  return dst;
+}
+
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_clone(const struct tw_bitmap_roaring *bitmap)
+{
+  if (!bitmap) {
+    return NULL;
+  }
+
+  struct tw_bitmap_roaring *dst = tw_bitmap_roaring_new(bitmap->size);
+  if (!dst) {
+    return NULL;
+  }
+
+  if (!tw_bitmap_roaring_copy(bitmap, dst)) {
+    tw_bitmap_roaring_free(dst);
+    return NULL;
+  }
+
+  return dst;
+}
+
+void tw_bitmap_roaring_set(struct tw_bitmap_roaring *bitmap, uint64_t pos)
+{
+  if (!bitmap || pos >= bitmap->size) {
+    return;
+  }
+
+  const uint64_t key = tw_roaring_key(pos);
+  const uint64_t i = tw_roaring_lower_bound(bitmap, key);
+
+  struct tw_bitmap_roaring_container *c = &bitmap->containers[i];
+  if (i == bitmap->n_containers || c->key != key) {
+    if (!(c = tw_roaring_insert(bitmap, i, key))) {
+      return;
+    }
+  }
+
+  if (tw_roaring_container_set(c, tw_roaring_low(pos))) {
+    bitmap->count++;
+  } else if (!c->count) {
+    /* freshly inserted but allocation failed */
+    tw_roaring_remove(bitmap, i);
+  }
+}
+
+void tw_bitmap_roaring_clear(struct tw_bitmap_roaring *bitmap, uint64_t pos)
+{
+  if (!bitmap || pos >= bitmap->size) {
+    return;
+  }
+
+  const uint64_t key = tw_roaring_key(pos);
+  const uint64_t i = tw_roaring_lower_bound(bitmap, key);
+  if (i == bitmap->n_containers || bitmap->containers[i].key != key) {
+    return;
+  }
+
+  struct tw_bitmap_roaring_container *c = &bitmap->containers[i];
+  if (tw_roaring_container_clear(c, tw_roaring_low(pos))) {
+    bitmap->count--;
+    if (!c->count) {
+      tw_roaring_remove(bitmap, i);
+    }
+  }
+}
+
+bool tw_bitmap_roaring_test(const struct tw_bitmap_roaring *bitmap,
+                            uint64_t pos)
+{
+  if (!bitmap || pos >= bitmap->size) {
+    return false;
+  }
+
+  const struct tw_bitmap_roaring_container *c =
+      tw_roaring_find(bitmap, tw_roaring_key(pos));
+
+  return c && tw_roaring_container_test(c, tw_roaring_low(pos));
+}
+
+bool tw_bitmap_roaring_empty(const struct tw_bitmap_roaring *bitmap)
+{
+  if (!bitmap) {
+    return false;
+  }
+
+  return bitmap->count == 0;
+}
+
+uint64_t tw_bitmap_roaring_count(const struct tw_bitmap_roaring *bitmap)
+{
+  if (!bitmap) {
+    return 0;
+  }
+
+  return bitmap->count;
+}
+
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_zero(struct tw_bitmap_roaring *bitmap)
+{
+  if (!bitmap) {
+    return NULL;
+  }
+
+  tw_roaring_free_containers(bitmap->containers, bitmap->n_containers);
+  bitmap->containers = NULL;
+  bitmap->n_containers = 0;
+  bitmap->alloc_containers = 0;
+  bitmap->count = 0;
+
+  return bitmap;
+}
+
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_optimize(struct tw_bitmap_roaring *bitmap)
+{
+  if (!bitmap) {
+    return NULL;
+  }
+
+  for (uint64_t i = 0; i < bitmap->n_containers; ++i) {
+    struct tw_bitmap_roaring_container *c = &bitmap->containers[i];
+
+    const uint64_t run_bytes =
+        tw_roaring_container_runs(c) * sizeof(struct tw_bitmap_rle_word);
+    const uint64_t bytes = (c->count <= TW_ROARING_ARRAY_MAX)
+                               ? c->count * sizeof(uint16_t)
+                               : TW_ROARING_BITS / 8;
+
+    if (run_bytes < bytes) {
+      tw_roaring_to_run(c);
+    } else if (c->type == TW_ROARING_RUN) {
+      if (c->count <= TW_ROARING_ARRAY_MAX) {
+        tw_roaring_to_array(c);
+      } else {
+        tw_roaring_to_bitset(c);
+      }
+    }
+  }
+
+  return bitmap;
+}
+
+static bool
+tw_roaring_container_equal(const struct tw_bitmap_roaring_container *a,
+                           const struct tw_bitmap_roaring_container *b)
+{
+  if (a->key != b->key || a->count != b->count) {
+    return false;
+  }
+
+  if (a->type == b->type) {
+    switch (a->type) {
+    case TW_ROARING_ARRAY:
+      return memcmp(a->array, b->array, a->count * sizeof(uint16_t)) == 0;
+    case TW_ROARING_BITSET:
+      return tw_bitmap_equal(a->bitset, b->bitset);
+    case TW_ROARING_RUN:
+      return tw_bitmap_rle_equal(a->run, b->run);
+    }
+  }
+
+  /* a container differs from `b` iff their xor is non-empty */
+  struct tw_bitmap_roaring_container tmp;
+  if (!tw_roaring_container_clone(a, &tmp)) {
+    return false;
+  }
+
+  const bool equal =
+      tw_roaring_container_op(TW_ROARING_XOR, b, &tmp) && tmp.count == 0;
+  tw_roaring_container_free(&tmp);
+
+  return equal;
+}
+
+bool tw_bitmap_roaring_equal(const struct tw_bitmap_roaring *fst,
+                             const struct tw_bitmap_roaring *snd)
+{
+  if (!fst || !snd) {
+    return false;
+  }
+
+  if (fst->size != snd->size || fst->count != snd->count ||
+      fst->n_containers != snd->n_containers) {
+    return false;
+  }
+
+  for (uint64_t i = 0; i < fst->n_containers; ++i) {
+    if (!tw_roaring_container_equal(&fst->containers[i],
+                                    &snd->containers[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Merge the containers of `src` and `dst` by key. Containers of `dst` are
+ * moved or released, containers only found in `src` are cloned when the
+ * operation keeps them, and empty results are dropped.
+ */
+static struct tw_bitmap_roaring *
+tw_roaring_binary(enum tw_roaring_op op, const struct tw_bitmap_roaring *src,
+                  struct tw_bitmap_roaring *dst)
+{
+  if (!src || !dst || src->size != dst->size) {
+    return NULL;
+  }
+
+  if (src == dst) {
+    return (op == TW_ROARING_OR || op == TW_ROARING_AND)
+               ? dst
+               : tw_bitmap_roaring_zero(dst);
+  }
+
+  const bool keep_d = (op != TW_ROARING_AND);
+  const bool keep_s = (op == TW_ROARING_OR || op == TW_ROARING_XOR);
+
+  const uint64_t n_src = src->n_containers, n_dst = dst->n_containers;
+  const uint64_t alloc = tw_max(n_dst + (keep_s ? n_src : 0), 1);
+  struct tw_bitmap_roaring_container *out =
+      malloc(alloc * sizeof(struct tw_bitmap_roaring_container));
+  if (!out) {
+    return NULL;
+  }
+
+  bool ok = true;
+  uint64_t i = 0, j = 0, n = 0, count = 0;
+  while (i < n_dst || j < n_src) {
+    struct tw_bitmap_roaring_container *d =
+        (i < n_dst) ? &dst->containers[i] : NULL;
+    const struct tw_bitmap_roaring_container *s =
+        (j < n_src) ? &src->containers[j] : NULL;
+
+    struct tw_bitmap_roaring_container c;
+    if (d && (!s || d->key < s->key)) {
+      ++i;
+      if (!keep_d) {
+        tw_roaring_container_free(d);
+        continue;
+      }
+      c = *d;
+    } else if (s && (!d || s->key < d->key)) {
+      ++j;
+      if (!keep_s) {
+        continue;
+      }
+      if (!tw_roaring_container_clone(s, &c)) {
+        ok = false;
+        continue;
+      }
+    } else {
+      ++i;
+      ++j;
+      c = *d;
+      ok &= tw_roaring_container_op(op, s, &c);
+    }
+
+    if (!c.count) {
+      tw_roaring_container_free(&c);
+      continue;
+    }
+
+    count += c.count;
+    out[n++] = c;
+  }
+
+  free(dst->containers);
+  dst->containers = out;
+  dst->n_containers = n;
+  dst->alloc_containers = alloc;
+  dst->count = count;
+
+  return ok ? dst : NULL;
+}
+
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_union(const struct tw_bitmap_roaring *src,
+                        struct tw_bitmap_roaring *dst)
+{
+  return tw_roaring_binary(TW_ROARING_OR, src, dst);
+}
+
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_intersection(const struct tw_bitmap_roaring *src,
+                               struct tw_bitmap_roaring *dst)
+{
+  return tw_roaring_binary(TW_ROARING_AND, src, dst);
+}
+
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_xor(const struct tw_bitmap_roaring *src,
+                      struct tw_bitmap_roaring *dst)
+{
+  return tw_roaring_binary(TW_ROARING_XOR, src, dst);
+}
+
+struct tw_bitmap_roaring *
+tw_bitmap_roaring_andnot(const struct tw_bitmap_roaring *src,
+                         struct tw_bitmap_roaring *dst)
+{
+  return tw_roaring_binary(TW_ROARING_ANDNOT, src, dst);
+}
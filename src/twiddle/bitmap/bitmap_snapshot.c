@@ -0,0 +1,526 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_snapshot.h>
+
+#include "../macrology.h"
+#include "bitmap_internal.h"
+
+#define tw_chunk_mask(c) (1ULL << ((c) % TW_BITS_PER_BITMAP))
+
+static_assert(TW_BITMAP_SNAPSHOT_CHUNK % (1UL << 12) == 0,
+              "chunks must be a multiple of pages");
+
+/**
+ * memory file holding the chunks of a bitmap and its snapshots
+ *
+ * The mutex guards the reference counts and the allocation of chunks, the
+ * chunks themselves are written by the bitmaps owning them.
+ */
+struct tw_bitmap_store {
+  pthread_mutex_t lock;
+  int fd;
+  /** size in bytes of a chunk */
+  uint64_t chunk_size;
+  /** chunks in the file */
+  uint64_t n_chunks;
+  /** allocated entries of `refs` and `free_chunks` */
+  uint64_t capacity;
+  /** number of bitmaps mapping each chunk, zero if free */
+  uint64_t *refs;
+  /** stack of free chunks, reused before growing the file */
+  uint64_t *free_chunks;
+  uint64_t n_free;
+  /** number of bitmaps mapping chunks of the file */
+  uint64_t users;
+};
+
+struct tw_bitmap_cow {
+  struct tw_bitmap_store *store;
+  /** chunks of the bitmap */
+  uint64_t n_chunks;
+  /** chunk of the file mapped by each chunk of the bitmap */
+  uint64_t *chunks;
+  /** bit per chunk of the bitmap, set if known not to be shared */
+  uint64_t *owned;
+};
+
+/* chunks are a multiple of pages, smaller for bitmaps of a single chunk */
+static uint64_t tw_bitmap_chunk_size(uint64_t data_size)
+{
+  const uint64_t page_size = sysconf(_SC_PAGESIZE);
+  const uint64_t pages = TW_DIV_ROUND_UP(data_size, page_size) * page_size;
+  return tw_min(pages, (uint64_t)TW_BITMAP_SNAPSHOT_CHUNK);
+}
+
+static void tw_bitmap_store_delete(struct tw_bitmap_store *store)
+{
+  close(store->fd);
+  pthread_mutex_destroy(&store->lock);
+  free(store->refs);
+  free(store->free_chunks);
+  free(store);
+}
+
+/* free the storage of `n_chunks` chunks, read as zeroes afterward */
+static bool tw_bitmap_store_punch(const struct tw_bitmap_store *store,
+                                  uint64_t chunk, uint64_t n_chunks)
+{
+  int ret;
+  do {
+    ret = fallocate(store->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                    chunk * store->chunk_size, n_chunks * store->chunk_size);
+  } while (ret != 0 && errno == EINTR);
+
+  return ret == 0;
+}
+
+/* create a file of `n_chunks` zeroed chunks, referenced once */
+static struct tw_bitmap_store *tw_bitmap_store_new(uint64_t n_chunks,
+                                                   uint64_t chunk_size)
+{
+  struct tw_bitmap_store *store = calloc(1, sizeof(struct tw_bitmap_store));
+  if (!store) {
+    return NULL;
+  }
+
+  store->fd = memfd_create("tw_bitmap", MFD_CLOEXEC);
+  if (store->fd < 0) {
+    free(store);
+    return NULL;
+  }
+  pthread_mutex_init(&store->lock, NULL);
+
+  store->chunk_size = chunk_size;
+  store->n_chunks = n_chunks;
+  store->capacity = n_chunks;
+  store->users = 1;
+  store->refs = malloc(n_chunks * sizeof(uint64_t));
+  store->free_chunks = malloc(n_chunks * sizeof(uint64_t));
+
+  /**
+   * extending the file leaves a hole, read as zeroes without storage, which
+   * must support punching holes for released chunks to be freed
+   */
+  if (!store->refs || !store->free_chunks ||
+      ftruncate(store->fd, n_chunks * chunk_size) != 0 ||
+      !tw_bitmap_store_punch(store, 0, n_chunks)) {
+    tw_bitmap_store_delete(store);
+    return NULL;
+  }
+
+  for (uint64_t c = 0; c < n_chunks; ++c) {
+    store->refs[c] = 1;
+  }
+
+  return store;
+}
+
+/* take a free chunk, or append one to the file, must hold the lock */
+static bool tw_bitmap_store_alloc(struct tw_bitmap_store *store,
+                                  uint64_t *chunk)
+{
+  if (store->n_free) {
+    *chunk = store->free_chunks[--store->n_free];
+    store->refs[*chunk] = 1;
+    return true;
+  }
+
+  if (store->n_chunks == store->capacity) {
+    const uint64_t capacity = 2 * store->capacity;
+    uint64_t *refs = realloc(store->refs, capacity * sizeof(uint64_t));
+    if (!refs) {
+      return false;
+    }
+    store->refs = refs;
+
+    uint64_t *free_chunks =
+        realloc(store->free_chunks, capacity * sizeof(uint64_t));
+    if (!free_chunks) {
+      return false;
+    }
+    store->free_chunks = free_chunks;
+    store->capacity = capacity;
+  }
+
+  if (ftruncate(store->fd, (store->n_chunks + 1) * store->chunk_size) != 0) {
+    return false;
+  }
+
+  *chunk = store->n_chunks++;
+  store->refs[*chunk] = 1;
+  return true;
+}
+
+/* drop a reference to a chunk, freeing its memory once unused */
+static void tw_bitmap_store_release(struct tw_bitmap_store *store,
+                                    uint64_t chunk)
+{
+  if (--store->refs[chunk]) {
+    return;
+  }
+
+  /**
+   * punching holes is checked by `tw_bitmap_store_new`, a failure only keeps
+   * the storage of the chunk until it is reused, overwritten in full
+   */
+  store->free_chunks[store->n_free++] = chunk;
+  (void)tw_bitmap_store_punch(store, chunk, 1);
+}
+
+/* write a chunk's worth of bytes from `src` to a chunk of the file */
+static bool tw_bitmap_store_write(const struct tw_bitmap_store *store,
+                                  uint64_t chunk, const void *src,
+                                  uint64_t length)
+{
+  const char *bytes = src;
+  uint64_t offset = 0;
+  while (offset < length) {
+    const ssize_t written =
+        pwrite(store->fd, bytes + offset, length - offset,
+               chunk * store->chunk_size + offset);
+    if (written <= 0) {
+      return false;
+    }
+    offset += written;
+  }
+
+  return true;
+}
+
+static void tw_bitmap_cow_delete(struct tw_bitmap_cow *cow)
+{
+  free(cow->chunks);
+  free(cow->owned);
+  free(cow);
+}
+
+static struct tw_bitmap_cow *tw_bitmap_cow_new(struct tw_bitmap_store *store,
+                                               uint64_t n_chunks)
+{
+  struct tw_bitmap_cow *cow = calloc(1, sizeof(struct tw_bitmap_cow));
+  if (!cow) {
+    return NULL;
+  }
+
+  cow->store = store;
+  cow->n_chunks = n_chunks;
+  cow->chunks = calloc(n_chunks, sizeof(uint64_t));
+  cow->owned = calloc(TW_BITMAP_PER_BITS(n_chunks), sizeof(uint64_t));
+  if (!cow->chunks || !cow->owned) {
+    tw_bitmap_cow_delete(cow);
+    return NULL;
+  }
+
+  return cow;
+}
+
+/**
+ * Map the chunks of a bitmap contiguously, such that bitmap kernels are
+ * oblivious of sharing. Address space is reserved first, then runs of
+ * consecutive chunks of the file are mapped over it.
+ */
+static void *tw_bitmap_cow_map(const struct tw_bitmap_cow *cow)
+{
+  const struct tw_bitmap_store *store = cow->store;
+  const uint64_t mapping_size = cow->n_chunks * store->chunk_size;
+
+  char *mapping = mmap(NULL, mapping_size, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mapping == MAP_FAILED) {
+    return NULL;
+  }
+
+  uint64_t run;
+  for (uint64_t c = 0; c < cow->n_chunks; c += run) {
+    for (run = 1; c + run < cow->n_chunks &&
+                  cow->chunks[c + run] == cow->chunks[c] + run;
+         ++run) {
+    }
+
+    if (mmap(mapping + c * store->chunk_size, run * store->chunk_size,
+             PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, store->fd,
+             cow->chunks[c] * store->chunk_size) == MAP_FAILED) {
+      munmap(mapping, mapping_size);
+      return NULL;
+    }
+  }
+
+  return mapping;
+}
+
+/* wrap the chunks of `cow` in `bitmap`, `NULL` if mapping failed */
+static struct tw_bitmap *tw_bitmap_cow_attach(struct tw_bitmap *bitmap,
+                                              struct tw_bitmap_cow *cow)
+{
+  void *mapping = tw_bitmap_cow_map(cow);
+  if (!mapping) {
+    return NULL;
+  }
+
+  bitmap->data = mapping;
+  bitmap->mapping = mapping;
+  bitmap->mapping_size = cow->n_chunks * cow->store->chunk_size;
+  bitmap->capacity = bitmap->mapping_size * TW_BITS_IN_WORD;
+  bitmap->cow = cow;
+
+  return bitmap;
+}
+
+/* a new store of chunks holding `data_size` bytes, all owned by `cow` */
+static struct tw_bitmap_cow *tw_bitmap_cow_create(uint64_t data_size)
+{
+  const uint64_t chunk_size = tw_bitmap_chunk_size(data_size);
+  const uint64_t n_chunks = TW_DIV_ROUND_UP(data_size, chunk_size);
+
+  struct tw_bitmap_store *store = tw_bitmap_store_new(n_chunks, chunk_size);
+  if (!store) {
+    return NULL;
+  }
+
+  struct tw_bitmap_cow *cow = tw_bitmap_cow_new(store, n_chunks);
+  if (!cow) {
+    tw_bitmap_store_delete(store);
+    return NULL;
+  }
+
+  for (uint64_t c = 0; c < n_chunks; ++c) {
+    cow->chunks[c] = c;
+    cow->owned[c / TW_BITS_PER_BITMAP] |= tw_chunk_mask(c);
+  }
+
+  return cow;
+}
+
+struct tw_bitmap *tw_bitmap_new_shared(uint64_t size)
+{
+  if (0 == size || size > TW_BITMAP_MAX_BITS) {
+    return NULL;
+  }
+
+  const uint64_t data_size =
+      TW_ALLOC_TO_CACHELINE(TW_BITMAP_PER_BITS(size) * TW_BYTES_PER_BITMAP);
+
+  struct tw_bitmap *bitmap = calloc(1, sizeof(struct tw_bitmap));
+  if (!bitmap) {
+    return NULL;
+  }
+
+  struct tw_bitmap_cow *cow = tw_bitmap_cow_create(data_size);
+  if (!cow) {
+    free(bitmap);
+    return NULL;
+  }
+
+  if (!tw_bitmap_cow_attach(bitmap, cow)) {
+    tw_bitmap_store_delete(cow->store);
+    tw_bitmap_cow_delete(cow);
+    free(bitmap);
+    return NULL;
+  }
+
+  bitmap->size = data_size * TW_BITS_IN_WORD;
+
+  return bitmap;
+}
+
+/* move the bits of a heap allocated or anonymously mapped bitmap to a store */
+static bool tw_bitmap_make_shared(struct tw_bitmap *bitmap)
+{
+  const uint64_t data_size =
+      TW_BITMAP_PER_BITS(bitmap->size) * TW_BYTES_PER_BITMAP;
+
+  struct tw_bitmap_cow *cow = tw_bitmap_cow_create(data_size);
+  if (!cow) {
+    return false;
+  }
+
+  /* bits past `size` are cleared, the rest of the file is a hole */
+  void *data = bitmap->data;
+  void *mapping = bitmap->mapping;
+  const uint64_t mapping_size = bitmap->mapping_size;
+  if (!tw_bitmap_store_write(cow->store, 0, data, data_size) ||
+      !tw_bitmap_cow_attach(bitmap, cow)) {
+    tw_bitmap_store_delete(cow->store);
+    tw_bitmap_cow_delete(cow);
+    return false;
+  }
+
+  if (mapping) {
+    munmap(mapping, mapping_size);
+  } else {
+    free(data);
+  }
+
+  return true;
+}
+
+/**
+ * Snapshot a shared bitmap. Both bitmaps map the same chunks, which are thus
+ * no longer owned by `bitmap`.
+ */
+static struct tw_bitmap *tw_bitmap_share(struct tw_bitmap *bitmap)
+{
+  struct tw_bitmap_cow *src = bitmap->cow;
+  struct tw_bitmap_store *store = src->store;
+
+  struct tw_bitmap *snapshot = malloc(sizeof(struct tw_bitmap));
+  if (!snapshot) {
+    return NULL;
+  }
+
+  struct tw_bitmap_cow *cow = tw_bitmap_cow_new(store, src->n_chunks);
+  if (!cow) {
+    free(snapshot);
+    return NULL;
+  }
+
+  /* `size`, `count` and friends are those of `bitmap` */
+  *snapshot = *bitmap;
+  memcpy(cow->chunks, src->chunks, src->n_chunks * sizeof(uint64_t));
+  if (!tw_bitmap_cow_attach(snapshot, cow)) {
+    tw_bitmap_cow_delete(cow);
+    free(snapshot);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&store->lock);
+  for (uint64_t c = 0; c < cow->n_chunks; ++c) {
+    store->refs[cow->chunks[c]]++;
+  }
+  store->users++;
+  pthread_mutex_unlock(&store->lock);
+
+  memset(src->owned, 0,
+         TW_BITMAP_PER_BITS(src->n_chunks) * TW_BYTES_PER_BITMAP);
+
+  return snapshot;
+}
+
+struct tw_bitmap *tw_bitmap_snapshot(struct tw_bitmap *bitmap)
+{
+  if (!bitmap || tw_bitmap_is_file_backed(bitmap) ||
+      tw_bitmap_is_wrapped(bitmap) ||
+      (!bitmap->cow && !tw_bitmap_make_shared(bitmap))) {
+    return NULL;
+  }
+
+  return tw_bitmap_share(bitmap);
+}
+
+uint64_t tw_bitmap_shared_size(const struct tw_bitmap *bitmap)
+{
+  if (!bitmap || !bitmap->cow) {
+    return 0;
+  }
+
+  const struct tw_bitmap_cow *cow = bitmap->cow;
+  struct tw_bitmap_store *store = cow->store;
+
+  uint64_t shared = 0;
+  pthread_mutex_lock(&store->lock);
+  for (uint64_t c = 0; c < cow->n_chunks; ++c) {
+    shared += store->refs[cow->chunks[c]] > 1;
+  }
+  pthread_mutex_unlock(&store->lock);
+
+  return shared * store->chunk_size;
+}
+
+/**
+ * Copy a shared chunk of a bitmap to a new chunk of the file, remapped in
+ * place of the shared one. A chunk no longer referenced by other bitmaps is
+ * owned without copy.
+ */
+static bool tw_bitmap_unshare_chunk(struct tw_bitmap *bitmap, uint64_t c)
+{
+  struct tw_bitmap_cow *cow = bitmap->cow;
+  struct tw_bitmap_store *store = cow->store;
+  const uint64_t old = cow->chunks[c];
+  uint64_t new;
+
+  pthread_mutex_lock(&store->lock);
+  const bool owned = store->refs[old] == 1;
+  const bool allocated = !owned && tw_bitmap_store_alloc(store, &new);
+  pthread_mutex_unlock(&store->lock);
+
+  if (owned) {
+    cow->owned[c / TW_BITS_PER_BITMAP] |= tw_chunk_mask(c);
+    return true;
+  } else if (!allocated) {
+    return false;
+  }
+
+  /* other bitmaps only read the shared chunk, it is copied without lock */
+  char *addr = (char *)bitmap->mapping + c * store->chunk_size;
+  const bool copied =
+      tw_bitmap_store_write(store, new, addr, store->chunk_size) &&
+      mmap(addr, store->chunk_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_FIXED, store->fd,
+           new * store->chunk_size) != MAP_FAILED;
+
+  pthread_mutex_lock(&store->lock);
+  tw_bitmap_store_release(store, copied ? old : new);
+  pthread_mutex_unlock(&store->lock);
+
+  if (!copied) {
+    return false;
+  }
+
+  cow->chunks[c] = new;
+  cow->owned[c / TW_BITS_PER_BITMAP] |= tw_chunk_mask(c);
+
+  return true;
+}
+
+/**
+ * Make the words `[first_word, last_word]` of a shared bitmap writable,
+ * called before modifying them. Returns `false` if a chunk could not be
+ * copied, the bitmap must then be left untouched.
+ */
+bool tw_bitmap_unshare(struct tw_bitmap *bitmap, uint64_t first_word,
+                       uint64_t last_word)
+{
+  const struct tw_bitmap_cow *cow = bitmap->cow;
+  const uint64_t words_per_chunk = cow->store->chunk_size / TW_BYTES_PER_BITMAP;
+
+  for (uint64_t c = first_word / words_per_chunk;
+       c <= last_word / words_per_chunk; ++c) {
+    if (!(cow->owned[c / TW_BITS_PER_BITMAP] & tw_chunk_mask(c)) &&
+        !tw_bitmap_unshare_chunk(bitmap, c)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* release the chunks of a shared bitmap, called by `tw_bitmap_free` */
+void tw_bitmap_cow_free(struct tw_bitmap *bitmap)
+{
+  struct tw_bitmap_cow *cow = bitmap->cow;
+  struct tw_bitmap_store *store = cow->store;
+
+  munmap(bitmap->mapping, bitmap->mapping_size);
+
+  /* the last user closes the file instead of freeing chunks one by one */
+  pthread_mutex_lock(&store->lock);
+  const bool last = --store->users == 0;
+  for (uint64_t c = 0; !last && c < cow->n_chunks; ++c) {
+    tw_bitmap_store_release(store, cow->chunks[c]);
+  }
+  pthread_mutex_unlock(&store->lock);
+
+  if (last) {
+    tw_bitmap_store_delete(store);
+  }
+  tw_bitmap_cow_delete(cow);
+}
@@ -0,0 +1,307 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_summary.h>
+
+#include "../macrology.h"
+
+#define TW_BITS_PER_WORD 64
+
+#define tw_word_mask(pos) (1ULL << ((pos) % TW_BITS_PER_WORD))
+/* bits of a word at or above `pos` */
+#define tw_word_from(pos) (~0ULL << ((pos) % TW_BITS_PER_WORD))
+
+/* (re)allocate the levels for the current size of the bitmap */
+static struct tw_bitmap_summary *
+tw_bitmap_summary_alloc(struct tw_bitmap_summary *summary)
+{
+  const uint64_t size = summary->bitmap->size;
+
+  if (summary->data && summary->size == size) {
+    return summary;
+  }
+
+  uint8_t levels = 0;
+  uint64_t words[TW_BITMAP_SUMMARY_MAX_LEVELS];
+  uint64_t total = 0;
+  uint64_t below = TW_DIV_ROUND_UP(size, TW_BITS_PER_WORD);
+  do {
+    below = TW_DIV_ROUND_UP(below, TW_BITS_PER_WORD);
+    words[levels++] = below;
+    total += below;
+  } while (below > 1);
+
+  uint64_t *data = calloc(2 * total, sizeof(uint64_t));
+  if (!data) {
+    return NULL;
+  }
+
+  free(summary->data);
+  summary->data = data;
+  summary->size = size;
+  summary->levels = levels;
+  for (uint8_t l = 0; l < levels; ++l) {
+    summary->words[l] = words[l];
+    summary->zeros[l] = data;
+    summary->ones[l] = data + total;
+    data += words[l];
+  }
+
+  return summary;
+}
+
+/* build a level from the words of the level below */
+static void tw_bitmap_summary_build(uint64_t *level, const uint64_t *below,
+                                    uint64_t n, uint64_t invert)
+{
+  for (uint64_t i = 0; i < n; ++i) {
+    if (below[i] ^ invert) {
+      level[i / TW_BITS_PER_WORD] |= tw_word_mask(i);
+    }
+  }
+}
+
+struct tw_bitmap_summary *tw_bitmap_summary_new(struct tw_bitmap *bitmap)
+{
+  if (!bitmap) {
+    return NULL;
+  }
+
+  struct tw_bitmap_summary *summary =
+      calloc(1, sizeof(struct tw_bitmap_summary));
+  if (!summary) {
+    return NULL;
+  }
+
+  summary->bitmap = bitmap;
+  /* forces the initial build */
+  summary->generation = bitmap->generation - 1;
+
+  if (!tw_bitmap_summary_update(summary)) {
+    tw_bitmap_summary_free(summary);
+    return NULL;
+  }
+
+  return summary;
+}
+
+void tw_bitmap_summary_free(struct tw_bitmap_summary *summary)
+{
+  if (!summary) {
+    return;
+  }
+
+  free(summary->data);
+  free(summary);
+}
+
+bool tw_bitmap_summary_stale(const struct tw_bitmap_summary *summary)
+{
+  if (!summary) {
+    return false;
+  }
+
+  const struct tw_bitmap *bitmap = summary->bitmap;
+  return bitmap->stale || summary->generation != bitmap->generation ||
+         summary->size != bitmap->size;
+}
+
+struct tw_bitmap_summary *
+tw_bitmap_summary_update(struct tw_bitmap_summary *summary)
+{
+  if (!summary) {
+    return NULL;
+  }
+
+  if (!tw_bitmap_summary_stale(summary)) {
+    return summary;
+  }
+
+  if (!tw_bitmap_summary_alloc(summary)) {
+    return NULL;
+  }
+
+  /* refreshes the generation of a bitmap written with `_nocount` */
+  struct tw_bitmap *bitmap = summary->bitmap;
+  tw_bitmap_count(bitmap);
+
+  const uint64_t n_words = bitmap->size / TW_BITS_PER_WORD;
+  uint64_t total = 0;
+  for (uint8_t l = 0; l < summary->levels; ++l) {
+    total += summary->words[l];
+  }
+  memset(summary->data, 0, 2 * total * sizeof(uint64_t));
+
+  tw_bitmap_summary_build(summary->zeros[0], bitmap->data, n_words, ~0ULL);
+  tw_bitmap_summary_build(summary->ones[0], bitmap->data, n_words, 0ULL);
+  for (uint8_t l = 1; l < summary->levels; ++l) {
+    const uint64_t n = summary->words[l - 1];
+    tw_bitmap_summary_build(summary->zeros[l], summary->zeros[l - 1], n, 0);
+    tw_bitmap_summary_build(summary->ones[l], summary->ones[l - 1], n, 0);
+  }
+
+  summary->generation = bitmap->generation;
+
+  return summary;
+}
+
+/**
+ * Propagate the state of the `idx`-th word of the bitmap up a hierarchy. A
+ * level's word changing from or to zero is the only change visible from the
+ * level above, thus the walk stops at the first word keeping its state.
+ */
+static void tw_bitmap_summary_propagate(const struct tw_bitmap_summary *summary,
+                                        uint64_t *const *levels, uint64_t idx,
+                                        bool active)
+{
+  for (uint8_t l = 0; l < summary->levels; ++l) {
+    uint64_t *word = &levels[l][idx / TW_BITS_PER_WORD];
+    const bool was_active = *word != 0;
+
+    if (active) {
+      *word |= tw_word_mask(idx);
+    } else {
+      *word &= ~tw_word_mask(idx);
+    }
+
+    active = *word != 0;
+    if (active == was_active) {
+      return;
+    }
+    idx /= TW_BITS_PER_WORD;
+  }
+}
+
+/* reflect a write of the word holding `pos` in both hierarchies */
+static void tw_bitmap_summary_refresh(struct tw_bitmap_summary *summary,
+                                      uint64_t pos)
+{
+  const uint64_t idx = pos / TW_BITS_PER_WORD;
+  const uint64_t word = summary->bitmap->data[idx];
+
+  tw_bitmap_summary_propagate(summary, summary->zeros, idx, word != ~0ULL);
+  tw_bitmap_summary_propagate(summary, summary->ones, idx, word != 0);
+  summary->generation = summary->bitmap->generation;
+}
+
+bool tw_bitmap_summary_set(struct tw_bitmap_summary *summary, uint64_t pos)
+{
+  if (!tw_bitmap_summary_update(summary) || pos >= summary->bitmap->size) {
+    return false;
+  }
+
+  tw_bitmap_set(summary->bitmap, pos);
+  tw_bitmap_summary_refresh(summary, pos);
+
+  return true;
+}
+
+bool tw_bitmap_summary_clear(struct tw_bitmap_summary *summary, uint64_t pos)
+{
+  if (!tw_bitmap_summary_update(summary) || pos >= summary->bitmap->size) {
+    return false;
+  }
+
+  tw_bitmap_clear(summary->bitmap, pos);
+  tw_bitmap_summary_refresh(summary, pos);
+
+  return true;
+}
+
+/**
+ * Find the first bit at or after `from` of the bitmap's words xor-ed with
+ * `invert`, whose words are summarized by `levels`.
+ *
+ * The hierarchy is walked up from the word holding `from` until a level has
+ * an active bit past the visited words, then down following the first active
+ * bit of each level.
+ */
+static int64_t tw_bitmap_summary_find(const struct tw_bitmap_summary *summary,
+                                      uint64_t *const *levels, uint64_t from,
+                                      uint64_t invert)
+{
+  const uint64_t *data = summary->bitmap->data;
+
+  uint64_t idx = from / TW_BITS_PER_WORD;
+  const uint64_t word = (data[idx] ^ invert) & tw_word_from(from);
+  if (word) {
+    return idx * TW_BITS_PER_WORD + __builtin_ctzll(word);
+  }
+
+  uint8_t l = 0;
+  for (idx++;; idx = idx / TW_BITS_PER_WORD + 1) {
+    if (l == summary->levels || idx / TW_BITS_PER_WORD >= summary->words[l]) {
+      return -1;
+    }
+
+    const uint64_t bits = levels[l][idx / TW_BITS_PER_WORD] & tw_word_from(idx);
+    if (bits) {
+      idx = (idx / TW_BITS_PER_WORD) * TW_BITS_PER_WORD + __builtin_ctzll(bits);
+      break;
+    }
+    l++;
+  }
+
+  for (; l > 0; --l) {
+    idx = idx * TW_BITS_PER_WORD + __builtin_ctzll(levels[l - 1][idx]);
+  }
+
+  return idx * TW_BITS_PER_WORD + __builtin_ctzll(data[idx] ^ invert);
+}
+
+int64_t tw_bitmap_summary_find_next_zero(struct tw_bitmap_summary *summary,
+                                         uint64_t from)
+{
+  if (!tw_bitmap_summary_update(summary) || from >= summary->bitmap->size) {
+    return -1;
+  }
+
+  return tw_bitmap_summary_find(summary, summary->zeros, from, ~0ULL);
+}
+
+int64_t tw_bitmap_summary_find_first_zero(struct tw_bitmap_summary *summary)
+{
+  return tw_bitmap_summary_find_next_zero(summary, 0);
+}
+
+int64_t tw_bitmap_summary_find_next_bit(struct tw_bitmap_summary *summary,
+                                        uint64_t from)
+{
+  if (!tw_bitmap_summary_update(summary) || from >= summary->bitmap->size) {
+    return -1;
+  }
+
+  return tw_bitmap_summary_find(summary, summary->ones, from, 0ULL);
+}
+
+int64_t tw_bitmap_summary_find_first_bit(struct tw_bitmap_summary *summary)
+{
+  return tw_bitmap_summary_find_next_bit(summary, 0);
+}
+
+int64_t tw_bitmap_summary_alloc_id(struct tw_bitmap_summary *summary)
+{
+  const int64_t id = tw_bitmap_summary_find_first_zero(summary);
+  if (id < 0) {
+    return -1;
+  }
+
+  tw_bitmap_set(summary->bitmap, id);
+  tw_bitmap_summary_refresh(summary, id);
+
+  return id;
+}
+
+bool tw_bitmap_summary_free_id(struct tw_bitmap_summary *summary, uint64_t id)
+{
+  if (!tw_bitmap_summary_update(summary) || id >= summary->bitmap->size ||
+      !tw_bitmap_test(summary->bitmap, id)) {
+    return false;
+  }
+
+  tw_bitmap_clear(summary->bitmap, id);
+  tw_bitmap_summary_refresh(summary, id);
+
+  return true;
+}
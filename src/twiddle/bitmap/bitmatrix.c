@@ -0,0 +1,328 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmatrix.h>
+
+#include "../macrology.h"
+#include "../utils/pages.h"
+#include "bitmap_internal.h"
+
+/* words per row */
+#define tw_bitmatrix_words(matrix) ((matrix)->row_bits / TW_BITS_PER_BITMAP)
+#define tw_bitmatrix_word(matrix, row, col)                                    \
+  ((matrix)->data[(row) * tw_bitmatrix_words(matrix) +                        \
+                  (col) / TW_BITS_PER_BITMAP])
+
+#define tw_bitmatrix_valid(matrix, row, col)                                   \
+  ((matrix) && (row) < (matrix)->n_rows && (col) < (matrix)->n_cols)
+
+/*
+ * views of rows recount their active bits on demand, and own none of their
+ * words: as wrapped bitmaps, they can't be resized nor freed
+ */
+static inline struct tw_bitmap
+tw_bitmatrix_view(const struct tw_bitmatrix *matrix, uint64_t row)
+{
+  return (struct tw_bitmap){
+      .size = matrix->row_bits,
+      .data = matrix->data + row * tw_bitmatrix_words(matrix),
+      .stale = true,
+      .flags = TW_ALLOC_WRAPPED,
+  };
+}
+
+struct tw_bitmatrix *tw_bitmatrix_new(uint64_t n_rows, uint64_t n_cols)
+{
+  if (0 == n_rows || 0 == n_cols || n_cols > TW_BITMAP_MAX_BITS) {
+    return NULL;
+  }
+
+  const uint64_t row_bits =
+      TW_ALLOC_TO_CACHELINE(TW_BITMAP_PER_BITS(n_cols) * TW_BYTES_PER_BITMAP) *
+      TW_BITS_IN_WORD;
+  if (n_rows > TW_BITMAP_MAX_BITS / row_bits) {
+    return NULL;
+  }
+
+  struct tw_bitmatrix *matrix = calloc(1, sizeof(struct tw_bitmatrix));
+  if (!matrix) {
+    return NULL;
+  }
+
+  /* large matrices are mapped, pages are then zeroed on first touch */
+  const uint64_t data_size = n_rows * row_bits / TW_BITS_IN_WORD;
+  if (data_size >= TW_BITMAP_REMAP_MIN) {
+    matrix->data = tw_pages_alloc(data_size, TW_ALLOC_DEFAULT);
+    matrix->mapping_size = tw_pages_size(data_size, TW_ALLOC_DEFAULT);
+  } else if ((matrix->data = malloc_aligned(TW_CACHELINE, data_size))) {
+    memset(matrix->data, 0, data_size);
+  }
+
+  if (!matrix->data) {
+    free(matrix);
+    return NULL;
+  }
+
+  matrix->n_rows = n_rows;
+  matrix->n_cols = n_cols;
+  matrix->row_bits = row_bits;
+
+  return matrix;
+}
+
+void tw_bitmatrix_free(struct tw_bitmatrix *matrix)
+{
+  if (!matrix) {
+    return;
+  }
+
+  if (matrix->mapping_size) {
+    tw_pages_free(matrix->data, matrix->mapping_size, TW_ALLOC_DEFAULT);
+  } else {
+    free(matrix->data);
+  }
+  free(matrix);
+}
+
+void tw_bitmatrix_set(struct tw_bitmatrix *matrix, uint64_t row, uint64_t col)
+{
+  if (!tw_bitmatrix_valid(matrix, row, col)) {
+    return;
+  }
+
+  tw_bitmatrix_word(matrix, row, col) |= 1ULL << (col % TW_BITS_PER_BITMAP);
+}
+
+void tw_bitmatrix_clear(struct tw_bitmatrix *matrix, uint64_t row,
+                        uint64_t col)
+{
+  if (!tw_bitmatrix_valid(matrix, row, col)) {
+    return;
+  }
+
+  tw_bitmatrix_word(matrix, row, col) &= ~(1ULL << (col % TW_BITS_PER_BITMAP));
+}
+
+bool tw_bitmatrix_test(const struct tw_bitmatrix *matrix, uint64_t row,
+                       uint64_t col)
+{
+  if (!tw_bitmatrix_valid(matrix, row, col)) {
+    return false;
+  }
+
+  return (tw_bitmatrix_word(matrix, row, col) >> (col % TW_BITS_PER_BITMAP)) &
+         1ULL;
+}
+
+struct tw_bitmap *tw_bitmatrix_row(const struct tw_bitmatrix *matrix,
+                                   uint64_t row, struct tw_bitmap *view)
+{
+  if (!matrix || !view || row >= matrix->n_rows) {
+    return NULL;
+  }
+
+  *view = tw_bitmatrix_view(matrix, row);
+
+  return view;
+}
+
+bool tw_bitmatrix_row_union(struct tw_bitmatrix *matrix, uint64_t src,
+                            uint64_t dst)
+{
+  if (!matrix || src >= matrix->n_rows || dst >= matrix->n_rows) {
+    return false;
+  }
+
+  struct tw_bitmap src_view = tw_bitmatrix_view(matrix, src);
+  struct tw_bitmap dst_view = tw_bitmatrix_view(matrix, dst);
+
+  return tw_bitmap_union(&src_view, &dst_view) != NULL;
+}
+
+bool tw_bitmatrix_row_intersection(struct tw_bitmatrix *matrix, uint64_t src,
+                                   uint64_t dst)
+{
+  if (!matrix || src >= matrix->n_rows || dst >= matrix->n_rows) {
+    return false;
+  }
+
+  struct tw_bitmap src_view = tw_bitmatrix_view(matrix, src);
+  struct tw_bitmap dst_view = tw_bitmatrix_view(matrix, dst);
+
+  return tw_bitmap_intersection(&src_view, &dst_view) != NULL;
+}
+
+uint64_t tw_bitmatrix_row_count(const struct tw_bitmatrix *matrix,
+                                uint64_t row)
+{
+  if (!matrix || row >= matrix->n_rows) {
+    return 0;
+  }
+
+  struct tw_bitmap view = tw_bitmatrix_view(matrix, row);
+
+  return tw_bitmap_count(&view);
+}
+
+uint64_t tw_bitmatrix_col_count(const struct tw_bitmatrix *matrix,
+                                uint64_t col)
+{
+  if (!matrix || col >= matrix->n_cols) {
+    return 0;
+  }
+
+  uint64_t count = 0;
+  for (uint64_t row = 0; row < matrix->n_rows; ++row) {
+    count += (tw_bitmatrix_word(matrix, row, col) >>
+              (col % TW_BITS_PER_BITMAP)) &
+             1ULL;
+  }
+
+  return count;
+}
+
+/**
+ * Transpose a block of 64 by 64 bits in place, bit `c` of word `r` is swapped
+ * with bit `r` of word `c`. Quadrants of 32 by 32 bits are swapped first,
+ * then quadrants of each quadrant down to single bits, see Hacker's Delight
+ * 7-3.
+ */
+static void tw_bitmatrix_transpose64(uint64_t block[TW_BITS_PER_BITMAP])
+{
+  uint64_t mask = 0x00000000FFFFFFFFULL;
+  for (unsigned j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+    for (unsigned k = 0; k < TW_BITS_PER_BITMAP; k = ((k | j) + 1) & ~j) {
+      const uint64_t t = ((block[k] >> j) ^ block[k | j]) & mask;
+      block[k] ^= t << j;
+      block[k | j] ^= t;
+    }
+  }
+}
+
+/* load the block of word `col_word` of rows `[row, row + 64)`, `false` if 0 */
+static bool tw_bitmatrix_load64(const struct tw_bitmatrix *matrix,
+                                uint64_t row, uint64_t col_word,
+                                uint64_t block[TW_BITS_PER_BITMAP])
+{
+  const uint64_t n_rows = tw_min(TW_BITS_PER_BITMAP, matrix->n_rows - row);
+  const uint64_t words = tw_bitmatrix_words(matrix);
+  const uint64_t *data = matrix->data + row * words + col_word;
+
+  uint64_t any = 0;
+  for (uint64_t r = 0; r < n_rows; ++r) {
+    block[r] = data[r * words];
+    any |= block[r];
+  }
+  memset(block + n_rows, 0, (TW_BITS_PER_BITMAP - n_rows) * sizeof(uint64_t));
+
+  return any != 0;
+}
+
+bool tw_bitmatrix_col_counts(const struct tw_bitmatrix *matrix,
+                             uint64_t *counts)
+{
+  if (!matrix || !counts) {
+    return false;
+  }
+
+  memset(counts, 0, matrix->n_cols * sizeof(uint64_t));
+
+  /* a transposed block holds a word per column of the block */
+  uint64_t block[TW_BITS_PER_BITMAP];
+  for (uint64_t w = 0; w < TW_BITMAP_PER_BITS(matrix->n_cols); ++w) {
+    const uint64_t col = w * TW_BITS_PER_BITMAP;
+    const uint64_t n_cols = tw_min(TW_BITS_PER_BITMAP, matrix->n_cols - col);
+
+    for (uint64_t row = 0; row < matrix->n_rows; row += TW_BITS_PER_BITMAP) {
+      if (!tw_bitmatrix_load64(matrix, row, w, block)) {
+        continue;
+      }
+
+      tw_bitmatrix_transpose64(block);
+      for (uint64_t c = 0; c < n_cols; ++c) {
+        counts[col + c] += __builtin_popcountll(block[c]);
+      }
+    }
+  }
+
+  return true;
+}
+
+struct tw_bitmatrix *tw_bitmatrix_transpose(const struct tw_bitmatrix *matrix)
+{
+  if (!matrix) {
+    return NULL;
+  }
+
+  struct tw_bitmatrix *transpose =
+      tw_bitmatrix_new(matrix->n_cols, matrix->n_rows);
+  if (!transpose) {
+    return NULL;
+  }
+
+  /**
+   * The block of rows `[row, row + 64)` and columns `[col, col + 64)` is
+   * stored at rows `[col, col + 64)` and columns `[row, row + 64)`. Empty
+   * blocks are skipped, the transpose being zeroed.
+   */
+  uint64_t block[TW_BITS_PER_BITMAP];
+  const uint64_t words = tw_bitmatrix_words(transpose);
+  for (uint64_t row = 0; row < matrix->n_rows; row += TW_BITS_PER_BITMAP) {
+    for (uint64_t w = 0; w < TW_BITMAP_PER_BITS(matrix->n_cols); ++w) {
+      if (!tw_bitmatrix_load64(matrix, row, w, block)) {
+        continue;
+      }
+
+      tw_bitmatrix_transpose64(block);
+
+      const uint64_t col = w * TW_BITS_PER_BITMAP;
+      const uint64_t n_cols =
+          tw_min(TW_BITS_PER_BITMAP, matrix->n_cols - col);
+      uint64_t *data =
+          transpose->data + col * words + row / TW_BITS_PER_BITMAP;
+      for (uint64_t c = 0; c < n_cols; ++c) {
+        data[c * words] = block[c];
+      }
+    }
+  }
+
+  return transpose;
+}
+
+struct tw_bitmap *tw_bitmatrix_expand(const struct tw_bitmatrix *matrix,
+                                      const struct tw_bitmap *frontier,
+                                      struct tw_bitmap *next)
+{
+  if (!matrix || !frontier || !next || frontier == next ||
+      frontier->size < matrix->n_rows || next->size != matrix->row_bits ||
+      !tw_bitmap_zero(next)) {
+    return NULL;
+  }
+
+  /* `next` is both a source and the destination of each batch */
+  struct tw_bitmap views[TW_BITMATRIX_EXPAND_BATCH];
+  const struct tw_bitmap *srcs[TW_BITMATRIX_EXPAND_BATCH + 1] = {next};
+  for (size_t k = 0; k < TW_BITMATRIX_EXPAND_BATCH; ++k) {
+    srcs[k + 1] = &views[k];
+  }
+
+  struct tw_bitmap_iter iter;
+  tw_bitmap_iter_init(&iter, frontier, 0);
+
+  size_t n_views = 0;
+  uint64_t row;
+  while (tw_bitmap_iter_next(&iter, &row) && row < matrix->n_rows) {
+    views[n_views++] = tw_bitmatrix_view(matrix, row);
+    if (n_views == TW_BITMATRIX_EXPAND_BATCH) {
+      tw_bitmap_union_many(srcs, n_views + 1, next);
+      n_views = 0;
+    }
+  }
+
+  if (n_views) {
+    tw_bitmap_union_many(srcs, n_views + 1, next);
+  }
+
+  return next;
+}
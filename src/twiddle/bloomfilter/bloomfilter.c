@@ -8,6 +8,12 @@
 #define TW_BF_DEFAULT_SEED 3781869495ULL
 
 struct tw_bloomfilter *tw_bloomfilter_new(uint64_t size, uint16_t k)
+{
+  return tw_bloomfilter_new_flags(size, k, TW_ALLOC_DEFAULT);
+}
+
+struct tw_bloomfilter *tw_bloomfilter_new_flags(uint64_t size, uint16_t k,
+                                                int flags)
 {
   if (!size || size > TW_BITMAP_MAX_BITS || !k) {
     return NULL;
@@ -18,7 +24,7 @@ struct tw_bloomfilter *tw_bloomfilter_new(uint64_t size, uint16_t k)
     return NULL;
   }
 
-  bf->bitmap = tw_bitmap_new(size);
+  bf->bitmap = tw_bitmap_new_flags(size, flags);
   if (!(bf->bitmap)) {
     free(bf);
     return NULL;
@@ -88,6 +94,25 @@ void tw_bloomfilter_set(struct tw_bloomfilter *bf, const void *key,
   }
 }
 
+void tw_bloomfilter_set_nocount(struct tw_bloomfilter *bf, const void *key,
+                                size_t key_size)
+{
+  if (!bf || !key || !key_size) {
+    return;
+  }
+
+  const tw_uint128_t hash = tw_metrohash_128(TW_BF_DEFAULT_SEED, key, key_size);
+  const uint16_t k = bf->k;
+  struct tw_bitmap *bitmap = bf->bitmap;
+  const uint64_t b_size = bitmap->size;
+
+  for (size_t i = 0; i < k; ++i) {
+    const uint64_t hash_fn_i = hash.h + (i * hash.l);
+    const uint64_t idx = tw_projection_mul_64(hash_fn_i, b_size);
+    tw_bitmap_set_nocount(bitmap, idx);
+  }
+}
+
 bool tw_bloomfilter_test(const struct tw_bloomfilter *bf, const void *key,
                          size_t key_size)
 {
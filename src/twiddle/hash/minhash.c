@@ -4,8 +4,10 @@
 
 #include <twiddle/hash/minhash.h>
 #include <twiddle/utils/hash.h>
+#include <twiddle/utils/simd.h>
 
 #include "../macrology.h"
+#include "../utils/pages.h"
 
 #define TW_BYTES_PER_MINHASH_REGISTER sizeof(uint32_t)
 
@@ -13,7 +15,12 @@
 
 struct tw_minhash *tw_minhash_new(uint32_t n_registers)
 {
-  if (n_registers == 0) {
+  return tw_minhash_new_flags(n_registers, TW_ALLOC_DEFAULT);
+}
+
+struct tw_minhash *tw_minhash_new_flags(uint32_t n_registers, int flags)
+{
+  if (n_registers == 0 || (flags & TW_ALLOC_WRAPPED)) {
     return NULL;
   }
 
@@ -25,14 +32,42 @@ struct tw_minhash *tw_minhash_new(uint32_t n_registers)
   const size_t data_size =
       TW_ALLOC_TO_CACHELINE(n_registers * TW_BYTES_PER_MINHASH_REGISTER);
 
-  if ((hash->registers = malloc_aligned(TW_CACHELINE, data_size)) == NULL) {
-    free(hash);
+  if (flags != TW_ALLOC_DEFAULT) {
+    /* mapped pages are already zeroed */
+    if ((hash->registers = tw_pages_alloc(data_size, flags)) == NULL) {
+      free(hash);
+      return NULL;
+    }
+  } else {
+    if ((hash->registers = malloc_aligned(TW_CACHELINE, data_size)) == NULL) {
+      free(hash);
+      return NULL;
+    }
+    memset(hash->registers, 0, data_size);
+  }
+
+  hash->n_registers = n_registers;
+  hash->flags = flags;
+  return hash;
+}
+
+struct tw_minhash *tw_minhash_wrap(void *registers, uint32_t n_registers)
+{
+  /* kernels see whole cache lines, thus no padding past the registers */
+  if (!registers || (uintptr_t)registers % TW_CACHELINE || n_registers == 0 ||
+      (n_registers * TW_BYTES_PER_MINHASH_REGISTER) % TW_CACHELINE) {
     return NULL;
   }
 
-  memset(hash->registers, 0, data_size);
+  struct tw_minhash *hash = calloc(1, sizeof(struct tw_minhash));
+  if (!hash) {
+    return NULL;
+  }
 
+  hash->registers = registers;
   hash->n_registers = n_registers;
+  hash->flags = TW_ALLOC_WRAPPED;
+
   return hash;
 }
 
@@ -42,7 +77,16 @@ void tw_minhash_free(struct tw_minhash *hash)
     return;
   }
 
-  free(hash->registers);
+  if (hash->flags & TW_ALLOC_WRAPPED) {
+    /* registers are owned by the caller */
+  } else if (hash->flags != TW_ALLOC_DEFAULT) {
+    tw_pages_free(hash->registers,
+                  TW_ALLOC_TO_CACHELINE(hash->n_registers *
+                                        TW_BYTES_PER_MINHASH_REGISTER),
+                  hash->flags);
+  } else {
+    free(hash->registers);
+  }
   free(hash);
 }
 
@@ -73,20 +117,6 @@ struct tw_minhash *tw_minhash_clone(const struct tw_minhash *hash)
   return tw_minhash_copy(hash, copy);
 }
 
-void tw_minhash_add(struct tw_minhash *hash, const void *key, size_t key_size)
-{
-  if (!hash || !key || !key_size) {
-    return;
-  }
-
-  const uint64_t hashed =
-      tw_metrohash_64(TW_MINHASH_DEFAULT_SEED, key, key_size);
-
-  const uint32_t a = (uint32_t)hashed;
-  const uint32_t b = (uint32_t)(hashed >> 32);
-
-  const uint32_t n_registers = hash->n_registers;
-
 #define MINH_ADD_LOOP(simd_t, simd_load, simd_add, simd_max, simd_store,       \
                       simd_set1, vec_elts)                                     \
   uint32_t ib[vec_elts];                                                       \
@@ -107,36 +137,17 @@ void tw_minhash_add(struct tw_minhash *hash, const void *key, size_t key_size)
     acc2 = simd_add(acc2, inc);                                                \
   }
 
-#ifdef USE_AVX2
-  MINH_ADD_LOOP(__m256i, _mm256_loadu_si256, _mm256_add_epi32, _mm256_max_epu32,
-                _mm256_storeu_si256, _mm256_set1_epi32,
-                sizeof(__m256i) / sizeof(uint32_t))
-#elif defined USE_AVX
-  MINH_ADD_LOOP(__m128i, _mm_load_si128, _mm_add_epi32, _mm_max_epu32,
-                _mm_store_si128, _mm_set1_epi32,
-                sizeof(__m128i) / sizeof(uint32_t))
-#else
-  for (size_t i = 0; i < n_registers; ++i) {
-    const uint32_t hashed_i = a + i * b;
-    hash->registers[i] = tw_max(hash->registers[i], hashed_i);
-  }
-#endif
-
-#undef MINH_ADD_LOOP
-}
-
-float tw_minhash_estimate(const struct tw_minhash *a,
-                          const struct tw_minhash *b)
-{
-  if (!a || !b || a->n_registers != b->n_registers) {
-    return 0.0f;
+#define MINH_ADD_KERNEL(name, target, simd_t, simd_load, simd_add, simd_max,   \
+                        simd_store, simd_set1)                                 \
+  static target void name(struct tw_minhash *hash, uint32_t a, uint32_t b)     \
+  {                                                                            \
+    const uint32_t n_registers = hash->n_registers;                            \
+    MINH_ADD_LOOP(simd_t, simd_load, simd_add, simd_max, simd_store,           \
+                  simd_set1, sizeof(simd_t) / sizeof(uint32_t))                \
   }
 
-  const uint32_t n_registers = a->n_registers;
-
-  uint32_t n_registers_eq = 0;
-
-#define MINH_EST_LOOP(simd_t, simd_load, simd_cmpeq, simd_add, simd_set1)      \
+#define MINH_EST_LOOP(simd_t, simd_load, simd_cmpeq, simd_add, simd_set1,      \
+                      simd_storeu)                                             \
   const size_t n_vectors =                                                     \
       n_registers * TW_BYTES_PER_MINHASH_REGISTER / sizeof(simd_t);            \
   simd_t acc = simd_set1(0);                                                   \
@@ -145,34 +156,23 @@ float tw_minhash_estimate(const struct tw_minhash *a,
            *b_addr = (simd_t *)b->registers + i;                               \
     acc = simd_add(acc, simd_cmpeq(*a_addr, *b_addr));                         \
   }                                                                            \
-  for (size_t i = 0; i < sizeof(simd_t) / sizeof(uint32_t); i++)               \
-    n_registers_eq -= ((uint32_t *)&acc)[i];
-
-#ifdef USE_AVX2
-  MINH_EST_LOOP(__m256i, _mm256_load_si256, _mm256_cmpeq_epi32,
-                _mm256_add_epi32, _mm256_set1_epi32)
-#elif defined USE_AVX
-  MINH_EST_LOOP(__m128i, _mm_load_si128, _mm_cmpeq_epi32, _mm_add_epi32,
-                _mm_set1_epi32)
-#else
-  for (size_t i = 0; i < n_registers; ++i) {
-    n_registers_eq += (a->registers[i] == b->registers[i]);
-  }
-#endif
-
-#undef MINH_EST_LOOP
-
-  return (float)n_registers_eq / (float)n_registers;
-}
-
-bool tw_minhash_equal(const struct tw_minhash *a, const struct tw_minhash *b)
-{
-  if (!a || !b || a->n_registers != b->n_registers) {
-    return false;
+  uint32_t lanes[sizeof(simd_t) / sizeof(uint32_t)];                           \
+  simd_storeu((simd_t *)lanes, acc);                                           \
+  for (size_t i = 0; i < TW_ARRAY_SIZE(lanes); i++)                            \
+    n_registers_eq -= lanes[i];
+
+#define MINH_EST_KERNEL(name, target, simd_t, simd_load, simd_cmpeq, simd_add, \
+                        simd_set1, simd_storeu)                                \
+  static target uint32_t name(const struct tw_minhash *a,                      \
+                              const struct tw_minhash *b)                      \
+  {                                                                            \
+    const uint32_t n_registers = a->n_registers;                               \
+    uint32_t n_registers_eq = 0;                                               \
+    MINH_EST_LOOP(simd_t, simd_load, simd_cmpeq, simd_add, simd_set1,          \
+                  simd_storeu)                                                 \
+    return n_registers_eq;                                                     \
   }
 
-  const uint32_t n_registers = a->n_registers;
-
 #define MINH_EQ_LOOP(simd_t, simd_load, simd_equal)                            \
   const size_t n_vectors =                                                     \
       n_registers * TW_BYTES_PER_MINHASH_REGISTER / sizeof(simd_t);            \
@@ -184,57 +184,212 @@ bool tw_minhash_equal(const struct tw_minhash *a, const struct tw_minhash *b)
     }                                                                          \
   }
 
-#ifdef USE_AVX2
-  MINH_EQ_LOOP(__m256i, _mm256_load_si256, tw_mm256_equal)
-#elif defined USE_AVX
-  MINH_EQ_LOOP(__m128i, _mm_load_si128, tw_mm_equal)
-#else
+#define MINH_EQ_KERNEL(name, target, simd_t, simd_load, simd_equal)            \
+  static target bool name(const struct tw_minhash *a,                          \
+                          const struct tw_minhash *b)                          \
+  {                                                                            \
+    const uint32_t n_registers = a->n_registers;                               \
+    MINH_EQ_LOOP(simd_t, simd_load, simd_equal)                                \
+    return true;                                                               \
+  }
+
+#define MINH_MAX_LOOP(simd_t, simd_load, simd_max, simd_store)                 \
+  const size_t n_vectors =                                                     \
+      n_registers * TW_BYTES_PER_MINHASH_REGISTER / sizeof(simd_t);            \
+  for (size_t i = 0; i < n_vectors; ++i) {                                     \
+    simd_t *src_vec = (simd_t *)src->registers + i,                            \
+           *dst_vec = (simd_t *)dst->registers + i;                            \
+    const simd_t res = simd_max(simd_load(src_vec), simd_load(dst_vec));       \
+    simd_store(dst_vec, res);                                                  \
+  }
+
+#define MINH_MAX_KERNEL(name, target, simd_t, simd_load, simd_max, simd_store) \
+  static target void name(const struct tw_minhash *src,                        \
+                          struct tw_minhash *dst)                              \
+  {                                                                            \
+    const uint32_t n_registers = src->n_registers;                             \
+    MINH_MAX_LOOP(simd_t, simd_load, simd_max, simd_store)                     \
+  }
+
+static void tw_minhash_add_port(struct tw_minhash *hash, uint32_t a,
+                                uint32_t b)
+{
+  const uint32_t n_registers = hash->n_registers;
+
+  for (size_t i = 0; i < n_registers; ++i) {
+    const uint32_t hashed_i = a + i * b;
+    hash->registers[i] = tw_max(hash->registers[i], hashed_i);
+  }
+}
+
+static uint32_t tw_minhash_estimate_port(const struct tw_minhash *a,
+                                         const struct tw_minhash *b)
+{
+  const uint32_t n_registers = a->n_registers;
+  uint32_t n_registers_eq = 0;
+
+  for (size_t i = 0; i < n_registers; ++i) {
+    n_registers_eq += (a->registers[i] == b->registers[i]);
+  }
+
+  return n_registers_eq;
+}
+
+static bool tw_minhash_equal_port(const struct tw_minhash *a,
+                                  const struct tw_minhash *b)
+{
+  const uint32_t n_registers = a->n_registers;
+
   for (size_t i = 0; i < n_registers; ++i) {
     if (a->registers[i] != b->registers[i]) {
       return false;
     }
   }
+
+  return true;
+}
+
+static void tw_minhash_merge_port(const struct tw_minhash *src,
+                                  struct tw_minhash *dst)
+{
+  const uint32_t n_registers = src->n_registers;
+
+  for (size_t i = 0; i < n_registers; ++i) {
+    dst->registers[i] = tw_max(dst->registers[i], src->registers[i]);
+  }
+}
+
+#ifdef USE_AVX
+MINH_ADD_KERNEL(tw_minhash_add_avx, TW_TARGET_AVX, __m128i, _mm_loadu_si128,
+                _mm_add_epi32, _mm_max_epu32, _mm_storeu_si128,
+                _mm_set1_epi32)
+MINH_EST_KERNEL(tw_minhash_estimate_avx, TW_TARGET_AVX, __m128i,
+                _mm_load_si128, _mm_cmpeq_epi32, _mm_add_epi32,
+                _mm_set1_epi32, _mm_storeu_si128)
+MINH_EQ_KERNEL(tw_minhash_equal_avx, TW_TARGET_AVX, __m128i, _mm_load_si128,
+               tw_mm_equal)
+MINH_MAX_KERNEL(tw_minhash_merge_avx, TW_TARGET_AVX, __m128i, _mm_load_si128,
+                _mm_max_epu32, _mm_store_si128)
+#endif
+
+#ifdef USE_AVX2
+MINH_ADD_KERNEL(tw_minhash_add_avx2, TW_TARGET_AVX2, __m256i,
+                _mm256_loadu_si256, _mm256_add_epi32, _mm256_max_epu32,
+                _mm256_storeu_si256, _mm256_set1_epi32)
+MINH_EST_KERNEL(tw_minhash_estimate_avx2, TW_TARGET_AVX2, __m256i,
+                _mm256_load_si256, _mm256_cmpeq_epi32, _mm256_add_epi32,
+                _mm256_set1_epi32, _mm256_storeu_si256)
+MINH_EQ_KERNEL(tw_minhash_equal_avx2, TW_TARGET_AVX2, __m256i,
+               _mm256_load_si256, tw_mm256_equal)
+MINH_MAX_KERNEL(tw_minhash_merge_avx2, TW_TARGET_AVX2, __m256i,
+                _mm256_load_si256, _mm256_max_epu32, _mm256_store_si256)
+#endif
+
+#ifdef USE_AVX512
+MINH_MAX_KERNEL(tw_minhash_merge_avx512, TW_TARGET_AVX512, __m512i,
+                _mm512_load_si512, _mm512_max_epu32, _mm512_store_si512)
 #endif
 
+#undef MINH_ADD_LOOP
+#undef MINH_ADD_KERNEL
+#undef MINH_EST_LOOP
+#undef MINH_EST_KERNEL
 #undef MINH_EQ_LOOP
+#undef MINH_EQ_KERNEL
+#undef MINH_MAX_LOOP
+#undef MINH_MAX_KERNEL
+
+struct tw_minhash_kernels {
+  void (*add)(struct tw_minhash *hash, uint32_t a, uint32_t b);
+  uint32_t (*estimate)(const struct tw_minhash *a, const struct tw_minhash *b);
+  bool (*equal)(const struct tw_minhash *a, const struct tw_minhash *b);
+  void (*merge)(const struct tw_minhash *src, struct tw_minhash *dst);
+};
+
+#define TW_MINHASH_KERNELS(isa)                                                \
+  {                                                                            \
+    .add = tw_minhash_add_##isa, .estimate = tw_minhash_estimate_##isa,        \
+    .equal = tw_minhash_equal_##isa, .merge = tw_minhash_merge_##isa,          \
+  }
 
-  return true;
+/* AVX512 only has a merge kernel, others fallback to AVX2. */
+static const struct tw_minhash_kernels tw_minhash_kernels[TW_SIMD_LEVELS] = {
+    [TW_SIMD_PORTABLE] = TW_MINHASH_KERNELS(port),
+#ifdef USE_AVX
+    [TW_SIMD_AVX] = TW_MINHASH_KERNELS(avx),
+#endif
+#ifdef USE_AVX2
+    [TW_SIMD_AVX2] = TW_MINHASH_KERNELS(avx2),
+#endif
+#ifdef USE_AVX512
+    [TW_SIMD_AVX512] =
+        {
+            .add = tw_minhash_add_avx2,
+            .estimate = tw_minhash_estimate_avx2,
+            .equal = tw_minhash_equal_avx2,
+            .merge = tw_minhash_merge_avx512,
+        },
+#endif
+#ifdef USE_AVX512_ICL
+    [TW_SIMD_AVX512_ICL] =
+        {
+            .add = tw_minhash_add_avx2,
+            .estimate = tw_minhash_estimate_avx2,
+            .equal = tw_minhash_equal_avx2,
+            .merge = tw_minhash_merge_avx512,
+        },
+#endif
+};
+
+static inline const struct tw_minhash_kernels *tw_minhash_kernels_(void)
+{
+  return &tw_minhash_kernels[tw_simd_level()];
 }
 
-struct tw_minhash *tw_minhash_merge(const struct tw_minhash *src,
-                                    struct tw_minhash *dst)
+void tw_minhash_add(struct tw_minhash *hash, const void *key, size_t key_size)
 {
-  if (!src || !dst || src->n_registers != dst->n_registers) {
-    return NULL;
+  if (!hash || !key || !key_size) {
+    return;
   }
 
-  const uint32_t n_registers = src->n_registers;
+  const uint64_t hashed =
+      tw_metrohash_64(TW_MINHASH_DEFAULT_SEED, key, key_size);
 
-#define MINH_MAX_LOOP(simd_t, simd_load, simd_max, simd_store)                 \
-  const size_t n_vectors =                                                     \
-      n_registers * TW_BYTES_PER_MINHASH_REGISTER / sizeof(simd_t);            \
-  for (size_t i = 0; i < n_vectors; ++i) {                                     \
-    simd_t *src_vec = (simd_t *)src->registers + i,                            \
-           *dst_vec = (simd_t *)dst->registers + i;                            \
-    const simd_t res = simd_max(simd_load(src_vec), simd_load(dst_vec));       \
-    simd_store(dst_vec, res);                                                  \
+  const uint32_t a = (uint32_t)hashed;
+  const uint32_t b = (uint32_t)(hashed >> 32);
+
+  tw_minhash_kernels_()->add(hash, a, b);
+}
+
+float tw_minhash_estimate(const struct tw_minhash *a,
+                          const struct tw_minhash *b)
+{
+  if (!a || !b || a->n_registers != b->n_registers) {
+    return 0.0f;
   }
 
-#ifdef USE_AVX512
-  MINH_MAX_LOOP(__m512i, _mm512_load_si512, _mm512_max_epu32,
-                _mm512_store_si512)
-#elif defined USE_AVX2
-  MINH_MAX_LOOP(__m256i, _mm256_load_si256, _mm256_max_epu32,
-                _mm256_store_si256)
-#elif defined USE_AVX
-  MINH_MAX_LOOP(__m128i, _mm_load_si128, _mm_max_epu32, _mm_store_si128)
-#else
-  for (size_t i = 0; i < n_registers; ++i) {
-    dst->registers[i] = tw_max(dst->registers[i], src->registers[i]);
+  const uint32_t n_registers_eq = tw_minhash_kernels_()->estimate(a, b);
+
+  return (float)n_registers_eq / (float)a->n_registers;
+}
+
+bool tw_minhash_equal(const struct tw_minhash *a, const struct tw_minhash *b)
+{
+  if (!a || !b || a->n_registers != b->n_registers) {
+    return false;
   }
-#endif
 
-#undef MINH_MAX_LOOP
+  return tw_minhash_kernels_()->equal(a, b);
+}
+
+struct tw_minhash *tw_minhash_merge(const struct tw_minhash *src,
+                                    struct tw_minhash *dst)
+{
+  if (!src || !dst || src->n_registers != dst->n_registers) {
+    return NULL;
+  }
+
+  tw_minhash_kernels_()->merge(src, dst);
 
   return dst;
 }
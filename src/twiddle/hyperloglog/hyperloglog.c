@@ -5,8 +5,10 @@
 
 #include <twiddle/hyperloglog/hyperloglog.h>
 #include <twiddle/utils/hash.h>
+#include <twiddle/utils/simd.h>
 
 #include "../macrology.h"
+#include "../utils/pages.h"
 #include "hyperloglog_simd.c"
 
 #define TW_BYTES_PER_HLL_REGISTER sizeof(uint8_t)
@@ -22,7 +24,13 @@ static_assert(TW_HLL_MAX_PRECISION < 64,
 
 struct tw_hyperloglog *tw_hyperloglog_new(uint8_t precision)
 {
-  if (precision < TW_HLL_MIN_PRECISION || precision > TW_HLL_MAX_PRECISION) {
+  return tw_hyperloglog_new_flags(precision, TW_ALLOC_DEFAULT);
+}
+
+struct tw_hyperloglog *tw_hyperloglog_new_flags(uint8_t precision, int flags)
+{
+  if (precision < TW_HLL_MIN_PRECISION || precision > TW_HLL_MAX_PRECISION ||
+      (flags & TW_ALLOC_WRAPPED)) {
     return NULL;
   }
 
@@ -33,13 +41,42 @@ struct tw_hyperloglog *tw_hyperloglog_new(uint8_t precision)
 
   size_t alloc_size = TW_ALLOC_TO_CACHELINE(1 << precision) * sizeof(uint8_t);
 
-  if ((hll->registers = malloc_aligned(TW_CACHELINE, alloc_size)) == NULL) {
-    free(hll);
+  if (flags != TW_ALLOC_DEFAULT) {
+    /* mapped pages are already zeroed */
+    if ((hll->registers = tw_pages_alloc(alloc_size, flags)) == NULL) {
+      free(hll);
+      return NULL;
+    }
+  } else {
+    if ((hll->registers = malloc_aligned(TW_CACHELINE, alloc_size)) == NULL) {
+      free(hll);
+      return NULL;
+    }
+    memset(hll->registers, 0, alloc_size);
+  }
+
+  hll->precision = precision;
+  hll->flags = flags;
+
+  return hll;
+}
+
+struct tw_hyperloglog *tw_hyperloglog_wrap(void *registers, uint8_t precision)
+{
+  if (!registers || (uintptr_t)registers % TW_CACHELINE ||
+      precision < TW_HLL_MIN_PRECISION || precision > TW_HLL_MAX_PRECISION) {
+    return NULL;
+  }
+
+  struct tw_hyperloglog *hll = calloc(1, sizeof(struct tw_hyperloglog));
+  if (!hll) {
     return NULL;
   }
 
-  memset(hll->registers, 0, alloc_size);
+  /* registers are a multiple of cache lines, see `TW_HLL_MIN_PRECISION` */
+  hll->registers = registers;
   hll->precision = precision;
+  hll->flags = TW_ALLOC_WRAPPED;
 
   return hll;
 }
@@ -50,7 +87,15 @@ void tw_hyperloglog_free(struct tw_hyperloglog *hll)
     return;
   }
 
-  free(hll->registers);
+  if (hll->flags & TW_ALLOC_WRAPPED) {
+    /* registers are owned by the caller */
+  } else if (hll->flags != TW_ALLOC_DEFAULT) {
+    tw_pages_free(hll->registers,
+                  TW_ALLOC_TO_CACHELINE(1 << hll->precision) * sizeof(uint8_t),
+                  hll->flags);
+  } else {
+    free(hll->registers);
+  }
   free(hll);
 }
 
@@ -105,20 +150,6 @@ void tw_hyperloglog_add(struct tw_hyperloglog *hll, const void *key,
 
 extern double estimate(uint8_t precision, uint32_t n_zeros, float inverse_sum);
 
-#ifdef USE_AVX2
-extern void hyperloglog_count_avx2(const uint8_t *registers,
-                                   uint32_t n_registers, float *inverse_sum,
-                                   uint32_t *n_zeros);
-#elif defined USE_AVX
-extern void hyperloglog_count_avx(const uint8_t *registers,
-                                  uint32_t n_registers, float *inverse_sum,
-                                  uint32_t *n_zeros);
-#else
-extern void hyperloglog_count_port(const uint8_t *registers,
-                                   uint32_t n_registers, float *inverse_sum,
-                                   uint32_t *n_zeros);
-#endif
-
 double tw_hyperloglog_count(const struct tw_hyperloglog *hll)
 {
   if (!hll) {
@@ -130,32 +161,12 @@ double tw_hyperloglog_count(const struct tw_hyperloglog *hll)
   uint32_t n_zeros = 0;
   float inverse_sum = 0.0;
 
-#ifdef USE_AVX2
-  hyperloglog_count_avx2(hll->registers, n_registers, &inverse_sum, &n_zeros);
-#elif defined USE_AVX
-  hyperloglog_count_avx(hll->registers, n_registers, &inverse_sum, &n_zeros);
-#else
-  hyperloglog_count_port(hll->registers, n_registers, &inverse_sum, &n_zeros);
-#endif
+  hyperloglog_count_kernels[tw_simd_level()](hll->registers, n_registers,
+                                             &inverse_sum, &n_zeros);
 
   return estimate(precision, n_zeros, inverse_sum);
 }
 
-bool tw_hyperloglog_equal(const struct tw_hyperloglog *fst,
-                          const struct tw_hyperloglog *snd)
-{
-  if (!fst || !snd) {
-    return false;
-  }
-
-  const uint8_t precision = fst->precision;
-
-  if (precision != snd->precision) {
-    return false;
-  }
-
-  const uint32_t n_registers = 1 << precision;
-
 #define HLL_EQ_LOOP(simd_t, simd_load, simd_equal)                             \
   for (size_t i = 0; i < n_registers / (sizeof(simd_t)); ++i) {                \
     simd_t *fst_addr = (simd_t *)fst->registers + i,                           \
@@ -165,55 +176,137 @@ bool tw_hyperloglog_equal(const struct tw_hyperloglog *fst,
     }                                                                          \
   }
 
-/* AVX512 does not have movemask_epi8 equivalent, fallback to AVX2 */
-#ifdef USE_AVX2
-  HLL_EQ_LOOP(__m256i, _mm256_load_si256, tw_mm256_equal)
-#elif defined USE_AVX
-  HLL_EQ_LOOP(__m128i, _mm_load_si128, tw_mm_equal)
-#else
+#define HLL_EQ_KERNEL(name, target, simd_t, simd_load, simd_equal)             \
+  static target bool name(const struct tw_hyperloglog *fst,                    \
+                          const struct tw_hyperloglog *snd)                    \
+  {                                                                            \
+    const uint32_t n_registers = 1 << fst->precision;                          \
+    HLL_EQ_LOOP(simd_t, simd_load, simd_equal)                                 \
+    return true;                                                               \
+  }
+
+#define HLL_MAX_LOOP(simd_t, simd_load, simd_max, simd_store)                  \
+  for (size_t i = 0; i < n_registers / sizeof(simd_t); ++i) {                  \
+    simd_t *src_vec = (simd_t *)src->registers + i,                            \
+           *dst_vec = (simd_t *)dst->registers + i;                            \
+    const simd_t res = simd_max(simd_load(src_vec), simd_load(dst_vec));       \
+    simd_store(dst_vec, res);                                                  \
+  }
+
+#define HLL_MAX_KERNEL(name, target, simd_t, simd_load, simd_max, simd_store)  \
+  static target void name(const struct tw_hyperloglog *src,                    \
+                          struct tw_hyperloglog *dst)                          \
+  {                                                                            \
+    const uint32_t n_registers = 1 << src->precision;                          \
+    HLL_MAX_LOOP(simd_t, simd_load, simd_max, simd_store)                      \
+  }
+
+static bool tw_hyperloglog_equal_port(const struct tw_hyperloglog *fst,
+                                      const struct tw_hyperloglog *snd)
+{
+  const uint32_t n_registers = 1 << fst->precision;
+
   for (size_t i = 0; i < n_registers; ++i) {
     if (fst->registers[i] != snd->registers[i]) {
       return false;
     }
   }
-#endif
-
-#undef HLL_EQ_LOOP
 
   return true;
 }
 
-struct tw_hyperloglog *tw_hyperloglog_merge(const struct tw_hyperloglog *src,
-                                            struct tw_hyperloglog *dst)
+static void tw_hyperloglog_merge_port(const struct tw_hyperloglog *src,
+                                      struct tw_hyperloglog *dst)
 {
-  if (!src || !dst || src->precision != dst->precision) {
-    return NULL;
+  const uint32_t n_registers = 1 << src->precision;
+
+  for (size_t i = 0; i < n_registers; ++i) {
+    dst->registers[i] = tw_max(src->registers[i], dst->registers[i]);
   }
+}
 
-  const uint8_t precision = src->precision;
-  const uint32_t n_registers = 1 << precision;
+#ifdef USE_AVX
+HLL_EQ_KERNEL(tw_hyperloglog_equal_avx, TW_TARGET_AVX, __m128i,
+              _mm_load_si128, tw_mm_equal)
+HLL_MAX_KERNEL(tw_hyperloglog_merge_avx, TW_TARGET_AVX, __m128i,
+               _mm_load_si128, _mm_max_epu8, _mm_store_si128)
+#endif
 
-#define HLL_MAX_LOOP(simd_t, simd_load, simd_max, simd_store)                  \
-  for (size_t i = 0; i < n_registers / sizeof(simd_t); ++i) {                  \
-    simd_t *src_vec = (simd_t *)src->registers + i,                            \
-           *dst_vec = (simd_t *)dst->registers + i;                            \
-    const simd_t res = simd_max(simd_load(src_vec), simd_load(dst_vec));       \
-    simd_store(dst_vec, res);                                                  \
-  }
+#ifdef USE_AVX2
+HLL_EQ_KERNEL(tw_hyperloglog_equal_avx2, TW_TARGET_AVX2, __m256i,
+              _mm256_load_si256, tw_mm256_equal)
+HLL_MAX_KERNEL(tw_hyperloglog_merge_avx2, TW_TARGET_AVX2, __m256i,
+               _mm256_load_si256, _mm256_max_epu8, _mm256_store_si256)
+#endif
 
 #ifdef USE_AVX512
-  HLL_MAX_LOOP(__m512i, _mm512_load_si512, _mm512_max_epu8, _mm512_store_si512)
-#elif defined USE_AVX2
-  HLL_MAX_LOOP(__m256i, _mm256_load_si256, _mm256_max_epu8, _mm256_store_si256)
-#elif defined USE_AVX
-  HLL_MAX_LOOP(__m128i, _mm_load_si128, _mm_max_epu8, _mm_store_si128)
-#else
-  for (size_t i = 0; i < n_registers; ++i) {
-    dst->registers[i] = tw_max(src->registers[i], dst->registers[i]);
-  }
+HLL_EQ_KERNEL(tw_hyperloglog_equal_avx512, TW_TARGET_AVX512, __m512i,
+              _mm512_load_si512, tw_mm512_equal)
+HLL_MAX_KERNEL(tw_hyperloglog_merge_avx512, TW_TARGET_AVX512, __m512i,
+               _mm512_load_si512, _mm512_max_epu8, _mm512_store_si512)
 #endif
 
+#undef HLL_EQ_LOOP
+#undef HLL_EQ_KERNEL
 #undef HLL_MAX_LOOP
+#undef HLL_MAX_KERNEL
+
+struct tw_hyperloglog_kernels {
+  bool (*equal)(const struct tw_hyperloglog *fst,
+                const struct tw_hyperloglog *snd);
+  void (*merge)(const struct tw_hyperloglog *src, struct tw_hyperloglog *dst);
+};
+
+#define TW_HLL_KERNELS(isa)                                                    \
+  {                                                                            \
+    .equal = tw_hyperloglog_equal_##isa, .merge = tw_hyperloglog_merge_##isa,  \
+  }
+
+static const struct tw_hyperloglog_kernels
+    tw_hyperloglog_kernels[TW_SIMD_LEVELS] = {
+        [TW_SIMD_PORTABLE] = TW_HLL_KERNELS(port),
+#ifdef USE_AVX
+        [TW_SIMD_AVX] = TW_HLL_KERNELS(avx),
+#endif
+#ifdef USE_AVX2
+        [TW_SIMD_AVX2] = TW_HLL_KERNELS(avx2),
+#endif
+#ifdef USE_AVX512
+        [TW_SIMD_AVX512] = TW_HLL_KERNELS(avx512),
+#endif
+#ifdef USE_AVX512_ICL
+        [TW_SIMD_AVX512_ICL] = TW_HLL_KERNELS(avx512),
+#endif
+};
+
+static inline const struct tw_hyperloglog_kernels *
+tw_hyperloglog_kernels_(void)
+{
+  return &tw_hyperloglog_kernels[tw_simd_level()];
+}
+
+bool tw_hyperloglog_equal(const struct tw_hyperloglog *fst,
+                          const struct tw_hyperloglog *snd)
+{
+  if (!fst || !snd) {
+    return false;
+  }
+
+  if (fst->precision != snd->precision) {
+    return false;
+  }
+
+  return tw_hyperloglog_kernels_()->equal(fst, snd);
+}
+
+struct tw_hyperloglog *tw_hyperloglog_merge(const struct tw_hyperloglog *src,
+                                            struct tw_hyperloglog *dst)
+{
+  if (!src || !dst || src->precision != dst->precision) {
+    return NULL;
+  }
+
+  tw_hyperloglog_kernels_()->merge(src, dst);
 
   return dst;
 }
@@ -2,10 +2,17 @@
 #include <x86intrin.h>
 
 #include <twiddle/hyperloglog/hyperloglog.h>
+#include <twiddle/utils/simd.h>
+
+#include "../macrology.h"
+
+typedef void (*hyperloglog_count_fn)(const uint8_t *registers,
+                                     uint32_t n_registers, float *inverse_sum,
+                                     uint32_t *n_zeros);
 
 #ifdef USE_AVX2
 /* http://stackoverflow.com/questions/13219146/how-to-sum-m256-horizontally */
-static inline float horizontal_sum_avx2(__m256 x)
+static inline TW_TARGET_AVX2 float horizontal_sum_avx2(__m256 x)
 {
   const __m128 hi_quad = _mm256_extractf128_ps(x, 1);
   const __m128 lo_quad = _mm256_castps256_ps128(x);
@@ -26,9 +33,9 @@ static inline float horizontal_sum_avx2(__m256 x)
 #define inverse_power_avx2(simd)                                               \
   _mm256_sub_epi32(ones, _mm256_slli_epi32(_mm256_cvtepu8_epi32(simd), 23))
 
-static inline void hyperloglog_count_avx2(const uint8_t *registers,
-                                          uint32_t n_registers,
-                                          float *inverse_sum, uint32_t *n_zeros)
+static inline TW_TARGET_AVX2 void
+hyperloglog_count_avx2(const uint8_t *registers, uint32_t n_registers,
+                       float *inverse_sum, uint32_t *n_zeros)
 {
   const __m256i ones = (__m256i)_mm256_set1_ps(1.0f);
   __m256 agg = _mm256_set1_ps(0.0f);
@@ -56,10 +63,10 @@ static inline void hyperloglog_count_avx2(const uint8_t *registers,
 
   *inverse_sum = horizontal_sum_avx2(agg);
 }
+#endif
 
-#elif defined USE_AVX
-
-static inline float horizontal_sum_avx(__m128 x)
+#ifdef USE_AVX
+static inline TW_TARGET_AVX float horizontal_sum_avx(__m128 x)
 {
   x = _mm_hadd_ps(x, x);
   x = _mm_hadd_ps(x, x);
@@ -73,9 +80,9 @@ static inline float horizontal_sum_avx(__m128 x)
 #define inverse_power_avx(simd)                                                \
   _mm_sub_epi32(ones, _mm_slli_epi32(_mm_cvtepu8_epi32(simd), 23))
 
-static inline void hyperloglog_count_avx(const uint8_t *registers,
-                                         uint32_t n_registers,
-                                         float *inverse_sum, uint32_t *n_zeros)
+static inline TW_TARGET_AVX void
+hyperloglog_count_avx(const uint8_t *registers, uint32_t n_registers,
+                      float *inverse_sum, uint32_t *n_zeros)
 {
   const __m128i ones = (__m128i)_mm_set1_ps(1.0f);
   __m128 agg = _mm_set1_ps(0.0f);
@@ -100,7 +107,6 @@ static inline void hyperloglog_count_avx(const uint8_t *registers,
 
   *inverse_sum = horizontal_sum_avx(agg);
 }
-
 #endif
 
 static inline void hyperloglog_count_port(const uint8_t *registers,
@@ -116,3 +122,20 @@ static inline void hyperloglog_count_port(const uint8_t *registers,
     }
   }
 }
+
+/* There is no AVX512 kernel, fallback to AVX2. */
+static const hyperloglog_count_fn hyperloglog_count_kernels[TW_SIMD_LEVELS] = {
+    [TW_SIMD_PORTABLE] = hyperloglog_count_port,
+#ifdef USE_AVX
+    [TW_SIMD_AVX] = hyperloglog_count_avx,
+#endif
+#ifdef USE_AVX2
+    [TW_SIMD_AVX2] = hyperloglog_count_avx2,
+#endif
+#ifdef USE_AVX512
+    [TW_SIMD_AVX512] = hyperloglog_count_avx2,
+#endif
+#ifdef USE_AVX512_ICL
+    [TW_SIMD_AVX512_ICL] = hyperloglog_count_avx2,
+#endif
+};
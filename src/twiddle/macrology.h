@@ -57,6 +57,20 @@ static_assert(false, "you're in hell.");
 #endif
 #endif
 
+/**
+ * Kernels are compiled for each enabled instruction set with the following
+ * function attributes, and selected at runtime with `tw_simd_level()`. A
+ * kernel must only be invoked when its level is smaller or equal to the
+ * selected level.
+ */
+#define TW_TARGET_AVX __attribute__((target("avx,popcnt")))
+#define TW_TARGET_AVX2 __attribute__((target("avx2,bmi,bmi2,popcnt")))
+#define TW_TARGET_AVX512                                                       \
+  __attribute__((target("avx512f,avx512bw,avx2,bmi,bmi2,popcnt")))
+#define TW_TARGET_AVX512_ICL                                                   \
+  __attribute__((target("avx512f,avx512bw,avx512vpopcntdq,avx512bitalg,"      \
+                        "avx512vbmi2,avx2,bmi,bmi2,popcnt")))
+
 #define tw_simd_equal(a, b, simd_cmpeq, simd_maskmove, mask)                   \
   ((int)mask == simd_maskmove(simd_cmpeq((a), (b))))
 
@@ -66,4 +80,40 @@ static_assert(false, "you're in hell.");
 #define tw_mm_equal(a, b)                                                      \
   tw_simd_equal((a), (b), _mm_cmpeq_epi8, _mm_movemask_epi8, 0xFFFF)
 
+/* AVX512 has no movemask, but comparisons directly yield a mask */
+#define tw_mm512_equal(a, b) (_mm512_cmpneq_epi64_mask((a), (b)) == 0)
+
+/* use with care, it evaluates twice v */
+#define tw_mm_zero(v) _mm_testz_si128((v), (v))
+#define tw_mm256_zero(v) _mm256_testz_si256((v), (v))
+#define tw_mm512_zero(v) (_mm512_test_epi64_mask((v), (v)) == 0)
+
+#define tw_mm_full(v) _mm_test_all_ones((v))
+#define tw_mm256_full(v) _mm256_testc_si256((v), _mm256_set1_epi8(-1))
+#define tw_mm512_full(v)                                                       \
+  (_mm512_cmpneq_epi64_mask((v), _mm512_set1_epi64(-1)) == 0)
+
+/* `(a & b) == 0` and `(a & ~b) == 0`, i.e. testz and testc */
+#define tw_mm_disjoint(a, b) _mm_testz_si128((a), (b))
+#define tw_mm256_disjoint(a, b) _mm256_testz_si256((a), (b))
+#define tw_mm512_disjoint(a, b) (_mm512_test_epi64_mask((a), (b)) == 0)
+
+#define tw_mm_subset(a, b) _mm_testc_si128((b), (a))
+#define tw_mm256_subset(a, b) _mm256_testc_si256((b), (a))
+#define tw_mm512_subset(a, b)                                                  \
+  (_mm512_test_epi64_mask(_mm512_andnot_si512((b), (a)),                       \
+                          _mm512_set1_epi64(-1)) == 0)
+
+/* `a & ~b`, the intrinsics negate their first operand */
+#define tw_mm_andnot(a, b) _mm_andnot_si128((b), (a))
+#define tw_mm256_andnot(a, b) _mm256_andnot_si256((b), (a))
+#define tw_mm512_andnot(a, b) _mm512_andnot_si512((b), (a))
+
+/* `a | ~b`, a single ternary logic instruction with AVX512 */
+#define tw_mm_ornot(a, b)                                                      \
+  _mm_or_si128((a), _mm_xor_si128((b), _mm_set1_epi8(-1)))
+#define tw_mm256_ornot(a, b)                                                   \
+  _mm256_or_si256((a), _mm256_xor_si256((b), _mm256_set1_epi8(-1)))
+#define tw_mm512_ornot(a, b) _mm512_ternarylogic_epi64((a), (b), (b), 0xF3)
+
 #endif /* TWIDDLE_INTERNAL_UTILS_H */
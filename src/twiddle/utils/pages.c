@@ -0,0 +1,129 @@
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "pages.h"
+
+#define TW_PAGE_SIZE (1UL << 12)
+#define TW_HUGE_PAGE_SIZE (1UL << 21)
+
+#define TW_ALIGN_UP(x, align) (((x) + (align)-1) & ~((align)-1))
+
+/* see set_mempolicy(2), not exposed without libnuma */
+#define TW_MPOL_BIND 2
+#define TW_MPOL_INTERLEAVE 3
+#define TW_MPOL_F_MEMS_ALLOWED (1 << 2)
+
+/* large enough for any kernel's MAX_NUMNODES */
+#define TW_MAX_NODES 1024
+#define TW_BITS_PER_LONG (sizeof(unsigned long) * 8)
+
+size_t tw_pages_size(size_t size, int flags)
+{
+  const bool huge = flags & (TW_ALLOC_HUGE_PAGES | TW_ALLOC_HUGETLB);
+  return TW_ALIGN_UP(size, huge ? TW_HUGE_PAGE_SIZE : TW_PAGE_SIZE);
+}
+
+/* map `size` bytes aligned on `align` bytes, by trimming a larger mapping */
+static void *tw_pages_map_aligned(size_t size, size_t align)
+{
+  const size_t map_size = size + align;
+  char *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+
+  char *pages = (char *)TW_ALIGN_UP((uintptr_t)map, align);
+  if (pages > map) {
+    munmap(map, pages - map);
+  }
+  munmap(pages + size, map + map_size - (pages + size));
+
+  return pages;
+}
+
+/* apply the NUMA placement before any page is touched, failures are ignored */
+static void tw_pages_bind(void *pages, size_t size, int flags)
+{
+  unsigned long nodes[TW_MAX_NODES / TW_BITS_PER_LONG];
+  memset(nodes, 0, sizeof(nodes));
+  int mode;
+
+  if (flags & TW_ALLOC_BIND) {
+    const unsigned node = (unsigned)flags >> TW_ALLOC_NODE_SHIFT;
+    if (node >= TW_MAX_NODES) {
+      return;
+    }
+    nodes[node / TW_BITS_PER_LONG] = 1UL << (node % TW_BITS_PER_LONG);
+    mode = TW_MPOL_BIND;
+  } else if (flags & TW_ALLOC_INTERLEAVE) {
+    int unused;
+    if (syscall(SYS_get_mempolicy, &unused, nodes, TW_MAX_NODES, NULL,
+                TW_MPOL_F_MEMS_ALLOWED) != 0) {
+      return;
+    }
+    mode = TW_MPOL_INTERLEAVE;
+  } else {
+    return;
+  }
+
+  syscall(SYS_mbind, pages, size, mode, nodes, TW_MAX_NODES, 0);
+}
+
+void *tw_pages_alloc(size_t size, int flags)
+{
+  size = tw_pages_size(size, flags);
+  void *pages = NULL;
+
+  if (flags & TW_ALLOC_HUGETLB) {
+    pages = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    pages = (pages == MAP_FAILED) ? NULL : pages;
+  }
+
+  if (!pages && (flags & (TW_ALLOC_HUGE_PAGES | TW_ALLOC_HUGETLB))) {
+    /* only 2MB aligned ranges are backed by transparent huge pages */
+    if ((pages = tw_pages_map_aligned(size, TW_HUGE_PAGE_SIZE)) != NULL) {
+      madvise(pages, size, MADV_HUGEPAGE);
+    }
+  } else if (!pages) {
+    pages = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    pages = (pages == MAP_FAILED) ? NULL : pages;
+  }
+
+  if (pages) {
+    tw_pages_bind(pages, size, flags);
+  }
+
+  return pages;
+}
+
+void tw_pages_free(void *pages, size_t size, int flags)
+{
+  munmap(pages, tw_pages_size(size, flags));
+}
+
+void *tw_pages_remap(void *pages, size_t size, size_t new_size, int flags)
+{
+  void *remapped = mremap(pages, tw_pages_size(size, flags),
+                          tw_pages_size(new_size, flags), MREMAP_MAYMOVE);
+  if (remapped != MAP_FAILED) {
+    return remapped;
+  }
+
+  /* e.g. explicit huge pages on kernels not remapping them, copy instead */
+  if ((remapped = tw_pages_alloc(new_size, flags)) == NULL) {
+    return NULL;
+  }
+  memcpy(remapped, pages, size < new_size ? size : new_size);
+  tw_pages_free(pages, size, flags);
+
+  return remapped;
+}
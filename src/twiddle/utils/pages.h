@@ -0,0 +1,38 @@
+#ifndef TWIDDLE_UTILS_PAGES_H
+#define TWIDDLE_UTILS_PAGES_H
+
+#include <stddef.h>
+
+#include <twiddle/utils/alloc.h>
+
+/**
+ * Allocation flag of memory owned by the caller, set by the `*_wrap`
+ * constructors in place of `enum tw_alloc_flags`. Such memory is never freed,
+ * resized nor remapped. Private, the `*_new_flags` constructors reject it.
+ */
+#define TW_ALLOC_WRAPPED (1 << 30)
+
+/**
+ * Number of bytes mapped by `tw_pages_alloc` for `size` bytes, i.e. `size`
+ * rounded to the page size implied by `flags`.
+ */
+size_t tw_pages_size(size_t size, int flags);
+
+/**
+ * Map zeroed anonymous memory of `tw_pages_size(size, flags)` bytes, see
+ * `enum tw_alloc_flags`. Returns `NULL` if mapping failed.
+ */
+void *tw_pages_alloc(size_t size, int flags);
+
+/** Unmap memory returned by `tw_pages_alloc` with the same arguments. */
+void tw_pages_free(void *pages, size_t size, int flags);
+
+/**
+ * Resize memory returned by `tw_pages_alloc` to `tw_pages_size(new_size,
+ * flags)` bytes. Pages are moved rather than copied when the kernel allows
+ * it, and pages past the previous size are zeroed. Returns `NULL` if
+ * remapping failed, in which case `pages` is left untouched.
+ */
+void *tw_pages_remap(void *pages, size_t size, size_t new_size, int flags);
+
+#endif /* TWIDDLE_UTILS_PAGES_H */
@@ -0,0 +1,180 @@
+#ifndef TWIDDLE_UTILS_POPCOUNT_H
+#define TWIDDLE_UTILS_POPCOUNT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <x86intrin.h>
+
+#include "../macrology.h"
+
+/**
+ * Population count kernels over sequences of vectors.
+ *
+ * Each `TW_POPCNT_*(count, n_vectors, vec_fn, ...)` macro adds to `count` the
+ * number of active bits in the `n_vectors` vectors yielded by
+ * `vec_fn(..., i)` for `i` in `[0, n_vectors)`. Each vector is requested
+ * exactly once, in unspecified order, thus `vec_fn` may have side effects
+ * local to `i`, e.g. storing the result of a boolean operation before it is
+ * counted. This is how bitmap operations maintain their count without a
+ * second pass.
+ *
+ * The AVX2 and AVX512 kernels implement the Harley-Seal carry-save adder
+ * network described in [1], counting 16 vectors with a single vectorized
+ * popcount. The AVX512_ICL kernel uses the native VPOPCNTQ instruction.
+ *
+ * [1] Muła, Wojciech, Nathan Kurz, and Daniel Lemire. "Faster population
+ * counts using AVX2 instructions." The Computer Journal 61.1 (2018).
+ */
+
+#define TW_POPCNT_PORT(count, n_words, word_fn, ...)                           \
+  do {                                                                         \
+    for (size_t i_ = 0; i_ < (n_words); ++i_) {                                \
+      count += __builtin_popcountll(word_fn(__VA_ARGS__, i_));                 \
+    }                                                                          \
+  } while (0)
+
+#ifdef USE_AVX
+static inline TW_TARGET_AVX uint64_t tw_popcount_avx(__m128i v)
+{
+  return __builtin_popcountll(_mm_cvtsi128_si64(v)) +
+         __builtin_popcountll(_mm_extract_epi64(v, 1));
+}
+
+#define TW_POPCNT_AVX(count, n_vectors, vec_fn, ...)                           \
+  do {                                                                         \
+    for (size_t i_ = 0; i_ < (n_vectors); ++i_) {                              \
+      count += tw_popcount_avx(vec_fn(__VA_ARGS__, i_));                       \
+    }                                                                          \
+  } while (0)
+#endif
+
+#ifdef USE_AVX2
+/* Per 64 bits lane popcount via nibble lookup, see [1]. */
+static inline TW_TARGET_AVX2 __m256i tw_popcount_avx2(__m256i v)
+{
+  const __m256i lookup =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1,
+                       2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  const __m256i lo = _mm256_and_si256(v, low_mask);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  const __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                      _mm256_shuffle_epi8(lookup, hi));
+  return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+static inline TW_TARGET_AVX2 void tw_csa_avx2(__m256i *h, __m256i *l,
+                                              __m256i a, __m256i b, __m256i c)
+{
+  const __m256i u = _mm256_xor_si256(a, b);
+  *h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+  *l = _mm256_xor_si256(u, c);
+}
+
+static inline TW_TARGET_AVX2 uint64_t tw_reduce_add_avx2(__m256i v)
+{
+  return _mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1) +
+         _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3);
+}
+#endif
+
+#ifdef USE_AVX512
+static inline TW_TARGET_AVX512 __m512i tw_popcount_avx512(__m512i v)
+{
+  const __m512i lookup = _mm512_broadcast_i32x4(
+      _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+  const __m512i low_mask = _mm512_set1_epi8(0x0f);
+  const __m512i lo = _mm512_and_si512(v, low_mask);
+  const __m512i hi = _mm512_and_si512(_mm512_srli_epi16(v, 4), low_mask);
+  const __m512i cnt = _mm512_add_epi8(_mm512_shuffle_epi8(lookup, lo),
+                                      _mm512_shuffle_epi8(lookup, hi));
+  return _mm512_sad_epu8(cnt, _mm512_setzero_si512());
+}
+
+/* majority and parity of three vectors, each a single VPTERNLOGQ */
+static inline TW_TARGET_AVX512 void tw_csa_avx512(__m512i *h, __m512i *l,
+                                                  __m512i a, __m512i b,
+                                                  __m512i c)
+{
+  *h = _mm512_ternarylogic_epi64(a, b, c, 0xE8);
+  *l = _mm512_ternarylogic_epi64(a, b, c, 0x96);
+}
+#endif
+
+/**
+ * Harley-Seal network over 16 vectors, shared by AVX2 and AVX512. `simd`
+ * is the kernel suffix, `add` adds 64 bits lanes and `slli` shifts them.
+ */
+#define TW_POPCNT_HARLEY_SEAL(simd, simd_t, zero, add, slli, count, n_vectors, \
+                              vec_fn, ...)                                     \
+  do {                                                                         \
+    simd_t total_ = zero(), ones_ = zero(), twos_ = zero(), fours_ = zero(),   \
+           eights_ = zero(), sixteens_;                                        \
+    simd_t twos_a_, twos_b_, fours_a_, fours_b_, eights_a_, eights_b_;         \
+    size_t i_ = 0;                                                             \
+    for (; i_ + 16 <= (n_vectors); i_ += 16) {                                 \
+      tw_csa_##simd(&twos_a_, &ones_, ones_, vec_fn(__VA_ARGS__, i_),          \
+                    vec_fn(__VA_ARGS__, i_ + 1));                              \
+      tw_csa_##simd(&twos_b_, &ones_, ones_, vec_fn(__VA_ARGS__, i_ + 2),      \
+                    vec_fn(__VA_ARGS__, i_ + 3));                              \
+      tw_csa_##simd(&fours_a_, &twos_, twos_, twos_a_, twos_b_);               \
+      tw_csa_##simd(&twos_a_, &ones_, ones_, vec_fn(__VA_ARGS__, i_ + 4),      \
+                    vec_fn(__VA_ARGS__, i_ + 5));                              \
+      tw_csa_##simd(&twos_b_, &ones_, ones_, vec_fn(__VA_ARGS__, i_ + 6),      \
+                    vec_fn(__VA_ARGS__, i_ + 7));                              \
+      tw_csa_##simd(&fours_b_, &twos_, twos_, twos_a_, twos_b_);               \
+      tw_csa_##simd(&eights_a_, &fours_, fours_, fours_a_, fours_b_);          \
+      tw_csa_##simd(&twos_a_, &ones_, ones_, vec_fn(__VA_ARGS__, i_ + 8),      \
+                    vec_fn(__VA_ARGS__, i_ + 9));                              \
+      tw_csa_##simd(&twos_b_, &ones_, ones_, vec_fn(__VA_ARGS__, i_ + 10),     \
+                    vec_fn(__VA_ARGS__, i_ + 11));                             \
+      tw_csa_##simd(&fours_a_, &twos_, twos_, twos_a_, twos_b_);               \
+      tw_csa_##simd(&twos_a_, &ones_, ones_, vec_fn(__VA_ARGS__, i_ + 12),     \
+                    vec_fn(__VA_ARGS__, i_ + 13));                             \
+      tw_csa_##simd(&twos_b_, &ones_, ones_, vec_fn(__VA_ARGS__, i_ + 14),     \
+                    vec_fn(__VA_ARGS__, i_ + 15));                             \
+      tw_csa_##simd(&fours_b_, &twos_, twos_, twos_a_, twos_b_);               \
+      tw_csa_##simd(&eights_b_, &fours_, fours_, fours_a_, fours_b_);          \
+      tw_csa_##simd(&sixteens_, &eights_, eights_, eights_a_, eights_b_);      \
+      total_ = add(total_, tw_popcount_##simd(sixteens_));                     \
+    }                                                                          \
+    total_ = slli(total_, 4);                                                  \
+    total_ = add(total_, slli(tw_popcount_##simd(eights_), 3));                \
+    total_ = add(total_, slli(tw_popcount_##simd(fours_), 2));                 \
+    total_ = add(total_, slli(tw_popcount_##simd(twos_), 1));                  \
+    total_ = add(total_, tw_popcount_##simd(ones_));                           \
+    for (; i_ < (n_vectors); ++i_) {                                           \
+      total_ = add(total_, tw_popcount_##simd(vec_fn(__VA_ARGS__, i_)));       \
+    }                                                                          \
+    count += tw_reduce_add_##simd(total_);                                     \
+  } while (0)
+
+#ifdef USE_AVX2
+#define TW_POPCNT_AVX2(count, n_vectors, vec_fn, ...)                          \
+  TW_POPCNT_HARLEY_SEAL(avx2, __m256i, _mm256_setzero_si256, _mm256_add_epi64, \
+                        _mm256_slli_epi64, count, n_vectors, vec_fn,           \
+                        __VA_ARGS__)
+#endif
+
+#ifdef USE_AVX512
+#define tw_reduce_add_avx512 _mm512_reduce_add_epi64
+
+#define TW_POPCNT_AVX512(count, n_vectors, vec_fn, ...)                        \
+  TW_POPCNT_HARLEY_SEAL(avx512, __m512i, _mm512_setzero_si512,                 \
+                        _mm512_add_epi64, _mm512_slli_epi64, count, n_vectors, \
+                        vec_fn, __VA_ARGS__)
+#endif
+
+#ifdef USE_AVX512_ICL
+#define TW_POPCNT_AVX512_ICL(count, n_vectors, vec_fn, ...)                    \
+  do {                                                                         \
+    __m512i total_ = _mm512_setzero_si512();                                   \
+    for (size_t i_ = 0; i_ < (n_vectors); ++i_) {                              \
+      total_ = _mm512_add_epi64(                                               \
+          total_, _mm512_popcnt_epi64(vec_fn(__VA_ARGS__, i_)));               \
+    }                                                                          \
+    count += _mm512_reduce_add_epi64(total_);                                  \
+  } while (0)
+#endif
+
+#endif /* TWIDDLE_UTILS_POPCOUNT_H */
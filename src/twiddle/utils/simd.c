@@ -0,0 +1,169 @@
+#include <cpuid.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <twiddle/utils/simd.h>
+
+#include "../macrology.h"
+
+#define TW_SIMD_ENV "TWIDDLE_SIMD"
+
+/* cpuid leaf 1, ecx */
+#define TW_CPUID_SSE41 (1U << 19)
+#define TW_CPUID_SSE42 (1U << 20)
+#define TW_CPUID_POPCNT (1U << 23)
+#define TW_CPUID_OSXSAVE (1U << 27)
+#define TW_CPUID_AVX (1U << 28)
+
+/* cpuid leaf 7, ebx */
+#define TW_CPUID_BMI1 (1U << 3)
+#define TW_CPUID_AVX2 (1U << 5)
+#define TW_CPUID_BMI2 (1U << 8)
+#define TW_CPUID_AVX512F (1U << 16)
+#define TW_CPUID_AVX512BW (1U << 30)
+
+/* cpuid leaf 7, ecx */
+#define TW_CPUID_AVX512VBMI2 (1U << 6)
+#define TW_CPUID_AVX512BITALG (1U << 12)
+#define TW_CPUID_AVX512VPOPCNTDQ (1U << 14)
+
+/* xcr0, registers state saved by the OS on context switch */
+#define TW_XCR0_YMM 0x06U
+#define TW_XCR0_ZMM 0xE6U
+
+#define tw_has_bits(reg, bits) (((reg) & (bits)) == (bits))
+
+static const char *const tw_simd_level_names[TW_SIMD_LEVELS] = {
+    [TW_SIMD_PORTABLE] = "portable",
+    [TW_SIMD_AVX] = "avx",
+    [TW_SIMD_AVX2] = "avx2",
+    [TW_SIMD_AVX512] = "avx512",
+    [TW_SIMD_AVX512_ICL] = "avx512icl",
+};
+
+static uint32_t tw_xgetbv(void)
+{
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax;
+}
+
+/**
+ * Highest level the host supports. Every level checks the previous ones
+ * since kernels of a level may fallback on kernels of a lower level.
+ */
+static enum tw_simd_level tw_simd_level_cpu(void)
+{
+  uint32_t eax, ebx, ecx, edx;
+
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return TW_SIMD_PORTABLE;
+  }
+
+  const uint32_t avx_bits = TW_CPUID_SSE41 | TW_CPUID_SSE42 | TW_CPUID_POPCNT |
+                            TW_CPUID_OSXSAVE | TW_CPUID_AVX;
+  if (!tw_has_bits(ecx, avx_bits)) {
+    return TW_SIMD_PORTABLE;
+  }
+
+  /* OSXSAVE is set, thus xgetbv is available */
+  const uint32_t xcr0 = tw_xgetbv();
+  if (!tw_has_bits(xcr0, TW_XCR0_YMM)) {
+    return TW_SIMD_PORTABLE;
+  }
+
+  if (__get_cpuid_max(0, NULL) < 7) {
+    return TW_SIMD_AVX;
+  }
+
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+  const uint32_t avx2_bits = TW_CPUID_AVX2 | TW_CPUID_BMI1 | TW_CPUID_BMI2;
+  if (!tw_has_bits(ebx, avx2_bits)) {
+    return TW_SIMD_AVX;
+  }
+
+  const uint32_t avx512_bits = TW_CPUID_AVX512F | TW_CPUID_AVX512BW;
+  if (!tw_has_bits(ebx, avx512_bits) || !tw_has_bits(xcr0, TW_XCR0_ZMM)) {
+    return TW_SIMD_AVX2;
+  }
+
+  const uint32_t icl_bits = TW_CPUID_AVX512VBMI2 | TW_CPUID_AVX512BITALG |
+                            TW_CPUID_AVX512VPOPCNTDQ;
+  if (!tw_has_bits(ecx, icl_bits)) {
+    return TW_SIMD_AVX512;
+  }
+
+  return TW_SIMD_AVX512_ICL;
+}
+
+/* Highest level with compiled kernels, see FindOptions.cmake. */
+static enum tw_simd_level tw_simd_level_compiled(void)
+{
+#if defined USE_AVX512_ICL
+  return TW_SIMD_AVX512_ICL;
+#elif defined USE_AVX512
+  return TW_SIMD_AVX512;
+#elif defined USE_AVX2
+  return TW_SIMD_AVX2;
+#elif defined USE_AVX
+  return TW_SIMD_AVX;
+#else
+  return TW_SIMD_PORTABLE;
+#endif
+}
+
+static enum tw_simd_level tw_simd_level_env(void)
+{
+  const char *name = getenv(TW_SIMD_ENV);
+  if (!name) {
+    return TW_SIMD_AVX512_ICL;
+  }
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(tw_simd_level_names); ++i) {
+    if (strcmp(name, tw_simd_level_names[i]) == 0) {
+      return (enum tw_simd_level)i;
+    }
+  }
+
+  return TW_SIMD_AVX512_ICL;
+}
+
+static enum tw_simd_level tw_simd_level_resolve(void)
+{
+  const enum tw_simd_level cpu = tw_simd_level_cpu();
+  const enum tw_simd_level compiled = tw_simd_level_compiled();
+  const enum tw_simd_level env = tw_simd_level_env();
+
+  return tw_min(tw_min(cpu, compiled), env);
+}
+
+/* -1 until resolved, see tw_simd_level */
+static int tw_simd_level_ = -1;
+
+enum tw_simd_level tw_simd_level(void)
+{
+  int level = __atomic_load_n(&tw_simd_level_, __ATOMIC_RELAXED);
+
+  /**
+   * Concurrent first calls might resolve the level more than once, but they
+   * all store the same value.
+   */
+  if (tw_unlikely(level < 0)) {
+    level = tw_simd_level_resolve();
+    __atomic_store_n(&tw_simd_level_, level, __ATOMIC_RELAXED);
+  }
+
+  return (enum tw_simd_level)level;
+}
+
+const char *tw_simd_level_name(enum tw_simd_level level)
+{
+  if ((unsigned)level >= TW_SIMD_LEVELS) {
+    return NULL;
+  }
+
+  return tw_simd_level_names[level];
+}
@@ -0,0 +1,161 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include <twiddle/utils/thread_pool.h>
+
+struct tw_thread_pool {
+  size_t n_threads;
+  pthread_t *threads;
+
+  /* protects every following field */
+  pthread_mutex_t lock;
+  /* signaled when a loop is posted or on shutdown */
+  pthread_cond_t work;
+  /* signaled when the last task of a loop completes */
+  pthread_cond_t done;
+
+  void (*fn)(void *arg, size_t task);
+  void *arg;
+  size_t n_tasks;
+  /* next task to pick, tasks are available while smaller than `n_tasks` */
+  size_t next_task;
+  /* completed tasks, the loop is over once equal to `n_tasks` */
+  size_t n_done;
+  bool shutdown;
+};
+
+/* execute tasks until none are left, `pool->lock` is held on entry and exit */
+static void tw_thread_pool_drain(struct tw_thread_pool *pool)
+{
+  while (pool->next_task < pool->n_tasks) {
+    const size_t task = pool->next_task++;
+    void (*fn)(void *, size_t) = pool->fn;
+    void *arg = pool->arg;
+
+    pthread_mutex_unlock(&pool->lock);
+    fn(arg, task);
+    pthread_mutex_lock(&pool->lock);
+
+    if (++pool->n_done == pool->n_tasks) {
+      pthread_cond_signal(&pool->done);
+    }
+  }
+}
+
+static void *tw_thread_pool_worker(void *opaque)
+{
+  struct tw_thread_pool *pool = (struct tw_thread_pool *)opaque;
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (!pool->shutdown && pool->next_task >= pool->n_tasks) {
+      pthread_cond_wait(&pool->work, &pool->lock);
+    }
+
+    if (pool->shutdown) {
+      break;
+    }
+
+    tw_thread_pool_drain(pool);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+static void tw_thread_pool_shutdown(struct tw_thread_pool *pool,
+                                    size_t n_spawned)
+{
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = true;
+  pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (size_t i = 0; i < n_spawned; ++i) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->work);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->threads);
+  free(pool);
+}
+
+struct tw_thread_pool *tw_thread_pool_new(size_t n_threads)
+{
+  if (n_threads == 0 || n_threads > TW_THREAD_POOL_MAX_THREADS) {
+    return NULL;
+  }
+
+  struct tw_thread_pool *pool = calloc(1, sizeof(struct tw_thread_pool));
+  if (!pool) {
+    return NULL;
+  }
+
+  /* the calling thread is the first of the pool */
+  pool->threads = calloc(n_threads, sizeof(pthread_t));
+  if (!pool->threads) {
+    free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  pool->n_threads = n_threads;
+
+  for (size_t i = 0; i < n_threads - 1; ++i) {
+    if (pthread_create(&pool->threads[i], NULL, tw_thread_pool_worker, pool)) {
+      tw_thread_pool_shutdown(pool, i);
+      return NULL;
+    }
+  }
+
+  return pool;
+}
+
+void tw_thread_pool_free(struct tw_thread_pool *pool)
+{
+  if (!pool) {
+    return;
+  }
+
+  tw_thread_pool_shutdown(pool, pool->n_threads - 1);
+}
+
+size_t tw_thread_pool_size(const struct tw_thread_pool *pool)
+{
+  if (!pool) {
+    return 0;
+  }
+
+  return pool->n_threads;
+}
+
+void tw_thread_pool_run(struct tw_thread_pool *pool,
+                        void (*fn)(void *arg, size_t task), void *arg,
+                        size_t n_tasks)
+{
+  if (!pool || !fn || n_tasks == 0) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->fn = fn;
+  pool->arg = arg;
+  pool->n_tasks = n_tasks;
+  pool->next_task = 0;
+  pool->n_done = 0;
+  if (n_tasks > 1) {
+    pthread_cond_broadcast(&pool->work);
+  }
+
+  tw_thread_pool_drain(pool);
+
+  while (pool->n_done < pool->n_tasks) {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,198 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_atomic.h>
+
+#include "benchmark.h"
+
+/**
+ * Scalability of concurrent writers: `size` random positions, in a bitmap of
+ * `size` 64 bits words, are split among threads. Results are reported in
+ * cycles per position, such that perfect scaling halves them when doubling
+ * the number of threads.
+ */
+
+#define MAX_THREADS 64
+
+struct shared_bitmap {
+  size_t n_threads;
+  /* runs alternate between setting and clearing, such that all are writes */
+  size_t round;
+  uint64_t *positions;
+  size_t n_positions;
+  struct tw_bitmap_atomic *atomic;
+  /* baseline, a `struct tw_bitmap` wrapped by a mutex */
+  struct tw_bitmap *bitmap;
+  pthread_mutex_t lock;
+};
+
+struct slice {
+  struct shared_bitmap *shared;
+  size_t begin;
+  size_t end;
+};
+
+static struct shared_bitmap *shared_bitmap_new(size_t size)
+{
+  const size_t nbits = size * 64;
+  const size_t n_positions = size;
+
+  struct shared_bitmap *shared = malloc(sizeof(struct shared_bitmap));
+  assert(shared);
+
+  shared->atomic = tw_bitmap_atomic_new(nbits);
+  assert(shared->atomic);
+  shared->bitmap = tw_bitmap_new(nbits);
+  assert(shared->bitmap);
+  pthread_mutex_init(&shared->lock, NULL);
+
+  shared->round = 0;
+  shared->positions = malloc(n_positions * sizeof(uint64_t));
+  assert(shared->positions);
+  shared->n_positions = n_positions;
+
+  uint64_t seed = 0xC0FFEE;
+  for (size_t i = 0; i < n_positions; ++i) {
+    /* xorshift64 */
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    shared->positions[i] = seed % nbits;
+  }
+
+  return shared;
+}
+
+static void shared_bitmap_free(struct shared_bitmap *shared)
+{
+  pthread_mutex_destroy(&shared->lock);
+  free(shared->positions);
+  tw_bitmap_free(shared->bitmap);
+  tw_bitmap_atomic_free(shared->atomic);
+  free(shared);
+}
+
+static void *atomic_worker(void *opaque)
+{
+  const struct slice *slice = (const struct slice *)opaque;
+  struct shared_bitmap *shared = slice->shared;
+
+  if (shared->round % 2) {
+    for (size_t i = slice->begin; i < slice->end; ++i) {
+      tw_bitmap_atomic_clear(shared->atomic, shared->positions[i]);
+    }
+  } else {
+    for (size_t i = slice->begin; i < slice->end; ++i) {
+      tw_bitmap_atomic_set(shared->atomic, shared->positions[i]);
+    }
+  }
+
+  return NULL;
+}
+
+static void *mutex_worker(void *opaque)
+{
+  const struct slice *slice = (const struct slice *)opaque;
+  struct shared_bitmap *shared = slice->shared;
+
+  for (size_t i = slice->begin; i < slice->end; ++i) {
+    pthread_mutex_lock(&shared->lock);
+    if (shared->round % 2) {
+      tw_bitmap_clear(shared->bitmap, shared->positions[i]);
+    } else {
+      tw_bitmap_set(shared->bitmap, shared->positions[i]);
+    }
+    pthread_mutex_unlock(&shared->lock);
+  }
+
+  return NULL;
+}
+
+static void run_workers(struct shared_bitmap *shared, void *(*worker)(void *))
+{
+  pthread_t threads[MAX_THREADS];
+  struct slice slices[MAX_THREADS];
+  const size_t n_threads = shared->n_threads;
+  const size_t per_thread = shared->n_positions / n_threads;
+
+  for (size_t t = 0; t < n_threads; ++t) {
+    slices[t] = (struct slice){
+        .shared = shared,
+        .begin = t * per_thread,
+        .end = (t + 1 == n_threads) ? shared->n_positions
+                                    : (t + 1) * per_thread,
+    };
+    pthread_create(&threads[t], NULL, worker, &slices[t]);
+  }
+
+  for (size_t t = 0; t < n_threads; ++t) {
+    pthread_join(threads[t], NULL);
+  }
+
+  shared->round++;
+}
+
+void bitmap_atomic_set(void *opaque)
+{
+  run_workers((struct shared_bitmap *)opaque, atomic_worker);
+}
+
+void bitmap_mutex_set(void *opaque)
+{
+  run_workers((struct shared_bitmap *)opaque, mutex_worker);
+}
+
+/* 1, 2, 4, ... threads, finishing with max_threads */
+static size_t next_threads(size_t n, size_t max_threads)
+{
+  if (n == max_threads) {
+    return max_threads + 1;
+  }
+
+  return (2 * n < max_threads) ? 2 * n : max_threads;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3 && argc != 4) {
+    fprintf(stderr, "usage: %s <repeat> <size> [<max-threads>]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const size_t repeat = strtol(argv[1], NULL, 10);
+  const size_t size = strtol(argv[2], NULL, 10);
+  const long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t max_threads = (argc == 4) ? strtoul(argv[3], NULL, 10)
+                                   : (size_t)((n_cpus > 0) ? n_cpus : 1);
+  if (max_threads == 0 || max_threads > MAX_THREADS) {
+    max_threads = MAX_THREADS;
+  }
+
+  struct shared_bitmap *shared = shared_bitmap_new(size);
+
+  for (size_t n = 1; n <= max_threads; n = next_threads(n, max_threads)) {
+    char atomic_name[64], mutex_name[64];
+    snprintf(atomic_name, sizeof(atomic_name), "bitmap_atomic_set_%zu", n);
+    snprintf(mutex_name, sizeof(mutex_name), "bitmap_mutex_set_%zu", n);
+
+    struct benchmark benchmarks[] = {
+        BENCHMARK(bitmap_atomic_set, repeat, size),
+        BENCHMARK(bitmap_mutex_set, repeat, size),
+    };
+    benchmarks[0].name = atomic_name;
+    benchmarks[1].name = mutex_name;
+
+    shared->n_threads = n;
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); ++i) {
+      benchmarks[i].opaque = shared;
+      run_benchmark(&benchmarks[i]);
+    }
+  }
+
+  shared_bitmap_free(shared);
+
+  return EXIT_SUCCESS;
+}
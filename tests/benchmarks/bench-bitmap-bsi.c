@@ -0,0 +1,145 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_bsi.h>
+
+#include "benchmark.h"
+
+/**
+ * Range predicates and sums over `size` rows of 16 bits values, evaluated on
+ * a bit-sliced index, compared with a scan of the values.
+ */
+
+#define VALUE_BITS 16
+#define THRESHOLD (1 << (VALUE_BITS - 2))
+
+struct indexed_values {
+  uint64_t size;
+  uint16_t *values;
+  struct tw_bitmap_bsi *bsi;
+  struct tw_bitmap *dst;
+};
+
+void indexed_setup(struct benchmark *b)
+{
+  struct indexed_values *indexed = malloc(sizeof(struct indexed_values));
+  assert(indexed);
+
+  indexed->size = b->size;
+  indexed->values = malloc(b->size * sizeof(uint16_t));
+  indexed->bsi = tw_bitmap_bsi_new(b->size, VALUE_BITS);
+  indexed->dst = tw_bitmap_new(b->size);
+  assert(indexed->values && indexed->bsi && indexed->dst);
+
+  uint64_t seed = 0xC0FFEE;
+  for (uint64_t row = 0; row < b->size; ++row) {
+    /* xorshift64 */
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    indexed->values[row] = (uint16_t)seed;
+    tw_bitmap_bsi_set(indexed->bsi, row, indexed->values[row]);
+  }
+
+  b->opaque = indexed;
+}
+
+void indexed_teardown(struct benchmark *b)
+{
+  struct indexed_values *indexed = (struct indexed_values *)b->opaque;
+  tw_bitmap_free(indexed->dst);
+  tw_bitmap_bsi_free(indexed->bsi);
+  free(indexed->values);
+  free(indexed);
+  b->opaque = NULL;
+}
+
+void scan_less(void *opaque)
+{
+  struct indexed_values *indexed = (struct indexed_values *)opaque;
+
+  tw_bitmap_zero(indexed->dst);
+  for (uint64_t row = 0; row < indexed->size; ++row) {
+    if (indexed->values[row] < THRESHOLD) {
+      tw_bitmap_set(indexed->dst, row);
+    }
+  }
+}
+
+void bsi_less(void *opaque)
+{
+  struct indexed_values *indexed = (struct indexed_values *)opaque;
+  tw_bitmap_bsi_compare(indexed->bsi, TW_BITMAP_BSI_LT, THRESHOLD, NULL,
+                        indexed->dst);
+}
+
+void scan_between(void *opaque)
+{
+  struct indexed_values *indexed = (struct indexed_values *)opaque;
+
+  tw_bitmap_zero(indexed->dst);
+  for (uint64_t row = 0; row < indexed->size; ++row) {
+    const uint16_t value = indexed->values[row];
+    if (value >= THRESHOLD && value <= 3 * THRESHOLD) {
+      tw_bitmap_set(indexed->dst, row);
+    }
+  }
+}
+
+void bsi_between(void *opaque)
+{
+  struct indexed_values *indexed = (struct indexed_values *)opaque;
+  tw_bitmap_bsi_between(indexed->bsi, THRESHOLD, 3 * THRESHOLD, NULL,
+                        indexed->dst);
+}
+
+void scan_sum(void *opaque)
+{
+  struct indexed_values *indexed = (struct indexed_values *)opaque;
+
+  uint64_t sum = 0;
+  for (uint64_t row = 0; row < indexed->size; ++row) {
+    sum += indexed->values[row];
+  }
+  __asm volatile("" : : "r"(sum));
+}
+
+void bsi_sum(void *opaque)
+{
+  struct indexed_values *indexed = (struct indexed_values *)opaque;
+
+  /* the filter forces the slices to be intersected */
+  uint64_t sum = tw_bitmap_bsi_sum(indexed->bsi, indexed->bsi->exists);
+  __asm volatile("" : : "r"(sum));
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <repeat> <size>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const size_t repeat = strtol(argv[1], NULL, 10);
+  const size_t size = strtol(argv[2], NULL, 10);
+
+  struct benchmark benchmarks[] = {
+      BENCHMARK_FIXTURE(scan_less, repeat, size, indexed_setup,
+                        indexed_teardown),
+      BENCHMARK_FIXTURE(bsi_less, repeat, size, indexed_setup,
+                        indexed_teardown),
+      BENCHMARK_FIXTURE(scan_between, repeat, size, indexed_setup,
+                        indexed_teardown),
+      BENCHMARK_FIXTURE(bsi_between, repeat, size, indexed_setup,
+                        indexed_teardown),
+      BENCHMARK_FIXTURE(scan_sum, repeat, size, indexed_setup,
+                        indexed_teardown),
+      BENCHMARK_FIXTURE(bsi_sum, repeat, size, indexed_setup,
+                        indexed_teardown),
+  };
+
+  run_benchmarks(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]));
+
+  return EXIT_SUCCESS;
+}
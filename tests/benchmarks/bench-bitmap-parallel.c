@@ -0,0 +1,157 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_parallel.h>
+#include <twiddle/utils/thread_pool.h>
+
+#include "benchmark.h"
+
+/**
+ * Scalability of set operations on bitmaps of `size` 64 bits words, larger
+ * than the last level cache. Results are reported in cycles per word, such
+ * that operations bound by a single core halve them when doubling the number
+ * of threads, until the memory bandwidth is saturated.
+ */
+
+struct shared_bitmaps {
+  struct tw_thread_pool *pool;
+  struct tw_bitmap *src;
+  struct tw_bitmap *dst;
+};
+
+static struct shared_bitmaps *shared_bitmaps_new(size_t size)
+{
+  const size_t nbits = size * 64;
+
+  struct shared_bitmaps *shared = malloc(sizeof(struct shared_bitmaps));
+  assert(shared);
+
+  shared->pool = NULL;
+  shared->src = tw_bitmap_new(nbits);
+  assert(shared->src);
+  shared->dst = tw_bitmap_new(nbits);
+  assert(shared->dst);
+
+  uint64_t seed = 0xC0FFEE;
+  for (size_t i = 0; i < size; ++i) {
+    /* xorshift64 */
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    tw_bitmap_set(shared->src, seed % nbits);
+    tw_bitmap_set(shared->dst, (seed >> 7) % nbits);
+  }
+
+  return shared;
+}
+
+static void shared_bitmaps_free(struct shared_bitmaps *shared)
+{
+  tw_bitmap_free(shared->dst);
+  tw_bitmap_free(shared->src);
+  free(shared);
+}
+
+void bitmap_union_parallel(void *opaque)
+{
+  struct shared_bitmaps *shared = (struct shared_bitmaps *)opaque;
+  tw_bitmap_union_parallel(shared->src, shared->dst, shared->pool);
+}
+
+void bitmap_intersection_parallel(void *opaque)
+{
+  struct shared_bitmaps *shared = (struct shared_bitmaps *)opaque;
+  tw_bitmap_intersection_parallel(shared->src, shared->dst, shared->pool);
+}
+
+void bitmap_xor_parallel(void *opaque)
+{
+  struct shared_bitmaps *shared = (struct shared_bitmaps *)opaque;
+  tw_bitmap_xor_parallel(shared->src, shared->dst, shared->pool);
+}
+
+void bitmap_not_parallel(void *opaque)
+{
+  struct shared_bitmaps *shared = (struct shared_bitmaps *)opaque;
+  tw_bitmap_not_parallel(shared->dst, shared->pool);
+}
+
+void bitmap_equal_parallel(void *opaque)
+{
+  struct shared_bitmaps *shared = (struct shared_bitmaps *)opaque;
+  /* same count, all chunks are compared */
+  tw_bitmap_equal_parallel(shared->dst, shared->dst, shared->pool);
+}
+
+void bitmap_fill_parallel(void *opaque)
+{
+  struct shared_bitmaps *shared = (struct shared_bitmaps *)opaque;
+  tw_bitmap_fill_parallel(shared->dst, shared->pool);
+}
+
+void bitmap_zero_parallel(void *opaque)
+{
+  struct shared_bitmaps *shared = (struct shared_bitmaps *)opaque;
+  tw_bitmap_zero_parallel(shared->dst, shared->pool);
+}
+
+/* 1, 2, 4, ... threads, finishing with max_threads */
+static size_t next_threads(size_t n, size_t max_threads)
+{
+  if (n == max_threads) {
+    return max_threads + 1;
+  }
+
+  return (2 * n < max_threads) ? 2 * n : max_threads;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3 && argc != 4) {
+    fprintf(stderr, "usage: %s <repeat> <size> [<max-threads>]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const size_t repeat = strtol(argv[1], NULL, 10);
+  const size_t size = strtol(argv[2], NULL, 10);
+  const long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t max_threads = (argc == 4) ? strtoul(argv[3], NULL, 10)
+                                   : (size_t)((n_cpus > 0) ? n_cpus : 1);
+  if (max_threads == 0 || max_threads > TW_THREAD_POOL_MAX_THREADS) {
+    max_threads = TW_THREAD_POOL_MAX_THREADS;
+  }
+
+  struct shared_bitmaps *shared = shared_bitmaps_new(size);
+
+  for (size_t n = 1; n <= max_threads; n = next_threads(n, max_threads)) {
+    struct benchmark benchmarks[] = {
+        BENCHMARK(bitmap_union_parallel, repeat, size),
+        BENCHMARK(bitmap_intersection_parallel, repeat, size),
+        BENCHMARK(bitmap_xor_parallel, repeat, size),
+        BENCHMARK(bitmap_not_parallel, repeat, size),
+        BENCHMARK(bitmap_equal_parallel, repeat, size),
+        BENCHMARK(bitmap_fill_parallel, repeat, size),
+        BENCHMARK(bitmap_zero_parallel, repeat, size),
+    };
+    const size_t n_benchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+    char names[sizeof(benchmarks) / sizeof(benchmarks[0])][64];
+    shared->pool = tw_thread_pool_new(n);
+    assert(shared->pool);
+
+    for (size_t i = 0; i < n_benchmarks; ++i) {
+      snprintf(names[i], sizeof(names[i]), "%s_%zu", benchmarks[i].name, n);
+      benchmarks[i].name = names[i];
+      benchmarks[i].opaque = shared;
+      run_benchmark(&benchmarks[i]);
+    }
+
+    tw_thread_pool_free(shared->pool);
+  }
+
+  shared_bitmaps_free(shared);
+
+  return EXIT_SUCCESS;
+}
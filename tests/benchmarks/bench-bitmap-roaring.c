@@ -0,0 +1,159 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_roaring.h>
+
+#include "benchmark.h"
+
+/**
+ * Set operations on bitmaps of `size` bytes of mixed density, where chunks
+ * alternate between sparse bits, dense bits, runs and nothing, compared with
+ * the same operations on dense bitmaps.
+ */
+
+struct mixed_bitmaps {
+  struct tw_bitmap *dense_a;
+  struct tw_bitmap *dense_b;
+  struct tw_bitmap_roaring *roaring_a;
+  struct tw_bitmap_roaring *roaring_b;
+};
+
+static void mixed_fill(struct tw_bitmap *dense,
+                       struct tw_bitmap_roaring *roaring, uint64_t seed,
+                       size_t shift)
+{
+  const uint64_t chunk_bits = TW_BITMAP_ROARING_CONTAINER_BITS;
+  const uint64_t n_chunks = dense->size / chunk_bits;
+
+  for (uint64_t chunk = 0; chunk < n_chunks; ++chunk) {
+    const uint64_t base = chunk * chunk_bits;
+    const uint64_t kind = (chunk + shift) % 4;
+
+    for (uint64_t i = 0; i < chunk_bits; ++i) {
+      /* xorshift64 */
+      seed ^= seed << 13;
+      seed ^= seed >> 7;
+      seed ^= seed << 17;
+
+      const bool set = (kind == 0 && seed % 1000 == 0) ||
+                       (kind == 1 && seed % 2 == 0) ||
+                       (kind == 2 && (i / 1024) % 2 == 0);
+      if (set) {
+        tw_bitmap_set(dense, base + i);
+        tw_bitmap_roaring_set(roaring, base + i);
+      }
+    }
+  }
+
+  tw_bitmap_roaring_optimize(roaring);
+}
+
+void mixed_setup(struct benchmark *b)
+{
+  const size_t size = b->size * 8;
+
+  struct mixed_bitmaps *mixed = malloc(sizeof(struct mixed_bitmaps));
+  assert(mixed);
+
+  mixed->dense_a = tw_bitmap_new(size);
+  mixed->dense_b = tw_bitmap_new(size);
+  mixed->roaring_a = tw_bitmap_roaring_new(size);
+  mixed->roaring_b = tw_bitmap_roaring_new(size);
+  assert(mixed->dense_a && mixed->dense_b);
+  assert(mixed->roaring_a && mixed->roaring_b);
+
+  mixed_fill(mixed->dense_a, mixed->roaring_a, 0xC0FFEE, 0);
+  mixed_fill(mixed->dense_b, mixed->roaring_b, 0xDEADBEEF, 1);
+
+  b->opaque = mixed;
+}
+
+void mixed_teardown(struct benchmark *b)
+{
+  struct mixed_bitmaps *mixed = (struct mixed_bitmaps *)b->opaque;
+  tw_bitmap_roaring_free(mixed->roaring_b);
+  tw_bitmap_roaring_free(mixed->roaring_a);
+  tw_bitmap_free(mixed->dense_b);
+  tw_bitmap_free(mixed->dense_a);
+  free(mixed);
+  b->opaque = NULL;
+}
+
+void dense_union(void *opaque)
+{
+  struct mixed_bitmaps *mixed = (struct mixed_bitmaps *)opaque;
+  tw_bitmap_union(mixed->dense_a, mixed->dense_b);
+}
+
+void roaring_union(void *opaque)
+{
+  struct mixed_bitmaps *mixed = (struct mixed_bitmaps *)opaque;
+  tw_bitmap_roaring_union(mixed->roaring_a, mixed->roaring_b);
+}
+
+void dense_intersection(void *opaque)
+{
+  struct mixed_bitmaps *mixed = (struct mixed_bitmaps *)opaque;
+  tw_bitmap_intersection(mixed->dense_a, mixed->dense_b);
+}
+
+void roaring_intersection(void *opaque)
+{
+  struct mixed_bitmaps *mixed = (struct mixed_bitmaps *)opaque;
+  tw_bitmap_roaring_intersection(mixed->roaring_a, mixed->roaring_b);
+}
+
+void dense_test(void *opaque)
+{
+  struct mixed_bitmaps *mixed = (struct mixed_bitmaps *)opaque;
+  const uint64_t size = mixed->dense_a->size;
+
+  uint64_t found = 0;
+  for (uint64_t pos = 0; pos < size; pos += 61) {
+    found += tw_bitmap_test(mixed->dense_a, pos);
+  }
+  __asm volatile("" : : "r"(found));
+}
+
+void roaring_test(void *opaque)
+{
+  struct mixed_bitmaps *mixed = (struct mixed_bitmaps *)opaque;
+  const uint64_t size = mixed->roaring_a->size;
+
+  uint64_t found = 0;
+  for (uint64_t pos = 0; pos < size; pos += 61) {
+    found += tw_bitmap_roaring_test(mixed->roaring_a, pos);
+  }
+  __asm volatile("" : : "r"(found));
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <repeat> <size>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const size_t repeat = strtol(argv[1], NULL, 10);
+  const size_t size = strtol(argv[2], NULL, 10);
+
+  struct benchmark benchmarks[] = {
+      BENCHMARK_FIXTURE(dense_union, repeat, size, mixed_setup,
+                        mixed_teardown),
+      BENCHMARK_FIXTURE(roaring_union, repeat, size, mixed_setup,
+                        mixed_teardown),
+      BENCHMARK_FIXTURE(dense_intersection, repeat, size, mixed_setup,
+                        mixed_teardown),
+      BENCHMARK_FIXTURE(roaring_intersection, repeat, size, mixed_setup,
+                        mixed_teardown),
+      BENCHMARK_FIXTURE(dense_test, repeat, size, mixed_setup,
+                        mixed_teardown),
+      BENCHMARK_FIXTURE(roaring_test, repeat, size, mixed_setup,
+                        mixed_teardown),
+  };
+
+  run_benchmarks(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]));
+
+  return EXIT_SUCCESS;
+}
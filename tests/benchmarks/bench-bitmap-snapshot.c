@@ -0,0 +1,103 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_snapshot.h>
+
+#include "benchmark.h"
+
+/**
+ * Taking a consistent copy of a bitmap of `size` bytes then modifying a few
+ * bits of it, e.g. publishing versions of a bitmap to readers. Cloning copies
+ * every byte, a copy-on-write snapshot copies the written chunks only.
+ */
+
+#define WRITES 4
+
+struct versions {
+  struct tw_bitmap *heap;
+  struct tw_bitmap *shared;
+};
+
+void versions_setup(struct benchmark *b)
+{
+  struct versions *versions = malloc(sizeof(struct versions));
+  assert(versions);
+
+  const uint64_t nbits = b->size * 8;
+  versions->heap = tw_bitmap_new(nbits);
+  versions->shared = tw_bitmap_new_shared(nbits);
+  assert(versions->heap && versions->shared);
+
+  for (uint64_t pos = 0; pos < nbits; pos += 3) {
+    tw_bitmap_set(versions->heap, pos);
+    tw_bitmap_set(versions->shared, pos);
+  }
+
+  b->opaque = versions;
+}
+
+void versions_teardown(struct benchmark *b)
+{
+  struct versions *versions = (struct versions *)b->opaque;
+  tw_bitmap_free(versions->heap);
+  tw_bitmap_free(versions->shared);
+  free(versions);
+  b->opaque = NULL;
+}
+
+/* flip bits spread over the bitmap */
+static void versions_write(struct tw_bitmap *bitmap)
+{
+  for (uint64_t i = 0; i < WRITES; ++i) {
+    const uint64_t pos = (i * bitmap->size) / WRITES + 1;
+    tw_bitmap_flip_range(bitmap, pos, pos);
+  }
+}
+
+void bitmap_clone(void *opaque)
+{
+  struct versions *versions = (struct versions *)opaque;
+  struct tw_bitmap *copy = tw_bitmap_clone(versions->heap);
+  versions_write(copy);
+  tw_bitmap_free(copy);
+}
+
+void bitmap_snapshot(void *opaque)
+{
+  struct versions *versions = (struct versions *)opaque;
+  struct tw_bitmap *copy = tw_bitmap_snapshot(versions->shared);
+  tw_bitmap_free(copy);
+}
+
+void bitmap_snapshot_write(void *opaque)
+{
+  struct versions *versions = (struct versions *)opaque;
+  struct tw_bitmap *copy = tw_bitmap_snapshot(versions->shared);
+  versions_write(copy);
+  tw_bitmap_free(copy);
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <repeat> <size>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const size_t repeat = strtol(argv[1], NULL, 10);
+  const size_t size = strtol(argv[2], NULL, 10);
+
+  struct benchmark benchmarks[] = {
+      BENCHMARK_FIXTURE(bitmap_clone, repeat, size, versions_setup,
+                        versions_teardown),
+      BENCHMARK_FIXTURE(bitmap_snapshot, repeat, size, versions_setup,
+                        versions_teardown),
+      BENCHMARK_FIXTURE(bitmap_snapshot_write, repeat, size, versions_setup,
+                        versions_teardown),
+  };
+
+  run_benchmarks(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]));
+
+  return EXIT_SUCCESS;
+}
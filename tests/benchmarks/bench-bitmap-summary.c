@@ -0,0 +1,101 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_summary.h>
+
+#include "benchmark.h"
+
+/**
+ * Allocating and freeing identifiers in a bitmap of `size` bytes whose low
+ * region is fully allocated, the usual state of a long running allocator. A
+ * linear scan for the first zero is compared with a hierarchical summary.
+ */
+
+#define CHURN 64
+
+struct allocator {
+  struct tw_bitmap *bitmap;
+  struct tw_bitmap_summary *summary;
+  /* identifiers freed and allocated again on each run */
+  uint64_t ids[CHURN];
+};
+
+void allocator_setup(struct benchmark *b)
+{
+  struct allocator *allocator = malloc(sizeof(struct allocator));
+  assert(allocator);
+
+  const uint64_t nbits = b->size * 8;
+  allocator->bitmap = tw_bitmap_new(nbits);
+  allocator->summary = tw_bitmap_summary_new(allocator->bitmap);
+  assert(allocator->bitmap && allocator->summary);
+
+  tw_bitmap_fill(allocator->bitmap);
+
+  /* free identifiers scattered in the last eighth */
+  uint64_t seed = 0xC0FFEE;
+  for (size_t i = 0; i < CHURN; ++i) {
+    /* xorshift64 */
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    allocator->ids[i] = nbits - 1 - seed % (nbits / 8);
+  }
+
+  b->opaque = allocator;
+}
+
+void allocator_teardown(struct benchmark *b)
+{
+  struct allocator *allocator = (struct allocator *)b->opaque;
+  tw_bitmap_summary_free(allocator->summary);
+  tw_bitmap_free(allocator->bitmap);
+  free(allocator);
+  b->opaque = NULL;
+}
+
+void bitmap_alloc_scan(void *opaque)
+{
+  struct allocator *allocator = (struct allocator *)opaque;
+  struct tw_bitmap *bitmap = allocator->bitmap;
+
+  for (size_t i = 0; i < CHURN; ++i) {
+    tw_bitmap_clear(bitmap, allocator->ids[i]);
+    const int64_t id = tw_bitmap_find_first_zero(bitmap);
+    tw_bitmap_set(bitmap, id);
+  }
+}
+
+void bitmap_alloc_summary(void *opaque)
+{
+  struct allocator *allocator = (struct allocator *)opaque;
+  struct tw_bitmap_summary *summary = allocator->summary;
+
+  for (size_t i = 0; i < CHURN; ++i) {
+    tw_bitmap_summary_free_id(summary, allocator->ids[i]);
+    tw_bitmap_summary_alloc_id(summary);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <repeat> <size>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const size_t repeat = strtol(argv[1], NULL, 10);
+  const size_t size = strtol(argv[2], NULL, 10);
+
+  struct benchmark benchmarks[] = {
+      BENCHMARK_FIXTURE(bitmap_alloc_scan, repeat, size, allocator_setup,
+                        allocator_teardown),
+      BENCHMARK_FIXTURE(bitmap_alloc_summary, repeat, size, allocator_setup,
+                        allocator_teardown),
+  };
+
+  run_benchmarks(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]));
+
+  return EXIT_SUCCESS;
+}
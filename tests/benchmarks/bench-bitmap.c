@@ -1,12 +1,15 @@
 #include <stdlib.h>
 
 #include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_rle.h>
 
 #include "benchmark.h"
 
 struct dual_bitmap {
   struct tw_bitmap *a;
   struct tw_bitmap *b;
+  /* destination of three-operand operations */
+  struct tw_bitmap *out;
 };
 
 void bitmap_dual_setup(struct benchmark *b)
@@ -21,6 +24,8 @@ void bitmap_dual_setup(struct benchmark *b)
   assert(dual->a);
   dual->b = tw_bitmap_new(size);
   assert(dual->b);
+  dual->out = tw_bitmap_new(size);
+  assert(dual->out);
 
   for (size_t i = 0; i < size; ++i) {
     if (i % 5) {
@@ -33,6 +38,7 @@ void bitmap_dual_setup(struct benchmark *b)
 void bitmap_dual_teardown(struct benchmark *b)
 {
   struct dual_bitmap *dual = (struct dual_bitmap *)b->opaque;
+  tw_bitmap_free(dual->out);
   tw_bitmap_free(dual->b);
   tw_bitmap_free(dual->a);
   free(dual);
@@ -46,6 +52,322 @@ void bitmap_xor(void *opaque)
   tw_bitmap_xor(dual->a, dual->b);
 }
 
+#define BITMAP_MANY 64
+
+struct many_bitmap {
+  struct tw_bitmap *srcs[BITMAP_MANY];
+  struct tw_bitmap *dst;
+};
+
+void bitmap_many_setup(struct benchmark *b)
+{
+  const size_t size = b->size * 8;
+
+  b->opaque = malloc(sizeof(struct many_bitmap));
+  struct many_bitmap *many = (struct many_bitmap *)b->opaque;
+  assert(many);
+
+  for (size_t k = 0; k < BITMAP_MANY; ++k) {
+    many->srcs[k] = tw_bitmap_new(size);
+    assert(many->srcs[k]);
+    for (size_t i = 0; i < size; ++i) {
+      if ((i + k) % 5) {
+        tw_bitmap_set(many->srcs[k], i);
+      }
+    }
+  }
+
+  many->dst = tw_bitmap_new(size);
+  assert(many->dst);
+}
+
+void bitmap_many_teardown(struct benchmark *b)
+{
+  struct many_bitmap *many = (struct many_bitmap *)b->opaque;
+  for (size_t k = 0; k < BITMAP_MANY; ++k) {
+    tw_bitmap_free(many->srcs[k]);
+  }
+  tw_bitmap_free(many->dst);
+  free(many);
+  b->opaque = NULL;
+}
+
+void bitmap_union_repeated(void *opaque)
+{
+  struct many_bitmap *many = (struct many_bitmap *)opaque;
+
+  tw_bitmap_copy(many->srcs[0], many->dst);
+  for (size_t k = 1; k < BITMAP_MANY; ++k) {
+    tw_bitmap_union(many->srcs[k], many->dst);
+  }
+}
+
+void bitmap_union_many(void *opaque)
+{
+  struct many_bitmap *many = (struct many_bitmap *)opaque;
+
+  tw_bitmap_union_many((const struct tw_bitmap **)many->srcs, BITMAP_MANY,
+                       many->dst);
+}
+
+void bitmap_intersection_many(void *opaque)
+{
+  struct many_bitmap *many = (struct many_bitmap *)opaque;
+
+  tw_bitmap_intersection_many((const struct tw_bitmap **)many->srcs,
+                              BITMAP_MANY, many->dst);
+}
+
+struct array_bitmap {
+  struct tw_bitmap *bitmap;
+  uint64_t *positions;
+};
+
+void bitmap_array_setup(struct benchmark *b)
+{
+  const size_t size = b->size * 8;
+
+  b->opaque = malloc(sizeof(struct array_bitmap));
+  struct array_bitmap *array = (struct array_bitmap *)b->opaque;
+  assert(array);
+
+  array->bitmap = tw_bitmap_new(size);
+  assert(array->bitmap);
+  array->positions = malloc(size * sizeof(uint64_t));
+  assert(array->positions);
+
+  for (size_t i = 0; i < size; ++i) {
+    if (i % 5) {
+      tw_bitmap_set(array->bitmap, i);
+    }
+  }
+}
+
+void bitmap_array_teardown(struct benchmark *b)
+{
+  struct array_bitmap *array = (struct array_bitmap *)b->opaque;
+  free(array->positions);
+  tw_bitmap_free(array->bitmap);
+  free(array);
+  b->opaque = NULL;
+}
+
+void bitmap_to_array(void *opaque)
+{
+  struct array_bitmap *array = (struct array_bitmap *)opaque;
+
+  tw_bitmap_to_array(array->bitmap, array->positions, 0,
+                     array->bitmap->size);
+}
+
+void bitmap_iter(void *opaque)
+{
+  struct array_bitmap *array = (struct array_bitmap *)opaque;
+  struct tw_bitmap_iter iter;
+  uint64_t *positions = array->positions;
+
+  tw_bitmap_iter_init(&iter, array->bitmap, 0);
+  while (tw_bitmap_iter_next(&iter, positions)) {
+    positions++;
+  }
+}
+
+/* `size` random positions in a bitmap of `size` 64 bits words */
+struct random_bitmap {
+  struct tw_bitmap *bitmap;
+  struct tw_bitmap *results;
+  uint64_t *positions;
+  size_t n_positions;
+};
+
+void bitmap_random_setup(struct benchmark *b)
+{
+  const size_t size = b->size * 64;
+  const size_t n_positions = b->size;
+
+  b->opaque = malloc(sizeof(struct random_bitmap));
+  struct random_bitmap *random = (struct random_bitmap *)b->opaque;
+  assert(random);
+
+  random->bitmap = tw_bitmap_new(size);
+  assert(random->bitmap);
+  random->results = tw_bitmap_new(n_positions);
+  assert(random->results);
+  random->positions = malloc(n_positions * sizeof(uint64_t));
+  assert(random->positions);
+  random->n_positions = n_positions;
+
+  uint64_t seed = 0xC0FFEE;
+  for (size_t i = 0; i < n_positions; ++i) {
+    /* xorshift64 */
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    random->positions[i] = seed % size;
+  }
+}
+
+void bitmap_random_teardown(struct benchmark *b)
+{
+  struct random_bitmap *random = (struct random_bitmap *)b->opaque;
+  free(random->positions);
+  tw_bitmap_free(random->results);
+  tw_bitmap_free(random->bitmap);
+  free(random);
+  b->opaque = NULL;
+}
+
+void bitmap_set_loop(void *opaque)
+{
+  struct random_bitmap *random = (struct random_bitmap *)opaque;
+
+  for (size_t i = 0; i < random->n_positions; ++i) {
+    tw_bitmap_set(random->bitmap, random->positions[i]);
+  }
+}
+
+/* includes the lazy recount, as a caller reading the count once would */
+void bitmap_set_nocount(void *opaque)
+{
+  struct random_bitmap *random = (struct random_bitmap *)opaque;
+
+  for (size_t i = 0; i < random->n_positions; ++i) {
+    tw_bitmap_set_nocount(random->bitmap, random->positions[i]);
+  }
+
+  tw_bitmap_count(random->bitmap);
+}
+
+void bitmap_set_many(void *opaque)
+{
+  struct random_bitmap *random = (struct random_bitmap *)opaque;
+
+  tw_bitmap_set_many(random->bitmap, random->positions, random->n_positions);
+}
+
+void bitmap_test_loop(void *opaque)
+{
+  struct random_bitmap *random = (struct random_bitmap *)opaque;
+
+  for (size_t i = 0; i < random->n_positions; ++i) {
+    if (tw_bitmap_test(random->bitmap, random->positions[i])) {
+      tw_bitmap_set(random->results, i);
+    }
+  }
+}
+
+void bitmap_test_many(void *opaque)
+{
+  struct random_bitmap *random = (struct random_bitmap *)opaque;
+
+  tw_bitmap_test_many(random->bitmap, random->positions, random->n_positions,
+                      random->results);
+}
+
+/* runs of random lengths in a bitmap of `size` 64 bits words */
+struct runs_bitmap {
+  struct tw_bitmap *bitmap;
+  struct tw_bitmap_rle *rle;
+};
+
+void bitmap_runs_setup(struct benchmark *b)
+{
+  const size_t size = b->size * 64;
+
+  b->opaque = malloc(sizeof(struct runs_bitmap));
+  struct runs_bitmap *runs = (struct runs_bitmap *)b->opaque;
+  assert(runs);
+
+  runs->bitmap = tw_bitmap_new(size);
+  assert(runs->bitmap);
+  runs->rle = tw_bitmap_rle_new(size);
+  assert(runs->rle);
+
+  uint64_t seed = 0xC0FFEE;
+  for (size_t pos = 0; pos < size;) {
+    /* xorshift64 */
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    const size_t length = 1 + seed % 256;
+    const size_t end = (pos + length < size) ? pos + length : size;
+    if (seed & (1UL << 32)) {
+      tw_bitmap_set_range(runs->bitmap, pos, end - 1);
+    }
+    pos = end;
+  }
+
+  tw_bitmap_to_rle(runs->bitmap, runs->rle);
+}
+
+void bitmap_runs_teardown(struct benchmark *b)
+{
+  struct runs_bitmap *runs = (struct runs_bitmap *)b->opaque;
+  tw_bitmap_rle_free(runs->rle);
+  tw_bitmap_free(runs->bitmap);
+  free(runs);
+  b->opaque = NULL;
+}
+
+/* conversion by visiting every active bit */
+void bitmap_to_rle_loop(void *opaque)
+{
+  struct runs_bitmap *runs = (struct runs_bitmap *)opaque;
+  struct tw_bitmap_iter iter;
+  uint64_t pos;
+
+  tw_bitmap_rle_zero(runs->rle);
+  tw_bitmap_iter_init(&iter, runs->bitmap, 0);
+  while (tw_bitmap_iter_next(&iter, &pos)) {
+    tw_bitmap_rle_set(runs->rle, pos);
+  }
+}
+
+void bitmap_to_rle(void *opaque)
+{
+  struct runs_bitmap *runs = (struct runs_bitmap *)opaque;
+
+  tw_bitmap_to_rle(runs->bitmap, runs->rle);
+}
+
+void bitmap_rle_to_bitmap(void *opaque)
+{
+  struct runs_bitmap *runs = (struct runs_bitmap *)opaque;
+
+  tw_bitmap_rle_to_bitmap(runs->rle, runs->bitmap);
+}
+
+void bitmap_union(void *opaque)
+{
+  struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
+
+  tw_bitmap_union(dual->a, dual->b);
+}
+
+void bitmap_intersection(void *opaque)
+{
+  struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
+
+  tw_bitmap_intersection(dual->a, dual->b);
+}
+
+/* `a AND NOT b` preserving `a`, with and without a third operand */
+void bitmap_andnot_clone(void *opaque)
+{
+  struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
+
+  struct tw_bitmap *tmp = tw_bitmap_clone(dual->a);
+  tw_bitmap_andnot(dual->b, tmp);
+  tw_bitmap_free(tmp);
+}
+
+void bitmap_andnot_into(void *opaque)
+{
+  struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
+
+  tw_bitmap_andnot_into(dual->a, dual->b, dual->out);
+}
+
 void bitmap_equal(void *opaque)
 {
   struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
@@ -54,6 +376,120 @@ void bitmap_equal(void *opaque)
   (void)res;
 }
 
+/**
+ * Testing whether bitmaps intersect by counting their intersection compared
+ * with the early exit predicate, which stops on the first vector here. The
+ * subset predicate scans every vector as `a` is a subset of `b`.
+ */
+
+void bitmap_intersection_count(void *opaque)
+{
+  struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
+
+  bool res = tw_bitmap_intersection_count(dual->a, dual->b) != 0;
+  (void)res;
+}
+
+void bitmap_intersects(void *opaque)
+{
+  struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
+
+  bool res = tw_bitmap_intersects(dual->a, dual->b);
+  (void)res;
+}
+
+void bitmap_is_subset(void *opaque)
+{
+  struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
+
+  bool res = tw_bitmap_is_subset(dual->a, dual->b);
+  (void)res;
+}
+
+/**
+ * Shifting a bitmap by a few bits, by moving every active bit compared with
+ * the funnel shift kernels.
+ */
+
+#define BITMAP_SHIFT 3
+
+void bitmap_shift_loop(void *opaque)
+{
+  struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
+
+  tw_bitmap_zero(dual->out);
+  for (int64_t pos = tw_bitmap_find_next_bit(dual->a, 0);
+       pos >= 0 && (uint64_t)pos + BITMAP_SHIFT < dual->a->size;
+       pos = tw_bitmap_find_next_bit(dual->a, pos + 1)) {
+    tw_bitmap_set(dual->out, pos + BITMAP_SHIFT);
+  }
+}
+
+void bitmap_shift_left(void *opaque)
+{
+  struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
+
+  tw_bitmap_copy(dual->a, dual->out);
+  tw_bitmap_shift_left(dual->out, BITMAP_SHIFT);
+}
+
+void bitmap_rotate_left(void *opaque)
+{
+  struct dual_bitmap *dual = (struct dual_bitmap *)opaque;
+
+  tw_bitmap_copy(dual->a, dual->out);
+  tw_bitmap_rotate_left(dual->out, BITMAP_SHIFT);
+}
+
+/**
+ * Appending bits to a bitmap of `size` bytes grown on demand, compared with a
+ * bitmap reserved upfront. Geometric growth amortizes reallocations, and
+ * large bitmaps are remapped instead of copied.
+ */
+
+void bitmap_grow_setup(struct benchmark *b)
+{
+  uint64_t *nbits = malloc(sizeof(uint64_t));
+  assert(nbits);
+  *nbits = b->size * 8;
+  b->opaque = nbits;
+}
+
+void bitmap_grow_teardown(struct benchmark *b)
+{
+  free(b->opaque);
+  b->opaque = NULL;
+}
+
+static void bitmap_append(struct tw_bitmap *bitmap, uint64_t nbits)
+{
+  for (uint64_t pos = 0; pos < nbits; pos += 64) {
+    if (pos >= bitmap->size) {
+      tw_bitmap_resize(bitmap, pos + 1);
+    }
+    tw_bitmap_set(bitmap, pos);
+  }
+}
+
+void bitmap_grow(void *opaque)
+{
+  const uint64_t nbits = *(uint64_t *)opaque;
+
+  struct tw_bitmap *bitmap = tw_bitmap_new(512);
+  bitmap_append(bitmap, nbits);
+  tw_bitmap_free(bitmap);
+}
+
+void bitmap_grow_reserved(void *opaque)
+{
+  const uint64_t nbits = *(uint64_t *)opaque;
+
+  struct tw_bitmap *bitmap = tw_bitmap_new(512);
+  tw_bitmap_reserve(bitmap, nbits);
+  bitmap_append(bitmap, nbits);
+  tw_bitmap_free(bitmap);
+}
+
 int main(int argc, char *argv[])
 {
 
@@ -68,8 +504,58 @@ int main(int argc, char *argv[])
   struct benchmark benchmarks[] = {
       BENCHMARK_FIXTURE(bitmap_equal, repeat, size, bitmap_dual_setup,
                         bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_intersection_count, repeat, size,
+                        bitmap_dual_setup, bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_intersects, repeat, size, bitmap_dual_setup,
+                        bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_is_subset, repeat, size, bitmap_dual_setup,
+                        bitmap_dual_teardown),
       BENCHMARK_FIXTURE(bitmap_xor, repeat, size, bitmap_dual_setup,
                         bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_union, repeat, size, bitmap_dual_setup,
+                        bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_andnot_clone, repeat, size, bitmap_dual_setup,
+                        bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_andnot_into, repeat, size, bitmap_dual_setup,
+                        bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_intersection, repeat, size, bitmap_dual_setup,
+                        bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_shift_loop, repeat, size, bitmap_dual_setup,
+                        bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_shift_left, repeat, size, bitmap_dual_setup,
+                        bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_rotate_left, repeat, size, bitmap_dual_setup,
+                        bitmap_dual_teardown),
+      BENCHMARK_FIXTURE(bitmap_iter, repeat, size, bitmap_array_setup,
+                        bitmap_array_teardown),
+      BENCHMARK_FIXTURE(bitmap_to_array, repeat, size, bitmap_array_setup,
+                        bitmap_array_teardown),
+      BENCHMARK_FIXTURE(bitmap_union_repeated, repeat, size, bitmap_many_setup,
+                        bitmap_many_teardown),
+      BENCHMARK_FIXTURE(bitmap_union_many, repeat, size, bitmap_many_setup,
+                        bitmap_many_teardown),
+      BENCHMARK_FIXTURE(bitmap_intersection_many, repeat, size,
+                        bitmap_many_setup, bitmap_many_teardown),
+      BENCHMARK_FIXTURE(bitmap_to_rle_loop, repeat, size, bitmap_runs_setup,
+                        bitmap_runs_teardown),
+      BENCHMARK_FIXTURE(bitmap_to_rle, repeat, size, bitmap_runs_setup,
+                        bitmap_runs_teardown),
+      BENCHMARK_FIXTURE(bitmap_rle_to_bitmap, repeat, size, bitmap_runs_setup,
+                        bitmap_runs_teardown),
+      BENCHMARK_FIXTURE(bitmap_set_loop, repeat, size, bitmap_random_setup,
+                        bitmap_random_teardown),
+      BENCHMARK_FIXTURE(bitmap_set_nocount, repeat, size, bitmap_random_setup,
+                        bitmap_random_teardown),
+      BENCHMARK_FIXTURE(bitmap_set_many, repeat, size, bitmap_random_setup,
+                        bitmap_random_teardown),
+      BENCHMARK_FIXTURE(bitmap_test_loop, repeat, size, bitmap_random_setup,
+                        bitmap_random_teardown),
+      BENCHMARK_FIXTURE(bitmap_test_many, repeat, size, bitmap_random_setup,
+                        bitmap_random_teardown),
+      BENCHMARK_FIXTURE(bitmap_grow, repeat, size, bitmap_grow_setup,
+                        bitmap_grow_teardown),
+      BENCHMARK_FIXTURE(bitmap_grow_reserved, repeat, size, bitmap_grow_setup,
+                        bitmap_grow_teardown),
   };
 
   run_benchmarks(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]));
@@ -0,0 +1,131 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmatrix.h>
+
+#include "benchmark.h"
+
+/**
+ * Breadth-first search steps on a random graph of `size` vertices, with an
+ * average degree of `DEGREE`. Expanding a frontier one row at a time is
+ * compared with `tw_bitmatrix_expand`, and transposing bit by bit with
+ * `tw_bitmatrix_transpose`.
+ */
+
+#define DEGREE 16
+#define FRONTIER 1024
+
+struct graph {
+  struct tw_bitmatrix *matrix;
+  struct tw_bitmap *frontier;
+  struct tw_bitmap *next;
+};
+
+void graph_setup(struct benchmark *b)
+{
+  struct graph *graph = malloc(sizeof(struct graph));
+  assert(graph);
+
+  const uint64_t n = b->size;
+  graph->matrix = tw_bitmatrix_new(n, n);
+  graph->frontier = tw_bitmap_new(n);
+  graph->next = tw_bitmap_new(n);
+  assert(graph->matrix && graph->frontier && graph->next);
+
+  uint64_t seed = 0xC0FFEE;
+  for (uint64_t i = 0; i < n * DEGREE; ++i) {
+    /* xorshift64 */
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    tw_bitmatrix_set(graph->matrix, i / DEGREE, seed % n);
+  }
+
+  for (uint64_t i = 0; i < FRONTIER; ++i) {
+    tw_bitmap_set(graph->frontier, (i * 7919) % n);
+  }
+
+  b->opaque = graph;
+}
+
+void graph_teardown(struct benchmark *b)
+{
+  struct graph *graph = (struct graph *)b->opaque;
+  tw_bitmatrix_free(graph->matrix);
+  tw_bitmap_free(graph->frontier);
+  tw_bitmap_free(graph->next);
+  free(graph);
+  b->opaque = NULL;
+}
+
+void bitmatrix_expand_loop(void *opaque)
+{
+  struct graph *graph = (struct graph *)opaque;
+
+  tw_bitmap_zero(graph->next);
+
+  struct tw_bitmap_iter iter;
+  struct tw_bitmap row;
+  uint64_t pos;
+  tw_bitmap_iter_init(&iter, graph->frontier, 0);
+  while (tw_bitmap_iter_next(&iter, &pos)) {
+    tw_bitmatrix_row(graph->matrix, pos, &row);
+    tw_bitmap_union(&row, graph->next);
+  }
+}
+
+void bitmatrix_expand(void *opaque)
+{
+  struct graph *graph = (struct graph *)opaque;
+  tw_bitmatrix_expand(graph->matrix, graph->frontier, graph->next);
+}
+
+void bitmatrix_transpose_loop(void *opaque)
+{
+  struct graph *graph = (struct graph *)opaque;
+  const struct tw_bitmatrix *matrix = graph->matrix;
+
+  struct tw_bitmatrix *transpose =
+      tw_bitmatrix_new(matrix->n_cols, matrix->n_rows);
+  for (uint64_t row = 0; row < matrix->n_rows; ++row) {
+    for (uint64_t col = 0; col < matrix->n_cols; ++col) {
+      if (tw_bitmatrix_test(matrix, row, col)) {
+        tw_bitmatrix_set(transpose, col, row);
+      }
+    }
+  }
+  tw_bitmatrix_free(transpose);
+}
+
+void bitmatrix_transpose(void *opaque)
+{
+  struct graph *graph = (struct graph *)opaque;
+  tw_bitmatrix_free(tw_bitmatrix_transpose(graph->matrix));
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <repeat> <size>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const size_t repeat = strtol(argv[1], NULL, 10);
+  const size_t size = strtol(argv[2], NULL, 10);
+
+  struct benchmark benchmarks[] = {
+      BENCHMARK_FIXTURE(bitmatrix_expand_loop, repeat, size, graph_setup,
+                        graph_teardown),
+      BENCHMARK_FIXTURE(bitmatrix_expand, repeat, size, graph_setup,
+                        graph_teardown),
+      BENCHMARK_FIXTURE(bitmatrix_transpose_loop, repeat, size, graph_setup,
+                        graph_teardown),
+      BENCHMARK_FIXTURE(bitmatrix_transpose, repeat, size, graph_setup,
+                        graph_teardown),
+  };
+
+  run_benchmarks(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]));
+
+  return EXIT_SUCCESS;
+}
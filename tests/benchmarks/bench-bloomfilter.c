@@ -5,21 +5,37 @@
 
 #include "benchmark.h"
 
-void bloomfilter_setup(struct benchmark *b)
+static void bloomfilter_setup_flags(struct benchmark *b, int flags)
 {
   const size_t size = b->size * 8;
   const uint16_t k = 10;
 
-  b->opaque = tw_bloomfilter_new(size, k);
+  b->opaque = tw_bloomfilter_new_flags(size, k, flags);
   assert(b->opaque);
 
-  for (size_t i = 0; i < size; ++i) {
-    if (i % 3) {
-      tw_bloomfilter_set(b->opaque, &i, sizeof(i));
-    }
+  /* a key per 16 bits sets about half of the bits with `k` hashes, such that
+   * filters larger than the last level cache are filled in reasonable time */
+  for (size_t i = 0; i < size; i += 16) {
+    tw_bloomfilter_set(b->opaque, &i, sizeof(i));
   }
 }
 
+void bloomfilter_setup(struct benchmark *b)
+{
+  bloomfilter_setup_flags(b, TW_ALLOC_DEFAULT);
+}
+
+/* filters larger than the TLB reach, each probe is likely a TLB miss */
+void bloomfilter_huge_setup(struct benchmark *b)
+{
+  bloomfilter_setup_flags(b, TW_ALLOC_HUGE_PAGES);
+}
+
+void bloomfilter_interleave_setup(struct benchmark *b)
+{
+  bloomfilter_setup_flags(b, TW_ALLOC_HUGE_PAGES | TW_ALLOC_INTERLEAVE);
+}
+
 void bloomfilter_teardown(struct benchmark *b)
 {
   struct tw_bloomfilter *bf = (struct tw_bloomfilter *)b->opaque;
@@ -47,6 +63,12 @@ void bloomfilter_test(void *opaque)
   }
 }
 
+void bloomfilter_huge_set(void *opaque) { bloomfilter_set(opaque); }
+
+void bloomfilter_huge_test(void *opaque) { bloomfilter_test(opaque); }
+
+void bloomfilter_interleave_test(void *opaque) { bloomfilter_test(opaque); }
+
 int main(int argc, char *argv[])
 {
 
@@ -64,6 +86,12 @@ int main(int argc, char *argv[])
                         bloomfilter_teardown),
       BENCHMARK_FIXTURE(bloomfilter_test, repeat, size, bloomfilter_setup,
                         bloomfilter_teardown),
+      BENCHMARK_FIXTURE(bloomfilter_huge_set, repeat, size,
+                        bloomfilter_huge_setup, bloomfilter_teardown),
+      BENCHMARK_FIXTURE(bloomfilter_huge_test, repeat, size,
+                        bloomfilter_huge_setup, bloomfilter_teardown),
+      BENCHMARK_FIXTURE(bloomfilter_interleave_test, repeat, size,
+                        bloomfilter_interleave_setup, bloomfilter_teardown),
   };
 
   run_benchmarks(benchmarks, sizeof(benchmarks) / sizeof(benchmarks[0]));
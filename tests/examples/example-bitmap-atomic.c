@@ -0,0 +1,57 @@
+#include <assert.h>
+#include <pthread.h>
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_atomic.h>
+
+#define N_THREADS 4
+
+static struct tw_bitmap_atomic *shared;
+
+static void *ingest(void *opaque)
+{
+  const uint64_t offset = (uint64_t)(uintptr_t)opaque;
+
+  /** threads write concurrently without locking */
+  for (uint64_t pos = offset; pos < shared->size; pos += 2) {
+    tw_bitmap_atomic_set(shared, pos);
+  }
+
+  return NULL;
+}
+
+int main()
+{
+  const uint64_t nbits = 1UL << 20;
+  pthread_t threads[N_THREADS];
+
+  shared = tw_bitmap_atomic_new(nbits);
+  assert(shared);
+
+  /** two threads for even positions, two for odd positions */
+  for (uint64_t i = 0; i < N_THREADS; ++i) {
+    pthread_create(&threads[i], NULL, ingest, (void *)(uintptr_t)(i % 2));
+  }
+
+  for (uint64_t i = 0; i < N_THREADS; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  /** striped counters are exact once writers are done */
+  assert(tw_bitmap_atomic_count(shared) == nbits);
+
+  /** a single thread wins a race on a position */
+  assert(tw_bitmap_atomic_test_and_clear(shared, 42));
+  assert(!tw_bitmap_atomic_test_and_clear(shared, 42));
+
+  /** copy to a regular bitmap to use set operations */
+  struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+  assert(bitmap);
+  assert(tw_bitmap_atomic_copy(shared, bitmap));
+  assert(tw_bitmap_count(bitmap) == nbits - 1);
+  assert(tw_bitmap_find_first_zero(bitmap) == 42);
+
+  tw_bitmap_free(bitmap);
+  tw_bitmap_atomic_free(shared);
+
+  return 0;
+}
@@ -0,0 +1,34 @@
+#include <assert.h>
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_rank.h>
+
+int main()
+{
+  const uint64_t nbits = 1UL << 20;
+  struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+
+  assert(bitmap);
+
+  /** every third bit is active */
+  for (uint64_t pos = 0; pos < nbits; pos += 3) {
+    tw_bitmap_set(bitmap, pos);
+  }
+
+  struct tw_bitmap_rank *rank = tw_bitmap_rank_new(bitmap);
+  assert(rank);
+
+  /** 0, 3 and 6 precede position 7 */
+  assert(tw_bitmap_rank_count(rank, 7) == 3);
+  /** the active bit with 1000 active bits before it */
+  assert(tw_bitmap_rank_select(rank, 1000) == 3000);
+
+  /** modifications invalidate the index, the next query rebuilds it */
+  tw_bitmap_clear(bitmap, 0);
+  assert(tw_bitmap_rank_stale(rank));
+  assert(tw_bitmap_rank_select(rank, 1000) == 3003);
+
+  tw_bitmap_rank_free(rank);
+  tw_bitmap_free(bitmap);
+
+  return 0;
+}
@@ -0,0 +1,193 @@
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_atomic.h>
+
+#include "../src/twiddle/macrology.h"
+#include "test.h"
+
+#define N_THREADS 8
+
+START_TEST(test_bitmap_atomic_basic)
+{
+  DESCRIBE_TEST;
+
+  const uint32_t sizes[] = {32, 512, 1 << 12, (1 << 15) + 3};
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    const uint32_t nbits = sizes[i];
+    struct tw_bitmap_atomic *bitmap = tw_bitmap_atomic_new(nbits);
+    ck_assert_ptr_ne(bitmap, NULL);
+    ck_assert_uint_ge(bitmap->size, nbits);
+    ck_assert_uint_eq(tw_bitmap_atomic_count(bitmap), 0);
+
+    for (uint32_t pos = 0; pos < nbits; pos += 3) {
+      ck_assert(!tw_bitmap_atomic_test(bitmap, pos));
+      ck_assert(!tw_bitmap_atomic_test_and_set(bitmap, pos));
+      ck_assert(tw_bitmap_atomic_test_and_set(bitmap, pos));
+      tw_bitmap_atomic_set(bitmap, pos);
+      ck_assert(tw_bitmap_atomic_test(bitmap, pos));
+    }
+    ck_assert_uint_eq(tw_bitmap_atomic_count(bitmap),
+                      TW_DIV_ROUND_UP(nbits, 3));
+
+    for (uint32_t pos = 0; pos < nbits; pos += 6) {
+      ck_assert(tw_bitmap_atomic_test_and_clear(bitmap, pos));
+      ck_assert(!tw_bitmap_atomic_test_and_clear(bitmap, pos));
+      tw_bitmap_atomic_clear(bitmap, pos);
+      ck_assert(!tw_bitmap_atomic_test(bitmap, pos));
+    }
+    ck_assert_uint_eq(tw_bitmap_atomic_count(bitmap),
+                      TW_DIV_ROUND_UP(nbits, 3) - TW_DIV_ROUND_UP(nbits, 6));
+
+    /* the destination is resized to the source */
+    struct tw_bitmap *copy = tw_bitmap_new(2 * nbits);
+    tw_bitmap_fill(copy);
+    ck_assert_ptr_eq(tw_bitmap_atomic_copy(bitmap, copy), copy);
+    ck_assert_uint_eq(copy->size, bitmap->size);
+    ck_assert_uint_eq(tw_bitmap_count(copy), tw_bitmap_atomic_count(bitmap));
+    for (uint32_t pos = 0; pos < nbits; ++pos) {
+      ck_assert(tw_bitmap_test(copy, pos) ==
+                tw_bitmap_atomic_test(bitmap, pos));
+    }
+
+    ck_assert_ptr_eq(tw_bitmap_atomic_zero(bitmap), bitmap);
+    ck_assert_uint_eq(tw_bitmap_atomic_count(bitmap), 0);
+    ck_assert(!tw_bitmap_atomic_test(bitmap, 3));
+
+    tw_bitmap_free(copy);
+    tw_bitmap_atomic_free(bitmap);
+  }
+}
+END_TEST
+
+struct worker {
+  struct tw_bitmap_atomic *bitmap;
+  uint64_t offset;
+  uint64_t n_won;
+};
+
+/* every thread races on every position, in a different order */
+static void *worker_test_and_set(void *opaque)
+{
+  struct worker *worker = (struct worker *)opaque;
+  const uint64_t size = worker->bitmap->size;
+
+  for (uint64_t i = 0; i < size; ++i) {
+    const uint64_t pos = (i + worker->offset) % size;
+    worker->n_won += !tw_bitmap_atomic_test_and_set(worker->bitmap, pos);
+  }
+
+  return NULL;
+}
+
+static void *worker_test_and_clear(void *opaque)
+{
+  struct worker *worker = (struct worker *)opaque;
+  const uint64_t size = worker->bitmap->size;
+
+  for (uint64_t i = 0; i < size; ++i) {
+    const uint64_t pos = (i + worker->offset) % size;
+    worker->n_won += tw_bitmap_atomic_test_and_clear(worker->bitmap, pos);
+  }
+
+  return NULL;
+}
+
+static uint64_t run_workers(struct tw_bitmap_atomic *bitmap,
+                            void *(*routine)(void *))
+{
+  pthread_t threads[N_THREADS];
+  struct worker workers[N_THREADS];
+  uint64_t n_won = 0;
+
+  for (size_t i = 0; i < N_THREADS; ++i) {
+    workers[i] = (struct worker){
+        .bitmap = bitmap, .offset = i * 61, .n_won = 0,
+    };
+    ck_assert_int_eq(
+        pthread_create(&threads[i], NULL, routine, &workers[i]), 0);
+  }
+
+  for (size_t i = 0; i < N_THREADS; ++i) {
+    ck_assert_int_eq(pthread_join(threads[i], NULL), 0);
+    n_won += workers[i].n_won;
+  }
+
+  return n_won;
+}
+
+START_TEST(test_bitmap_atomic_concurrent)
+{
+  DESCRIBE_TEST;
+
+  const uint32_t nbits = 1 << 16;
+  struct tw_bitmap_atomic *bitmap = tw_bitmap_atomic_new(nbits);
+
+  for (int round = 0; round < 4; ++round) {
+    /* each position is won by exactly one thread */
+    ck_assert_uint_eq(run_workers(bitmap, worker_test_and_set), nbits);
+    ck_assert_uint_eq(tw_bitmap_atomic_count(bitmap), nbits);
+
+    ck_assert_uint_eq(run_workers(bitmap, worker_test_and_clear), nbits);
+    ck_assert_uint_eq(tw_bitmap_atomic_count(bitmap), 0);
+  }
+
+  tw_bitmap_atomic_free(bitmap);
+}
+END_TEST
+
+START_TEST(test_bitmap_atomic_errors)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t nbits = 1 << 10;
+  struct tw_bitmap_atomic *bitmap = tw_bitmap_atomic_new(nbits);
+  struct tw_bitmap *other = tw_bitmap_new(2 * nbits);
+
+  ck_assert_ptr_eq(tw_bitmap_atomic_new(0), NULL);
+  ck_assert_ptr_eq(tw_bitmap_atomic_new(TW_BITMAP_MAX_BITS + 1), NULL);
+
+  tw_bitmap_atomic_set(NULL, 0);
+  tw_bitmap_atomic_set(bitmap, nbits);
+  tw_bitmap_atomic_clear(NULL, 0);
+  ck_assert(!tw_bitmap_atomic_test(NULL, 0));
+  ck_assert(!tw_bitmap_atomic_test(bitmap, nbits));
+  ck_assert(!tw_bitmap_atomic_test_and_set(NULL, 0));
+  ck_assert(!tw_bitmap_atomic_test_and_set(bitmap, nbits));
+  ck_assert(!tw_bitmap_atomic_test_and_clear(NULL, 0));
+  ck_assert_uint_eq(tw_bitmap_atomic_count(NULL), 0);
+  ck_assert_uint_eq(tw_bitmap_atomic_count(bitmap), 0);
+  ck_assert_ptr_eq(tw_bitmap_atomic_zero(NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_atomic_copy(NULL, other), NULL);
+  ck_assert_ptr_eq(tw_bitmap_atomic_copy(bitmap, NULL), NULL);
+
+  tw_bitmap_free(other);
+  tw_bitmap_atomic_free(bitmap);
+}
+END_TEST
+
+int run_tests()
+{
+  int number_failed;
+
+  Suite *s = suite_create("bitmap_atomic");
+  SRunner *runner = srunner_create(s);
+
+  TCase *tc = tcase_create("basic");
+  tcase_add_test(tc, test_bitmap_atomic_basic);
+  tcase_add_test(tc, test_bitmap_atomic_concurrent);
+  tcase_add_test(tc, test_bitmap_atomic_errors);
+  tcase_set_timeout(tc, 15);
+  suite_add_tcase(s, tc);
+
+  srunner_run_all(runner, CK_NORMAL);
+  number_failed = srunner_ntests_failed(runner);
+  srunner_free(runner);
+
+  return number_failed;
+}
+
+int main() { return (run_tests() == 0) ? EXIT_SUCCESS : EXIT_FAILURE; }
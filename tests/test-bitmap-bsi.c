@@ -0,0 +1,282 @@
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_bsi.h>
+
+#include "../src/twiddle/macrology.h"
+#include "test.h"
+
+/* value of the rows, or `-1` for rows without a value */
+static int64_t *fill(struct tw_bitmap_bsi *bsi, uint64_t seed)
+{
+  int64_t *values = malloc(bsi->size * sizeof(int64_t));
+  ck_assert_ptr_ne(values, NULL);
+
+  const uint64_t mask = (bsi->bits == 64) ? ~0ULL : (1ULL << bsi->bits) - 1;
+
+  for (uint64_t row = 0; row < bsi->size; ++row) {
+    if (xorshift64(&seed) % 5 == 0) {
+      values[row] = -1;
+    } else {
+      /* few distinct values, such that ties are frequent */
+      values[row] = (int64_t)((xorshift64(&seed) % 1000) & mask);
+      tw_bitmap_bsi_set(bsi, row, values[row]);
+    }
+  }
+
+  return values;
+}
+
+static bool compare(int64_t value, enum tw_bitmap_bsi_op op, uint64_t x)
+{
+  const uint64_t v = (uint64_t)value;
+  switch (op) {
+  case TW_BITMAP_BSI_LT:
+    return v < x;
+  case TW_BITMAP_BSI_LE:
+    return v <= x;
+  case TW_BITMAP_BSI_GT:
+    return v > x;
+  case TW_BITMAP_BSI_GE:
+    return v >= x;
+  case TW_BITMAP_BSI_EQ:
+    return v == x;
+  default:
+    return v != x;
+  }
+}
+
+START_TEST(test_bitmap_bsi_basic)
+{
+  DESCRIBE_TEST;
+
+  const uint8_t bits[] = {1, 10, 33, 64};
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(bits); ++i) {
+    struct tw_bitmap_bsi *bsi = tw_bitmap_bsi_new(1000, bits[i]);
+    ck_assert_ptr_ne(bsi, NULL);
+    ck_assert_uint_eq(tw_bitmap_bsi_count(bsi), 0);
+
+    const uint64_t max = (bits[i] == 64) ? ~0ULL : (1ULL << bits[i]) - 1;
+    uint64_t value;
+
+    tw_bitmap_bsi_set(bsi, 0, max);
+    tw_bitmap_bsi_set(bsi, 999, 0);
+    tw_bitmap_bsi_set(bsi, 500, max / 3);
+    ck_assert_uint_eq(tw_bitmap_bsi_count(bsi), 3);
+
+    ck_assert(tw_bitmap_bsi_get(bsi, 0, &value));
+    ck_assert_uint_eq(value, max);
+    ck_assert(tw_bitmap_bsi_get(bsi, 999, &value));
+    ck_assert_uint_eq(value, 0);
+    ck_assert(tw_bitmap_bsi_get(bsi, 500, &value));
+    ck_assert_uint_eq(value, max / 3);
+    ck_assert(!tw_bitmap_bsi_get(bsi, 1, &value));
+
+    /* overwriting clears the previous bits */
+    tw_bitmap_bsi_set(bsi, 0, 1);
+    ck_assert(tw_bitmap_bsi_get(bsi, 0, &value));
+    ck_assert_uint_eq(value, 1);
+    ck_assert_uint_eq(tw_bitmap_bsi_count(bsi), 3);
+    ck_assert_uint_eq(tw_bitmap_bsi_sum(bsi, NULL), 1 + max / 3);
+
+    tw_bitmap_bsi_clear(bsi, 500);
+    ck_assert(!tw_bitmap_bsi_get(bsi, 500, &value));
+    ck_assert_uint_eq(tw_bitmap_bsi_count(bsi), 2);
+    ck_assert_uint_eq(tw_bitmap_bsi_sum(bsi, NULL), 1);
+
+    tw_bitmap_bsi_free(bsi);
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_bsi_compare)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t size = 5000;
+  const uint8_t bits[] = {4, 10, 64};
+  const uint64_t xs[] = {0, 1, 7, 15, 16, 499, 500, 999, 1000, 1 << 20};
+
+  for (size_t b = 0; b < TW_ARRAY_SIZE(bits); ++b) {
+    struct tw_bitmap_bsi *bsi = tw_bitmap_bsi_new(size, bits[b]);
+    int64_t *values = fill(bsi, 0xC0FFEE + b);
+
+    struct tw_bitmap *filter = tw_bitmap_new(size);
+    struct tw_bitmap *dst = tw_bitmap_new(size);
+    for (uint64_t row = 0; row < size; row += 3) {
+      tw_bitmap_set(filter, row);
+    }
+
+    for (size_t j = 0; j < TW_ARRAY_SIZE(xs); ++j) {
+      for (int op = TW_BITMAP_BSI_LT; op <= TW_BITMAP_BSI_NE; ++op) {
+        ck_assert_ptr_eq(tw_bitmap_bsi_compare(bsi, op, xs[j], NULL, dst),
+                         dst);
+        uint64_t mismatches = 0, expected = 0;
+        for (uint64_t row = 0; row < size; ++row) {
+          const bool match =
+              values[row] >= 0 && compare(values[row], op, xs[j]);
+          mismatches += (match != tw_bitmap_test(dst, row));
+          expected += match;
+        }
+        ck_assert_uint_eq(mismatches, 0);
+        ck_assert_uint_eq(tw_bitmap_count(dst), expected);
+
+        ck_assert_ptr_eq(tw_bitmap_bsi_compare(bsi, op, xs[j], filter, dst),
+                         dst);
+        for (uint64_t row = 0; row < size; ++row) {
+          const bool match = row % 3 == 0 && values[row] >= 0 &&
+                             compare(values[row], op, xs[j]);
+          mismatches += (match != tw_bitmap_test(dst, row));
+        }
+        ck_assert_uint_eq(mismatches, 0);
+      }
+
+      const uint64_t lo = xs[j] / 2, hi = xs[j];
+      ck_assert_ptr_eq(tw_bitmap_bsi_between(bsi, lo, hi, filter, dst), dst);
+      uint64_t mismatches = 0;
+      for (uint64_t row = 0; row < size; ++row) {
+        const bool match = row % 3 == 0 && values[row] >= 0 &&
+                           (uint64_t)values[row] >= lo &&
+                           (uint64_t)values[row] <= hi;
+        mismatches += (match != tw_bitmap_test(dst, row));
+      }
+      ck_assert_uint_eq(mismatches, 0);
+    }
+
+    /* empty range */
+    ck_assert_ptr_eq(tw_bitmap_bsi_between(bsi, 10, 5, NULL, dst), dst);
+    ck_assert(tw_bitmap_empty(dst));
+
+    tw_bitmap_free(dst);
+    tw_bitmap_free(filter);
+    free(values);
+    tw_bitmap_bsi_free(bsi);
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_bsi_aggregates)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t size = 5000;
+  struct tw_bitmap_bsi *bsi = tw_bitmap_bsi_new(size, 12);
+  int64_t *values = fill(bsi, 0xDEADBEEF);
+
+  struct tw_bitmap *filter = tw_bitmap_new(size);
+  struct tw_bitmap *dst = tw_bitmap_new(size);
+  for (uint64_t row = 0; row < size; row += 7) {
+    tw_bitmap_set(filter, row);
+  }
+
+  uint64_t sum = 0, filtered_sum = 0, n_filtered = 0;
+  for (uint64_t row = 0; row < size; ++row) {
+    if (values[row] >= 0) {
+      sum += values[row];
+      if (row % 7 == 0) {
+        filtered_sum += values[row];
+        n_filtered++;
+      }
+    }
+  }
+  ck_assert_uint_eq(tw_bitmap_bsi_sum(bsi, NULL), sum);
+  ck_assert_uint_eq(tw_bitmap_bsi_sum(bsi, filter), filtered_sum);
+
+  const uint64_t ks[] = {0, 1, 10, 100, 999, n_filtered, size};
+  for (size_t i = 0; i < TW_ARRAY_SIZE(ks); ++i) {
+    ck_assert_ptr_eq(tw_bitmap_bsi_top_k(bsi, ks[i], filter, dst), dst);
+    ck_assert_uint_eq(tw_bitmap_count(dst), tw_min(ks[i], n_filtered));
+
+    /* selected rows are filtered, and none has a smaller value than others */
+    int64_t min_selected = 1 << 12, max_discarded = -1;
+    for (uint64_t row = 0; row < size; ++row) {
+      if (row % 7 != 0 || values[row] < 0) {
+        ck_assert(!tw_bitmap_test(dst, row));
+      } else if (tw_bitmap_test(dst, row)) {
+        min_selected = tw_min(min_selected, values[row]);
+      } else {
+        max_discarded = tw_max(max_discarded, values[row]);
+      }
+    }
+    ck_assert_int_le(max_discarded, min_selected);
+  }
+
+  tw_bitmap_free(dst);
+  tw_bitmap_free(filter);
+  free(values);
+  tw_bitmap_bsi_free(bsi);
+}
+END_TEST
+
+START_TEST(test_bitmap_bsi_errors)
+{
+  DESCRIBE_TEST;
+
+  struct tw_bitmap_bsi *bsi = tw_bitmap_bsi_new(1000, 8);
+  struct tw_bitmap *dst = tw_bitmap_new(1000);
+  struct tw_bitmap *other = tw_bitmap_new(5000);
+  uint64_t value;
+
+  ck_assert_ptr_eq(tw_bitmap_bsi_new(0, 8), NULL);
+  ck_assert_ptr_eq(tw_bitmap_bsi_new(TW_BITMAP_MAX_BITS + 1, 8), NULL);
+  ck_assert_ptr_eq(tw_bitmap_bsi_new(1000, 0), NULL);
+  ck_assert_ptr_eq(tw_bitmap_bsi_new(1000, TW_BITMAP_BSI_MAX_BITS + 1), NULL);
+
+  /* This should not raise a segfault. */
+  tw_bitmap_bsi_set(NULL, 0, 0);
+  tw_bitmap_bsi_set(bsi, 1000, 0);
+  tw_bitmap_bsi_set(bsi, 0, 256);
+  tw_bitmap_bsi_clear(NULL, 0);
+  tw_bitmap_bsi_clear(bsi, 1000);
+  ck_assert_uint_eq(tw_bitmap_bsi_count(bsi), 0);
+  ck_assert_uint_eq(tw_bitmap_bsi_count(NULL), 0);
+
+  ck_assert(!tw_bitmap_bsi_get(NULL, 0, &value));
+  ck_assert(!tw_bitmap_bsi_get(bsi, 0, NULL));
+  ck_assert(!tw_bitmap_bsi_get(bsi, 1000, &value));
+
+  ck_assert_ptr_eq(tw_bitmap_bsi_compare(NULL, 0, 0, NULL, dst), NULL);
+  ck_assert_ptr_eq(tw_bitmap_bsi_compare(bsi, 0, 0, NULL, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_bsi_compare(bsi, 0, 0, NULL, other), NULL);
+  ck_assert_ptr_eq(tw_bitmap_bsi_compare(bsi, 0, 0, other, dst), NULL);
+  ck_assert_ptr_eq(tw_bitmap_bsi_compare(bsi, TW_BITMAP_BSI_NE + 1, 0, NULL,
+                                         dst),
+                   NULL);
+  ck_assert_ptr_eq(tw_bitmap_bsi_between(NULL, 0, 1, NULL, dst), NULL);
+  ck_assert_ptr_eq(tw_bitmap_bsi_between(bsi, 0, 1, other, dst), NULL);
+  ck_assert_uint_eq(tw_bitmap_bsi_sum(NULL, NULL), 0);
+  ck_assert_uint_eq(tw_bitmap_bsi_sum(bsi, other), 0);
+  ck_assert_ptr_eq(tw_bitmap_bsi_top_k(NULL, 1, NULL, dst), NULL);
+  ck_assert_ptr_eq(tw_bitmap_bsi_top_k(bsi, 1, NULL, other), NULL);
+
+  tw_bitmap_bsi_free(NULL);
+
+  tw_bitmap_free(other);
+  tw_bitmap_free(dst);
+  tw_bitmap_bsi_free(bsi);
+}
+END_TEST
+
+int run_tests()
+{
+  int number_failed;
+
+  Suite *s = suite_create("bitmap_bsi");
+  SRunner *runner = srunner_create(s);
+
+  TCase *tc = tcase_create("basic");
+  tcase_add_test(tc, test_bitmap_bsi_basic);
+  tcase_add_test(tc, test_bitmap_bsi_compare);
+  tcase_add_test(tc, test_bitmap_bsi_aggregates);
+  tcase_add_test(tc, test_bitmap_bsi_errors);
+  suite_add_tcase(s, tc);
+
+  srunner_run_all(runner, CK_NORMAL);
+  number_failed = srunner_ntests_failed(runner);
+  srunner_free(runner);
+
+  return number_failed;
+}
+
+int main() { return (run_tests() == 0) ? EXIT_SUCCESS : EXIT_FAILURE; }
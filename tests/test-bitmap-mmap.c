@@ -0,0 +1,221 @@
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_mmap.h>
+
+#include "../src/twiddle/macrology.h"
+#include "test.h"
+
+/* unique temporary path, the file is created by the library */
+static void temp_path(char *path)
+{
+  strcpy(path, "/tmp/test-bitmap-mmap-XXXXXX");
+  const int fd = mkstemp(path);
+  ck_assert_int_ge(fd, 0);
+  close(fd);
+}
+
+START_TEST(test_bitmap_mmap_persist)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t sizes[] = {1, 512, 1 << 16, (1 << 20) + 7};
+  uint64_t seed = 0xFEEDFACECAFEBEEFULL;
+  char path[64];
+  temp_path(path);
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    struct tw_bitmap *bitmap = tw_bitmap_create_mmap(path, sizes[i]);
+    ck_assert_ptr_ne(bitmap, NULL);
+    ck_assert_uint_ge(bitmap->size, sizes[i]);
+    ck_assert(tw_bitmap_empty(bitmap));
+
+    bitmap_random_fill(bitmap, &seed, 7);
+    ck_assert(tw_bitmap_sync_mmap(bitmap));
+    struct tw_bitmap *expected = tw_bitmap_clone(bitmap);
+    tw_bitmap_free(bitmap);
+
+    /* modifications of read only bitmaps are not persisted */
+    bitmap = tw_bitmap_open_mmap(path, false);
+    ck_assert_ptr_ne(bitmap, NULL);
+    ck_assert(tw_bitmap_equal(bitmap, expected));
+    ck_assert_uint_eq(bitmap->count, expected->count);
+    tw_bitmap_not(bitmap);
+    tw_bitmap_free(bitmap);
+
+    bitmap = tw_bitmap_open_mmap(path, true);
+    ck_assert_ptr_ne(bitmap, NULL);
+    ck_assert(tw_bitmap_equal(bitmap, expected));
+    tw_bitmap_not(bitmap);
+    tw_bitmap_not(expected);
+    tw_bitmap_free(bitmap);
+
+    bitmap = tw_bitmap_open_mmap(path, false);
+    ck_assert(tw_bitmap_equal(bitmap, expected));
+    ck_assert_uint_eq(bitmap->count, expected->count);
+
+    tw_bitmap_free(bitmap);
+    tw_bitmap_free(expected);
+  }
+
+  unlink(path);
+}
+END_TEST
+
+START_TEST(test_bitmap_mmap_recover)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t nbits = 1 << 16;
+  char path[64];
+  temp_path(path);
+
+  struct tw_bitmap *bitmap = tw_bitmap_create_mmap(path, nbits);
+  tw_bitmap_set_range(bitmap, 100, 1099);
+
+  /* a crashed writer leaves a dirty header with a stale count */
+  ck_assert(tw_bitmap_sync_mmap(bitmap));
+  tw_bitmap_set_range(bitmap, 2000, 2999);
+  struct tw_bitmap *reader = tw_bitmap_open_mmap(path, false);
+  ck_assert_ptr_ne(reader, NULL);
+  ck_assert_uint_eq(tw_bitmap_count(reader), 2000);
+  ck_assert_uint_eq(tw_bitmap_count(reader), bitmap->count);
+
+  tw_bitmap_free(reader);
+  tw_bitmap_free(bitmap);
+  unlink(path);
+}
+END_TEST
+
+START_TEST(test_bitmap_mmap_set_operations)
+{
+  DESCRIBE_TEST;
+
+  /* a partial last chunk */
+  const uint64_t nbits = 3 * TW_BITMAP_MMAP_CHUNK + 512;
+  uint64_t seed = 0x1234567887654321ULL;
+  char src_path[64], dst_path[64];
+  temp_path(src_path);
+  temp_path(dst_path);
+
+  struct tw_bitmap *src = tw_bitmap_create_mmap(src_path, nbits);
+  struct tw_bitmap *dst = tw_bitmap_create_mmap(dst_path, nbits);
+
+  /* sparse, such that most pages are holes */
+  for (int i = 0; i < 10000; ++i) {
+    const uint64_t r = xorshift64(&seed);
+    tw_bitmap_set(src, r % nbits);
+    tw_bitmap_set(dst, (r >> 17) % nbits);
+    if (i % 3 == 0) {
+      tw_bitmap_set(dst, r % nbits);
+    }
+  }
+
+  struct tw_bitmap *expected = tw_bitmap_clone(dst);
+  ck_assert_ptr_eq(tw_bitmap_intersection_mmap(src, dst), dst);
+  tw_bitmap_intersection(src, expected);
+  ck_assert(tw_bitmap_equal(dst, expected));
+  ck_assert_uint_eq(dst->count, expected->count);
+
+  ck_assert_ptr_eq(tw_bitmap_union_mmap(src, dst), dst);
+  tw_bitmap_union(src, expected);
+  ck_assert(tw_bitmap_equal(dst, expected));
+  ck_assert_uint_eq(dst->count, expected->count);
+
+  /* heap bitmaps are supported too */
+  tw_bitmap_zero(dst);
+  ck_assert_ptr_eq(tw_bitmap_union_mmap(src, expected), expected);
+  ck_assert_ptr_eq(tw_bitmap_intersection_mmap(src, expected), expected);
+  ck_assert(tw_bitmap_equal(src, expected));
+
+  /* a larger source grows the destination, unless file-backed */
+  struct tw_bitmap *large = tw_bitmap_new(nbits + TW_BITMAP_MMAP_CHUNK);
+  tw_bitmap_fill(large);
+  ck_assert_ptr_eq(tw_bitmap_union_mmap(large, dst), NULL);
+  ck_assert_ptr_eq(tw_bitmap_union_mmap(large, expected), expected);
+  ck_assert_uint_eq(expected->size, large->size);
+  ck_assert(tw_bitmap_full(expected));
+
+  /* a smaller source clears the destination past its size */
+  ck_assert_ptr_eq(tw_bitmap_intersection_mmap(src, expected), expected);
+  ck_assert_uint_eq(expected->size, large->size);
+  ck_assert(tw_bitmap_equal(src, expected));
+  ck_assert_uint_eq(expected->count, src->count);
+
+  ck_assert_ptr_eq(tw_bitmap_union_mmap(src, large), large);
+  ck_assert(tw_bitmap_full(large));
+  ck_assert_uint_eq(large->count, large->size);
+
+  tw_bitmap_free(large);
+  tw_bitmap_free(expected);
+  tw_bitmap_free(dst);
+  tw_bitmap_free(src);
+  unlink(dst_path);
+  unlink(src_path);
+}
+END_TEST
+
+START_TEST(test_bitmap_mmap_errors)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t nbits = 1 << 12;
+  char path[64];
+  temp_path(path);
+
+  ck_assert_ptr_eq(tw_bitmap_create_mmap(NULL, nbits), NULL);
+  ck_assert_ptr_eq(tw_bitmap_create_mmap(path, 0), NULL);
+  ck_assert_ptr_eq(tw_bitmap_create_mmap(path, TW_BITMAP_MAX_BITS + 1), NULL);
+  ck_assert_ptr_eq(tw_bitmap_create_mmap("/nonexistent/bitmap", nbits), NULL);
+
+  /* not a bitmap file */
+  ck_assert_ptr_eq(tw_bitmap_open_mmap(NULL, false), NULL);
+  ck_assert_ptr_eq(tw_bitmap_open_mmap(path, false), NULL);
+  ck_assert_ptr_eq(tw_bitmap_open_mmap("/nonexistent/bitmap", false), NULL);
+
+  /* truncated bitmap file */
+  struct tw_bitmap *bitmap = tw_bitmap_create_mmap(path, nbits);
+  ck_assert_ptr_eq(tw_bitmap_resize(bitmap, 2 * nbits), NULL);
+  ck_assert_ptr_eq(tw_bitmap_reserve(bitmap, 2 * nbits), NULL);
+  tw_bitmap_free(bitmap);
+  ck_assert_int_eq(truncate(path, 4096 + nbits / 16), 0);
+  ck_assert_ptr_eq(tw_bitmap_open_mmap(path, false), NULL);
+
+  struct tw_bitmap *heap = tw_bitmap_new(nbits);
+  ck_assert(!tw_bitmap_sync_mmap(NULL));
+  ck_assert(!tw_bitmap_sync_mmap(heap));
+  ck_assert_ptr_eq(tw_bitmap_union_mmap(NULL, heap), NULL);
+  ck_assert_ptr_eq(tw_bitmap_union_mmap(heap, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_intersection_mmap(NULL, heap), NULL);
+
+  tw_bitmap_free(heap);
+  unlink(path);
+}
+END_TEST
+
+int run_tests()
+{
+  int number_failed;
+
+  Suite *s = suite_create("bitmap_mmap");
+  SRunner *runner = srunner_create(s);
+
+  TCase *tc = tcase_create("basic");
+  tcase_add_test(tc, test_bitmap_mmap_persist);
+  tcase_add_test(tc, test_bitmap_mmap_recover);
+  tcase_add_test(tc, test_bitmap_mmap_set_operations);
+  tcase_add_test(tc, test_bitmap_mmap_errors);
+  tcase_set_timeout(tc, 15);
+  suite_add_tcase(s, tc);
+
+  srunner_run_all(runner, CK_NORMAL);
+  number_failed = srunner_ntests_failed(runner);
+  srunner_free(runner);
+
+  return number_failed;
+}
+
+int main() { return (run_tests() == 0) ? EXIT_SUCCESS : EXIT_FAILURE; }
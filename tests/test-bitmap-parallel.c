@@ -0,0 +1,241 @@
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_parallel.h>
+#include <twiddle/utils/thread_pool.h>
+
+#include "../src/twiddle/macrology.h"
+#include "test.h"
+
+static void count_task(void *opaque, size_t task)
+{
+  uint64_t *executed = (uint64_t *)opaque;
+  __atomic_fetch_add(&executed[task], 1, __ATOMIC_RELAXED);
+}
+
+START_TEST(test_thread_pool_basic)
+{
+  DESCRIBE_TEST;
+
+  const size_t n_threads[] = {1, 2, 5, 16};
+  const size_t n_tasks = 1000;
+  uint64_t executed[1000];
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(n_threads); ++i) {
+    struct tw_thread_pool *pool = tw_thread_pool_new(n_threads[i]);
+    ck_assert_ptr_ne(pool, NULL);
+    ck_assert_uint_eq(tw_thread_pool_size(pool), n_threads[i]);
+
+    /* pools are reused across loops of varying sizes */
+    for (size_t round = 1; round <= n_tasks; round *= 10) {
+      memset(executed, 0, sizeof(executed));
+      tw_thread_pool_run(pool, count_task, executed, round);
+      for (size_t task = 0; task < n_tasks; ++task) {
+        ck_assert_uint_eq(executed[task], task < round);
+      }
+    }
+
+    tw_thread_pool_free(pool);
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_parallel_operations)
+{
+  DESCRIBE_TEST;
+
+  /* a single chunk, and chunks of uneven sizes */
+  const uint64_t sizes[] = {1 << 12, 5 * TW_BITMAP_PARALLEL_MIN_CHUNK + 512};
+  const size_t n_threads[] = {1, 3, 8};
+
+  for (size_t t = 0; t < TW_ARRAY_SIZE(n_threads); ++t) {
+    struct tw_thread_pool *pool = tw_thread_pool_new(n_threads[t]);
+
+    for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+      const uint64_t nbits = sizes[i];
+      struct tw_bitmap *a = tw_bitmap_new(nbits);
+      struct tw_bitmap *b = tw_bitmap_new(nbits);
+      struct tw_bitmap *expected = tw_bitmap_new(nbits);
+      struct tw_bitmap *result = tw_bitmap_new(nbits);
+
+      uint64_t seed = 0xC0FFEE;
+      bitmap_random_set(a, &seed, 10000);
+      bitmap_random_set(b, &seed, 10000);
+
+      tw_bitmap_copy(b, expected);
+      tw_bitmap_copy(b, result);
+      ck_assert_ptr_eq(tw_bitmap_union_parallel(a, result, pool), result);
+      tw_bitmap_union(a, expected);
+      ck_assert(tw_bitmap_equal(result, expected));
+      ck_assert(tw_bitmap_equal_parallel(result, expected, pool));
+
+      tw_bitmap_copy(b, expected);
+      tw_bitmap_copy(b, result);
+      ck_assert_ptr_eq(tw_bitmap_intersection_parallel(a, result, pool),
+                       result);
+      tw_bitmap_intersection(a, expected);
+      ck_assert(tw_bitmap_equal(result, expected));
+
+      tw_bitmap_copy(b, expected);
+      tw_bitmap_copy(b, result);
+      ck_assert_ptr_eq(tw_bitmap_xor_parallel(a, result, pool), result);
+      tw_bitmap_xor(a, expected);
+      ck_assert(tw_bitmap_equal(result, expected));
+
+      ck_assert_ptr_eq(tw_bitmap_not_parallel(result, pool), result);
+      tw_bitmap_not(expected);
+      ck_assert(tw_bitmap_equal(result, expected));
+
+      /* equal counts, a single differing bit in the last chunk */
+      tw_bitmap_clear(result, tw_bitmap_find_last_bit(result));
+      tw_bitmap_set(result, tw_bitmap_find_last_zero(expected));
+      ck_assert_uint_eq(tw_bitmap_count(result), tw_bitmap_count(expected));
+      ck_assert(!tw_bitmap_equal_parallel(result, expected, pool));
+      ck_assert(!tw_bitmap_equal_parallel(a, b, pool));
+
+      ck_assert_ptr_eq(tw_bitmap_fill_parallel(result, pool), result);
+      ck_assert(tw_bitmap_full(result));
+      ck_assert_int64_t_eq(tw_bitmap_find_first_zero(result), -1);
+
+      ck_assert_ptr_eq(tw_bitmap_zero_parallel(result, pool), result);
+      ck_assert(tw_bitmap_empty(result));
+      ck_assert_int64_t_eq(tw_bitmap_find_first_bit(result), -1);
+
+      tw_bitmap_free(result);
+      tw_bitmap_free(expected);
+      tw_bitmap_free(b);
+      tw_bitmap_free(a);
+    }
+
+    tw_thread_pool_free(pool);
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_parallel_sizes)
+{
+  DESCRIBE_TEST;
+
+  /* the smaller bitmap ends in the middle of a chunk of the larger */
+  const uint64_t small = 2 * TW_BITMAP_PARALLEL_MIN_CHUNK + 512;
+  const uint64_t large = 5 * TW_BITMAP_PARALLEL_MIN_CHUNK + 512;
+  const uint64_t sizes[][2] = {{small, large}, {large, small}};
+  struct tw_thread_pool *pool = tw_thread_pool_new(3);
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    struct tw_bitmap *src = tw_bitmap_new(sizes[i][0]);
+    struct tw_bitmap *dst = tw_bitmap_new(sizes[i][1]);
+    uint64_t seed = 0xC0FFEE;
+    bitmap_random_set(src, &seed, 10000);
+    bitmap_random_set(dst, &seed, 10000);
+
+    struct tw_bitmap *expected = tw_bitmap_clone(dst);
+    struct tw_bitmap *result = tw_bitmap_clone(dst);
+    ck_assert_ptr_eq(tw_bitmap_union_parallel(src, result, pool), result);
+    tw_bitmap_union(src, expected);
+    ck_assert_uint_eq(result->size, expected->size);
+    ck_assert_uint_eq(tw_bitmap_count(result), tw_bitmap_count(expected));
+    ck_assert(tw_bitmap_equal_parallel(result, expected, pool));
+    tw_bitmap_free(result);
+    tw_bitmap_free(expected);
+
+    expected = tw_bitmap_clone(dst);
+    result = tw_bitmap_clone(dst);
+    ck_assert_ptr_eq(tw_bitmap_intersection_parallel(src, result, pool),
+                     result);
+    tw_bitmap_intersection(src, expected);
+    ck_assert_uint_eq(result->size, expected->size);
+    ck_assert_uint_eq(tw_bitmap_count(result), tw_bitmap_count(expected));
+    ck_assert(tw_bitmap_equal_parallel(result, expected, pool));
+    tw_bitmap_free(result);
+    tw_bitmap_free(expected);
+
+    expected = tw_bitmap_clone(dst);
+    result = tw_bitmap_clone(dst);
+    ck_assert_ptr_eq(tw_bitmap_xor_parallel(src, result, pool), result);
+    tw_bitmap_xor(src, expected);
+    ck_assert_uint_eq(result->size, expected->size);
+    ck_assert_uint_eq(tw_bitmap_count(result), tw_bitmap_count(expected));
+    ck_assert(tw_bitmap_equal_parallel(result, expected, pool));
+
+    /* bits past the smaller size are compared as cleared */
+    tw_bitmap_zero(dst);
+    ck_assert_ptr_eq(tw_bitmap_union_parallel(src, dst, pool), dst);
+    ck_assert(tw_bitmap_equal(src, dst));
+    ck_assert(tw_bitmap_equal_parallel(src, dst, pool));
+    ck_assert(tw_bitmap_equal_parallel(dst, src, pool));
+
+    /* equal counts, a single differing bit in the last chunk */
+    tw_bitmap_clear(dst, tw_bitmap_find_first_bit(dst));
+    tw_bitmap_set(dst, tw_bitmap_find_last_zero(dst));
+    ck_assert(!tw_bitmap_equal(src, dst));
+    ck_assert(!tw_bitmap_equal_parallel(src, dst, pool));
+    ck_assert(!tw_bitmap_equal_parallel(dst, src, pool));
+    tw_bitmap_free(result);
+    tw_bitmap_free(expected);
+
+    tw_bitmap_free(dst);
+    tw_bitmap_free(src);
+  }
+
+  tw_thread_pool_free(pool);
+}
+END_TEST
+
+START_TEST(test_bitmap_parallel_errors)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t nbits = 1 << 10;
+  struct tw_thread_pool *pool = tw_thread_pool_new(2);
+  struct tw_bitmap *a = tw_bitmap_new(nbits);
+  struct tw_bitmap *b = tw_bitmap_new(2 * nbits);
+
+  ck_assert_ptr_eq(tw_thread_pool_new(0), NULL);
+  ck_assert_ptr_eq(tw_thread_pool_new(TW_THREAD_POOL_MAX_THREADS + 1), NULL);
+  ck_assert_uint_eq(tw_thread_pool_size(NULL), 0);
+  tw_thread_pool_run(NULL, count_task, NULL, 1);
+  tw_thread_pool_run(pool, NULL, NULL, 1);
+  tw_thread_pool_free(NULL);
+
+  ck_assert_ptr_eq(tw_bitmap_union_parallel(NULL, a, pool), NULL);
+  ck_assert_ptr_eq(tw_bitmap_union_parallel(a, NULL, pool), NULL);
+  ck_assert_ptr_eq(tw_bitmap_union_parallel(a, a, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_not_parallel(NULL, pool), NULL);
+  ck_assert_ptr_eq(tw_bitmap_not_parallel(a, NULL), NULL);
+  ck_assert(!tw_bitmap_equal_parallel(a, a, NULL));
+  ck_assert(!tw_bitmap_equal_parallel(NULL, a, pool));
+  ck_assert_ptr_eq(tw_bitmap_zero_parallel(NULL, pool), NULL);
+  ck_assert_ptr_eq(tw_bitmap_fill_parallel(a, NULL), NULL);
+
+  tw_bitmap_free(b);
+  tw_bitmap_free(a);
+  tw_thread_pool_free(pool);
+}
+END_TEST
+
+int run_tests()
+{
+  int number_failed;
+
+  Suite *s = suite_create("bitmap_parallel");
+  SRunner *runner = srunner_create(s);
+
+  TCase *tc = tcase_create("basic");
+  tcase_add_test(tc, test_thread_pool_basic);
+  tcase_add_test(tc, test_bitmap_parallel_operations);
+  tcase_add_test(tc, test_bitmap_parallel_sizes);
+  tcase_add_test(tc, test_bitmap_parallel_errors);
+  tcase_set_timeout(tc, 30);
+  suite_add_tcase(s, tc);
+
+  srunner_run_all(runner, CK_NORMAL);
+  number_failed = srunner_ntests_failed(runner);
+  srunner_free(runner);
+
+  return number_failed;
+}
+
+int main() { return (run_tests() == 0) ? EXIT_SUCCESS : EXIT_FAILURE; }
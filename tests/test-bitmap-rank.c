@@ -0,0 +1,175 @@
+#include <signal.h>
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_rank.h>
+
+#include "../src/twiddle/macrology.h"
+#include "test.h"
+
+/* verify rank and select against a linear scan of the bitmap */
+static void validate_rank(struct tw_bitmap_rank *rank)
+{
+  const struct tw_bitmap *bitmap = rank->bitmap;
+  uint64_t count = 0;
+
+  for (uint64_t pos = 0; pos < bitmap->size; ++pos) {
+    ck_assert_int64_t_eq(tw_bitmap_rank_count(rank, pos), count);
+    if (tw_bitmap_test(bitmap, pos)) {
+      ck_assert_int64_t_eq(tw_bitmap_rank_select(rank, count), pos);
+      count++;
+    }
+  }
+
+  ck_assert_int64_t_eq(tw_bitmap_rank_count(rank, bitmap->size), count);
+  ck_assert_int64_t_eq(tw_bitmap_rank_select(rank, count), -1);
+}
+
+START_TEST(test_bitmap_rank_basic)
+{
+  DESCRIBE_TEST;
+
+  const uint32_t sizes[] = {512, 4096, 8192 + 3 * 512, 1 << 17};
+  /* dense blocks, sparse blocks and blocks without any active bit */
+  const uint32_t sparsities[] = {1, 2, 17, 1000, 100000};
+  uint64_t seed = 0xB16B00B5DEADBEEFULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    for (size_t j = 0; j < TW_ARRAY_SIZE(sparsities); ++j) {
+      struct tw_bitmap *bitmap = tw_bitmap_new(sizes[i]);
+      bitmap_random_fill(bitmap, &seed, sparsities[j]);
+
+      struct tw_bitmap_rank *rank = tw_bitmap_rank_new(bitmap);
+      ck_assert_ptr_ne(rank, NULL);
+      ck_assert(!tw_bitmap_rank_stale(rank));
+      validate_rank(rank);
+
+      tw_bitmap_rank_free(rank);
+      tw_bitmap_free(bitmap);
+    }
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_rank_edges)
+{
+  DESCRIBE_TEST;
+
+  const uint32_t nbits = 1 << 14;
+  struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+  struct tw_bitmap_rank *rank = tw_bitmap_rank_new(bitmap);
+
+  /* empty */
+  validate_rank(rank);
+  ck_assert_int64_t_eq(tw_bitmap_rank_select(rank, 0), -1);
+
+  /* full, samples fall on every block */
+  tw_bitmap_fill(bitmap);
+  validate_rank(rank);
+
+  /* first and last bits of words and blocks */
+  tw_bitmap_zero(bitmap);
+  for (uint64_t pos = 0; pos < nbits; pos += 64) {
+    tw_bitmap_set(bitmap, pos);
+    tw_bitmap_set(bitmap, pos + 63);
+  }
+  validate_rank(rank);
+
+  tw_bitmap_free(bitmap);
+  tw_bitmap_rank_free(rank);
+}
+END_TEST
+
+START_TEST(test_bitmap_rank_invalidation)
+{
+  DESCRIBE_TEST;
+
+  const uint32_t nbits = 1 << 12;
+  struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+  struct tw_bitmap *other = tw_bitmap_new(nbits);
+  struct tw_bitmap_rank *rank = tw_bitmap_rank_new(bitmap);
+
+  tw_bitmap_set(bitmap, 100);
+  ck_assert(tw_bitmap_rank_stale(rank));
+  ck_assert_int64_t_eq(tw_bitmap_rank_count(rank, 101), 1);
+  ck_assert(!tw_bitmap_rank_stale(rank));
+
+  /* no-op modifications keep the index */
+  tw_bitmap_set(bitmap, 100);
+  tw_bitmap_clear(bitmap, 101);
+  ck_assert(!tw_bitmap_rank_stale(rank));
+
+  tw_bitmap_test_and_set(bitmap, 200);
+  ck_assert(tw_bitmap_rank_stale(rank));
+  ck_assert_int64_t_eq(tw_bitmap_rank_select(rank, 1), 200);
+
+  tw_bitmap_clear(bitmap, 100);
+  ck_assert_int64_t_eq(tw_bitmap_rank_select(rank, 0), 200);
+
+  tw_bitmap_not(bitmap);
+  ck_assert(tw_bitmap_rank_stale(rank));
+  ck_assert_int64_t_eq(tw_bitmap_rank_select(rank, 200), 201);
+
+  tw_bitmap_set(other, 3000);
+  tw_bitmap_intersection(other, bitmap);
+  ck_assert(tw_bitmap_rank_stale(rank));
+  ck_assert_int64_t_eq(tw_bitmap_rank_select(rank, 0), 3000);
+
+  tw_bitmap_set(other, 0);
+  tw_bitmap_union(other, bitmap);
+  ck_assert(tw_bitmap_rank_update(rank));
+  ck_assert(!tw_bitmap_rank_stale(rank));
+  ck_assert_int64_t_eq(tw_bitmap_rank_count(rank, nbits), 2);
+
+  tw_bitmap_xor(other, bitmap);
+  ck_assert_int64_t_eq(tw_bitmap_rank_select(rank, 0), -1);
+
+  tw_bitmap_copy(other, bitmap);
+  ck_assert_int64_t_eq(tw_bitmap_rank_select(rank, 0), 0);
+
+  tw_bitmap_set_nocount(bitmap, 1000);
+  ck_assert(tw_bitmap_rank_stale(rank));
+  ck_assert_int64_t_eq(tw_bitmap_rank_select(rank, 1), 1000);
+  ck_assert(!tw_bitmap_rank_stale(rank));
+  ck_assert_int64_t_eq(tw_bitmap_rank_count(rank, nbits), 3);
+
+  tw_bitmap_rank_free(rank);
+  tw_bitmap_free(other);
+  tw_bitmap_free(bitmap);
+}
+END_TEST
+
+START_TEST(test_bitmap_rank_errors)
+{
+  DESCRIBE_TEST;
+
+  ck_assert_ptr_eq(tw_bitmap_rank_new(NULL), NULL);
+  ck_assert(!tw_bitmap_rank_stale(NULL));
+  ck_assert_ptr_eq(tw_bitmap_rank_update(NULL), NULL);
+  ck_assert_int64_t_eq(tw_bitmap_rank_count(NULL, 0), -1);
+  ck_assert_int64_t_eq(tw_bitmap_rank_select(NULL, 0), -1);
+}
+END_TEST
+
+int run_tests()
+{
+  int number_failed;
+
+  Suite *s = suite_create("bitmap_rank");
+  SRunner *runner = srunner_create(s);
+
+  TCase *tc = tcase_create("basic");
+  tcase_add_test(tc, test_bitmap_rank_basic);
+  tcase_add_test(tc, test_bitmap_rank_edges);
+  tcase_add_test(tc, test_bitmap_rank_invalidation);
+  tcase_add_test(tc, test_bitmap_rank_errors);
+  suite_add_tcase(s, tc);
+
+  srunner_run_all(runner, CK_NORMAL);
+  number_failed = srunner_ntests_failed(runner);
+  srunner_free(runner);
+
+  return number_failed;
+}
+
+int main() { return (run_tests() == 0) ? EXIT_SUCCESS : EXIT_FAILURE; }
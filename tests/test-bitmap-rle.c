@@ -466,6 +466,120 @@ START_TEST(test_bitmap_rle_intersection_advanced)
 }
 END_TEST
 
+START_TEST(test_bitmap_rle_relations)
+{
+  DESCRIBE_TEST;
+  const uint32_t nbits = 512;
+  struct tw_bitmap_rle *a = tw_bitmap_rle_new(nbits);
+  struct tw_bitmap_rle *b = tw_bitmap_rle_new(nbits);
+  struct tw_bitmap_rle *c = tw_bitmap_rle_new(nbits);
+
+  /* empty bitmaps are disjoint from and a subset of anything */
+  ck_assert(!tw_bitmap_rle_intersects(a, b));
+  ck_assert(tw_bitmap_rle_is_disjoint(a, b));
+  ck_assert(tw_bitmap_rle_is_subset(a, b));
+
+  tw_bitmap_rle_set_range(a, 0, 127);
+  tw_bitmap_rle_set_range(a, 255, 325);
+  tw_bitmap_rle_set_range(a, 409, 511);
+  tw_bitmap_rle_set_range(b, 128, 254);
+  tw_bitmap_rle_set_range(b, 326, 408);
+  ck_assert(!tw_bitmap_rle_intersects(a, b));
+  ck_assert(tw_bitmap_rle_is_disjoint(b, a));
+  ck_assert(!tw_bitmap_rle_is_subset(a, b));
+  ck_assert(tw_bitmap_rle_is_subset(b, tw_bitmap_rle_not(a, c)));
+
+  /* a single shared bit at the end of the last run */
+  tw_bitmap_rle_set(b, 511);
+  ck_assert(tw_bitmap_rle_intersects(a, b));
+  ck_assert(tw_bitmap_rle_intersects(b, a));
+  ck_assert(!tw_bitmap_rle_is_disjoint(a, b));
+
+  ck_assert(tw_bitmap_rle_is_subset(a, a));
+  ck_assert_ptr_ne(tw_bitmap_rle_intersection(a, b, c), NULL);
+  ck_assert(tw_bitmap_rle_is_subset(c, a));
+  ck_assert(tw_bitmap_rle_is_subset(c, b));
+  ck_assert_ptr_ne(tw_bitmap_rle_union(a, b, c), NULL);
+  ck_assert(tw_bitmap_rle_is_subset(a, c));
+  ck_assert(tw_bitmap_rle_is_subset(b, c));
+  ck_assert(!tw_bitmap_rle_is_subset(c, a));
+
+  /* a run of `c` overlapping two runs of `a` is not covered */
+  tw_bitmap_rle_zero(c);
+  tw_bitmap_rle_set_range(c, 120, 260);
+  ck_assert(tw_bitmap_rle_intersects(a, c));
+  ck_assert(!tw_bitmap_rle_is_subset(c, a));
+  tw_bitmap_rle_zero(c);
+  tw_bitmap_rle_set_range(c, 260, 300);
+  tw_bitmap_rle_set_range(c, 320, 330);
+  ck_assert(!tw_bitmap_rle_is_subset(c, a));
+
+  ck_assert(!tw_bitmap_rle_intersects(NULL, a));
+  ck_assert(!tw_bitmap_rle_is_disjoint(a, NULL));
+  ck_assert(!tw_bitmap_rle_is_subset(NULL, NULL));
+
+  tw_bitmap_rle_free(c);
+  tw_bitmap_rle_free(b);
+  tw_bitmap_rle_free(a);
+}
+END_TEST
+
+START_TEST(test_bitmap_rle_conversion)
+{
+  DESCRIBE_TEST;
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    for (size_t j = 0; j < TW_ARRAY_SIZE(offsets); ++j) {
+      const uint32_t nbits = sizes[i] + offsets[j];
+
+      struct tw_bitmap *dense = tw_bitmap_new(nbits);
+      struct tw_bitmap *back = tw_bitmap_new(nbits);
+      struct tw_bitmap_rle *rle = tw_bitmap_rle_new(nbits);
+      struct tw_bitmap_rle *expected = tw_bitmap_rle_new(nbits);
+
+      /**
+       * short runs in every word, a run crossing words, and a run up to the
+       * last bit spanning whole words
+       */
+      for (uint32_t pos = 0; pos < nbits; ++pos) {
+        const bool set = (pos < nbits / 4 && pos % 4 == 1) ||
+                         (pos >= nbits / 4 + 60 && pos < nbits / 4 + 130) ||
+                         (pos >= nbits / 2);
+        if (set) {
+          tw_bitmap_set(dense, pos);
+          tw_bitmap_rle_set(expected, pos);
+        }
+      }
+
+      ck_assert_ptr_eq(tw_bitmap_to_rle(dense, rle), rle);
+      ck_assert(tw_bitmap_rle_equal(rle, expected));
+      ck_assert_uint_eq(tw_bitmap_rle_count(rle), tw_bitmap_count(dense));
+
+      ck_assert_ptr_eq(tw_bitmap_rle_to_bitmap(rle, back), back);
+      ck_assert(tw_bitmap_equal(back, dense));
+
+      /* empty and full bitmaps, bits past the rle size are ignored */
+      tw_bitmap_zero(dense);
+      ck_assert_ptr_eq(tw_bitmap_to_rle(dense, rle), rle);
+      ck_assert(tw_bitmap_rle_empty(rle));
+      ck_assert_ptr_eq(tw_bitmap_rle_to_bitmap(rle, back), back);
+      ck_assert(tw_bitmap_empty(back));
+
+      tw_bitmap_fill(dense);
+      ck_assert_ptr_eq(tw_bitmap_to_rle(dense, rle), rle);
+      ck_assert(tw_bitmap_rle_full(rle));
+      ck_assert_uint_eq(rle->last_word_idx, 0);
+      ck_assert_ptr_eq(tw_bitmap_rle_to_bitmap(rle, back), back);
+      ck_assert_uint_eq(tw_bitmap_count(back), nbits);
+
+      tw_bitmap_rle_free(expected);
+      tw_bitmap_rle_free(rle);
+      tw_bitmap_free(back);
+      tw_bitmap_free(dense);
+    }
+  }
+}
+END_TEST
+
 START_TEST(test_bitmap_rle_errors)
 {
   DESCRIBE_TEST;
@@ -509,6 +623,15 @@ START_TEST(test_bitmap_rle_errors)
   ck_assert_ptr_eq(tw_bitmap_rle_intersection(NULL, a, NULL), NULL);
   ck_assert_ptr_eq(tw_bitmap_rle_intersection(a, b, NULL), NULL);
 
+  struct tw_bitmap *dense = tw_bitmap_new(a_size);
+  ck_assert_ptr_eq(tw_bitmap_to_rle(NULL, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_to_rle(dense, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_to_rle(dense, b), NULL);
+  ck_assert_ptr_eq(tw_bitmap_rle_to_bitmap(NULL, dense), NULL);
+  ck_assert_ptr_eq(tw_bitmap_rle_to_bitmap(a, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_rle_to_bitmap(b, dense), NULL);
+  tw_bitmap_free(dense);
+
   tw_bitmap_rle_free(b);
   tw_bitmap_rle_free(a);
 }
@@ -527,6 +650,7 @@ int run_tests()
   tcase_add_test(basic, test_bitmap_rle_copy_and_clone);
   tcase_add_test(basic, test_bitmap_rle_zero_and_fill);
   tcase_add_test(basic, test_bitmap_rle_find_first);
+  tcase_add_test(basic, test_bitmap_rle_conversion);
   tcase_add_test(basic, test_bitmap_rle_errors);
   tcase_set_timeout(basic, 15);
   suite_add_tcase(s, basic);
@@ -538,6 +662,7 @@ int run_tests()
   tcase_add_test(ops, test_bitmap_rle_union_advanced);
   tcase_add_test(ops, test_bitmap_rle_intersection);
   tcase_add_test(ops, test_bitmap_rle_intersection_advanced);
+  tcase_add_test(ops, test_bitmap_rle_relations);
   suite_add_tcase(s, ops);
 
   srunner_run_all(runner, CK_NORMAL);
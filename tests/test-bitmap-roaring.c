@@ -0,0 +1,283 @@
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_roaring.h>
+
+#include "../src/twiddle/macrology.h"
+#include "test.h"
+
+#define CONTAINER_BITS TW_BITMAP_ROARING_CONTAINER_BITS
+
+/**
+ * Fill every chunk of `bitmap`, and of the dense `expected`, with one of
+ * sparse bits, dense bits, runs or nothing, rotating by `shift` such that
+ * bitmaps built with different shifts combine all kinds of containers.
+ */
+static void fill(struct tw_bitmap_roaring *bitmap, struct tw_bitmap *expected,
+                 uint64_t seed, size_t shift)
+{
+  const uint64_t n_chunks = bitmap->size / CONTAINER_BITS;
+
+  for (uint64_t chunk = 0; chunk < n_chunks; ++chunk) {
+    const uint64_t base = chunk * CONTAINER_BITS;
+
+    switch ((chunk + shift) % 4) {
+    case 0:
+      for (size_t i = 0; i < 100; ++i) {
+        const uint64_t pos = base + xorshift64(&seed) % CONTAINER_BITS;
+        tw_bitmap_roaring_set(bitmap, pos);
+        tw_bitmap_set(expected, pos);
+      }
+      break;
+    case 1:
+      for (size_t i = 0; i < 30000; ++i) {
+        const uint64_t pos = base + xorshift64(&seed) % CONTAINER_BITS;
+        tw_bitmap_roaring_set(bitmap, pos);
+        tw_bitmap_set(expected, pos);
+      }
+      break;
+    case 2:
+      for (size_t i = 0; i < 20; ++i) {
+        const uint64_t start = xorshift64(&seed) % CONTAINER_BITS;
+        const uint64_t end =
+            tw_min(start + xorshift64(&seed) % 2000, CONTAINER_BITS - 1);
+        for (uint64_t pos = base + start; pos <= base + end; ++pos) {
+          tw_bitmap_roaring_set(bitmap, pos);
+          tw_bitmap_set(expected, pos);
+        }
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+static void assert_matches(const struct tw_bitmap_roaring *bitmap,
+                           const struct tw_bitmap *expected)
+{
+  ck_assert_uint_eq(tw_bitmap_roaring_count(bitmap),
+                    tw_bitmap_count(expected));
+
+  uint64_t mismatches = 0;
+  for (uint64_t pos = 0; pos < expected->size; ++pos) {
+    mismatches +=
+        tw_bitmap_roaring_test(bitmap, pos) != tw_bitmap_test(expected, pos);
+  }
+  ck_assert_uint_eq(mismatches, 0);
+}
+
+START_TEST(test_bitmap_roaring_basic)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t nbits = 4 * CONTAINER_BITS;
+  struct tw_bitmap_roaring *bitmap = tw_bitmap_roaring_new(nbits);
+  struct tw_bitmap *expected = tw_bitmap_new(nbits);
+
+  ck_assert(tw_bitmap_roaring_empty(bitmap));
+  ck_assert(!tw_bitmap_roaring_test(bitmap, 0));
+
+  fill(bitmap, expected, 0xC0FFEE, 0);
+  assert_matches(bitmap, expected);
+  ck_assert(!tw_bitmap_roaring_empty(bitmap));
+
+  /* clear every other bit, bitsets convert back to arrays */
+  for (uint64_t pos = 0; pos < nbits; pos += 2) {
+    tw_bitmap_roaring_clear(bitmap, pos);
+    tw_bitmap_clear(expected, pos);
+  }
+  assert_matches(bitmap, expected);
+
+  /* setting twice, or clearing an inactive bit, is a no-op */
+  tw_bitmap_roaring_set(bitmap, 1);
+  tw_bitmap_roaring_set(bitmap, 1);
+  tw_bitmap_roaring_clear(bitmap, 2);
+  tw_bitmap_set(expected, 1);
+  assert_matches(bitmap, expected);
+
+  /* bits set in increasing order, the array overflows to a bitset */
+  tw_bitmap_roaring_zero(bitmap);
+  tw_bitmap_zero(expected);
+  ck_assert(tw_bitmap_roaring_empty(bitmap));
+  for (uint64_t pos = nbits - 2 * TW_BITMAP_ROARING_ARRAY_MAX; pos < nbits;
+       ++pos) {
+    tw_bitmap_roaring_set(bitmap, pos);
+    tw_bitmap_set(expected, pos);
+  }
+  assert_matches(bitmap, expected);
+  ck_assert(tw_bitmap_roaring_test(bitmap, nbits - 1));
+
+  for (uint64_t pos = 0; pos < nbits; ++pos) {
+    tw_bitmap_roaring_clear(bitmap, pos);
+  }
+  ck_assert(tw_bitmap_roaring_empty(bitmap));
+  ck_assert_uint_eq(bitmap->n_containers, 0);
+
+  tw_bitmap_free(expected);
+  tw_bitmap_roaring_free(bitmap);
+}
+END_TEST
+
+START_TEST(test_bitmap_roaring_optimize)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t nbits = 4 * CONTAINER_BITS;
+  struct tw_bitmap_roaring *bitmap = tw_bitmap_roaring_new(nbits);
+  struct tw_bitmap *expected = tw_bitmap_new(nbits);
+
+  fill(bitmap, expected, 0xDEADBEEF, 1);
+  struct tw_bitmap_roaring *clone = tw_bitmap_roaring_clone(bitmap);
+  ck_assert_ptr_ne(clone, NULL);
+
+  ck_assert_ptr_eq(tw_bitmap_roaring_optimize(bitmap), bitmap);
+  assert_matches(bitmap, expected);
+  ck_assert(tw_bitmap_roaring_equal(bitmap, clone));
+  ck_assert(tw_bitmap_roaring_equal(clone, bitmap));
+
+  /* run containers are decompressed on writes */
+  for (uint64_t pos = 0; pos < nbits; pos += 1000) {
+    tw_bitmap_roaring_set(bitmap, pos);
+    tw_bitmap_roaring_clear(bitmap, pos + 1);
+    tw_bitmap_set(expected, pos);
+    tw_bitmap_clear(expected, pos + 1);
+  }
+  assert_matches(bitmap, expected);
+  ck_assert(!tw_bitmap_roaring_equal(bitmap, clone));
+
+  ck_assert_ptr_eq(tw_bitmap_roaring_copy(bitmap, clone), clone);
+  tw_bitmap_roaring_free(bitmap);
+  assert_matches(clone, expected);
+
+  tw_bitmap_free(expected);
+  tw_bitmap_roaring_free(clone);
+}
+END_TEST
+
+typedef struct tw_bitmap_roaring *(*roaring_op)(
+    const struct tw_bitmap_roaring *, struct tw_bitmap_roaring *);
+typedef struct tw_bitmap *(*dense_op)(const struct tw_bitmap *,
+                                      struct tw_bitmap *);
+
+START_TEST(test_bitmap_roaring_operations)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t nbits = 4 * CONTAINER_BITS;
+  const roaring_op roaring_ops[] = {
+      tw_bitmap_roaring_union, tw_bitmap_roaring_intersection,
+      tw_bitmap_roaring_xor, tw_bitmap_roaring_andnot,
+  };
+  const dense_op dense_ops[] = {
+      tw_bitmap_union, tw_bitmap_intersection, tw_bitmap_xor, tw_bitmap_andnot,
+  };
+
+  struct tw_bitmap_roaring *a = tw_bitmap_roaring_new(nbits);
+  struct tw_bitmap_roaring *b = tw_bitmap_roaring_new(nbits);
+  struct tw_bitmap *dense_a = tw_bitmap_new(nbits);
+  struct tw_bitmap *dense_b = tw_bitmap_new(nbits);
+  struct tw_bitmap *expected = tw_bitmap_new(nbits);
+
+  /* every pair of kinds of containers */
+  fill(a, dense_a, 0xC0FFEE, 0);
+  fill(b, dense_b, 0xDEADBEEF, 1);
+  fill(b, dense_b, 0xBADC0DE, 2);
+
+  for (size_t optimize = 0; optimize < 4; ++optimize) {
+    if (optimize & 1) {
+      tw_bitmap_roaring_optimize(a);
+    }
+    if (optimize & 2) {
+      tw_bitmap_roaring_optimize(b);
+    }
+
+    for (size_t op = 0; op < TW_ARRAY_SIZE(roaring_ops); ++op) {
+      struct tw_bitmap_roaring *result = tw_bitmap_roaring_clone(b);
+
+      ck_assert_ptr_eq(roaring_ops[op](a, result), result);
+      tw_bitmap_copy(dense_b, expected);
+      dense_ops[op](dense_a, expected);
+      assert_matches(result, expected);
+
+      tw_bitmap_roaring_free(result);
+    }
+  }
+
+  /* operands aliasing the destination */
+  ck_assert_ptr_eq(tw_bitmap_roaring_union(a, a), a);
+  assert_matches(a, dense_a);
+  ck_assert_ptr_eq(tw_bitmap_roaring_intersection(a, a), a);
+  assert_matches(a, dense_a);
+  ck_assert_ptr_eq(tw_bitmap_roaring_xor(a, a), a);
+  ck_assert(tw_bitmap_roaring_empty(a));
+
+  tw_bitmap_free(expected);
+  tw_bitmap_free(dense_b);
+  tw_bitmap_free(dense_a);
+  tw_bitmap_roaring_free(b);
+  tw_bitmap_roaring_free(a);
+}
+END_TEST
+
+START_TEST(test_bitmap_roaring_errors)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t nbits = CONTAINER_BITS;
+  struct tw_bitmap_roaring *a = tw_bitmap_roaring_new(nbits);
+  struct tw_bitmap_roaring *b = tw_bitmap_roaring_new(2 * nbits);
+
+  ck_assert_ptr_eq(tw_bitmap_roaring_new(0), NULL);
+  ck_assert_ptr_eq(tw_bitmap_roaring_new(TW_BITMAP_MAX_BITS + 1), NULL);
+
+  /* out of range positions are ignored */
+  tw_bitmap_roaring_set(a, nbits);
+  tw_bitmap_roaring_clear(a, nbits);
+  ck_assert(!tw_bitmap_roaring_test(a, nbits));
+  ck_assert(tw_bitmap_roaring_empty(a));
+
+  ck_assert(!tw_bitmap_roaring_test(NULL, 0));
+  ck_assert(!tw_bitmap_roaring_empty(NULL));
+  ck_assert_uint_eq(tw_bitmap_roaring_count(NULL), 0);
+  ck_assert_ptr_eq(tw_bitmap_roaring_zero(NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_roaring_optimize(NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_roaring_clone(NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_roaring_copy(a, b), NULL);
+  ck_assert_ptr_eq(tw_bitmap_roaring_copy(NULL, a), NULL);
+  ck_assert(!tw_bitmap_roaring_equal(a, b));
+  ck_assert(!tw_bitmap_roaring_equal(a, NULL));
+  ck_assert_ptr_eq(tw_bitmap_roaring_union(a, b), NULL);
+  ck_assert_ptr_eq(tw_bitmap_roaring_intersection(a, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_roaring_xor(NULL, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_roaring_andnot(b, a), NULL);
+  tw_bitmap_roaring_free(NULL);
+
+  tw_bitmap_roaring_free(b);
+  tw_bitmap_roaring_free(a);
+}
+END_TEST
+
+int run_tests()
+{
+  int number_failed;
+
+  Suite *s = suite_create("bitmap_roaring");
+  SRunner *runner = srunner_create(s);
+
+  TCase *tc = tcase_create("basic");
+  tcase_add_test(tc, test_bitmap_roaring_basic);
+  tcase_add_test(tc, test_bitmap_roaring_optimize);
+  tcase_add_test(tc, test_bitmap_roaring_operations);
+  tcase_add_test(tc, test_bitmap_roaring_errors);
+  tcase_set_timeout(tc, 30);
+  suite_add_tcase(s, tc);
+
+  srunner_run_all(runner, CK_NORMAL);
+  number_failed = srunner_ntests_failed(runner);
+  srunner_free(runner);
+
+  return number_failed;
+}
+
+int main() { return (run_tests() == 0) ? EXIT_SUCCESS : EXIT_FAILURE; }
@@ -0,0 +1,336 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_mmap.h>
+#include <twiddle/bitmap/bitmap_snapshot.h>
+
+#include "../src/twiddle/macrology.h"
+#include "test.h"
+
+#define CHUNK_BITS (TW_BITMAP_SNAPSHOT_CHUNK * TW_BITS_IN_WORD)
+
+/* bitmaps spanning a few chunks */
+#define N_CHUNKS 4
+#define NBITS (N_CHUNKS * CHUNK_BITS)
+
+/* compare the bits and the count of a bitmap with a private copy */
+static void validate_bitmap(const struct tw_bitmap *bitmap,
+                            const struct tw_bitmap *expected)
+{
+  ck_assert_uint_eq(bitmap->size, expected->size);
+  ck_assert_uint_eq(tw_bitmap_count(bitmap), tw_bitmap_count(expected));
+  ck_assert(memcmp(bitmap->data, expected->data,
+                   bitmap->size / TW_BITS_IN_WORD) == 0);
+}
+
+START_TEST(test_bitmap_snapshot_basic)
+{
+  DESCRIBE_TEST;
+
+  struct tw_bitmap *bitmap = tw_bitmap_new_shared(NBITS);
+  ck_assert_ptr_ne(bitmap, NULL);
+  ck_assert_uint_eq(bitmap->size, NBITS);
+  ck_assert(tw_bitmap_empty(bitmap));
+  ck_assert_uint_eq(tw_bitmap_shared_size(bitmap), 0);
+
+  tw_bitmap_set(bitmap, 0);
+  tw_bitmap_set(bitmap, CHUNK_BITS + 1);
+
+  struct tw_bitmap *snapshot = tw_bitmap_snapshot(bitmap);
+  ck_assert_ptr_ne(snapshot, NULL);
+  ck_assert_ptr_ne(snapshot->data, bitmap->data);
+  ck_assert_uint_eq(snapshot->size, NBITS);
+  ck_assert_uint_eq(tw_bitmap_count(snapshot), 2);
+  ck_assert_uint_eq(tw_bitmap_shared_size(bitmap),
+                    N_CHUNKS * TW_BITMAP_SNAPSHOT_CHUNK);
+
+  /* the written chunk is copied, in the written bitmap only */
+  tw_bitmap_set(bitmap, CHUNK_BITS + 2);
+  ck_assert(tw_bitmap_test(bitmap, CHUNK_BITS + 2));
+  ck_assert(!tw_bitmap_test(snapshot, CHUNK_BITS + 2));
+  ck_assert(tw_bitmap_test(bitmap, CHUNK_BITS + 1));
+  ck_assert_uint_eq(tw_bitmap_count(bitmap), 3);
+  ck_assert_uint_eq(tw_bitmap_count(snapshot), 2);
+  ck_assert_uint_eq(tw_bitmap_shared_size(bitmap),
+                    (N_CHUNKS - 1) * TW_BITMAP_SNAPSHOT_CHUNK);
+  ck_assert_uint_eq(tw_bitmap_shared_size(snapshot),
+                    (N_CHUNKS - 1) * TW_BITMAP_SNAPSHOT_CHUNK);
+
+  /* no-op writes keep chunks shared */
+  tw_bitmap_set(bitmap, 0);
+  tw_bitmap_clear(bitmap, NBITS - 1);
+  ck_assert_uint_eq(tw_bitmap_shared_size(bitmap),
+                    (N_CHUNKS - 1) * TW_BITMAP_SNAPSHOT_CHUNK);
+
+  /* writing the snapshot's chunk no longer shared does not copy it */
+  tw_bitmap_clear(snapshot, CHUNK_BITS + 1);
+  ck_assert(tw_bitmap_test(bitmap, CHUNK_BITS + 1));
+  ck_assert_uint_eq(tw_bitmap_shared_size(snapshot),
+                    (N_CHUNKS - 1) * TW_BITMAP_SNAPSHOT_CHUNK);
+
+  tw_bitmap_clear(snapshot, 0);
+  ck_assert(tw_bitmap_test(bitmap, 0));
+  ck_assert(!tw_bitmap_test(snapshot, 0));
+  ck_assert_uint_eq(tw_bitmap_shared_size(bitmap),
+                    (N_CHUNKS - 2) * TW_BITMAP_SNAPSHOT_CHUNK);
+
+  /* freeing a bitmap leaves the chunks of the other */
+  tw_bitmap_free(bitmap);
+  ck_assert_uint_eq(tw_bitmap_shared_size(snapshot), 0);
+  ck_assert(tw_bitmap_empty(snapshot));
+  tw_bitmap_set(snapshot, NBITS - 1);
+  ck_assert_uint_eq(tw_bitmap_count(snapshot), 1);
+  tw_bitmap_free(snapshot);
+
+  /* bitmaps of a single chunk are shared by pages */
+  bitmap = tw_bitmap_new_shared(1000);
+  ck_assert_uint_eq(bitmap->size, 1024);
+  ck_assert_uint_eq(bitmap->mapping_size, 4096);
+  snapshot = tw_bitmap_snapshot(bitmap);
+  tw_bitmap_set(snapshot, 1023);
+  ck_assert(!tw_bitmap_test(bitmap, 1023));
+  ck_assert_uint_eq(tw_bitmap_shared_size(snapshot), 0);
+  tw_bitmap_free(snapshot);
+  tw_bitmap_free(bitmap);
+}
+END_TEST
+
+START_TEST(test_bitmap_snapshot_ops)
+{
+  DESCRIBE_TEST;
+
+  uint64_t seed = 0xFEEDFACECAFEBEEFULL;
+  const uint64_t positions[] = {1, CHUNK_BITS - 1, CHUNK_BITS, NBITS - 1};
+
+  /* a heap allocated bitmap is moved to chunks by its first snapshot */
+  struct tw_bitmap *bitmap = tw_bitmap_new(NBITS);
+  bitmap_random_set(bitmap, &seed, 10000);
+  struct tw_bitmap *expected = tw_bitmap_clone(bitmap);
+  struct tw_bitmap *other = tw_bitmap_new(NBITS);
+  bitmap_random_set(other, &seed, 10000);
+
+  struct tw_bitmap *snapshot = tw_bitmap_snapshot(bitmap);
+  ck_assert_ptr_ne(snapshot, NULL);
+  ck_assert_ptr_ne(bitmap->cow, NULL);
+  validate_bitmap(bitmap, expected);
+  validate_bitmap(snapshot, expected);
+
+  /* every kind of write to either side leaves the other untouched */
+  struct tw_bitmap *mirror = tw_bitmap_clone(expected);
+  struct tw_bitmap *targets[] = {bitmap, snapshot};
+  for (size_t i = 0; i < TW_ARRAY_SIZE(targets); ++i) {
+    struct tw_bitmap *target = targets[i];
+    struct tw_bitmap *untouched = targets[1 - i];
+
+    tw_bitmap_set_range(target, CHUNK_BITS - 100, CHUNK_BITS + 100);
+    tw_bitmap_set_range(mirror, CHUNK_BITS - 100, CHUNK_BITS + 100);
+    tw_bitmap_clear_many(target, positions, TW_ARRAY_SIZE(positions));
+    tw_bitmap_clear_many(mirror, positions, TW_ARRAY_SIZE(positions));
+    tw_bitmap_flip_range(target, 10, 2 * CHUNK_BITS);
+    tw_bitmap_flip_range(mirror, 10, 2 * CHUNK_BITS);
+    ck_assert_ptr_ne(tw_bitmap_xor(other, target), NULL);
+    tw_bitmap_xor(other, mirror);
+    ck_assert_ptr_ne(tw_bitmap_shift_left(target, 77), NULL);
+    tw_bitmap_shift_left(mirror, 77);
+    ck_assert_ptr_ne(tw_bitmap_not(target), NULL);
+    tw_bitmap_not(mirror);
+    tw_bitmap_set_nocount(target, 3);
+    tw_bitmap_set_nocount(mirror, 3);
+
+    validate_bitmap(target, mirror);
+    validate_bitmap(untouched, expected);
+
+    tw_bitmap_copy(expected, mirror);
+    ck_assert_ptr_ne(tw_bitmap_copy(expected, target), NULL);
+    validate_bitmap(target, expected);
+  }
+
+  /* clones of shared bitmaps are copies */
+  struct tw_bitmap *copy = tw_bitmap_clone(snapshot);
+  ck_assert_ptr_eq(copy->cow, NULL);
+  validate_bitmap(copy, expected);
+  tw_bitmap_free(copy);
+
+  /* snapshots of snapshots */
+  struct tw_bitmap *clone = tw_bitmap_snapshot(snapshot);
+  ck_assert_ptr_ne(clone, NULL);
+  ck_assert_uint_eq(tw_bitmap_shared_size(clone),
+                    N_CHUNKS * TW_BITMAP_SNAPSHOT_CHUNK);
+  tw_bitmap_zero(clone);
+  ck_assert(tw_bitmap_empty(clone));
+  ck_assert_uint_eq(tw_bitmap_shared_size(clone), 0);
+  validate_bitmap(snapshot, expected);
+
+  /* shared bitmaps cannot be resized */
+  ck_assert_ptr_eq(tw_bitmap_resize(bitmap, 2 * NBITS), NULL);
+  ck_assert_ptr_eq(tw_bitmap_reserve(bitmap, 2 * NBITS), NULL);
+  struct tw_bitmap *larger = tw_bitmap_new(2 * NBITS);
+  ck_assert_ptr_eq(tw_bitmap_union(larger, clone), NULL);
+  tw_bitmap_free(larger);
+
+  tw_bitmap_free(snapshot);
+  tw_bitmap_free(bitmap);
+  tw_bitmap_free(clone);
+  tw_bitmap_free(mirror);
+  tw_bitmap_free(other);
+  tw_bitmap_free(expected);
+}
+END_TEST
+
+START_TEST(test_bitmap_snapshot_history)
+{
+  DESCRIBE_TEST;
+
+  uint64_t seed = 0x5EED;
+  struct tw_bitmap *bitmap = tw_bitmap_new_flags(NBITS, TW_ALLOC_HUGE_PAGES);
+  struct tw_bitmap *snapshots[16];
+  struct tw_bitmap *expected[TW_ARRAY_SIZE(snapshots)];
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(snapshots); ++i) {
+    bitmap_random_set(bitmap, &seed, 1 + i % 4);
+    expected[i] = tw_bitmap_new(NBITS);
+    tw_bitmap_copy(bitmap, expected[i]);
+    snapshots[i] = tw_bitmap_snapshot(bitmap);
+    ck_assert_ptr_ne(snapshots[i], NULL);
+  }
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(snapshots); ++i) {
+    validate_bitmap(snapshots[i], expected[i]);
+  }
+
+  /* freed in an arbitrary order, chunks are reused */
+  for (size_t i = 0; i < TW_ARRAY_SIZE(snapshots); i += 2) {
+    tw_bitmap_free(snapshots[i]);
+    tw_bitmap_free(expected[i]);
+  }
+  tw_bitmap_fill(bitmap);
+  ck_assert(tw_bitmap_full(bitmap));
+  for (size_t i = 1; i < TW_ARRAY_SIZE(snapshots); i += 2) {
+    tw_bitmap_set(snapshots[i], i);
+    tw_bitmap_set(expected[i], i);
+    validate_bitmap(snapshots[i], expected[i]);
+  }
+
+  tw_bitmap_free(bitmap);
+  for (size_t i = 1; i < TW_ARRAY_SIZE(snapshots); i += 2) {
+    validate_bitmap(snapshots[i], expected[i]);
+    tw_bitmap_free(snapshots[i]);
+    tw_bitmap_free(expected[i]);
+  }
+}
+END_TEST
+
+struct writer {
+  struct tw_bitmap *bitmap;
+  uint64_t seed;
+};
+
+static void *writer_run(void *opaque)
+{
+  struct writer *writer = (struct writer *)opaque;
+  struct tw_bitmap *bitmap = writer->bitmap;
+
+  for (size_t i = 0; i < 64; ++i) {
+    tw_bitmap_flip_range(bitmap, xorshift64(&writer->seed) % (NBITS / 2),
+                         NBITS / 2 + xorshift64(&writer->seed) % (NBITS / 2));
+  }
+
+  return NULL;
+}
+
+START_TEST(test_bitmap_snapshot_threads)
+{
+  DESCRIBE_TEST;
+
+  uint64_t seed = 0xC0FFEE;
+  struct tw_bitmap *bitmap = tw_bitmap_new_shared(NBITS);
+  bitmap_random_set(bitmap, &seed, 10000);
+
+  /* snapshots are written concurrently, sharing the chunks' file */
+  struct writer writers[4];
+  pthread_t threads[TW_ARRAY_SIZE(writers)];
+  for (size_t i = 0; i < TW_ARRAY_SIZE(writers); ++i) {
+    writers[i].bitmap = tw_bitmap_snapshot(bitmap);
+    writers[i].seed = 0xDEADBEEF + i;
+    ck_assert_int_eq(
+        pthread_create(&threads[i], NULL, writer_run, &writers[i]), 0);
+  }
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(writers); ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(writers); ++i) {
+    /* replay the writes on a private copy */
+    struct writer replay = {.bitmap = tw_bitmap_new(NBITS),
+                            .seed = 0xDEADBEEF + i};
+    tw_bitmap_copy(bitmap, replay.bitmap);
+    writer_run(&replay);
+
+    validate_bitmap(writers[i].bitmap, replay.bitmap);
+    tw_bitmap_free(replay.bitmap);
+    tw_bitmap_free(writers[i].bitmap);
+  }
+
+  tw_bitmap_free(bitmap);
+}
+END_TEST
+
+START_TEST(test_bitmap_snapshot_errors)
+{
+  DESCRIBE_TEST;
+
+  ck_assert_ptr_eq(tw_bitmap_new_shared(0), NULL);
+  ck_assert_ptr_eq(tw_bitmap_new_shared(TW_BITMAP_MAX_BITS + 1), NULL);
+  ck_assert_ptr_eq(tw_bitmap_snapshot(NULL), NULL);
+  ck_assert_uint_eq(tw_bitmap_shared_size(NULL), 0);
+
+  struct tw_bitmap *bitmap = tw_bitmap_new(512);
+  ck_assert_uint_eq(tw_bitmap_shared_size(bitmap), 0);
+  tw_bitmap_free(bitmap);
+
+  /* file-backed bitmaps are not snapshotted */
+  char path[] = "/tmp/test-bitmap-snapshot-XXXXXX";
+  close(mkstemp(path));
+  bitmap = tw_bitmap_create_mmap(path, 512);
+  ck_assert_ptr_ne(bitmap, NULL);
+  ck_assert_ptr_eq(tw_bitmap_snapshot(bitmap), NULL);
+  tw_bitmap_free(bitmap);
+  unlink(path);
+
+  /* nor are wrapped bitmaps, their bits are owned by the caller */
+  uint64_t words[8] __attribute__((aligned(64))) = {0};
+  bitmap = tw_bitmap_wrap(words, 512);
+  ck_assert_ptr_ne(bitmap, NULL);
+  ck_assert_ptr_eq(tw_bitmap_snapshot(bitmap), NULL);
+  tw_bitmap_free(bitmap);
+}
+END_TEST
+
+int run_tests()
+{
+  int number_failed;
+
+  Suite *s = suite_create("bitmap_snapshot");
+  SRunner *runner = srunner_create(s);
+
+  TCase *tc = tcase_create("basic");
+  tcase_set_timeout(tc, 15);
+  tcase_add_test(tc, test_bitmap_snapshot_basic);
+  tcase_add_test(tc, test_bitmap_snapshot_ops);
+  tcase_add_test(tc, test_bitmap_snapshot_history);
+  tcase_add_test(tc, test_bitmap_snapshot_threads);
+  tcase_add_test(tc, test_bitmap_snapshot_errors);
+  suite_add_tcase(s, tc);
+
+  srunner_run_all(runner, CK_NORMAL);
+  number_failed = srunner_ntests_failed(runner);
+  srunner_free(runner);
+
+  return number_failed;
+}
+
+int main() { return (run_tests() == 0) ? EXIT_SUCCESS : EXIT_FAILURE; }
@@ -0,0 +1,217 @@
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmap_summary.h>
+
+#include "../src/twiddle/macrology.h"
+#include "test.h"
+
+/* verify searches against the linear scans of the bitmap */
+static void validate_summary(struct tw_bitmap_summary *summary, uint64_t *seed)
+{
+  const struct tw_bitmap *bitmap = summary->bitmap;
+  const uint64_t step = 1 + bitmap->size / 4096;
+
+  ck_assert_int64_t_eq(tw_bitmap_summary_find_first_zero(summary),
+                       tw_bitmap_find_first_zero(bitmap));
+  ck_assert_int64_t_eq(tw_bitmap_summary_find_first_bit(summary),
+                       tw_bitmap_find_first_bit(bitmap));
+
+  for (uint64_t pos = 0; pos < bitmap->size;
+       pos += 1 + xorshift64(seed) % step) {
+    ck_assert_int64_t_eq(tw_bitmap_summary_find_next_zero(summary, pos),
+                         tw_bitmap_find_next_zero(bitmap, pos));
+    ck_assert_int64_t_eq(tw_bitmap_summary_find_next_bit(summary, pos),
+                         tw_bitmap_find_next_bit(bitmap, pos));
+  }
+
+  ck_assert_int64_t_eq(
+      tw_bitmap_summary_find_next_zero(summary, bitmap->size - 1),
+      tw_bitmap_find_next_zero(bitmap, bitmap->size - 1));
+  ck_assert_int64_t_eq(
+      tw_bitmap_summary_find_next_bit(summary, bitmap->size - 1),
+      tw_bitmap_find_next_bit(bitmap, bitmap->size - 1));
+}
+
+START_TEST(test_bitmap_summary_basic)
+{
+  DESCRIBE_TEST;
+
+  /* one, two and three levels */
+  const uint32_t sizes[] = {512, 4096, 1 << 18, 1 << 20};
+  /* empty and full regions of words, and of summary words */
+  const int32_t sparsities[] = {1, 2, 1000, 100000, -1000, -100000};
+  uint64_t seed = 0xFEEDFACECAFEBEEFULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    for (size_t j = 0; j < TW_ARRAY_SIZE(sparsities); ++j) {
+      struct tw_bitmap *bitmap = tw_bitmap_new(sizes[i]);
+      /* negative sparsities clear one in `-sparsity` bits instead */
+      bitmap_random_fill(bitmap, &seed, abs(sparsities[j]));
+      if (sparsities[j] < 0) {
+        tw_bitmap_not(bitmap);
+      }
+
+      struct tw_bitmap_summary *summary = tw_bitmap_summary_new(bitmap);
+      ck_assert_ptr_ne(summary, NULL);
+      ck_assert(!tw_bitmap_summary_stale(summary));
+      validate_summary(summary, &seed);
+
+      /* writes through the summary keep it up to date */
+      for (size_t k = 0; k < 1000; ++k) {
+        const uint64_t pos = xorshift64(&seed) % sizes[i];
+        if (k % 2) {
+          ck_assert(tw_bitmap_summary_set(summary, pos));
+          ck_assert(tw_bitmap_test(bitmap, pos));
+        } else {
+          ck_assert(tw_bitmap_summary_clear(summary, pos));
+          ck_assert(!tw_bitmap_test(bitmap, pos));
+        }
+        ck_assert(!tw_bitmap_summary_stale(summary));
+      }
+      validate_summary(summary, &seed);
+
+      tw_bitmap_summary_free(summary);
+      tw_bitmap_free(bitmap);
+    }
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_summary_ids)
+{
+  DESCRIBE_TEST;
+
+  const uint32_t nbits = 1 << 18;
+  struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+  struct tw_bitmap_summary *summary = tw_bitmap_summary_new(bitmap);
+
+  for (uint32_t id = 0; id < nbits; ++id) {
+    ck_assert_int64_t_eq(tw_bitmap_summary_alloc_id(summary), id);
+  }
+  ck_assert(tw_bitmap_full(bitmap));
+  ck_assert_int64_t_eq(tw_bitmap_summary_alloc_id(summary), -1);
+  ck_assert_int64_t_eq(tw_bitmap_summary_find_first_zero(summary), -1);
+
+  /* freed identifiers are reused lowest first */
+  const uint64_t freed[] = {nbits - 1, 4095, 4096, 70000, 63, 64};
+  for (size_t i = 0; i < TW_ARRAY_SIZE(freed); ++i) {
+    ck_assert(tw_bitmap_summary_free_id(summary, freed[i]));
+    ck_assert(!tw_bitmap_summary_free_id(summary, freed[i]));
+  }
+  ck_assert_uint_eq(tw_bitmap_count(bitmap), nbits - TW_ARRAY_SIZE(freed));
+
+  const uint64_t expected[] = {63, 64, 4095, 4096, 70000, nbits - 1};
+  for (size_t i = 0; i < TW_ARRAY_SIZE(expected); ++i) {
+    ck_assert_int64_t_eq(tw_bitmap_summary_alloc_id(summary), expected[i]);
+  }
+  ck_assert_int64_t_eq(tw_bitmap_summary_alloc_id(summary), -1);
+
+  ck_assert(!tw_bitmap_summary_free_id(summary, nbits));
+
+  tw_bitmap_summary_free(summary);
+  tw_bitmap_free(bitmap);
+}
+END_TEST
+
+START_TEST(test_bitmap_summary_invalidation)
+{
+  DESCRIBE_TEST;
+
+  const uint32_t nbits = 1 << 14;
+  struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+  struct tw_bitmap_summary *summary = tw_bitmap_summary_new(bitmap);
+  uint64_t seed = 0x5EED;
+
+  tw_bitmap_set(bitmap, 100);
+  ck_assert(tw_bitmap_summary_stale(summary));
+  ck_assert_int64_t_eq(tw_bitmap_summary_find_first_bit(summary), 100);
+  ck_assert(!tw_bitmap_summary_stale(summary));
+
+  /* no-op modifications keep the summary */
+  tw_bitmap_set(bitmap, 100);
+  tw_bitmap_clear(bitmap, 101);
+  ck_assert(!tw_bitmap_summary_stale(summary));
+
+  tw_bitmap_fill(bitmap);
+  ck_assert(tw_bitmap_summary_stale(summary));
+  ck_assert_int64_t_eq(tw_bitmap_summary_alloc_id(summary), -1);
+
+  tw_bitmap_clear_range(bitmap, 5000, 5100);
+  ck_assert_int64_t_eq(tw_bitmap_summary_alloc_id(summary), 5000);
+  validate_summary(summary, &seed);
+
+  tw_bitmap_clear_nocount(bitmap, 3);
+  ck_assert(tw_bitmap_summary_stale(summary));
+  ck_assert_int64_t_eq(tw_bitmap_summary_alloc_id(summary), 3);
+  ck_assert(!tw_bitmap_summary_stale(summary));
+
+  /* levels are reallocated for the new size */
+  ck_assert_ptr_ne(tw_bitmap_resize(bitmap, 1 << 20), NULL);
+  ck_assert(tw_bitmap_summary_stale(summary));
+  ck_assert_int64_t_eq(tw_bitmap_summary_find_next_zero(summary, 6000),
+                       nbits);
+  ck_assert_int64_t_eq(tw_bitmap_summary_find_next_bit(summary, 1 << 16),
+                       -1);
+  ck_assert_uint_eq(summary->levels, 3);
+  validate_summary(summary, &seed);
+
+  ck_assert_ptr_ne(tw_bitmap_resize(bitmap, 512), NULL);
+  ck_assert(tw_bitmap_summary_update(summary));
+  ck_assert_uint_eq(summary->levels, 1);
+  validate_summary(summary, &seed);
+
+  tw_bitmap_summary_free(summary);
+  tw_bitmap_free(bitmap);
+}
+END_TEST
+
+START_TEST(test_bitmap_summary_errors)
+{
+  DESCRIBE_TEST;
+
+  struct tw_bitmap *bitmap = tw_bitmap_new(512);
+  struct tw_bitmap_summary *summary = tw_bitmap_summary_new(bitmap);
+
+  ck_assert_ptr_eq(tw_bitmap_summary_new(NULL), NULL);
+  ck_assert(!tw_bitmap_summary_stale(NULL));
+  ck_assert_ptr_eq(tw_bitmap_summary_update(NULL), NULL);
+  ck_assert(!tw_bitmap_summary_set(NULL, 0));
+  ck_assert(!tw_bitmap_summary_set(summary, 512));
+  ck_assert(!tw_bitmap_summary_clear(NULL, 0));
+  ck_assert(!tw_bitmap_summary_clear(summary, 512));
+  ck_assert_int64_t_eq(tw_bitmap_summary_find_first_zero(NULL), -1);
+  ck_assert_int64_t_eq(tw_bitmap_summary_find_next_zero(summary, 512), -1);
+  ck_assert_int64_t_eq(tw_bitmap_summary_find_first_bit(NULL), -1);
+  ck_assert_int64_t_eq(tw_bitmap_summary_find_next_bit(summary, 512), -1);
+  ck_assert_int64_t_eq(tw_bitmap_summary_alloc_id(NULL), -1);
+  ck_assert(!tw_bitmap_summary_free_id(NULL, 0));
+
+  tw_bitmap_summary_free(summary);
+  tw_bitmap_free(bitmap);
+}
+END_TEST
+
+int run_tests()
+{
+  int number_failed;
+
+  Suite *s = suite_create("bitmap_summary");
+  SRunner *runner = srunner_create(s);
+
+  TCase *tc = tcase_create("basic");
+  tcase_set_timeout(tc, 15);
+  tcase_add_test(tc, test_bitmap_summary_basic);
+  tcase_add_test(tc, test_bitmap_summary_ids);
+  tcase_add_test(tc, test_bitmap_summary_invalidation);
+  tcase_add_test(tc, test_bitmap_summary_errors);
+  suite_add_tcase(s, tc);
+
+  srunner_run_all(runner, CK_NORMAL);
+  number_failed = srunner_ntests_failed(runner);
+  srunner_free(runner);
+
+  return number_failed;
+}
+
+int main() { return (run_tests() == 0) ? EXIT_SUCCESS : EXIT_FAILURE; }
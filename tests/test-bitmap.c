@@ -1,5 +1,6 @@
 #include <signal.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <twiddle/bitmap/bitmap.h>
 
@@ -253,6 +254,1056 @@ START_TEST(test_bitmap_set_operations)
 }
 END_TEST
 
+static uint64_t bitmap_naive_count(const struct tw_bitmap *bitmap)
+{
+  uint64_t count = 0;
+  for (uint64_t pos = 0; pos < bitmap->size; ++pos) {
+    count += tw_bitmap_test(bitmap, pos);
+  }
+  return count;
+}
+
+START_TEST(test_bitmap_set_operations_count)
+{
+  DESCRIBE_TEST;
+  /* exercise both full carry-save blocks and remaining vectors */
+  const uint32_t sizes[] = {512, 8192, 8192 + 3 * 512, 1 << 17,
+                            (1 << 17) + 15 * 512};
+  const uint32_t sparsities[] = {1, 2, 3, 64};
+  uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    for (size_t j = 0; j < TW_ARRAY_SIZE(sparsities); ++j) {
+      const uint32_t nbits = sizes[i];
+      struct tw_bitmap *a = tw_bitmap_new(nbits);
+      struct tw_bitmap *b = tw_bitmap_new(nbits);
+      bitmap_random_fill(a, &seed, sparsities[j]);
+      bitmap_random_fill(b, &seed, 2);
+
+      struct tw_bitmap *dst = tw_bitmap_clone(b);
+      tw_bitmap_union(a, dst);
+      ck_assert_uint_eq(tw_bitmap_count(dst), bitmap_naive_count(dst));
+
+      tw_bitmap_copy(b, dst);
+      tw_bitmap_intersection(a, dst);
+      ck_assert_uint_eq(tw_bitmap_count(dst), bitmap_naive_count(dst));
+
+      tw_bitmap_copy(b, dst);
+      tw_bitmap_xor(a, dst);
+      ck_assert_uint_eq(tw_bitmap_count(dst), bitmap_naive_count(dst));
+
+      tw_bitmap_free(dst);
+      tw_bitmap_free(b);
+      tw_bitmap_free(a);
+    }
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_three_operands)
+{
+  DESCRIBE_TEST;
+  const uint32_t sizes[] = {512, 8192 + 3 * 512, (1 << 17) + 15 * 512};
+  uint64_t seed = 0x2545F4914F6CDD1DULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    const uint32_t nbits = sizes[i];
+    struct tw_bitmap *a = tw_bitmap_new(nbits);
+    struct tw_bitmap *b = tw_bitmap_new(nbits);
+    bitmap_random_fill(a, &seed, 3);
+    bitmap_random_fill(b, &seed, 2);
+
+    struct tw_bitmap *a_copy = tw_bitmap_clone(a);
+    struct tw_bitmap *b_copy = tw_bitmap_clone(b);
+    struct tw_bitmap *out = tw_bitmap_new(nbits);
+    tw_bitmap_fill(out);
+
+    ck_assert_ptr_eq(tw_bitmap_union_into(a, b, out), out);
+    for (uint32_t pos = 0; pos < nbits; ++pos) {
+      ck_assert(tw_bitmap_test(out, pos) ==
+                (tw_bitmap_test(a, pos) || tw_bitmap_test(b, pos)));
+    }
+    ck_assert_uint_eq(tw_bitmap_count(out), bitmap_naive_count(out));
+
+    ck_assert_ptr_eq(tw_bitmap_intersection_into(a, b, out), out);
+    for (uint32_t pos = 0; pos < nbits; ++pos) {
+      ck_assert(tw_bitmap_test(out, pos) ==
+                (tw_bitmap_test(a, pos) && tw_bitmap_test(b, pos)));
+    }
+    ck_assert_uint_eq(tw_bitmap_count(out), bitmap_naive_count(out));
+
+    ck_assert_ptr_eq(tw_bitmap_xor_into(a, b, out), out);
+    for (uint32_t pos = 0; pos < nbits; ++pos) {
+      ck_assert(tw_bitmap_test(out, pos) ==
+                (tw_bitmap_test(a, pos) != tw_bitmap_test(b, pos)));
+    }
+    ck_assert_uint_eq(tw_bitmap_count(out), bitmap_naive_count(out));
+
+    ck_assert_ptr_eq(tw_bitmap_andnot_into(a, b, out), out);
+    for (uint32_t pos = 0; pos < nbits; ++pos) {
+      ck_assert(tw_bitmap_test(out, pos) ==
+                (tw_bitmap_test(a, pos) && !tw_bitmap_test(b, pos)));
+    }
+    ck_assert_uint_eq(tw_bitmap_count(out), tw_bitmap_andnot_count(a, b));
+
+    ck_assert_ptr_eq(tw_bitmap_ornot_into(a, b, out), out);
+    for (uint32_t pos = 0; pos < nbits; ++pos) {
+      ck_assert(tw_bitmap_test(out, pos) ==
+                (tw_bitmap_test(a, pos) || !tw_bitmap_test(b, pos)));
+    }
+    ck_assert_uint_eq(tw_bitmap_count(out), bitmap_naive_count(out));
+
+    /* operands are untouched */
+    ck_assert(tw_bitmap_equal(a, a_copy));
+    ck_assert(tw_bitmap_equal(b, b_copy));
+
+    /* in-place forms alias the output with an operand */
+    tw_bitmap_andnot_into(a, b, out);
+    ck_assert(tw_bitmap_equal(tw_bitmap_andnot(b, a_copy), out));
+    tw_bitmap_copy(a, a_copy);
+    ck_assert(tw_bitmap_equal(tw_bitmap_andnot_into(a_copy, b, a_copy), out));
+    tw_bitmap_copy(a, a_copy);
+    ck_assert(tw_bitmap_equal(tw_bitmap_andnot_into(a, b_copy, b_copy), out));
+    tw_bitmap_copy(b, b_copy);
+
+    tw_bitmap_xor_into(a, b, out);
+    ck_assert(tw_bitmap_equal(tw_bitmap_xor(b, a_copy), out));
+    tw_bitmap_copy(a, a_copy);
+
+    /* a \ a = 0, a | ~a = U */
+    ck_assert(tw_bitmap_empty(tw_bitmap_andnot_into(a, a, out)));
+    ck_assert(tw_bitmap_full(tw_bitmap_ornot_into(a, a, out)));
+
+    tw_bitmap_free(out);
+    tw_bitmap_free(b_copy);
+    tw_bitmap_free(a_copy);
+    tw_bitmap_free(b);
+    tw_bitmap_free(a);
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_count_operations)
+{
+  DESCRIBE_TEST;
+  const uint32_t sizes[] = {512, 8192, 8192 + 3 * 512, (1 << 17) + 15 * 512};
+  const uint32_t sparsities[] = {1, 3, 64};
+  uint64_t seed = 0xDEADBEEFCAFEBABEULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    for (size_t j = 0; j < TW_ARRAY_SIZE(sparsities); ++j) {
+      const uint32_t nbits = sizes[i];
+      struct tw_bitmap *a = tw_bitmap_new(nbits);
+      struct tw_bitmap *b = tw_bitmap_new(nbits);
+      bitmap_random_fill(a, &seed, sparsities[j]);
+      bitmap_random_fill(b, &seed, 2);
+
+      struct tw_bitmap *dst = tw_bitmap_clone(a);
+      const uint64_t n_and = tw_bitmap_count(tw_bitmap_intersection(b, dst));
+      ck_assert_uint_eq(tw_bitmap_intersection_count(a, b), n_and);
+      ck_assert_uint_eq(tw_bitmap_intersection_count(b, a), n_and);
+
+      tw_bitmap_copy(a, dst);
+      const uint64_t n_or = tw_bitmap_count(tw_bitmap_union(b, dst));
+      ck_assert_uint_eq(tw_bitmap_union_count(a, b), n_or);
+
+      tw_bitmap_copy(a, dst);
+      const uint64_t n_xor = tw_bitmap_count(tw_bitmap_xor(b, dst));
+      ck_assert_uint_eq(tw_bitmap_xor_count(a, b), n_xor);
+
+      /* a & ~b = a ^ (a & b) */
+      tw_bitmap_copy(a, dst);
+      tw_bitmap_xor(a, tw_bitmap_intersection(b, dst));
+      ck_assert_uint_eq(tw_bitmap_andnot_count(a, b), tw_bitmap_count(dst));
+
+      ck_assert(tw_almost_equal(tw_bitmap_jaccard(a, b), n_and / (float)n_or));
+      ck_assert(tw_almost_equal(tw_bitmap_jaccard(a, a), 1.0f));
+
+      /* the operands are left untouched */
+      ck_assert_uint_eq(tw_bitmap_count(a), bitmap_naive_count(a));
+      ck_assert_uint_eq(tw_bitmap_count(b), bitmap_naive_count(b));
+
+      tw_bitmap_zero(dst);
+      ck_assert_uint_eq(tw_bitmap_intersection_count(a, dst), 0);
+      ck_assert_uint_eq(tw_bitmap_union_count(a, dst), tw_bitmap_count(a));
+      ck_assert(tw_almost_equal(tw_bitmap_jaccard(a, dst), 0.0f));
+      ck_assert(tw_almost_equal(tw_bitmap_jaccard(dst, dst), 1.0f));
+
+      tw_bitmap_free(dst);
+      tw_bitmap_free(b);
+      tw_bitmap_free(a);
+    }
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_relations)
+{
+  DESCRIBE_TEST;
+  const uint32_t sizes[] = {512, 8192, 8192 + 3 * 512, (1 << 17) + 15 * 512};
+  const uint32_t sparsities[] = {1, 3, 64};
+  uint64_t seed = 0xC0FFEE0123456789ULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    for (size_t j = 0; j < TW_ARRAY_SIZE(sparsities); ++j) {
+      const uint32_t nbits = sizes[i];
+      struct tw_bitmap *a = tw_bitmap_new(nbits);
+      struct tw_bitmap *b = tw_bitmap_new(nbits);
+      bitmap_random_fill(a, &seed, sparsities[j]);
+      bitmap_random_fill(b, &seed, 2);
+
+      const bool intersects = tw_bitmap_intersection_count(a, b) != 0;
+      ck_assert(tw_bitmap_intersects(a, b) == intersects);
+      ck_assert(tw_bitmap_is_disjoint(b, a) == !intersects);
+      ck_assert(tw_bitmap_is_subset(a, b) ==
+                (tw_bitmap_andnot_count(a, b) == 0));
+
+      /* `a & b` is a subset of both, and disjoint from `a & ~b` */
+      struct tw_bitmap *dst = tw_bitmap_clone(a);
+      tw_bitmap_intersection(b, dst);
+      ck_assert(tw_bitmap_is_subset(dst, a));
+      ck_assert(tw_bitmap_is_subset(dst, b));
+      ck_assert(tw_bitmap_is_subset(a, a));
+
+      struct tw_bitmap *rest = tw_bitmap_clone(a);
+      tw_bitmap_andnot(b, rest);
+      ck_assert(tw_bitmap_is_disjoint(dst, rest));
+      ck_assert(tw_bitmap_is_disjoint(rest, b));
+      ck_assert(tw_bitmap_is_subset(rest, a));
+      ck_assert(tw_bitmap_is_subset(a, b) == tw_bitmap_empty(rest));
+
+      /* the witness is the last bit, outdated counts are not trusted */
+      tw_bitmap_zero(dst);
+      tw_bitmap_zero(rest);
+      tw_bitmap_set_nocount(dst, nbits - 1);
+      ck_assert(!tw_bitmap_intersects(dst, rest));
+      ck_assert(!tw_bitmap_is_subset(dst, rest));
+      tw_bitmap_set_nocount(rest, nbits - 1);
+      ck_assert(tw_bitmap_intersects(dst, rest));
+      ck_assert(tw_bitmap_is_subset(dst, rest));
+      tw_bitmap_set(rest, 0);
+      ck_assert(!tw_bitmap_is_subset(rest, dst));
+
+      tw_bitmap_free(rest);
+      tw_bitmap_free(dst);
+      tw_bitmap_free(b);
+      tw_bitmap_free(a);
+    }
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_many_operations)
+{
+  DESCRIBE_TEST;
+  const uint32_t sizes[] = {512, 8192 + 3 * 512, (1 << 17) + 15 * 512};
+  const size_t n_srcs_list[] = {1, 2, 7, 64};
+  uint64_t seed = 0x0123456789ABCDEFULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    for (size_t j = 0; j < TW_ARRAY_SIZE(n_srcs_list); ++j) {
+      const uint32_t nbits = sizes[i];
+      const size_t n_srcs = n_srcs_list[j];
+      struct tw_bitmap *srcs[64];
+
+      for (size_t k = 0; k < n_srcs; ++k) {
+        srcs[k] = tw_bitmap_new(nbits);
+        /* dense enough for intersections to survive a few sources */
+        bitmap_random_fill(srcs[k], &seed, 1 + (k % 2));
+        tw_bitmap_not(srcs[k]);
+      }
+
+      struct tw_bitmap *expected = tw_bitmap_clone(srcs[0]);
+      struct tw_bitmap *dst = tw_bitmap_new(nbits);
+      const struct tw_bitmap *const *csrcs = (const struct tw_bitmap **)srcs;
+
+      for (size_t k = 1; k < n_srcs; ++k) {
+        tw_bitmap_union(srcs[k], expected);
+      }
+      tw_bitmap_fill(dst);
+      ck_assert_ptr_eq(tw_bitmap_union_many(csrcs, n_srcs, dst), dst);
+      ck_assert(tw_bitmap_equal(dst, expected));
+      ck_assert_uint_eq(tw_bitmap_count(dst), bitmap_naive_count(dst));
+
+      tw_bitmap_copy(srcs[0], expected);
+      for (size_t k = 1; k < n_srcs; ++k) {
+        tw_bitmap_intersection(srcs[k], expected);
+      }
+      ck_assert_ptr_eq(tw_bitmap_intersection_many(csrcs, n_srcs, dst), dst);
+      ck_assert(tw_bitmap_equal(dst, expected));
+      ck_assert_uint_eq(tw_bitmap_count(dst), bitmap_naive_count(dst));
+
+      /* the destination may also be a source */
+      ck_assert_ptr_eq(tw_bitmap_intersection_many(csrcs, n_srcs, srcs[0]),
+                       srcs[0]);
+      ck_assert(tw_bitmap_equal(srcs[0], expected));
+
+      tw_bitmap_free(dst);
+      tw_bitmap_free(expected);
+      for (size_t k = 0; k < n_srcs; ++k) {
+        tw_bitmap_free(srcs[k]);
+      }
+    }
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_iterators)
+{
+  DESCRIBE_TEST;
+  const uint32_t sizes[] = {512, 8192 + 3 * 512, (1 << 17) + 15 * 512};
+  /* sparse words use tzcnt, dense words use compress */
+  const uint32_t sparsities[] = {1, 2, 5, 64, 1000};
+  uint64_t seed = 0xFEEDFACE12345678ULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    for (size_t j = 0; j < TW_ARRAY_SIZE(sparsities); ++j) {
+      const uint32_t nbits = sizes[i];
+      struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+      bitmap_random_fill(bitmap, &seed, sparsities[j]);
+
+      const uint64_t count = tw_bitmap_count(bitmap);
+      uint64_t *positions = calloc(count + 1, sizeof(uint64_t));
+      uint64_t n = 0;
+      for (uint64_t pos = 0; pos < bitmap->size; ++pos) {
+        if (tw_bitmap_test(bitmap, pos)) {
+          positions[n++] = pos;
+        }
+      }
+
+      struct tw_bitmap_iter iter;
+      uint64_t pos;
+
+      n = 0;
+      tw_bitmap_iter_init(&iter, bitmap, 0);
+      while (tw_bitmap_iter_next(&iter, &pos)) {
+        ck_assert_uint_eq(pos, positions[n++]);
+      }
+      ck_assert_uint_eq(n, count);
+      ck_assert(!tw_bitmap_iter_next(&iter, &pos));
+
+      tw_bitmap_iter_init_reverse(&iter, bitmap, TW_BITMAP_MAX_POS);
+      while (tw_bitmap_iter_prev(&iter, &pos)) {
+        ck_assert_uint_eq(pos, positions[--n]);
+      }
+      ck_assert_uint_eq(n, 0);
+      ck_assert(!tw_bitmap_iter_prev(&iter, &pos));
+
+      /* starting mid-word */
+      if (count > 2) {
+        const uint64_t mid = positions[count / 2];
+        tw_bitmap_iter_init(&iter, bitmap, mid + 1);
+        ck_assert(tw_bitmap_iter_next(&iter, &pos));
+        ck_assert_uint_eq(pos, positions[count / 2 + 1]);
+        tw_bitmap_iter_init_reverse(&iter, bitmap, mid - 1);
+        ck_assert(tw_bitmap_iter_prev(&iter, &pos));
+        ck_assert_uint_eq(pos, positions[count / 2 - 1]);
+      }
+
+      /* bulk extraction, resumed with chunks of various sizes */
+      const uint64_t chunks[] = {1, 7, 63, 64, 65, 1000, count + 1};
+      uint64_t *out = calloc(count + 1, sizeof(uint64_t));
+      for (size_t k = 0; k < TW_ARRAY_SIZE(chunks); ++k) {
+        uint64_t start = 0, extracted = 0, m;
+        memset(out, 0, (count + 1) * sizeof(uint64_t));
+        while (start < bitmap->size &&
+               (m = tw_bitmap_to_array(bitmap, out + extracted, start,
+                                       tw_min(chunks[k], count + 1 -
+                                                             extracted)))) {
+          ck_assert(m <= chunks[k]);
+          extracted += m;
+          start = out[extracted - 1] + 1;
+        }
+        ck_assert_uint_eq(extracted, count);
+        ck_assert_int_eq(memcmp(out, positions, count * sizeof(uint64_t)), 0);
+        /* never writes past max */
+        ck_assert_uint_eq(out[count], 0);
+      }
+
+      free(out);
+      free(positions);
+      tw_bitmap_free(bitmap);
+    }
+  }
+}
+END_TEST
+
+static int64_t naive_find_next(const struct tw_bitmap *bitmap, uint64_t from,
+                               bool value)
+{
+  for (uint64_t pos = from; pos < bitmap->size; ++pos) {
+    if (tw_bitmap_test(bitmap, pos) == value) {
+      return pos;
+    }
+  }
+  return -1;
+}
+
+static int64_t naive_find_prev(const struct tw_bitmap *bitmap, uint64_t from,
+                               bool value)
+{
+  for (int64_t pos = from; pos >= 0; --pos) {
+    if (tw_bitmap_test(bitmap, pos) == value) {
+      return pos;
+    }
+  }
+  return -1;
+}
+
+START_TEST(test_bitmap_find_next_prev)
+{
+  DESCRIBE_TEST;
+  const uint32_t nbits = 1 << 15;
+  /* sparse enough to skip whole vectors, in both polarities */
+  const uint32_t sparsities[] = {2, 500, 5000, 100000};
+  uint64_t seed = 0xA5A5A5A55A5A5A5AULL;
+
+  for (size_t j = 0; j < TW_ARRAY_SIZE(sparsities); ++j) {
+    struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+    bitmap_random_fill(bitmap, &seed, sparsities[j]);
+
+    for (int negate = 0; negate < 2; ++negate) {
+      for (uint64_t from = 0; from < nbits; from += 1 + (from % 61)) {
+        ck_assert_int64_t_eq(tw_bitmap_find_next_bit(bitmap, from),
+                             naive_find_next(bitmap, from, true));
+        ck_assert_int64_t_eq(tw_bitmap_find_next_zero(bitmap, from),
+                             naive_find_next(bitmap, from, false));
+        ck_assert_int64_t_eq(tw_bitmap_find_prev_bit(bitmap, from),
+                             naive_find_prev(bitmap, from, true));
+        ck_assert_int64_t_eq(tw_bitmap_find_prev_zero(bitmap, from),
+                             naive_find_prev(bitmap, from, false));
+      }
+
+      ck_assert_int64_t_eq(tw_bitmap_find_first_bit(bitmap),
+                           naive_find_next(bitmap, 0, true));
+      ck_assert_int64_t_eq(tw_bitmap_find_first_zero(bitmap),
+                           naive_find_next(bitmap, 0, false));
+      ck_assert_int64_t_eq(tw_bitmap_find_last_bit(bitmap),
+                           naive_find_prev(bitmap, nbits - 1, true));
+      ck_assert_int64_t_eq(tw_bitmap_find_last_zero(bitmap),
+                           naive_find_prev(bitmap, nbits - 1, false));
+
+      /* cursor-style enumeration visits every active bit */
+      uint64_t n = 0;
+      for (int64_t pos = tw_bitmap_find_next_bit(bitmap, 0); pos >= 0;
+           pos = tw_bitmap_find_next_bit(bitmap, pos + 1)) {
+        n++;
+        if ((uint64_t)pos + 1 == nbits) {
+          break;
+        }
+      }
+      ck_assert_uint_eq(n, tw_bitmap_count(bitmap));
+
+      tw_bitmap_not(bitmap);
+    }
+
+    tw_bitmap_free(bitmap);
+  }
+
+  /* empty and full bitmaps */
+  struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+  ck_assert_int64_t_eq(tw_bitmap_find_next_bit(bitmap, 0), -1);
+  ck_assert_int64_t_eq(tw_bitmap_find_prev_bit(bitmap, nbits - 1), -1);
+  ck_assert_int64_t_eq(tw_bitmap_find_last_bit(bitmap), -1);
+  ck_assert_int64_t_eq(tw_bitmap_find_last_zero(bitmap), nbits - 1);
+  ck_assert_int64_t_eq(tw_bitmap_find_prev_zero(bitmap, TW_BITMAP_MAX_POS),
+                       nbits - 1);
+  tw_bitmap_fill(bitmap);
+  ck_assert_int64_t_eq(tw_bitmap_find_next_zero(bitmap, 0), -1);
+  ck_assert_int64_t_eq(tw_bitmap_find_prev_zero(bitmap, nbits - 1), -1);
+  ck_assert_int64_t_eq(tw_bitmap_find_last_zero(bitmap), -1);
+  ck_assert_int64_t_eq(tw_bitmap_find_last_bit(bitmap), nbits - 1);
+  tw_bitmap_free(bitmap);
+}
+END_TEST
+
+static uint64_t naive_count_range(const struct tw_bitmap *bitmap,
+                                  uint64_t start, uint64_t end)
+{
+  uint64_t count = 0;
+  for (uint64_t pos = start; pos <= end; ++pos) {
+    count += tw_bitmap_test(bitmap, pos);
+  }
+  return count;
+}
+
+/* apply a range operation, verifying it against the previous bits */
+static void validate_range(struct tw_bitmap *bitmap, uint64_t start,
+                           uint64_t end, int op)
+{
+  const uint64_t size = bitmap->size;
+  struct tw_bitmap *before = tw_bitmap_clone(bitmap);
+
+  const uint64_t count = naive_count_range(bitmap, start, end);
+  ck_assert_uint_eq(tw_bitmap_count_range(bitmap, start, end), count);
+  ck_assert(tw_bitmap_test_range_all(bitmap, start, end) ==
+            (count == end - start + 1));
+  ck_assert(tw_bitmap_test_range_any(bitmap, start, end) == (count != 0));
+
+  switch (op) {
+  case 0:
+    tw_bitmap_set_range(bitmap, start, end);
+    break;
+  case 1:
+    tw_bitmap_clear_range(bitmap, start, end);
+    break;
+  default:
+    tw_bitmap_flip_range(bitmap, start, end);
+    break;
+  }
+
+  for (uint64_t pos = 0; pos < size; ++pos) {
+    bool expected = tw_bitmap_test(before, pos);
+    if (start <= pos && pos <= end) {
+      expected = (op == 0) ? true : (op == 1) ? false : !expected;
+    }
+    ck_assert(tw_bitmap_test(bitmap, pos) == expected);
+  }
+  ck_assert_uint_eq(bitmap->count, bitmap_naive_count(bitmap));
+
+  tw_bitmap_free(before);
+}
+
+START_TEST(test_bitmap_range_operations)
+{
+  DESCRIBE_TEST;
+  const uint32_t nbits = 1 << 13;
+  /* single word, word boundaries, unaligned and whole bitmap */
+  const uint64_t ranges[][2] = {
+      {0, 0},     {5, 5},        {3, 60},     {0, 63},      {63, 64},
+      {64, 127},  {1, 126},      {60, 600},   {0, 4095},    {65, 4097},
+      {511, 513}, {100, 8000},   {0, 8191},   {8191, 8191}, {4000, 8191},
+  };
+  uint64_t seed = 0xDEADC0DEBAADF00DULL;
+
+  for (int op = 0; op < 3; ++op) {
+    struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+    for (size_t i = 0; i < TW_ARRAY_SIZE(ranges); ++i) {
+      tw_bitmap_zero(bitmap);
+      bitmap_random_fill(bitmap, &seed, 3);
+      validate_range(bitmap, ranges[i][0], ranges[i][1], op);
+      /* full and empty ranges */
+      validate_range(bitmap, ranges[i][0], ranges[i][1], op);
+    }
+
+    for (int i = 0; i < 64; ++i) {
+      const uint64_t r = xorshift64(&seed);
+      const uint64_t a = r % nbits, b = (r >> 32) % nbits;
+      validate_range(bitmap, tw_min(a, b), tw_max(a, b), op);
+    }
+
+    tw_bitmap_free(bitmap);
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_many_positions)
+{
+  DESCRIBE_TEST;
+  const uint32_t nbits = 1 << 14;
+  /* shorter and longer than the prefetch distance, with out of range */
+  const size_t lengths[] = {0, 1, 7, TW_BITMAP_PREFETCH_DISTANCE + 1, 1000};
+  uint64_t seed = 0x0123456789ABCDEFULL;
+  uint64_t positions[1000];
+
+  struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+  struct tw_bitmap *expected = tw_bitmap_new(nbits);
+  struct tw_bitmap *results = tw_bitmap_new(1000);
+
+  for (size_t l = 0; l < TW_ARRAY_SIZE(lengths); ++l) {
+    const size_t n = lengths[l];
+    for (size_t i = 0; i < n; ++i) {
+      /* duplicates and some positions past the end */
+      positions[i] = xorshift64(&seed) % (nbits + nbits / 8);
+    }
+
+    tw_bitmap_copy(bitmap, expected);
+    uint64_t changed = 0;
+    for (size_t i = 0; i < n; ++i) {
+      if (positions[i] < nbits) {
+        changed += !tw_bitmap_test_and_set(expected, positions[i]);
+      }
+    }
+    ck_assert_uint_eq(tw_bitmap_set_many(bitmap, positions, n), changed);
+    ck_assert(tw_bitmap_equal(bitmap, expected));
+    ck_assert_uint_eq(bitmap->count, bitmap_naive_count(bitmap));
+
+    /* set a random half, such that tested positions are mixed */
+    bitmap_random_fill(bitmap, &seed, 2);
+    ck_assert_ptr_eq(tw_bitmap_test_many(bitmap, positions, n, results),
+                     results);
+    for (size_t i = 0; i < results->size; ++i) {
+      const bool value = i < n && tw_bitmap_test(bitmap, positions[i]);
+      ck_assert(tw_bitmap_test(results, i) == value);
+    }
+    ck_assert_uint_eq(results->count, bitmap_naive_count(results));
+
+    tw_bitmap_copy(bitmap, expected);
+    changed = 0;
+    for (size_t i = 0; i < n; ++i) {
+      changed += tw_bitmap_test_and_clear(expected, positions[i]);
+    }
+    ck_assert_uint_eq(tw_bitmap_clear_many(bitmap, positions, n), changed);
+    ck_assert(tw_bitmap_equal(bitmap, expected));
+    ck_assert_uint_eq(bitmap->count, bitmap_naive_count(bitmap));
+  }
+
+  tw_bitmap_free(results);
+  tw_bitmap_free(expected);
+  tw_bitmap_free(bitmap);
+}
+END_TEST
+
+START_TEST(test_bitmap_nocount)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t sizes[] = {512, 1 << 12, (1 << 17) + 1};
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    const uint64_t nbits = sizes[i];
+    struct tw_bitmap *bitmap = tw_bitmap_new(nbits);
+    struct tw_bitmap *expected = tw_bitmap_new(nbits);
+
+    for (uint64_t pos = 0; pos < nbits; pos += 3) {
+      tw_bitmap_set_nocount(bitmap, pos);
+      tw_bitmap_set_nocount(bitmap, pos);
+      tw_bitmap_set(expected, pos);
+    }
+    ck_assert(bitmap->stale);
+    ck_assert_uint_eq(tw_bitmap_count(bitmap), tw_bitmap_count(expected));
+    ck_assert(!bitmap->stale);
+    ck_assert(tw_bitmap_equal(bitmap, expected));
+
+    /* counted and uncounted writes mix */
+    for (uint64_t pos = 0; pos < nbits; pos += 6) {
+      tw_bitmap_clear_nocount(bitmap, pos);
+      tw_bitmap_clear(bitmap, pos + 1);
+      tw_bitmap_set_range(bitmap, pos + 2, tw_min(pos + 4, nbits - 1));
+      tw_bitmap_clear(expected, pos);
+      tw_bitmap_clear(expected, pos + 1);
+      tw_bitmap_set_range(expected, pos + 2, tw_min(pos + 4, nbits - 1));
+    }
+    ck_assert(tw_almost_equal(tw_bitmap_density(bitmap),
+                              tw_bitmap_density(expected)));
+    ck_assert(tw_bitmap_equal(bitmap, expected));
+
+    tw_bitmap_fill(expected);
+    for (uint64_t pos = 0; pos < bitmap->size; ++pos) {
+      tw_bitmap_set_nocount(bitmap, pos);
+    }
+    ck_assert(tw_bitmap_full(bitmap));
+    for (uint64_t pos = 0; pos < bitmap->size; ++pos) {
+      tw_bitmap_clear_nocount(bitmap, pos);
+    }
+    ck_assert(tw_bitmap_empty(bitmap));
+
+    /* outdated counts are refreshed by operations deriving from them */
+    tw_bitmap_set_nocount(bitmap, 1);
+    ck_assert_uint_eq(tw_bitmap_union_count(bitmap, expected), bitmap->size);
+    tw_bitmap_set_nocount(bitmap, 2);
+    ck_assert_uint_eq(tw_bitmap_andnot_count(expected, bitmap),
+                      bitmap->size - 2);
+    tw_bitmap_set_nocount(bitmap, 3);
+    ck_assert_ptr_eq(tw_bitmap_copy(bitmap, expected), expected);
+    ck_assert_uint_eq(tw_bitmap_count(expected), 3);
+    tw_bitmap_set_nocount(bitmap, 4);
+    ck_assert_ptr_eq(tw_bitmap_union(expected, bitmap), bitmap);
+    ck_assert(!bitmap->stale);
+    ck_assert_uint_eq(bitmap->count, 4);
+
+    tw_bitmap_free(expected);
+    tw_bitmap_free(bitmap);
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_alloc_flags)
+{
+  DESCRIBE_TEST;
+  const uint64_t sizes[] = {1, 1 << 15, (1 << 24) + 1};
+  uint64_t seed = 0x8BADF00D0D15EA5EULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    struct tw_bitmap *expected = tw_bitmap_new(sizes[i]);
+    bitmap_random_set(expected, &seed, 1000);
+
+    for (size_t f = 0; f < TW_ARRAY_SIZE(alloc_flags); ++f) {
+      struct tw_bitmap *bitmap = tw_bitmap_new_flags(sizes[i], alloc_flags[f]);
+      ck_assert_ptr_ne(bitmap, NULL);
+      ck_assert_uint_eq(bitmap->size, expected->size);
+      ck_assert(tw_bitmap_empty(bitmap));
+      ck_assert_int64_t_eq(tw_bitmap_find_first_bit(bitmap), -1);
+
+      ck_assert_ptr_eq(tw_bitmap_union(expected, bitmap), bitmap);
+      ck_assert(tw_bitmap_equal(bitmap, expected));
+      ck_assert_uint_eq(bitmap->count, expected->count);
+
+      tw_bitmap_free(bitmap);
+    }
+
+    tw_bitmap_free(expected);
+  }
+
+  ck_assert_ptr_eq(tw_bitmap_new_flags(0, TW_ALLOC_HUGE_PAGES), NULL);
+  ck_assert_ptr_eq(
+      tw_bitmap_new_flags(TW_BITMAP_MAX_BITS + 1, TW_ALLOC_HUGE_PAGES), NULL);
+}
+END_TEST
+
+START_TEST(test_bitmap_wrap)
+{
+  DESCRIBE_TEST;
+  const uint64_t sizes[] = {512, 1 << 12, (1 << 17) + 512};
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    const uint64_t nbits = sizes[i];
+    uint64_t *words = malloc_aligned(TW_CACHELINE, nbits / TW_BITS_IN_WORD);
+    memset(words, 0, nbits / TW_BITS_IN_WORD);
+
+    struct tw_bitmap *expected = tw_bitmap_new(nbits);
+    for (uint64_t pos = 0; pos < nbits; pos += 7) {
+      words[pos / 64] |= 1ULL << (pos % 64);
+      tw_bitmap_set(expected, pos);
+    }
+
+    /* bits of the buffer are seen, and counted, without copying */
+    struct tw_bitmap *bitmap = tw_bitmap_wrap(words, nbits);
+    ck_assert_ptr_ne(bitmap, NULL);
+    ck_assert_ptr_eq(bitmap->data, words);
+    ck_assert_uint_eq(bitmap->size, nbits);
+    ck_assert_uint_eq(tw_bitmap_count(bitmap), tw_bitmap_count(expected));
+    ck_assert(tw_bitmap_equal(bitmap, expected));
+
+    /* writes go through to the buffer */
+    tw_bitmap_clear(bitmap, 0);
+    tw_bitmap_set(bitmap, nbits - 1);
+    ck_assert_uint_eq(words[0] & 1ULL, 0);
+    ck_assert_uint_eq(words[nbits / 64 - 1] >> 63, 1);
+    ck_assert_ptr_eq(tw_bitmap_union(expected, bitmap), bitmap);
+    ck_assert(tw_bitmap_is_subset(expected, bitmap));
+
+    /* the allocation is the caller's */
+    ck_assert_ptr_eq(tw_bitmap_resize(bitmap, 2 * nbits), NULL);
+    ck_assert_ptr_eq(tw_bitmap_resize(bitmap, nbits / 2), NULL);
+    ck_assert_ptr_eq(tw_bitmap_reserve(bitmap, 2 * nbits), NULL);
+    ck_assert_uint_eq(bitmap->size, nbits);
+
+    struct tw_bitmap *clone = tw_bitmap_clone(bitmap);
+    ck_assert_ptr_ne(clone->data, words);
+    ck_assert(tw_bitmap_equal(clone, bitmap));
+    tw_bitmap_free(clone);
+
+    tw_bitmap_free(bitmap);
+    ck_assert_uint_eq(words[nbits / 64 - 1] >> 63, 1);
+
+    free(words);
+    tw_bitmap_free(expected);
+  }
+
+  uint64_t words[16] __attribute__((aligned(64))) = {0};
+  ck_assert_ptr_eq(tw_bitmap_wrap(NULL, 512), NULL);
+  ck_assert_ptr_eq(tw_bitmap_wrap(words, 0), NULL);
+  ck_assert_ptr_eq(tw_bitmap_wrap(words, 513), NULL);
+  ck_assert_ptr_eq(tw_bitmap_wrap(words + 1, 512), NULL);
+  ck_assert_ptr_eq(tw_bitmap_wrap(words, TW_BITMAP_MAX_BITS + 512), NULL);
+}
+END_TEST
+
+START_TEST(test_bitmap_resize)
+{
+  DESCRIBE_TEST;
+
+  /* growing one bit at a time, past `TW_BITMAP_REMAP_MIN` bytes */
+  const uint64_t nbits = (TW_BITMAP_REMAP_MIN * 8) << 1;
+  struct tw_bitmap *bitmap = tw_bitmap_new(1);
+  uint64_t n_grows = 0, capacity = bitmap->capacity;
+
+  for (uint64_t pos = 0; pos < nbits; pos += 7) {
+    if (pos >= bitmap->size) {
+      ck_assert_ptr_eq(tw_bitmap_resize(bitmap, pos + 1), bitmap);
+      n_grows += (bitmap->capacity != capacity);
+      capacity = bitmap->capacity;
+    }
+    tw_bitmap_set(bitmap, pos);
+  }
+
+  ck_assert_uint_le(n_grows, 64);
+  ck_assert_ptr_ne(bitmap->mapping, NULL);
+  ck_assert_uint_ge(bitmap->capacity, bitmap->size);
+  ck_assert_uint_eq(tw_bitmap_count(bitmap), TW_DIV_ROUND_UP(nbits, 7));
+  ck_assert_uint_eq(tw_bitmap_count_range(bitmap, 0, bitmap->size - 1),
+                    TW_DIV_ROUND_UP(nbits, 7));
+
+  /* shrinking keeps the count and clears the bits past the new size */
+  ck_assert_ptr_eq(tw_bitmap_resize(bitmap, 1000), bitmap);
+  ck_assert_uint_eq(bitmap->size, 1024);
+  ck_assert_uint_eq(tw_bitmap_count(bitmap), TW_DIV_ROUND_UP(1024, 7));
+  tw_bitmap_set_nocount(bitmap, 1023);
+  ck_assert_ptr_eq(tw_bitmap_resize(bitmap, 512), bitmap);
+  ck_assert_uint_eq(tw_bitmap_count(bitmap), TW_DIV_ROUND_UP(512, 7));
+  ck_assert_ptr_eq(tw_bitmap_resize(bitmap, nbits), bitmap);
+  ck_assert_uint_eq(tw_bitmap_count(bitmap), TW_DIV_ROUND_UP(512, 7));
+  ck_assert_int64_t_eq(tw_bitmap_find_next_bit(bitmap, 512), -1);
+  tw_bitmap_free(bitmap);
+
+  /* reserving keeps the size, later growth does not reallocate */
+  bitmap = tw_bitmap_new(512);
+  tw_bitmap_set(bitmap, 511);
+  ck_assert_ptr_eq(tw_bitmap_reserve(bitmap, 1 << 20), bitmap);
+  ck_assert_uint_eq(bitmap->size, 512);
+  ck_assert_uint_ge(bitmap->capacity, 1 << 20);
+  const uint64_t *data = bitmap->data;
+  ck_assert_ptr_eq(tw_bitmap_resize(bitmap, 1 << 20), bitmap);
+  ck_assert_ptr_eq(bitmap->data, data);
+  ck_assert(tw_bitmap_test(bitmap, 511));
+  ck_assert_uint_eq(tw_bitmap_count(bitmap), 1);
+  tw_bitmap_free(bitmap);
+
+  /* anonymous mappings are grown by remapping, with their own flags */
+  const int flags[] = {TW_ALLOC_HUGE_PAGES, TW_ALLOC_HUGETLB,
+                       TW_ALLOC_INTERLEAVE};
+  for (size_t f = 0; f < TW_ARRAY_SIZE(flags); ++f) {
+    bitmap = tw_bitmap_new_flags(1 << 15, flags[f]);
+    ck_assert_int_eq(bitmap->flags, flags[f]);
+    tw_bitmap_set(bitmap, 0);
+    tw_bitmap_set(bitmap, (1 << 15) - 1);
+    ck_assert_ptr_eq(tw_bitmap_resize(bitmap, (1 << 24) + 1), bitmap);
+    tw_bitmap_set(bitmap, 1 << 24);
+    ck_assert_uint_eq(tw_bitmap_count(bitmap), 3);
+    ck_assert_uint_eq(tw_bitmap_count_range(bitmap, 0, bitmap->size - 1), 3);
+    tw_bitmap_free(bitmap);
+  }
+}
+END_TEST
+
+START_TEST(test_bitmap_mixed_sizes)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t small_size = 1 << 12, large_size = 1 << 16;
+  struct tw_bitmap *small = tw_bitmap_new(small_size);
+  struct tw_bitmap *large = tw_bitmap_new(large_size);
+  uint64_t seed = 0xFEEDFACECAFEBEEFULL;
+
+  for (int i = 0; i < 4000; ++i) {
+    const uint64_t r = xorshift64(&seed);
+    tw_bitmap_set(small, r % small_size);
+    tw_bitmap_set(large, (r >> 16) % large_size);
+  }
+
+  /* the small bitmap resized to the large size is the reference */
+  struct tw_bitmap *padded = tw_bitmap_clone(small);
+  ck_assert_ptr_eq(tw_bitmap_resize(padded, large_size), padded);
+  ck_assert(tw_bitmap_equal(small, padded));
+  ck_assert(tw_bitmap_equal(padded, small));
+  ck_assert(!tw_bitmap_equal(small, large));
+
+  ck_assert(tw_bitmap_intersects(small, large) ==
+            tw_bitmap_intersects(padded, large));
+  ck_assert(tw_bitmap_is_subset(small, padded));
+  ck_assert(tw_bitmap_is_subset(padded, small));
+  ck_assert(!tw_bitmap_is_subset(large, small));
+  ck_assert_uint_eq(tw_bitmap_intersection_count(small, large),
+                    tw_bitmap_intersection_count(padded, large));
+  ck_assert_uint_eq(tw_bitmap_union_count(large, small),
+                    tw_bitmap_union_count(large, padded));
+  ck_assert_uint_eq(tw_bitmap_xor_count(small, large),
+                    tw_bitmap_xor_count(padded, large));
+  ck_assert_uint_eq(tw_bitmap_andnot_count(large, small),
+                    tw_bitmap_andnot_count(large, padded));
+  ck_assert(tw_almost_equal(tw_bitmap_jaccard(small, large),
+                            tw_bitmap_jaccard(padded, large)));
+
+  typedef struct tw_bitmap *(*op_t)(const struct tw_bitmap *,
+                                    struct tw_bitmap *);
+  const op_t ops[] = {tw_bitmap_union, tw_bitmap_intersection, tw_bitmap_xor,
+                      tw_bitmap_andnot};
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(ops); ++i) {
+    /* smaller destination, grown by union and xor */
+    struct tw_bitmap *dst = tw_bitmap_clone(small);
+    struct tw_bitmap *expected = tw_bitmap_clone(padded);
+    ck_assert_ptr_eq(ops[i](large, dst), dst);
+    ck_assert_ptr_eq(ops[i](large, expected), expected);
+    ck_assert(tw_bitmap_equal(dst, expected));
+    ck_assert_uint_eq(tw_bitmap_count_range(dst, 0, dst->size - 1),
+                      tw_bitmap_count(expected));
+    tw_bitmap_free(expected);
+    tw_bitmap_free(dst);
+
+    /* larger destination */
+    dst = tw_bitmap_clone(large);
+    expected = tw_bitmap_clone(large);
+    ck_assert_ptr_eq(ops[i](small, dst), dst);
+    ck_assert_ptr_eq(ops[i](padded, expected), expected);
+    ck_assert_uint_eq(dst->size, large_size);
+    ck_assert(tw_bitmap_equal(dst, expected));
+    ck_assert_uint_eq(tw_bitmap_count_range(dst, 0, dst->size - 1),
+                      tw_bitmap_count(expected));
+    tw_bitmap_free(expected);
+    tw_bitmap_free(dst);
+  }
+
+  typedef struct tw_bitmap *(*op3_t)(const struct tw_bitmap *,
+                                     const struct tw_bitmap *,
+                                     struct tw_bitmap *);
+  const op3_t ops3[] = {tw_bitmap_union_into, tw_bitmap_intersection_into,
+                        tw_bitmap_xor_into, tw_bitmap_andnot_into,
+                        tw_bitmap_ornot_into};
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(ops3); ++i) {
+    struct tw_bitmap *expected = tw_bitmap_new(large_size);
+    struct tw_bitmap *out = tw_bitmap_new(small_size);
+
+    /* the output is resized to the larger operand, either one */
+    ck_assert_ptr_eq(ops3[i](padded, large, expected), expected);
+    ck_assert_ptr_eq(ops3[i](small, large, out), out);
+    ck_assert_uint_eq(out->size, large_size);
+    ck_assert(tw_bitmap_equal(out, expected));
+    ck_assert_uint_eq(tw_bitmap_count(out), bitmap_naive_count(out));
+
+    ck_assert_ptr_eq(ops3[i](large, padded, expected), expected);
+    ck_assert_ptr_eq(ops3[i](large, small, out), out);
+    ck_assert(tw_bitmap_equal(out, expected));
+    ck_assert_uint_eq(tw_bitmap_count(out), bitmap_naive_count(out));
+
+    /* aliasing the smaller operand grows it */
+    struct tw_bitmap *alias = tw_bitmap_clone(small);
+    ck_assert_ptr_eq(ops3[i](large, alias, alias), alias);
+    ck_assert(tw_bitmap_equal(alias, expected));
+    ck_assert_uint_eq(tw_bitmap_count(alias), bitmap_naive_count(alias));
+
+    tw_bitmap_free(alias);
+    tw_bitmap_free(out);
+    tw_bitmap_free(expected);
+  }
+
+  const struct tw_bitmap *mixed[] = {small, large, padded};
+  const struct tw_bitmap *uniform[] = {padded, large, padded};
+
+  /* union grows the destination to the largest source */
+  struct tw_bitmap *expected = tw_bitmap_new(large_size);
+  struct tw_bitmap *dst = tw_bitmap_new(small_size);
+  tw_bitmap_fill(dst);
+  ck_assert_ptr_eq(tw_bitmap_union_many(uniform, 3, expected), expected);
+  ck_assert_ptr_eq(tw_bitmap_union_many(mixed, 3, dst), dst);
+  ck_assert_uint_eq(dst->size, large_size);
+  ck_assert(tw_bitmap_equal(dst, expected));
+  ck_assert_uint_eq(tw_bitmap_count(dst), bitmap_naive_count(dst));
+
+  /* intersection clears the destination past the smallest source */
+  tw_bitmap_fill(dst);
+  ck_assert_ptr_eq(tw_bitmap_intersection_many(uniform, 3, expected),
+                   expected);
+  ck_assert_ptr_eq(tw_bitmap_intersection_many(mixed, 3, dst), dst);
+  ck_assert_uint_eq(dst->size, large_size);
+  ck_assert(tw_bitmap_equal(dst, expected));
+  ck_assert_uint_eq(tw_bitmap_count(dst), bitmap_naive_count(dst));
+  tw_bitmap_free(dst);
+
+  /* the destination may be the smallest source */
+  dst = tw_bitmap_clone(small);
+  const struct tw_bitmap *aliased[] = {dst, large};
+  ck_assert_ptr_eq(tw_bitmap_union_many(uniform, 2, expected), expected);
+  ck_assert_ptr_eq(tw_bitmap_union_many(aliased, 2, dst), dst);
+  ck_assert(tw_bitmap_equal(dst, expected));
+  ck_assert_uint_eq(tw_bitmap_count(dst), bitmap_naive_count(dst));
+  tw_bitmap_free(dst);
+  tw_bitmap_free(expected);
+
+  /* copying resizes the destination */
+  dst = tw_bitmap_clone(large);
+  ck_assert_ptr_eq(tw_bitmap_copy(small, dst), dst);
+  ck_assert_uint_eq(dst->size, small_size);
+  ck_assert(tw_bitmap_equal(dst, small));
+  tw_bitmap_free(dst);
+
+  tw_bitmap_free(padded);
+  tw_bitmap_free(large);
+  tw_bitmap_free(small);
+}
+END_TEST
+
+/* move the bit at `pos` to `pos + shift`, wrapping around if `rotate` */
+static void shift_bits(const struct tw_bitmap *src, struct tw_bitmap *dst,
+                       int64_t shift, bool rotate)
+{
+  const int64_t size = src->size;
+
+  tw_bitmap_zero(dst);
+  for (int64_t pos = 0; pos < size; ++pos) {
+    if (!tw_bitmap_test(src, pos)) {
+      continue;
+    }
+    int64_t moved = pos + shift % size;
+    if (rotate) {
+      tw_bitmap_set(dst, (moved + size) % size);
+    } else if (pos + shift >= 0 && pos + shift < size) {
+      tw_bitmap_set(dst, pos + shift);
+    }
+  }
+}
+
+START_TEST(test_bitmap_shift)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t sizes[] = {512, 4096, 1 << 16};
+  const uint64_t shifts[] = {0, 1, 7, 63, 64, 65, 127, 128, 500, 511, 513};
+  uint64_t seed = 0x0DDBA11C0FFEEULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(sizes); ++i) {
+    const uint64_t size = sizes[i];
+    struct tw_bitmap *src = tw_bitmap_new(size);
+    struct tw_bitmap *bitmap = tw_bitmap_new(size);
+    struct tw_bitmap *expected = tw_bitmap_new(size);
+
+    bitmap_random_set(src, &seed, size / 3);
+
+    for (size_t j = 0; j < TW_ARRAY_SIZE(shifts) + 3; ++j) {
+      /* shifts relative to the size, up to a full rotation and beyond */
+      const uint64_t shift = (j < TW_ARRAY_SIZE(shifts))
+                                 ? shifts[j]
+                                 : size - 1 + (j - TW_ARRAY_SIZE(shifts));
+
+      tw_bitmap_copy(src, bitmap);
+      shift_bits(src, expected, shift, false);
+      ck_assert_ptr_eq(tw_bitmap_shift_left(bitmap, shift), bitmap);
+      ck_assert(tw_bitmap_equal(bitmap, expected));
+      ck_assert_uint_eq(bitmap->count, expected->count);
+
+      tw_bitmap_copy(src, bitmap);
+      shift_bits(src, expected, -(int64_t)shift, false);
+      ck_assert_ptr_eq(tw_bitmap_shift_right(bitmap, shift), bitmap);
+      ck_assert(tw_bitmap_equal(bitmap, expected));
+      ck_assert_uint_eq(bitmap->count, expected->count);
+
+      tw_bitmap_copy(src, bitmap);
+      shift_bits(src, expected, shift, true);
+      ck_assert_ptr_eq(tw_bitmap_rotate_left(bitmap, shift), bitmap);
+      ck_assert(tw_bitmap_equal(bitmap, expected));
+
+      ck_assert_ptr_eq(tw_bitmap_rotate_right(bitmap, shift), bitmap);
+      ck_assert(tw_bitmap_equal(bitmap, src));
+      ck_assert_uint_eq(bitmap->count, src->count);
+    }
+
+    /* stale counts are recomputed */
+    tw_bitmap_copy(src, bitmap);
+    tw_bitmap_set_nocount(bitmap, size - 1);
+    tw_bitmap_shift_left(bitmap, 1);
+    tw_bitmap_clear(src, size - 1);
+    shift_bits(src, expected, 1, false);
+    ck_assert(tw_bitmap_equal(bitmap, expected));
+
+    tw_bitmap_free(expected);
+    tw_bitmap_free(bitmap);
+    tw_bitmap_free(src);
+  }
+}
+END_TEST
+
 START_TEST(test_bitmap_errors)
 {
   DESCRIBE_TEST;
@@ -266,12 +1317,25 @@ START_TEST(test_bitmap_errors)
   ck_assert_ptr_eq(tw_bitmap_new(TW_BITMAP_MAX_BITS), NULL);
 
   ck_assert_ptr_eq(tw_bitmap_clone(NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_copy(NULL, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_copy(a, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_resize(NULL, a_size), NULL);
+  ck_assert_ptr_eq(tw_bitmap_resize(a, 0), NULL);
+  ck_assert_ptr_eq(tw_bitmap_resize(a, TW_BITMAP_MAX_BITS + 1), NULL);
+  ck_assert_ptr_eq(tw_bitmap_reserve(NULL, a_size), NULL);
+  ck_assert_ptr_eq(tw_bitmap_reserve(a, TW_BITMAP_MAX_BITS + 1), NULL);
+  ck_assert_uint_eq(a->size, a_size);
 
   /* This should not raise a segfault. */
   tw_bitmap_set(a, a_size);
   tw_bitmap_set(a, a_size + 1);
   tw_bitmap_clear(a, a_size);
   tw_bitmap_clear(a, a_size + 1);
+  tw_bitmap_set_nocount(NULL, 0);
+  tw_bitmap_set_nocount(a, a_size);
+  tw_bitmap_clear_nocount(NULL, 0);
+  tw_bitmap_clear_nocount(a, a_size);
+  ck_assert(!a->stale);
   ck_assert(!tw_bitmap_test(a, a_size));
   ck_assert(!tw_bitmap_test(a, a_size + 1));
 
@@ -290,19 +1354,93 @@ START_TEST(test_bitmap_errors)
   ck_assert_ptr_eq(tw_bitmap_fill(NULL), NULL);
   ck_assert_int_eq(tw_bitmap_find_first_zero(NULL), -1);
   ck_assert_int_eq(tw_bitmap_find_first_bit(NULL), -1);
+  ck_assert_int_eq(tw_bitmap_find_last_zero(NULL), -1);
+  ck_assert_int_eq(tw_bitmap_find_last_bit(NULL), -1);
+  ck_assert_int_eq(tw_bitmap_find_next_zero(NULL, 0), -1);
+  ck_assert_int_eq(tw_bitmap_find_next_zero(a, a_size), -1);
+  ck_assert_int_eq(tw_bitmap_find_next_bit(NULL, 0), -1);
+  ck_assert_int_eq(tw_bitmap_find_next_bit(a, a_size), -1);
+  ck_assert_int_eq(tw_bitmap_find_prev_zero(NULL, 0), -1);
+  ck_assert_int_eq(tw_bitmap_find_prev_bit(NULL, 0), -1);
 
   ck_assert_ptr_eq(tw_bitmap_not(NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_shift_left(NULL, 1), NULL);
+  ck_assert_ptr_eq(tw_bitmap_shift_right(NULL, 1), NULL);
+  ck_assert_ptr_eq(tw_bitmap_rotate_left(NULL, 1), NULL);
+  ck_assert_ptr_eq(tw_bitmap_rotate_right(NULL, 1), NULL);
   ck_assert(!tw_bitmap_equal(a, NULL));
   ck_assert(!tw_bitmap_equal(NULL, a));
   ck_assert_ptr_eq(tw_bitmap_union(a, NULL), NULL);
   ck_assert_ptr_eq(tw_bitmap_union(NULL, a), NULL);
-  ck_assert_ptr_eq(tw_bitmap_union(a, b), NULL);
   ck_assert_ptr_eq(tw_bitmap_intersection(a, NULL), NULL);
   ck_assert_ptr_eq(tw_bitmap_intersection(NULL, a), NULL);
-  ck_assert_ptr_eq(tw_bitmap_intersection(a, b), NULL);
   ck_assert_ptr_eq(tw_bitmap_xor(a, NULL), NULL);
   ck_assert_ptr_eq(tw_bitmap_xor(NULL, a), NULL);
-  ck_assert_ptr_eq(tw_bitmap_xor(a, b), NULL);
+  ck_assert_ptr_eq(tw_bitmap_andnot(NULL, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_andnot(a, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_union_into(NULL, a, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_union_into(a, NULL, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_union_into(a, a, NULL), NULL);
+  const struct tw_bitmap *ab[] = {a, b}, *an[] = {a, NULL};
+  ck_assert_ptr_eq(tw_bitmap_union_many(NULL, 1, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_union_many(ab, 0, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_union_many(ab, 1, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_union_many(an, 2, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_intersection_many(NULL, 1, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_intersection_many(ab, 0, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_intersection_many(ab, 1, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_intersection_many(an, 2, a), NULL);
+  struct tw_bitmap_iter iter;
+  uint64_t pos, out[1];
+  ck_assert_ptr_eq(tw_bitmap_iter_init(NULL, a, 0), NULL);
+  ck_assert_ptr_eq(tw_bitmap_iter_init(&iter, NULL, 0), NULL);
+  ck_assert_ptr_eq(tw_bitmap_iter_init_reverse(NULL, a, 0), NULL);
+  ck_assert_ptr_eq(tw_bitmap_iter_init_reverse(&iter, NULL, 0), NULL);
+  ck_assert(!tw_bitmap_iter_next(NULL, &pos));
+  ck_assert(!tw_bitmap_iter_prev(NULL, &pos));
+  ck_assert(!tw_bitmap_iter_next(tw_bitmap_iter_init(&iter, a, a_size), &pos));
+  ck_assert(!tw_bitmap_iter_next(&iter, NULL));
+  ck_assert(!tw_bitmap_iter_prev(&iter, NULL));
+  ck_assert_uint_eq(tw_bitmap_to_array(NULL, out, 0, 1), 0);
+  ck_assert_uint_eq(tw_bitmap_to_array(a, NULL, 0, 1), 0);
+  ck_assert_uint_eq(tw_bitmap_to_array(a, out, a_size, 1), 0);
+  ck_assert_uint_eq(tw_bitmap_to_array(a, out, 0, 0), 0);
+
+  ck_assert_uint_eq(tw_bitmap_intersection_count(a, NULL), 0);
+  ck_assert_uint_eq(tw_bitmap_intersection_count(NULL, a), 0);
+  ck_assert_uint_eq(tw_bitmap_union_count(a, NULL), 0);
+  ck_assert_uint_eq(tw_bitmap_xor_count(NULL, a), 0);
+  ck_assert_uint_eq(tw_bitmap_andnot_count(a, NULL), 0);
+  ck_assert(tw_almost_equal(tw_bitmap_jaccard(NULL, a), 0.0f));
+  ck_assert(!tw_bitmap_intersects(a, NULL));
+  ck_assert(!tw_bitmap_is_disjoint(NULL, a));
+  ck_assert(!tw_bitmap_is_subset(NULL, a));
+
+  tw_bitmap_set_range(NULL, 0, 1);
+  tw_bitmap_set_range(a, 2, 1);
+  tw_bitmap_set_range(a, 0, a_size);
+  tw_bitmap_flip_range(a, a_size, a_size);
+  tw_bitmap_clear_range(NULL, 0, 1);
+  ck_assert(tw_bitmap_empty(a));
+  ck_assert_uint_eq(tw_bitmap_count_range(NULL, 0, 1), 0);
+  ck_assert_uint_eq(tw_bitmap_count_range(a, 1, 0), 0);
+  ck_assert(!tw_bitmap_test_range_any(a, 0, a_size));
+  tw_bitmap_fill(a);
+  ck_assert_uint_eq(tw_bitmap_count_range(a, 0, a_size), 0);
+  ck_assert(!tw_bitmap_test_range_all(NULL, 0, 1));
+  ck_assert(!tw_bitmap_test_range_all(a, 1, 0));
+  ck_assert(!tw_bitmap_test_range_all(a, 0, a_size));
+
+  const uint64_t positions[] = {0, 1, 2};
+  ck_assert_uint_eq(tw_bitmap_set_many(NULL, positions, 3), 0);
+  ck_assert_uint_eq(tw_bitmap_set_many(a, NULL, 3), 0);
+  ck_assert_uint_eq(tw_bitmap_clear_many(NULL, positions, 3), 0);
+  ck_assert_uint_eq(tw_bitmap_clear_many(a, NULL, 3), 0);
+  ck_assert_ptr_eq(tw_bitmap_test_many(NULL, positions, 3, b), NULL);
+  ck_assert_ptr_eq(tw_bitmap_test_many(a, NULL, 3, b), NULL);
+  ck_assert_ptr_eq(tw_bitmap_test_many(a, positions, 3, NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmap_test_many(a, positions, 3, a), NULL);
+  ck_assert_ptr_eq(tw_bitmap_test_many(a, positions, b_size + 512, b), NULL);
 
   tw_bitmap_free(b);
   tw_bitmap_free(a);
@@ -323,6 +1461,21 @@ int run_tests()
   tcase_add_test(tc, test_bitmap_zero_and_fill);
   tcase_add_test(tc, test_bitmap_find_first);
   tcase_add_test(tc, test_bitmap_set_operations);
+  tcase_add_test(tc, test_bitmap_set_operations_count);
+  tcase_add_test(tc, test_bitmap_three_operands);
+  tcase_add_test(tc, test_bitmap_count_operations);
+  tcase_add_test(tc, test_bitmap_relations);
+  tcase_add_test(tc, test_bitmap_many_operations);
+  tcase_add_test(tc, test_bitmap_iterators);
+  tcase_add_test(tc, test_bitmap_find_next_prev);
+  tcase_add_test(tc, test_bitmap_range_operations);
+  tcase_add_test(tc, test_bitmap_many_positions);
+  tcase_add_test(tc, test_bitmap_nocount);
+  tcase_add_test(tc, test_bitmap_alloc_flags);
+  tcase_add_test(tc, test_bitmap_wrap);
+  tcase_add_test(tc, test_bitmap_resize);
+  tcase_add_test(tc, test_bitmap_mixed_sizes);
+  tcase_add_test(tc, test_bitmap_shift);
   tcase_add_test(tc, test_bitmap_errors);
   suite_add_tcase(s, tc);
 
@@ -0,0 +1,308 @@
+#include <stdlib.h>
+
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/bitmap/bitmatrix.h>
+
+#include "../src/twiddle/macrology.h"
+#include "test.h"
+
+/* set one in `sparsity` bits */
+static struct tw_bitmatrix *random_matrix(uint64_t n_rows, uint64_t n_cols,
+                                          uint64_t *seed, uint32_t sparsity)
+{
+  struct tw_bitmatrix *matrix = tw_bitmatrix_new(n_rows, n_cols);
+  ck_assert_ptr_ne(matrix, NULL);
+
+  for (uint64_t row = 0; row < n_rows; ++row) {
+    for (uint64_t col = 0; col < n_cols; ++col) {
+      if (xorshift64(seed) % sparsity == 0) {
+        tw_bitmatrix_set(matrix, row, col);
+      }
+    }
+  }
+
+  return matrix;
+}
+
+START_TEST(test_bitmatrix_basic)
+{
+  DESCRIBE_TEST;
+
+  struct tw_bitmatrix *matrix = tw_bitmatrix_new(100, 1000);
+  ck_assert_ptr_ne(matrix, NULL);
+  ck_assert_uint_eq(matrix->n_rows, 100);
+  ck_assert_uint_eq(matrix->n_cols, 1000);
+  ck_assert_uint_eq(matrix->row_bits, 1024);
+
+  tw_bitmatrix_set(matrix, 0, 0);
+  tw_bitmatrix_set(matrix, 99, 999);
+  tw_bitmatrix_set(matrix, 50, 64);
+  tw_bitmatrix_set(matrix, 50, 999);
+  ck_assert(tw_bitmatrix_test(matrix, 0, 0));
+  ck_assert(tw_bitmatrix_test(matrix, 99, 999));
+  ck_assert(!tw_bitmatrix_test(matrix, 99, 998));
+  ck_assert(!tw_bitmatrix_test(matrix, 98, 999));
+
+  ck_assert_uint_eq(tw_bitmatrix_row_count(matrix, 50), 2);
+  ck_assert_uint_eq(tw_bitmatrix_row_count(matrix, 51), 0);
+  ck_assert_uint_eq(tw_bitmatrix_col_count(matrix, 999), 2);
+  ck_assert_uint_eq(tw_bitmatrix_col_count(matrix, 64), 1);
+
+  tw_bitmatrix_clear(matrix, 50, 999);
+  ck_assert(!tw_bitmatrix_test(matrix, 50, 999));
+  ck_assert_uint_eq(tw_bitmatrix_col_count(matrix, 999), 1);
+
+  /* rows are regular bitmaps */
+  struct tw_bitmap row;
+  ck_assert_ptr_eq(tw_bitmatrix_row(matrix, 50, &row), &row);
+  ck_assert_uint_eq(row.size, matrix->row_bits);
+  ck_assert_uint_eq(tw_bitmap_count(&row), 1);
+  ck_assert_int64_t_eq(tw_bitmap_find_first_bit(&row), 64);
+  tw_bitmap_set(&row, 65);
+  ck_assert(tw_bitmatrix_test(matrix, 50, 65));
+
+  /* row operations */
+  ck_assert(tw_bitmatrix_row_union(matrix, 99, 50));
+  ck_assert_uint_eq(tw_bitmatrix_row_count(matrix, 50), 3);
+  ck_assert(tw_bitmatrix_test(matrix, 50, 999));
+  ck_assert(tw_bitmatrix_row_intersection(matrix, 99, 50));
+  ck_assert_uint_eq(tw_bitmatrix_row_count(matrix, 50), 1);
+  ck_assert(tw_bitmatrix_test(matrix, 50, 999));
+  ck_assert(tw_bitmatrix_row_intersection(matrix, 1, 50));
+  ck_assert_uint_eq(tw_bitmatrix_row_count(matrix, 50), 0);
+  ck_assert_uint_eq(tw_bitmatrix_row_count(matrix, 99), 1);
+
+  tw_bitmatrix_free(matrix);
+}
+END_TEST
+
+START_TEST(test_bitmatrix_transpose)
+{
+  DESCRIBE_TEST;
+
+  /* partial blocks in both dimensions, and mapped matrices */
+  const uint64_t dims[][2] = {{1, 1},     {64, 64},   {63, 65},
+                              {200, 130}, {1000, 77}, {4100, 5000}};
+  uint64_t seed = 0xFEEDFACECAFEBEEFULL;
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(dims); ++i) {
+    const uint64_t n_rows = dims[i][0], n_cols = dims[i][1];
+    struct tw_bitmatrix *matrix = random_matrix(n_rows, n_cols, &seed, 7);
+    struct tw_bitmatrix *transpose = tw_bitmatrix_transpose(matrix);
+    ck_assert_ptr_ne(transpose, NULL);
+    ck_assert_uint_eq(transpose->n_rows, n_cols);
+    ck_assert_uint_eq(transpose->n_cols, n_rows);
+
+    uint64_t *counts = malloc(n_cols * sizeof(uint64_t));
+    ck_assert(tw_bitmatrix_col_counts(matrix, counts));
+
+    /* asserts are costly, mismatches are accumulated */
+    uint64_t mismatches = 0;
+    for (uint64_t col = 0; col < n_cols; ++col) {
+      uint64_t count = 0;
+      for (uint64_t row = 0; row < n_rows; ++row) {
+        const bool bit = tw_bitmatrix_test(matrix, row, col);
+        mismatches += bit != tw_bitmatrix_test(transpose, col, row);
+        count += bit;
+      }
+      ck_assert_uint_eq(counts[col], count);
+      ck_assert_uint_eq(tw_bitmatrix_col_count(matrix, col), count);
+      ck_assert_uint_eq(tw_bitmatrix_row_count(transpose, col), count);
+    }
+    ck_assert_uint_eq(mismatches, 0);
+
+    /* padding bits stay cleared */
+    struct tw_bitmap row = {.size = transpose->row_bits};
+    for (uint64_t col = 0; col < n_cols && n_rows < row.size; ++col) {
+      tw_bitmatrix_row(transpose, col, &row);
+      ck_assert(!tw_bitmap_test_range_any(&row, n_rows, row.size - 1));
+    }
+
+    struct tw_bitmatrix *twice = tw_bitmatrix_transpose(transpose);
+    for (uint64_t r = 0; r < n_rows; ++r) {
+      struct tw_bitmap fst, snd;
+      tw_bitmatrix_row(matrix, r, &fst);
+      tw_bitmatrix_row(twice, r, &snd);
+      ck_assert(tw_bitmap_equal(&fst, &snd));
+    }
+
+    free(counts);
+    tw_bitmatrix_free(twice);
+    tw_bitmatrix_free(transpose);
+    tw_bitmatrix_free(matrix);
+  }
+}
+END_TEST
+
+START_TEST(test_bitmatrix_expand)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t n = 3000;
+  uint64_t seed = 0x5EED;
+  struct tw_bitmatrix *graph = random_matrix(n, n, &seed, 500);
+
+  struct tw_bitmap *frontier = tw_bitmap_new(n);
+  struct tw_bitmap *next = tw_bitmap_new(n);
+  struct tw_bitmap *expected = tw_bitmap_new(n);
+
+  /* empty, single, and several batches of rows */
+  const uint64_t n_rows[] = {0, 1, 15, 16, 17, 100, n};
+  for (size_t i = 0; i < TW_ARRAY_SIZE(n_rows); ++i) {
+    tw_bitmap_zero(frontier);
+    tw_bitmap_zero(expected);
+    for (uint64_t k = 0; k < n_rows[i]; ++k) {
+      const uint64_t row = xorshift64(&seed) % n;
+      tw_bitmap_set(frontier, row);
+    }
+
+    struct tw_bitmap_iter iter;
+    uint64_t row;
+    tw_bitmap_iter_init(&iter, frontier, 0);
+    while (tw_bitmap_iter_next(&iter, &row)) {
+      for (uint64_t col = 0; col < n; ++col) {
+        if (tw_bitmatrix_test(graph, row, col)) {
+          tw_bitmap_set(expected, col);
+        }
+      }
+    }
+
+    tw_bitmap_fill(next);
+    ck_assert_ptr_eq(tw_bitmatrix_expand(graph, frontier, next), next);
+    ck_assert(tw_bitmap_equal(next, expected));
+    ck_assert_uint_eq(tw_bitmap_count(next), tw_bitmap_count(expected));
+  }
+
+  tw_bitmap_free(expected);
+  tw_bitmap_free(next);
+  tw_bitmap_free(frontier);
+  tw_bitmatrix_free(graph);
+}
+END_TEST
+
+START_TEST(test_bitmatrix_bfs)
+{
+  DESCRIBE_TEST;
+
+  /* a grid of `side` by `side` vertices, at distance `x + y` from 0 */
+  const uint64_t side = 100, n = side * side;
+  struct tw_bitmatrix *graph = tw_bitmatrix_new(n, n);
+  for (uint64_t v = 0; v < n; ++v) {
+    if (v % side + 1 < side) {
+      tw_bitmatrix_set(graph, v, v + 1);
+    }
+    if (v + side < n) {
+      tw_bitmatrix_set(graph, v, v + side);
+    }
+  }
+
+  struct tw_bitmap *frontier = tw_bitmap_new(n);
+  struct tw_bitmap *next = tw_bitmap_new(n);
+  struct tw_bitmap *visited = tw_bitmap_new(n);
+  tw_bitmap_set(frontier, 0);
+  tw_bitmap_set(visited, 0);
+
+  uint64_t depth = 0;
+  while (!tw_bitmap_empty(frontier)) {
+    uint64_t mismatches = 0;
+    for (uint64_t v = 0; v < n; ++v) {
+      mismatches +=
+          tw_bitmap_test(frontier, v) != (v % side + v / side == depth);
+    }
+    ck_assert_uint_eq(mismatches, 0);
+
+    tw_bitmatrix_expand(graph, frontier, next);
+    tw_bitmap_andnot(visited, next);
+    tw_bitmap_union(next, visited);
+
+    struct tw_bitmap *tmp = frontier;
+    frontier = next;
+    next = tmp;
+    depth++;
+  }
+  ck_assert_uint_eq(depth, 2 * side - 1);
+  ck_assert_uint_eq(tw_bitmap_count(visited), n);
+
+  tw_bitmap_free(visited);
+  tw_bitmap_free(next);
+  tw_bitmap_free(frontier);
+  tw_bitmatrix_free(graph);
+}
+END_TEST
+
+START_TEST(test_bitmatrix_errors)
+{
+  DESCRIBE_TEST;
+
+  ck_assert_ptr_eq(tw_bitmatrix_new(0, 1), NULL);
+  ck_assert_ptr_eq(tw_bitmatrix_new(1, 0), NULL);
+  ck_assert_ptr_eq(tw_bitmatrix_new(1UL << 30, 1UL << 30), NULL);
+
+  struct tw_bitmatrix *matrix = tw_bitmatrix_new(10, 20);
+  struct tw_bitmap row;
+  struct tw_bitmap *frontier = tw_bitmap_new(10);
+  struct tw_bitmap *next = tw_bitmap_new(20);
+  struct tw_bitmap *larger = tw_bitmap_new(1000);
+
+  tw_bitmatrix_set(NULL, 0, 0);
+  tw_bitmatrix_set(matrix, 10, 0);
+  tw_bitmatrix_set(matrix, 0, 20);
+  tw_bitmatrix_clear(NULL, 0, 0);
+  ck_assert(!tw_bitmatrix_test(NULL, 0, 0));
+  ck_assert(!tw_bitmatrix_test(matrix, 0, 20));
+  ck_assert_ptr_eq(tw_bitmatrix_row(NULL, 0, &row), NULL);
+  ck_assert_ptr_eq(tw_bitmatrix_row(matrix, 10, &row), NULL);
+  ck_assert_ptr_eq(tw_bitmatrix_row(matrix, 0, NULL), NULL);
+  ck_assert(!tw_bitmatrix_row_union(NULL, 0, 0));
+  ck_assert(!tw_bitmatrix_row_union(matrix, 10, 0));
+  ck_assert(!tw_bitmatrix_row_intersection(matrix, 0, 10));
+  ck_assert_uint_eq(tw_bitmatrix_row_count(matrix, 10), 0);
+  ck_assert_uint_eq(tw_bitmatrix_col_count(matrix, 20), 0);
+  ck_assert(!tw_bitmatrix_col_counts(matrix, NULL));
+  ck_assert_ptr_eq(tw_bitmatrix_transpose(NULL), NULL);
+  ck_assert_ptr_eq(tw_bitmatrix_expand(NULL, frontier, next), NULL);
+  ck_assert_ptr_eq(tw_bitmatrix_expand(matrix, frontier, frontier), NULL);
+  ck_assert_ptr_eq(tw_bitmatrix_expand(matrix, frontier, larger), NULL);
+
+  /* rows are not resized by operations with larger bitmaps */
+  tw_bitmap_set(larger, 0);
+  tw_bitmap_set(larger, 999);
+  ck_assert_ptr_eq(tw_bitmatrix_row(matrix, 1, &row), &row);
+  ck_assert_ptr_eq(tw_bitmap_union(larger, &row), NULL);
+  ck_assert_ptr_eq(tw_bitmap_xor(larger, &row), NULL);
+  ck_assert_ptr_eq(tw_bitmap_copy(larger, &row), NULL);
+  ck_assert_ptr_eq(tw_bitmap_resize(&row, 1024), NULL);
+  ck_assert_uint_eq(row.size, matrix->row_bits);
+  ck_assert_uint_eq(tw_bitmatrix_row_count(matrix, 1), 0);
+
+  tw_bitmap_free(larger);
+  tw_bitmap_free(next);
+  tw_bitmap_free(frontier);
+  tw_bitmatrix_free(matrix);
+}
+END_TEST
+
+int run_tests()
+{
+  int number_failed;
+
+  Suite *s = suite_create("bitmatrix");
+  SRunner *runner = srunner_create(s);
+
+  TCase *tc = tcase_create("basic");
+  tcase_set_timeout(tc, 15);
+  tcase_add_test(tc, test_bitmatrix_basic);
+  tcase_add_test(tc, test_bitmatrix_transpose);
+  tcase_add_test(tc, test_bitmatrix_expand);
+  tcase_add_test(tc, test_bitmatrix_bfs);
+  tcase_add_test(tc, test_bitmatrix_errors);
+  suite_add_tcase(s, tc);
+
+  srunner_run_all(runner, CK_NORMAL);
+  number_failed = srunner_ntests_failed(runner);
+  srunner_free(runner);
+
+  return number_failed;
+}
+
+int main() { return (run_tests() == 0) ? EXIT_SUCCESS : EXIT_FAILURE; }
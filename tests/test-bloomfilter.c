@@ -37,6 +37,62 @@ START_TEST(test_bloomfilter_basic)
 }
 END_TEST
 
+START_TEST(test_bloomfilter_nocount)
+{
+  DESCRIBE_TEST;
+
+  const uint64_t nbits = 1 << 16;
+  struct tw_bloomfilter *bf = tw_bloomfilter_new(nbits, 7);
+  struct tw_bloomfilter *expected = tw_bloomfilter_new(nbits, 7);
+
+  for (uint64_t i = 0; i < 2000; ++i) {
+    tw_bloomfilter_set_nocount(bf, &i, sizeof(i));
+    tw_bloomfilter_set(expected, &i, sizeof(i));
+    ck_assert(tw_bloomfilter_test(bf, &i, sizeof(i)));
+  }
+
+  ck_assert_uint_eq(tw_bloomfilter_count(bf), tw_bloomfilter_count(expected));
+  ck_assert(tw_bloomfilter_equal(bf, expected));
+
+  tw_bloomfilter_set_nocount(NULL, "herp", 4);
+  tw_bloomfilter_set_nocount(bf, NULL, 4);
+  tw_bloomfilter_set_nocount(bf, "herp", 0);
+
+  tw_bloomfilter_free(expected);
+  tw_bloomfilter_free(bf);
+}
+END_TEST
+
+START_TEST(test_bloomfilter_alloc_flags)
+{
+  DESCRIBE_TEST;
+  const uint64_t nbits = 1 << 24;
+  const char *values[] = {"herp", "derp", "ferp", "merp"};
+
+  for (size_t f = 0; f < TW_ARRAY_SIZE(alloc_flags); ++f) {
+    struct tw_bloomfilter *bf =
+        tw_bloomfilter_new_flags(nbits, 7, alloc_flags[f]);
+    ck_assert_ptr_ne(bf, NULL);
+    ck_assert(tw_bloomfilter_empty(bf));
+
+    for (size_t l = 0; l < TW_ARRAY_SIZE(values); ++l) {
+      tw_bloomfilter_set(bf, values[l], strlen(values[l]));
+      ck_assert(tw_bloomfilter_test(bf, values[l], strlen(values[l])));
+    }
+
+    struct tw_bloomfilter *clone = tw_bloomfilter_clone(bf);
+    ck_assert(tw_bloomfilter_equal(bf, clone));
+
+    tw_bloomfilter_free(clone);
+    tw_bloomfilter_free(bf);
+  }
+
+  ck_assert_ptr_eq(tw_bloomfilter_new_flags(0, 7, TW_ALLOC_HUGE_PAGES), NULL);
+  ck_assert_ptr_eq(tw_bloomfilter_new_flags(nbits, 0, TW_ALLOC_HUGE_PAGES),
+                   NULL);
+}
+END_TEST
+
 START_TEST(test_bloomfilter_copy_and_clone)
 {
   DESCRIBE_TEST;
@@ -207,6 +263,8 @@ int run_tests()
   SRunner *runner = srunner_create(s);
   TCase *tc = tcase_create("basic");
   tcase_add_test(tc, test_bloomfilter_basic);
+  tcase_add_test(tc, test_bloomfilter_nocount);
+  tcase_add_test(tc, test_bloomfilter_alloc_flags);
   tcase_add_test(tc, test_bloomfilter_copy_and_clone);
   tcase_add_test(tc, test_bloomfilter_set_operations);
   tcase_add_test(tc, test_bloomfilter_errors);
@@ -1,5 +1,6 @@
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <twiddle/hyperloglog/hyperloglog.h>
 
@@ -84,6 +85,77 @@ START_TEST(test_hyperloglog_copy_and_clone)
 }
 END_TEST
 
+START_TEST(test_hyperloglog_alloc_flags)
+{
+  DESCRIBE_TEST;
+
+  for (size_t f = 0; f < TW_ARRAY_SIZE(alloc_flags); ++f) {
+    for (uint8_t p = TW_HLL_MIN_PRECISION; p <= TW_HLL_MAX_PRECISION; ++p) {
+      struct tw_hyperloglog *hll = tw_hyperloglog_new_flags(p, alloc_flags[f]);
+      struct tw_hyperloglog *expected = tw_hyperloglog_new(p);
+      ck_assert_ptr_ne(hll, NULL);
+      ck_assert(tw_hyperloglog_equal(hll, expected));
+
+      for (size_t k = 0; k < (1U << p); k += 3) {
+        tw_hyperloglog_add(hll, (void *)&k, sizeof(k));
+        tw_hyperloglog_add(expected, (void *)&k, sizeof(k));
+      }
+      ck_assert(tw_hyperloglog_equal(hll, expected));
+
+      tw_hyperloglog_free(expected);
+      tw_hyperloglog_free(hll);
+    }
+  }
+
+  ck_assert_ptr_eq(tw_hyperloglog_new_flags(TW_HLL_MAX_PRECISION + 1,
+                                            TW_ALLOC_HUGE_PAGES),
+                   NULL);
+}
+END_TEST
+
+START_TEST(test_hyperloglog_wrap)
+{
+  DESCRIBE_TEST;
+  for (uint8_t p = TW_HLL_MIN_PRECISION; p <= TW_HLL_MAX_PRECISION; ++p) {
+    const uint32_t n_registers = 1 << p;
+    struct tw_hyperloglog *expected = tw_hyperloglog_new(p);
+    for (size_t k = 0; k < n_registers; k += 3) {
+      tw_hyperloglog_add(expected, (void *)&k, sizeof(k));
+    }
+
+    /* registers received from elsewhere are used in place */
+    uint8_t *registers = malloc_aligned(TW_CACHELINE, n_registers);
+    memcpy(registers, expected->registers, n_registers);
+    struct tw_hyperloglog *hll = tw_hyperloglog_wrap(registers, p);
+    ck_assert_ptr_ne(hll, NULL);
+    ck_assert_ptr_eq(hll->registers, registers);
+    ck_assert(tw_hyperloglog_equal(hll, expected));
+    ck_assert(tw_almost_equal(tw_hyperloglog_count(hll),
+                              tw_hyperloglog_count(expected)));
+
+    for (size_t k = 1; k < n_registers; k += 3) {
+      tw_hyperloglog_add(hll, (void *)&k, sizeof(k));
+      tw_hyperloglog_add(expected, (void *)&k, sizeof(k));
+    }
+    ck_assert(tw_hyperloglog_equal(hll, expected));
+    ck_assert_int_eq(memcmp(registers, expected->registers, n_registers), 0);
+
+    tw_hyperloglog_free(hll);
+    ck_assert_int_eq(memcmp(registers, expected->registers, n_registers), 0);
+
+    free(registers);
+    tw_hyperloglog_free(expected);
+  }
+
+  uint8_t registers[128] __attribute__((aligned(64))) = {0};
+  ck_assert_ptr_eq(tw_hyperloglog_wrap(NULL, TW_HLL_MIN_PRECISION), NULL);
+  ck_assert_ptr_eq(tw_hyperloglog_wrap(registers + 1, TW_HLL_MIN_PRECISION),
+                   NULL);
+  ck_assert_ptr_eq(tw_hyperloglog_wrap(registers, TW_HLL_MIN_PRECISION - 1),
+                   NULL);
+}
+END_TEST
+
 START_TEST(test_hyperloglog_merge)
 {
   DESCRIBE_TEST;
@@ -125,6 +197,27 @@ START_TEST(test_hyperloglog_merge)
 }
 END_TEST
 
+/* Verify that the SIMD implementations available on the host computes the
+ * same n_zeros/inverse_sum than the naive (correct) version */
+static void validate_count_kernels(const uint8_t *registers,
+                                   uint32_t n_registers, float tolerance)
+{
+  uint32_t n_zeros_1 = 0;
+  float sum_1 = 0.0;
+  hyperloglog_count_port(registers, n_registers, &sum_1, &n_zeros_1);
+
+  for (int level = TW_SIMD_PORTABLE; level <= (int)tw_simd_level(); ++level) {
+    uint32_t n_zeros_2 = 0;
+    float sum_2 = 0.0;
+    hyperloglog_count_kernels[level](registers, n_registers, &sum_2,
+                                     &n_zeros_2);
+    ck_assert_uint32_t_eq(n_zeros_1, n_zeros_2);
+    /* float sums is _not_ associative, thus it might differ a bit when using
+     * SIMD operations */
+    ck_assert(fabs(sum_1 - sum_2) < sum_1 * tolerance);
+  }
+}
+
 START_TEST(test_hyperloglog_simd)
 {
   DESCRIBE_TEST;
@@ -146,22 +239,7 @@ START_TEST(test_hyperloglog_simd)
         estimate_within_error(tw_hyperloglog_count(hll), n_elems);
     ck_assert(within_error);
 
-    /* Verify that the SIMD implementation computes the same
-     * n_zeros/inverse_sum than the naive (correct) version */
-    uint32_t n_zeros_1 = 0, n_zeros_2 = 0;
-    float sum_1 = 0.0, sum_2 = 0.0;
-    hyperloglog_count_port(hll->registers, n_registers, &sum_1, &n_zeros_1);
-#ifdef USE_AVX2
-    hyperloglog_count_avx2(hll->registers, n_registers, &sum_2, &n_zeros_2);
-#elif defined USE_AVX
-    hyperloglog_count_avx(hll->registers, n_registers, &sum_2, &n_zeros_2);
-#else
-    hyperloglog_count_port(hll->registers, n_registers, &sum_2, &n_zeros_2);
-#endif
-    ck_assert_uint32_t_eq(n_zeros_1, n_zeros_2);
-    /* float sums is _not_ associative, thus it might differ a bit when using
-     * SIMD operations */
-    ck_assert(fabs(sum_1 - sum_2) < sum_1 * 0.00001);
+    validate_count_kernels(hll->registers, n_registers, 0.00001);
 
     /** test loglog */
     n_elems = 0;
@@ -175,20 +253,7 @@ START_TEST(test_hyperloglog_simd)
     ck_assert_msg(within_error, "estimate %f not within bounds",
                   tw_hyperloglog_count(hll));
 
-    n_zeros_1 = 0, n_zeros_2 = 0;
-    sum_1 = 0.0, sum_2 = 0.0;
-    hyperloglog_count_port(hll->registers, n_registers, &sum_1, &n_zeros_1);
-#ifdef USE_AVX2
-    hyperloglog_count_avx2(hll->registers, n_registers, &sum_2, &n_zeros_2);
-#elif defined USE_AVX
-    hyperloglog_count_avx(hll->registers, n_registers, &sum_2, &n_zeros_2);
-#else
-    hyperloglog_count_port(hll->registers, n_registers, &sum_2, &n_zeros_2);
-#endif
-    ck_assert_uint32_t_eq(n_zeros_1, n_zeros_2);
-    /* float sums is _not_ associative, thus it might differ a bit when using
-     * SIMD operations */
-    ck_assert(fabs(sum_1 - sum_2) < sum_1 * 0.0001);
+    validate_count_kernels(hll->registers, n_registers, 0.0001);
 
     tw_hyperloglog_free(hll);
   }
@@ -241,6 +306,8 @@ int run_tests()
   TCase *tc = tcase_create("basic");
   tcase_add_test(tc, test_hyperloglog_basic);
   tcase_add_test(tc, test_hyperloglog_copy_and_clone);
+  tcase_add_test(tc, test_hyperloglog_alloc_flags);
+  tcase_add_test(tc, test_hyperloglog_wrap);
   tcase_add_test(tc, test_hyperloglog_merge);
   tcase_add_test(tc, test_hyperloglog_simd);
   tcase_add_test(tc, test_hyperloglog_errors);
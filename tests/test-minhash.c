@@ -1,6 +1,7 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <twiddle/hash/minhash.h>
 
@@ -94,6 +95,74 @@ START_TEST(test_minhash_copy_and_clone)
 }
 END_TEST
 
+START_TEST(test_minhash_alloc_flags)
+{
+  DESCRIBE_TEST;
+  const uint32_t n_registers = 1 << 20;
+
+  for (size_t f = 0; f < TW_ARRAY_SIZE(alloc_flags); ++f) {
+    struct tw_minhash *hash = tw_minhash_new_flags(n_registers, alloc_flags[f]);
+    struct tw_minhash *expected = tw_minhash_new(n_registers);
+    ck_assert_ptr_ne(hash, NULL);
+    ck_assert(tw_minhash_equal(hash, expected));
+
+    for (size_t j = 0; j < 100; ++j) {
+      tw_minhash_add(hash, (void *)&j, sizeof(j));
+      tw_minhash_add(expected, (void *)&j, sizeof(j));
+    }
+    ck_assert(tw_minhash_equal(hash, expected));
+
+    tw_minhash_free(expected);
+    tw_minhash_free(hash);
+  }
+
+  ck_assert_ptr_eq(tw_minhash_new_flags(0, TW_ALLOC_HUGE_PAGES), NULL);
+}
+END_TEST
+
+START_TEST(test_minhash_wrap)
+{
+  DESCRIBE_TEST;
+  const uint32_t n_registers_list[] = {16, 256, 1 << 20};
+
+  for (size_t i = 0; i < TW_ARRAY_SIZE(n_registers_list); ++i) {
+    const uint32_t n_registers = n_registers_list[i];
+    const size_t data_size = n_registers * sizeof(uint32_t);
+    struct tw_minhash *expected = tw_minhash_new(n_registers);
+    for (size_t j = 0; j < 100; ++j) {
+      tw_minhash_add(expected, (void *)&j, sizeof(j));
+    }
+
+    /* registers received from elsewhere are used in place */
+    uint32_t *registers = malloc_aligned(TW_CACHELINE, data_size);
+    memcpy(registers, expected->registers, data_size);
+    struct tw_minhash *hash = tw_minhash_wrap(registers, n_registers);
+    ck_assert_ptr_ne(hash, NULL);
+    ck_assert_ptr_eq(hash->registers, registers);
+    ck_assert(tw_minhash_equal(hash, expected));
+
+    for (size_t j = 100; j < 200; ++j) {
+      tw_minhash_add(hash, (void *)&j, sizeof(j));
+      tw_minhash_add(expected, (void *)&j, sizeof(j));
+    }
+    ck_assert(tw_minhash_equal(hash, expected));
+    ck_assert(tw_almost_equal(tw_minhash_estimate(hash, expected), 1.0f));
+
+    tw_minhash_free(hash);
+    ck_assert_int_eq(memcmp(registers, expected->registers, data_size), 0);
+
+    free(registers);
+    tw_minhash_free(expected);
+  }
+
+  uint32_t registers[32] __attribute__((aligned(64))) = {0};
+  ck_assert_ptr_eq(tw_minhash_wrap(NULL, 16), NULL);
+  ck_assert_ptr_eq(tw_minhash_wrap(registers, 0), NULL);
+  ck_assert_ptr_eq(tw_minhash_wrap(registers, 17), NULL);
+  ck_assert_ptr_eq(tw_minhash_wrap(registers + 1, 16), NULL);
+}
+END_TEST
+
 START_TEST(test_minhash_merge)
 {
   DESCRIBE_TEST;
@@ -188,6 +257,8 @@ int run_tests()
   TCase *tc = tcase_create("basic");
   tcase_add_test(tc, test_minhash_basic);
   tcase_add_test(tc, test_minhash_copy_and_clone);
+  tcase_add_test(tc, test_minhash_alloc_flags);
+  tcase_add_test(tc, test_minhash_wrap);
   tcase_add_test(tc, test_minhash_merge);
   tcase_add_test(tc, test_minhash_errors);
   /* added for travis slowness of clang */
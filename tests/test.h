@@ -2,6 +2,9 @@
 #include <inttypes.h>
 #include <stdio.h>
 
+#include <twiddle/bitmap/bitmap.h>
+#include <twiddle/utils/alloc.h>
+
 #undef _ck_assert_ptr
 #define _ck_assert_ptr(X, OP, Y)                                               \
   do {                                                                         \
@@ -83,3 +86,37 @@
 #undef _ck_assert_type_all
 #undef _ck_assert_type
 */
+
+/* xorshift64, deterministic pseudo-random fixtures given a non-zero seed */
+static inline uint64_t xorshift64(uint64_t *seed)
+{
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 7;
+  *seed ^= *seed << 17;
+  return *seed;
+}
+
+/* set one in `sparsity` bits of `bitmap` on average */
+static inline void bitmap_random_fill(struct tw_bitmap *bitmap, uint64_t *seed,
+                                      uint32_t sparsity)
+{
+  for (uint64_t pos = 0; pos < bitmap->size; ++pos) {
+    if (xorshift64(seed) % sparsity == 0) {
+      tw_bitmap_set(bitmap, pos);
+    }
+  }
+}
+
+/* set `n` random positions of `bitmap` */
+static inline void bitmap_random_set(struct tw_bitmap *bitmap, uint64_t *seed,
+                                     uint64_t n)
+{
+  for (uint64_t i = 0; i < n; ++i) {
+    tw_bitmap_set(bitmap, xorshift64(seed) % bitmap->size);
+  }
+}
+
+/* hints the host may not honour, allocations must succeed regardless */
+static const int alloc_flags[] __attribute__((unused)) = {
+    TW_ALLOC_DEFAULT, TW_ALLOC_HUGE_PAGES, TW_ALLOC_HUGETLB,
+    TW_ALLOC_INTERLEAVE, TW_ALLOC_HUGE_PAGES | TW_ALLOC_NODE(0)};
@@ -254,6 +254,12 @@ function(add_c_test TEST_NAME)
         LOCAL_LIBRARIES ${ALL_LOCAL_LIBRARIES}
     )
     add_test(${TEST_NAME} ${TEST_NAME})
+    # run once more for each compiled SIMD level, see `tw_simd_level()`
+    foreach(level ${TW_SIMD_LEVELS})
+        add_test(${TEST_NAME}-${level} ${TEST_NAME})
+        set_tests_properties(${TEST_NAME}-${level} PROPERTIES
+                             ENVIRONMENT "TWIDDLE_SIMD=${level}")
+    endforeach(level)
     target_link_libraries(${TEST_NAME} m rt)
     if (USE_VALGRIND)
       add_test(${TEST_NAME}-valgrind valgrind --quiet ./${TEST_NAME})
@@ -23,28 +23,51 @@ if(NOT CMAKE_BUILD_TYPE)
 endif(NOT CMAKE_BUILD_TYPE)
 
 
+# SIMD kernels are compiled for every enabled instruction set with function
+# target attributes, thus no global -m flag is required. The best kernels
+# supported by the host are selected at runtime, see `tw_simd_level()`.
+include(CheckCSourceCompiles)
+
+if(USE_AVX512)
+  check_c_source_compiles("
+    #include <x86intrin.h>
+    __attribute__((target(\"avx512f,avx512bw\")))
+    int f(void) { return _mm512_cmpneq_epi64_mask(_mm512_max_epu8(
+                    _mm512_setzero_si512(), _mm512_setzero_si512()),
+                    _mm512_setzero_si512()); }
+    int main(void) { return f(); }" HAVE_TARGET_AVX512)
+  if(NOT HAVE_TARGET_AVX512)
+    message(WARNING "Compiler does not support AVX512 targets, disabling.")
+    set(USE_AVX512 OFF)
+  endif()
+
+  # Ice Lake extensions are compiled along AVX512 when supported.
+  check_c_source_compiles("
+    #include <x86intrin.h>
+    __attribute__((target(\"avx512f,avx512vpopcntdq,avx512bitalg,avx512vbmi2\")))
+    int f(void) { return _mm512_reduce_add_epi64(_mm512_popcnt_epi64(
+                    _mm512_shldi_epi64(_mm512_setzero_si512(),
+                                       _mm512_setzero_si512(), 1))); }
+    int main(void) { return f(); }" HAVE_TARGET_AVX512_ICL)
+endif()
+
+# Kernels of a level fallback on kernels of the previous level when an
+# operation has no better implementation, thus AVX512 implies AVX2 and AVX2
+# implies AVX.
+set(TW_SIMD_LEVELS portable)
 if(USE_AVX512)
-  if (CMAKE_C_COMPILER_ID MATCHES "GNU" OR CMAKE_C_COMPILER_ID MATCHES "Clang")
-    add_definitions(-mavx512 -mavx2 -mavx)
-  elseif (CMAKE_C_COMPILER_ID MATCHES "Intel")
-    add_definitions(-xCORE-AVX512)
-  endif ()
   add_definitions(-DUSE_AVX512=1 -DUSE_AVX2=1 -DUSE_AVX=1)
+  list(APPEND TW_SIMD_LEVELS avx avx2 avx512)
+  if(HAVE_TARGET_AVX512_ICL)
+    add_definitions(-DUSE_AVX512_ICL=1)
+    list(APPEND TW_SIMD_LEVELS avx512icl)
+  endif()
 elseif(USE_AVX2)
-  if (CMAKE_C_COMPILER_ID MATCHES "GNU" OR CMAKE_C_COMPILER_ID MATCHES "Clang")
-    add_definitions(-mavx2 -mavx)
-  elseif (CMAKE_C_COMPILER_ID MATCHES "Intel")
-    add_definitions(-xCORE-AVX2)
-  endif ()
-  add_definitions(-DUSE_AVX2=1)
-  add_definitions(-DUSE_AVX=1)
+  add_definitions(-DUSE_AVX2=1 -DUSE_AVX=1)
+  list(APPEND TW_SIMD_LEVELS avx avx2)
 elseif(USE_AVX)
-  if (CMAKE_C_COMPILER_ID MATCHES "GNU" OR CMAKE_C_COMPILER_ID MATCHES "Clang")
-    add_definitions(-mavx)
-  elseif (CMAKE_C_COMPILER_ID MATCHES "Intel")
-    add_definitions(-xCORE-AVX-I)
-  endif ()
   add_definitions(-DUSE_AVX=1)
+  list(APPEND TW_SIMD_LEVELS avx)
 else()
   add_definitions(-DUSE_PORTABLE=1)
 endif()